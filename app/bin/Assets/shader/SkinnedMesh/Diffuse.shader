@@ -0,0 +1,12 @@
+{
+    "vs": {
+        "predefine": "#define SKINNED_MESH 1",
+        "includes": [ "Skin.in", "Diffuse.vs.in" ],
+        "source": ""
+    },
+    "fs": {
+        "predefine": "",
+        "includes": [ "Diffuse.fs.in" ],
+        "source": ""
+    }
+}
@@ -0,0 +1,578 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "AssetCooking.h"
+#include "io/Directory.h"
+#include "io/File.h"
+#include "io/Pak.h"
+#include "graphics/MaterialFile.h"
+#include "graphics/Shader.h"
+#include "graphics/TextureCompressor.h"
+#include "container/Map.h"
+#include "math/Mathf.h"
+#include "thread/ThreadPool.h"
+#include "vulkan/vulkan_shader_compiler.h"
+#include "Object.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace Viry3D;
+
+// cooks an exported asset directory into runtime files, in parallel and only for inputs that changed.
+// usage: Viry3DAssetCooker input_dir output_dir [--jobs 0] [--target any] [--format R8G8B8A8] [--zlib 1] [--pak output.pak] [--force 0]
+// .mesh files become binary mesh files, .tex descriptors get a .ktx2 with mipmaps next to them,
+// .shader descriptors are compiled into shader/Cache/<md5>.spv the vulkan backend reads instead of compiling,
+// .mat files are cooked with the uniform slot of each property resolved against the spir-v of their shader,
+// .go files are cooked with the bone and animation curve targets resolved to node indices, other files are copied.
+// the content hash of each input, its images, its shader and the options is kept in output_dir/.cooked with
+// the outputs it made, a file is cooked again when its hash changes or an output is missing, and outputs no
+// input makes any more are removed.
+// --pak also packs the output directory into an archive for FileSystem::MountPak, jobs 0 uses every core.
+// --target picks the ktx2 format: desktop BC7, mobile ETC2_R8G8B8A8, any R8G8B8A8 which every device samples.
+// --format overrides it. the runtime loads the .tex image instead of a ktx2 the device can not sample.
+
+#define COOKER_VERSION 2
+#define MANIFEST_NAME ".cooked"
+#define SHADER_CACHE_DIR "shader/Cache"
+
+enum class CookResult
+{
+    Skipped,
+    Cooked,
+    Failed,
+};
+
+struct CookItem
+{
+    String path;
+    String hash;
+    // relative to output_dir
+    Vector<String> outputs;
+    CookResult result = CookResult::Failed;
+};
+
+struct ManifestEntry
+{
+    String hash;
+    Vector<String> outputs;
+};
+
+struct CookedShader
+{
+    String hash;
+    Vector<UniformSet> uniform_sets;
+};
+
+struct CookContext
+{
+    String input_dir;
+    String output_dir;
+    String settings;
+    TextureCookOptions options;
+    bool force = false;
+    Map<String, ManifestEntry> manifest;
+    // by the name materials use, written by the serial shader pass and only read after it
+    Map<String, CookedShader> shaders;
+};
+
+// fnv-1a 64
+static unsigned long long HashBytes(unsigned long long hash, const void* data, int size)
+{
+    const byte* bytes = (const byte*) data;
+    for (int i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static unsigned long long HashString(unsigned long long hash, const String& str)
+{
+    return HashBytes(hash, str.CString(), str.Size());
+}
+
+static unsigned long long HashFile(unsigned long long hash, const String& path)
+{
+    ByteBuffer buffer = File::ReadAllBytes(path);
+    hash = HashString(hash, path);
+    return HashBytes(hash, buffer.Bytes(), buffer.Size());
+}
+
+static void CreateParentDirectory(const String& path)
+{
+    int end = path.LastIndexOf("/");
+    if (end > 0)
+    {
+        Directory::Create(path.Substring(0, end));
+    }
+}
+
+// lines are "hash path", then a tab before each output
+static Map<String, ManifestEntry> LoadManifest(const String& path)
+{
+    Map<String, ManifestEntry> manifest;
+
+    if (File::Exist(path))
+    {
+        Vector<String> lines = File::ReadAllText(path).Split("\n", true);
+        for (const auto& i : lines)
+        {
+            int space = i.IndexOf(" ");
+            if (space <= 0)
+            {
+                continue;
+            }
+
+            Vector<String> paths = i.Substring(space + 1).Split("\t", true);
+            if (paths.Empty())
+            {
+                continue;
+            }
+
+            ManifestEntry entry;
+            entry.hash = i.Substring(0, space);
+            for (int j = 1; j < paths.Size(); ++j)
+            {
+                entry.outputs.Add(paths[j]);
+            }
+            if (entry.outputs.Empty())
+            {
+                entry.outputs.Add(paths[0]);
+            }
+            manifest.Add(paths[0], entry);
+        }
+    }
+
+    return manifest;
+}
+
+static bool IsUpToDate(const CookContext& context, const CookItem& item)
+{
+    const ManifestEntry* entry;
+    if (context.force || !context.manifest.TryGet(item.path, &entry) || entry->hash != item.hash)
+    {
+        return false;
+    }
+
+    for (const auto& i : item.outputs)
+    {
+        if (!File::Exist(context.output_dir + "/" + i))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static String GetShaderName(const String& path)
+{
+    // shader/SkinnedMesh/Diffuse.shader is the SkinnedMesh/Diffuse a material names
+    String name = path.Substring(0, path.Size() - String(".shader").Size());
+    if (name.StartsWith("shader/"))
+    {
+        name = name.Substring(String("shader/").Size());
+    }
+    return name;
+}
+
+static void CookShaderFile(CookContext& context, CookItem& item)
+{
+    String input = context.input_dir + "/" + item.path;
+    String include_dir = context.input_dir + "/shader/Include";
+
+    Vector<ShaderCookSource> sources;
+    if (!AssetCooking::LoadShaderSources(input, include_dir, sources))
+    {
+        return;
+    }
+
+    // the processed glsl holds the includes, so an include change cooks the shader again
+    unsigned long long hash = 14695981039346656037ull;
+    hash = HashString(hash, context.settings);
+    hash = HashString(hash, item.path);
+    for (const auto& i : sources)
+    {
+        hash = HashString(hash, i.glsl);
+        item.outputs.Add(String(SHADER_CACHE_DIR) + "/" + Shader::GetSpirvName(i.glsl) + ".spv");
+    }
+    item.hash = String::Format("%016llx", hash);
+
+    bool up_to_date = IsUpToDate(context, item);
+    String cache_dir = context.output_dir + "/" + SHADER_CACHE_DIR;
+    Directory::Create(cache_dir);
+
+    CookedShader shader;
+    String info;
+    if (!AssetCooking::CookShader(sources, cache_dir, !up_to_date, shader.uniform_sets, info))
+    {
+        return;
+    }
+
+    shader.hash = item.hash;
+    context.shaders.Add(GetShaderName(item.path), shader);
+
+    if (up_to_date)
+    {
+        item.result = CookResult::Skipped;
+        return;
+    }
+
+    if (info.Size() > 0)
+    {
+        printf("%s: %s\n", item.path.CString(), info.CString());
+    }
+
+    item.result = CookResult::Cooked;
+}
+
+static void CookFile(const CookContext& context, CookItem& item)
+{
+    String input = context.input_dir + "/" + item.path;
+    String output = context.output_dir + "/" + item.path;
+    String ktx_output;
+    const CookedShader* shader = nullptr;
+
+    unsigned long long hash = 14695981039346656037ull;
+    hash = HashString(hash, context.settings);
+    hash = HashFile(hash, input);
+
+    item.outputs.Add(item.path);
+
+    if (item.path.EndsWith(".tex"))
+    {
+        String ktx_path = item.path.Substring(0, item.path.Size() - 4) + ".ktx2";
+        ktx_output = context.output_dir + "/" + ktx_path;
+        item.outputs.Add(ktx_path);
+
+        Vector<String> dependencies = AssetCooking::GetTexDependencies(input);
+        for (const auto& i : dependencies)
+        {
+            hash = HashFile(hash, i);
+        }
+    }
+    else if (item.path.EndsWith(".mat"))
+    {
+        // the slots come from the shader, so the material is cooked again when the shader is
+        MaterialFileData data;
+        if (MaterialFile::Load(File::ReadAllBytes(input), data) && context.shaders.TryGet(data.shader, &shader))
+        {
+            hash = HashString(hash, shader->hash);
+        }
+    }
+
+    item.hash = String::Format("%016llx", hash);
+
+    if (IsUpToDate(context, item))
+    {
+        item.result = CookResult::Skipped;
+        return;
+    }
+
+    CreateParentDirectory(output);
+
+    bool success = true;
+    String info;
+    if (item.path.EndsWith(".mesh"))
+    {
+        success = AssetCooking::CookMesh(input, output, context.options.zlib, info);
+    }
+    else if (item.path.EndsWith(".mat"))
+    {
+        success = AssetCooking::CookMaterial(input, output, shader ? &shader->uniform_sets : nullptr, info);
+    }
+    else if (item.path.EndsWith(".go"))
+    {
+        success = AssetCooking::CookPrefab(input, output, info);
+    }
+    else
+    {
+        success = File::WriteAllBytes(output, File::ReadAllBytes(input));
+
+        if (success && ktx_output.Size() > 0)
+        {
+            success = AssetCooking::CookTexture(input, ktx_output, context.options, info);
+        }
+    }
+
+    if (success && info.Size() > 0)
+    {
+        printf("%s\n", info.CString());
+    }
+
+    item.result = success ? CookResult::Cooked : CookResult::Failed;
+}
+
+static bool WritePak(const String& output_dir, const String& path)
+{
+    Vector<String> files = Directory::GetFiles(output_dir, true);
+    Vector<PakFile> pak_files;
+
+    for (const auto& i : files)
+    {
+        String relative = i.Substring(output_dir.Size() + 1);
+        if (relative == MANIFEST_NAME)
+        {
+            continue;
+        }
+
+        PakFile file;
+        file.path = relative;
+        file.data = File::ReadAllBytes(i);
+        // images and zlib ktx2 files do not shrink further
+        file.compress = !(relative.EndsWith(".png") || relative.EndsWith(".jpg") || relative.EndsWith(".ktx2"));
+        pak_files.Add(file);
+    }
+
+    CreateParentDirectory(path);
+    if (!Pak::Save(path, pak_files))
+    {
+        printf("write pak failed: %s\n", path.CString());
+        return false;
+    }
+
+    printf("%s: %d files\n", path.CString(), pak_files.Size());
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        printf("usage: Viry3DAssetCooker input_dir output_dir [--jobs 0] [--target any] [--format R8G8B8A8] [--zlib 1] [--pak output.pak] [--force 0]\n");
+        return 1;
+    }
+
+    String input_dir = argv[1];
+    String output_dir = argv[2];
+    int jobs = 0;
+    bool force = false;
+    String pak_path;
+    TextureCookOptions options;
+    options.format = TextureFormat::None;
+    options.zlib = true;
+    String target = "any";
+
+    for (int i = 3; i + 1 < argc; i += 2)
+    {
+        const char* key = argv[i];
+        const char* value = argv[i + 1];
+
+        if (strcmp(key, "--jobs") == 0)
+        {
+            jobs = atoi(value);
+        }
+        else if (strcmp(key, "--target") == 0)
+        {
+            target = value;
+        }
+        else if (strcmp(key, "--format") == 0)
+        {
+            options.format = TextureFormatInfo::FromName(value);
+            if (options.format == TextureFormat::None)
+            {
+                printf("format not support\n");
+                return 1;
+            }
+        }
+        else if (strcmp(key, "--zlib") == 0)
+        {
+            options.zlib = atoi(value) != 0;
+        }
+        else if (strcmp(key, "--pak") == 0)
+        {
+            pak_path = value;
+        }
+        else if (strcmp(key, "--force") == 0)
+        {
+            force = atoi(value) != 0;
+        }
+        else
+        {
+            printf("unknown option: %s\n", key);
+            return 1;
+        }
+    }
+
+    if (input_dir.EndsWith("/"))
+    {
+        input_dir = input_dir.Substring(0, input_dir.Size() - 1);
+    }
+    if (output_dir.EndsWith("/"))
+    {
+        output_dir = output_dir.Substring(0, output_dir.Size() - 1);
+    }
+
+    if (!Directory::Exist(input_dir))
+    {
+        printf("directory not exist: %s\n", input_dir.CString());
+        return 1;
+    }
+
+    if (options.format == TextureFormat::None)
+    {
+        if (target == "desktop")
+        {
+            options.format = TextureFormat::BC7;
+        }
+        else if (target == "mobile")
+        {
+            options.format = TextureFormat::ETC2_R8G8B8A8;
+        }
+        else if (target == "any")
+        {
+            options.format = TextureFormat::R8G8B8A8;
+        }
+        else
+        {
+            printf("unknown target: %s\n", target.CString());
+            return 1;
+        }
+    }
+
+    if (options.format != TextureFormat::R8G8B8A8 && !TextureCompressor::IsFormatSupported(options.format))
+    {
+        printf("format not support\n");
+        return 1;
+    }
+
+    if (jobs <= 0)
+    {
+        jobs = Mathf::Max((int) std::thread::hardware_concurrency(), 1);
+    }
+
+    CookContext context;
+    context.input_dir = input_dir;
+    context.output_dir = output_dir;
+    context.settings = String::Format("%d %s %d", COOKER_VERSION, TextureFormatInfo::GetName(options.format), options.zlib ? 1 : 0);
+    context.options = options;
+    context.force = force;
+
+    String manifest_path = output_dir + "/" + MANIFEST_NAME;
+    context.manifest = LoadManifest(manifest_path);
+
+    Vector<String> files = Directory::GetFiles(input_dir, true);
+    Vector<CookItem> items(files.Size());
+    for (int i = 0; i < files.Size(); ++i)
+    {
+        items[i].path = files[i].Substring(input_dir.Size() + 1);
+    }
+
+    // shaders first and on this thread, glslang is not thread safe and materials need the uniform sets
+    InitShaderCompiler();
+    for (auto& i : items)
+    {
+        if (i.path.EndsWith(".shader"))
+        {
+            CookShaderFile(context, i);
+        }
+    }
+    DeinitShaderCompiler();
+
+    {
+        // each task writes its own item, the pool joins in WaitAll
+        ThreadPool pool(jobs);
+        for (int i = 0; i < items.Size(); ++i)
+        {
+            if (items[i].path.EndsWith(".shader"))
+            {
+                continue;
+            }
+
+            CookItem* item = &items[i];
+            Thread::Task task;
+            task.job = [&context, item]() {
+                CookFile(context, *item);
+                return Ref<Object>();
+            };
+            pool.AddTask(task);
+        }
+        pool.WaitAll();
+    }
+
+    int cooked = 0;
+    int skipped = 0;
+    int failed = 0;
+    String manifest_text;
+    Map<String, bool> outputs;
+    for (const auto& i : items)
+    {
+        switch (i.result)
+        {
+            case CookResult::Cooked:
+                cooked += 1;
+                break;
+            case CookResult::Skipped:
+                skipped += 1;
+                break;
+            case CookResult::Failed:
+                failed += 1;
+                printf("cook failed: %s\n", i.path.CString());
+                break;
+        }
+
+        // failed files are left out so the next run tries them again, and their stale outputs are removed
+        if (i.result != CookResult::Failed)
+        {
+            manifest_text += i.hash + " " + i.path;
+            for (const auto& j : i.outputs)
+            {
+                manifest_text += "\t" + j;
+                outputs.Add(j, true);
+            }
+            manifest_text += "\n";
+        }
+    }
+
+    Directory::Create(output_dir);
+    File::WriteAllText(manifest_path, manifest_text);
+
+    // outputs no input makes any more would otherwise stay in output_dir and the pak
+    int removed = 0;
+    for (const auto& i : context.manifest)
+    {
+        for (const auto& j : i.second.outputs)
+        {
+            if (outputs.Contains(j))
+            {
+                continue;
+            }
+
+            String output = output_dir + "/" + j;
+            if (File::Exist(output))
+            {
+                File::Delete(output);
+                removed += 1;
+            }
+        }
+    }
+
+    printf("%d cooked, %d up to date, %d removed, %d failed, %d jobs\n", cooked, skipped, removed, failed, jobs);
+
+    if (pak_path.Size() > 0 && (cooked > 0 || removed > 0 || !File::Exist(pak_path)))
+    {
+        if (!WritePak(output_dir, pak_path))
+        {
+            return 1;
+        }
+    }
+
+    return failed > 0 ? 1 : 0;
+}
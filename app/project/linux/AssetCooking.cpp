@@ -0,0 +1,588 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "AssetCooking.h"
+#include "graphics/Image.h"
+#include "graphics/KTX.h"
+#include "graphics/MaterialFile.h"
+#include "graphics/MeshFile.h"
+#include "graphics/Shader.h"
+#include "graphics/TextureCompressor.h"
+#include "io/File.h"
+#include "io/MemoryStream.h"
+#include "math/Mathf.h"
+#include "PrefabFile.h"
+#include "json/json.h"
+#include "vulkan/vulkan_shader_compiler.h"
+#include <stdio.h>
+
+namespace Viry3D
+{
+    struct SourceImage
+    {
+        int width = 0;
+        int height = 0;
+        int face_count = 1;
+        int level_count = 1;
+        bool gen_mipmap = false;
+        bool float_pixels = false;
+        // rgba8 or rgba32f images ordered by level and face
+        Vector<ByteBuffer> images;
+        Map<String, String> key_values;
+    };
+
+    static ByteBuffer ToRGBA(const ByteBuffer& pixels, int bpp)
+    {
+        int channels = bpp / 8;
+        if (channels == 4)
+        {
+            return pixels;
+        }
+
+        int pixel_count = pixels.Size() / channels;
+        ByteBuffer rgba(pixel_count * 4);
+        for (int i = 0; i < pixel_count; ++i)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                rgba[i * 4 + c] = pixels[i * channels + (channels == 3 ? c : 0)];
+            }
+            rgba[i * 4 + 3] = 255;
+        }
+
+        return rgba;
+    }
+
+    static bool LoadImage(const String& path, ByteBuffer& rgba, int& width, int& height)
+    {
+        if (!File::Exist(path))
+        {
+            printf("file not exist: %s\n", path.CString());
+            return false;
+        }
+
+        int bpp = 0;
+        ByteBuffer file = File::ReadAllBytes(path);
+        ByteBuffer pixels;
+        if (path.EndsWith(".png"))
+        {
+            pixels = Image::LoadPNG(file, width, height, bpp);
+        }
+        else if (path.EndsWith(".jpg"))
+        {
+            pixels = Image::LoadJPEG(file, width, height, bpp);
+        }
+
+        if (pixels.Size() == 0)
+        {
+            printf("load image failed: %s\n", path.CString());
+            return false;
+        }
+
+        rgba = ToRGBA(pixels, bpp);
+
+        return true;
+    }
+
+    static String ReadString(MemoryStream& ms)
+    {
+        int size = ms.Read<int>();
+        return ms.ReadString(size);
+    }
+
+    // paths in a .tex are relative to the asset root and start with the path of the .tex itself
+    static String GetAssetRoot(const String& tex_path, const String& image_path)
+    {
+        int end = image_path.LastIndexOf(".tex");
+        if (end < 0)
+        {
+            return "";
+        }
+
+        String asset_path = image_path.Substring(0, end + 4);
+        if (!tex_path.EndsWith(asset_path))
+        {
+            return "";
+        }
+
+        return tex_path.Substring(0, tex_path.Size() - asset_path.Size());
+    }
+
+    static bool LoadTex(const String& path, SourceImage& source)
+    {
+        if (!File::Exist(path))
+        {
+            printf("file not exist: %s\n", path.CString());
+            return false;
+        }
+
+        MemoryStream ms(File::ReadAllBytes(path));
+
+        ReadString(ms); // name
+        source.width = ms.Read<int>();
+        source.height = ms.Read<int>();
+        int wrap_mode = ms.Read<int>();
+        int filter_mode = ms.Read<int>();
+        String texture_type = ReadString(ms);
+        int mipmap_count = ms.Read<int>();
+
+        source.key_values.Add(KTX_KEY_FILTER_MODE, String::Format("%d", filter_mode));
+        source.key_values.Add(KTX_KEY_WRAP_MODE, String::Format("%d", wrap_mode));
+
+        if (texture_type == "Texture2D")
+        {
+            String image_path = ReadString(ms);
+            String root = GetAssetRoot(path, image_path);
+
+            ByteBuffer rgba;
+            int width;
+            int height;
+            if (!LoadImage(root + image_path, rgba, width, height))
+            {
+                return false;
+            }
+
+            source.width = width;
+            source.height = height;
+            source.gen_mipmap = mipmap_count > 1;
+            source.images.Add(rgba);
+        }
+        else if (texture_type == "Cubemap")
+        {
+            source.face_count = 6;
+            source.level_count = mipmap_count;
+
+            for (int i = 0; i < mipmap_count * 6; ++i)
+            {
+                String image_path = ReadString(ms);
+                String root = GetAssetRoot(path, image_path);
+
+                ByteBuffer rgba;
+                int width;
+                int height;
+                if (!LoadImage(root + image_path, rgba, width, height))
+                {
+                    return false;
+                }
+
+                int level = i / 6;
+                if (width != Mathf::Max(source.width >> level, 1) || height != Mathf::Max(source.height >> level, 1))
+                {
+                    printf("cubemap face size not match: %s\n", image_path.CString());
+                    return false;
+                }
+
+                source.images.Add(rgba);
+            }
+        }
+        else if (texture_type == "Texture2DRGBFloat")
+        {
+            String data_path = ReadString(ms);
+            String root = GetAssetRoot(path, data_path);
+
+            ByteBuffer rgb = File::ReadAllBytes(root + data_path);
+            int pixel_count = source.width * source.height;
+            if (rgb.Size() != pixel_count * 12)
+            {
+                printf("float data size not match: %s\n", data_path.CString());
+                return false;
+            }
+
+            ByteBuffer rgba(pixel_count * 16);
+            const float one = 1.0f;
+            for (int i = 0; i < pixel_count; ++i)
+            {
+                Memory::Copy(&rgba[i * 16], &rgb[i * 12], 12);
+                Memory::Copy(&rgba[i * 16 + 12], &one, 4);
+            }
+
+            source.float_pixels = true;
+            source.images.Add(rgba);
+        }
+        else
+        {
+            printf("texture type not support: %s\n", texture_type.CString());
+            return false;
+        }
+
+        return true;
+    }
+
+    static void GenMipmaps(SourceImage& source, const MipmapOptions& options)
+    {
+        source.images = MipmapGenerator::Generate(source.images[0], source.width, source.height, 4, options);
+        source.level_count = source.images.Size();
+    }
+
+    bool AssetCooking::CookTexture(const String& input, const String& output, const TextureCookOptions& options, String& info)
+    {
+        TextureFormat format = options.format;
+
+        SourceImage source;
+        if (input.EndsWith(".tex"))
+        {
+            if (!LoadTex(input, source))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            ByteBuffer rgba;
+            if (!LoadImage(input, rgba, source.width, source.height))
+            {
+                return false;
+            }
+            source.gen_mipmap = options.mipmaps;
+            source.images.Add(rgba);
+        }
+
+        if (source.float_pixels)
+        {
+            format = TextureFormat::R32G32B32A32F;
+        }
+        else if (format != TextureFormat::R8G8B8A8 && !TextureCompressor::IsFormatSupported(format))
+        {
+            printf("format not support\n");
+            return false;
+        }
+
+        if (source.gen_mipmap && !source.float_pixels)
+        {
+            GenMipmaps(source, options.mipmap_options);
+        }
+
+        KTXImage image;
+        image.format = format;
+        image.width = source.width;
+        image.height = source.height;
+        image.face_count = source.face_count;
+        image.level_count = source.level_count;
+        image.key_values = source.key_values;
+
+        for (int i = 0; i < source.images.Size(); ++i)
+        {
+            int level = i / source.face_count;
+            int width = Mathf::Max(source.width >> level, 1);
+            int height = Mathf::Max(source.height >> level, 1);
+
+            if (TextureCompressor::IsFormatSupported(format))
+            {
+                image.images.Add(TextureCompressor::Compress(source.images[i], width, height, format));
+            }
+            else
+            {
+                image.images.Add(source.images[i]);
+            }
+        }
+
+        ByteBuffer file;
+        if (output.EndsWith(".ktx2"))
+        {
+            file = KTX::SaveKTX2(image, options.zlib);
+        }
+        else if (image.face_count == 1)
+        {
+            file = KTX::Save(format, image.width, image.height, image.images);
+        }
+        else
+        {
+            printf("ktx 1.1 output supports 2d textures only, use ktx2\n");
+            return false;
+        }
+
+        if (!File::WriteAllBytes(output, file))
+        {
+            printf("write file failed: %s\n", output.CString());
+            return false;
+        }
+
+        info = String::Format("%s %dx%d %s, %d faces, %d levels, %d bytes", output.CString(), image.width, image.height, TextureFormatInfo::GetName(format), image.face_count, image.level_count, file.Size());
+
+        return true;
+    }
+
+    bool AssetCooking::CookMesh(const String& input, const String& output, bool zlib, String& info)
+    {
+        if (!File::Exist(input))
+        {
+            printf("file not exist: %s\n", input.CString());
+            return false;
+        }
+
+        ByteBuffer file = File::ReadAllBytes(input);
+        MeshFileData data;
+        if (!MeshFile::Load(file, data))
+        {
+            printf("invalid mesh file: %s\n", input.CString());
+            return false;
+        }
+
+        ByteBuffer binary = MeshFile::Save(data, zlib);
+        if (!File::WriteAllBytes(output, binary))
+        {
+            printf("write file failed: %s\n", output.CString());
+            return false;
+        }
+
+        info = String::Format("%s: %d vertices %d indices, %d -> %d bytes", output.CString(), data.vertex_count, data.index_count, file.Size(), binary.Size());
+
+        return true;
+    }
+
+    bool AssetCooking::CookMaterial(const String& input, const String& output, const Vector<UniformSet>* uniform_sets, String& info)
+    {
+        if (!File::Exist(input))
+        {
+            printf("file not exist: %s\n", input.CString());
+            return false;
+        }
+
+        MaterialFileData data;
+        if (!MaterialFile::Load(File::ReadAllBytes(input), data))
+        {
+            printf("invalid material file: %s\n", input.CString());
+            return false;
+        }
+
+        int resolved = 0;
+        for (auto& i : data.properties)
+        {
+            if (uniform_sets && Material::FindSlot(*uniform_sets, i.name, i.type, i.slot))
+            {
+                resolved += 1;
+            }
+        }
+
+        if (!File::WriteAllBytes(output, MaterialFile::Save(data)))
+        {
+            printf("write file failed: %s\n", output.CString());
+            return false;
+        }
+
+        info = String::Format("%s: %s, %d of %d property slots resolved", output.CString(), data.shader.CString(), resolved, data.properties.Size());
+
+        return true;
+    }
+
+    static void CountTargets(const PrefabNode* node, int& node_count, int& bone_count, int& bones_found, int& curve_count, int& curves_found)
+    {
+        node_count += 1;
+
+        for (auto i : node->bone_nodes)
+        {
+            bone_count += 1;
+            bones_found += i >= 0 ? 1 : 0;
+        }
+        for (const auto& i : node->curve_nodes)
+        {
+            for (auto j : i)
+            {
+                curve_count += 1;
+                curves_found += j >= 0 ? 1 : 0;
+            }
+        }
+
+        for (const auto& i : node->children)
+        {
+            CountTargets(i.get(), node_count, bone_count, bones_found, curve_count, curves_found);
+        }
+    }
+
+    bool AssetCooking::CookPrefab(const String& input, const String& output, String& info)
+    {
+        if (!File::Exist(input))
+        {
+            printf("file not exist: %s\n", input.CString());
+            return false;
+        }
+
+        Ref<PrefabNode> root;
+        if (!PrefabFile::Load(File::ReadAllBytes(input), root))
+        {
+            printf("invalid prefab file: %s\n", input.CString());
+            return false;
+        }
+
+        PrefabFile::ResolveTargets(root);
+
+        if (!File::WriteAllBytes(output, PrefabFile::Save(root)))
+        {
+            printf("write file failed: %s\n", output.CString());
+            return false;
+        }
+
+        int node_count = 0;
+        int bone_count = 0;
+        int bones_found = 0;
+        int curve_count = 0;
+        int curves_found = 0;
+        CountTargets(root.get(), node_count, bone_count, bones_found, curve_count, curves_found);
+
+        info = String::Format("%s: %d nodes, %d of %d bones and %d of %d curve targets resolved",
+            output.CString(), node_count, bones_found, bone_count, curves_found, curve_count);
+
+        return true;
+    }
+
+    Vector<String> AssetCooking::GetTexDependencies(const String& path)
+    {
+        Vector<String> paths;
+
+        if (!File::Exist(path))
+        {
+            return paths;
+        }
+
+        MemoryStream ms(File::ReadAllBytes(path));
+
+        ReadString(ms); // name
+        ms.Read<int>(); // width
+        ms.Read<int>(); // height
+        ms.Read<int>(); // wrap mode
+        ms.Read<int>(); // filter mode
+        String texture_type = ReadString(ms);
+        int mipmap_count = ms.Read<int>();
+
+        int count = 0;
+        if (texture_type == "Texture2D" || texture_type == "Texture2DRGBFloat")
+        {
+            count = 1;
+        }
+        else if (texture_type == "Cubemap")
+        {
+            count = mipmap_count * 6;
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            String data_path = ReadString(ms);
+            paths.Add(GetAssetRoot(path, data_path) + data_path);
+        }
+
+        return paths;
+    }
+
+    bool AssetCooking::LoadShaderSources(const String& input, const String& include_dir, Vector<ShaderCookSource>& sources)
+    {
+        String text = File::ReadAllText(input);
+
+        Json::Reader reader;
+        Json::Value root;
+        if (!reader.parse(text.CString(), text.CString() + text.Size(), root) || !root.isObject())
+        {
+            printf("invalid shader file: %s %s\n", input.CString(), reader.getFormatedErrorMessages().c_str());
+            return false;
+        }
+
+        static const char* s_stage_names[] = { "vs", "fs", "cs" };
+        static const VkShaderStageFlagBits s_stages[] = { VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT, VK_SHADER_STAGE_COMPUTE_BIT };
+
+        for (int i = 0; i < 3; ++i)
+        {
+            if (!root.isMember(s_stage_names[i]))
+            {
+                continue;
+            }
+
+            const Json::Value& stage = root[s_stage_names[i]];
+            if (!stage.isObject())
+            {
+                printf("invalid shader stage: %s %s\n", input.CString(), s_stage_names[i]);
+                return false;
+            }
+
+            Vector<String> includes;
+            const Json::Value& include_values = stage["includes"];
+            for (Json::Value::UInt j = 0; j < include_values.size(); ++j)
+            {
+                String include = include_values[j].asString().c_str();
+                if (!File::Exist(include_dir + "/" + include))
+                {
+                    printf("shader include not exist: %s %s\n", input.CString(), include.CString());
+                    return false;
+                }
+                includes.Add(include);
+            }
+
+            ShaderCookSource source;
+            source.stage = s_stages[i];
+            source.glsl = Shader::ProcessSource(source.stage, stage["source"].asString().c_str(), stage["predefine"].asString().c_str(), includes, include_dir);
+            sources.Add(source);
+        }
+
+        if (sources.Empty())
+        {
+            printf("shader file has no stage: %s\n", input.CString());
+            return false;
+        }
+
+        return true;
+    }
+
+    bool AssetCooking::CookShader(const Vector<ShaderCookSource>& sources, const String& cache_dir, bool compile, Vector<UniformSet>& uniform_sets, String& info)
+    {
+        Vector<VertexAttribute> attributes;
+        int compiled = 0;
+
+        for (const auto& i : sources)
+        {
+            String path = cache_dir + "/" + Shader::GetSpirvName(i.glsl) + ".spv";
+
+            Vector<unsigned int> spirv;
+            if (!compile && File::Exist(path))
+            {
+                ByteBuffer buffer = File::ReadAllBytes(path);
+                if (buffer.Size() > 0 && buffer.Size() % 4 == 0)
+                {
+                    spirv.Resize(buffer.Size() / 4);
+                    Memory::Copy(&spirv[0], buffer.Bytes(), buffer.Size());
+                }
+            }
+
+            if (spirv.Empty())
+            {
+                String error;
+                if (!GlslToSpv(i.stage, i.glsl.CString(), spirv, error) || spirv.Empty())
+                {
+                    printf("shader compile error: %s\n", error.CString());
+                    return false;
+                }
+
+                ByteBuffer buffer(spirv.SizeInBytes());
+                Memory::Copy(buffer.Bytes(), &spirv[0], buffer.Size());
+                if (!File::WriteAllBytes(path, buffer))
+                {
+                    printf("write file failed: %s\n", path.CString());
+                    return false;
+                }
+                compiled += 1;
+            }
+
+            Shader::Reflect(spirv, i.stage, attributes, uniform_sets);
+        }
+
+        Shader::SortUniformSets(uniform_sets);
+
+        if (compiled > 0)
+        {
+            info = String::Format("%d stages compiled into %s, %d uniform sets", compiled, cache_dir.CString(), uniform_sets.Size());
+        }
+
+        return true;
+    }
+}
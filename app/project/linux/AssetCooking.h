@@ -0,0 +1,67 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "graphics/MipmapGenerator.h"
+#include "graphics/TextureFormat.h"
+#include "graphics/UniformSet.h"
+#include "vulkan/vulkan_include.h"
+#include "container/Vector.h"
+#include "string/String.h"
+
+namespace Viry3D
+{
+    struct TextureCookOptions
+    {
+        TextureFormat format = TextureFormat::BC7;
+        bool mipmaps = true;
+        bool zlib = false;
+        MipmapOptions mipmap_options;
+    };
+
+    struct ShaderCookSource
+    {
+        VkShaderStageFlagBits stage;
+        // processed the way the vulkan backend does, its md5 names the spir-v file
+        String glsl;
+    };
+
+    // conversions shared by the offline tools, safe to run on several threads.
+    // errors are printed, info gets a line describing the output
+    class AssetCooking
+    {
+    public:
+        // png or jpg image, or an exported .tex descriptor with its images, into a ktx or ktx2 file
+        static bool CookTexture(const String& input, const String& output, const TextureCookOptions& options, String& info);
+        // exported .mesh into the binary mesh file
+        static bool CookMesh(const String& input, const String& output, bool zlib, String& info);
+        // exported or cooked .mat into the cooked material file, property slots are resolved when the uniform sets
+        // of its vulkan shader are given
+        static bool CookMaterial(const String& input, const String& output, const Vector<UniformSet>* uniform_sets, String& info);
+        // exported .go into the cooked prefab file with bone and curve target node indices
+        static bool CookPrefab(const String& input, const String& output, String& info);
+        // images and data files a .tex reads
+        static Vector<String> GetTexDependencies(const String& path);
+        // a .shader descriptor, json with "vs", "fs" or "cs" stages that each have the "predefine", "includes" and "source"
+        // the code creates the shader with. includes are read from include_dir
+        static bool LoadShaderSources(const String& input, const String& include_dir, Vector<ShaderCookSource>& sources);
+        // compiles the sources into spir-v files in cache_dir, or reads the files already there when compile is false,
+        // and reflects the uniform sets in the order a material gets them. needs InitShaderCompiler, not thread safe
+        static bool CookShader(const Vector<ShaderCookSource>& sources, const String& cache_dir, bool compile, Vector<UniformSet>& uniform_sets, String& info);
+    };
+}
@@ -0,0 +1,292 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "graphics/Display.h"
+#include "graphics/GpuProfiler.h"
+#include "graphics/RenderStats.h"
+#include "Profiler.h"
+#include "App.h"
+#include "time/Time.h"
+#include "memory/ByteBuffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+extern "C"
+{
+#include "crypto/md5/md5.h"
+}
+
+using namespace Viry3D;
+
+// runs one demo on a headless display and prints cpu time per frame phase, gpu time per camera and md5 of rendered frames.
+// usage: Viry3DBenchmark [--demo 0] [--frames 300] [--warmup 30] [--width 1280] [--height 720]
+//                        [--checksum-interval 0] [--fixed-delta 0.016667] [--trace trace.json]
+// checksum interval 0 hashes the last frame only, fixed delta 0 uses real time.
+// trace writes the cpu zones of the measured frames as chrome trace json.
+
+enum class Phase
+{
+    FrameBegin,
+    Update,
+    Draw,
+    Readback,
+    FrameEnd,
+
+    Count
+};
+
+static const char* g_phase_names[(int) Phase::Count] = {
+    "frame begin",
+    "update",
+    "draw",
+    "gpu wait + readback",
+    "frame end",
+};
+
+struct PhaseStats
+{
+    double total = 0;
+    double min = 0;
+    double max = 0;
+    int count = 0;
+
+    void Add(double ms)
+    {
+        if (count == 0 || ms < min)
+        {
+            min = ms;
+        }
+        if (count == 0 || ms > max)
+        {
+            max = ms;
+        }
+        total += ms;
+        count += 1;
+    }
+};
+
+class PhaseTimer
+{
+public:
+    void Begin()
+    {
+        m_begin = std::chrono::high_resolution_clock::now();
+    }
+
+    double End()
+    {
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - m_begin).count();
+    }
+
+private:
+    std::chrono::high_resolution_clock::time_point m_begin;
+};
+
+static String Checksum(const ByteBuffer& pixels)
+{
+    unsigned char hash_bytes[16];
+    MD5_CTX md5_context;
+    MD5_Init(&md5_context);
+    MD5_Update(&md5_context, (void*) pixels.Bytes(), pixels.Size());
+    MD5_Final(hash_bytes, &md5_context);
+
+    String str;
+    for (int i = 0; i < 16; ++i)
+    {
+        str += String::Format("%02x", hash_bytes[i]);
+    }
+    return str;
+}
+
+int main(int argc, char* argv[])
+{
+    String name = "viry3d-benchmark";
+    int demo = 0;
+    int frame_count = 300;
+    int warmup_count = 30;
+    int width = 1280;
+    int height = 720;
+    int checksum_interval = 0;
+    float fixed_delta = 1.0f / 60;
+    String trace_path;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const char* key = argv[i];
+        const char* value = argv[i + 1];
+
+        if (strcmp(key, "--demo") == 0)
+        {
+            demo = atoi(value);
+        }
+        else if (strcmp(key, "--frames") == 0)
+        {
+            frame_count = atoi(value);
+        }
+        else if (strcmp(key, "--warmup") == 0)
+        {
+            warmup_count = atoi(value);
+        }
+        else if (strcmp(key, "--width") == 0)
+        {
+            width = atoi(value);
+        }
+        else if (strcmp(key, "--height") == 0)
+        {
+            height = atoi(value);
+        }
+        else if (strcmp(key, "--checksum-interval") == 0)
+        {
+            checksum_interval = atoi(value);
+        }
+        else if (strcmp(key, "--fixed-delta") == 0)
+        {
+            fixed_delta = (float) atof(value);
+        }
+        else if (strcmp(key, "--trace") == 0)
+        {
+            trace_path = value;
+        }
+        else
+        {
+            printf("unknown option: %s\n", key);
+            return 1;
+        }
+    }
+
+    Time::SetFixedDeltaTime(fixed_delta);
+
+    Display* display = new Display(name, nullptr, width, height, true);
+
+    App* app = new App();
+    app->SetName(name);
+    app->Init();
+    app->RunDemo(demo);
+
+    GpuProfiler::SetHistorySize(frame_count > 0 ? frame_count : 1);
+
+    PhaseStats stats[(int) Phase::Count];
+    double render_stats[(int) RenderStat::Count] = { 0 };
+    PhaseTimer timer;
+    ByteBuffer pixels;
+    auto run_begin = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < warmup_count + frame_count; ++i)
+    {
+        bool measure = i >= warmup_count;
+        int frame = i - warmup_count;
+        double ms[(int) Phase::Count] = { 0 };
+
+        if (frame == 0)
+        {
+            run_begin = std::chrono::high_resolution_clock::now();
+            GpuProfiler::SetEnabled(true);
+            Profiler::SetEnabled(!trace_path.Empty());
+        }
+
+        timer.Begin();
+        app->OnFrameBegin();
+        ms[(int) Phase::FrameBegin] = timer.End();
+
+        timer.Begin();
+        app->Update();
+        ms[(int) Phase::Update] = timer.End();
+
+        if (app->HasQuit())
+        {
+            break;
+        }
+
+        timer.Begin();
+        display->OnDraw();
+        ms[(int) Phase::Draw] = timer.End();
+
+        bool checksum = measure && (frame == frame_count - 1 || (checksum_interval > 0 && frame % checksum_interval == 0));
+        if (checksum)
+        {
+            timer.Begin();
+            display->ReadHeadlessImage(pixels);
+            ms[(int) Phase::Readback] = timer.End();
+
+            printf("frame %d checksum %s\n", frame, Checksum(pixels).CString());
+        }
+
+        timer.Begin();
+        app->OnFrameEnd();
+        ms[(int) Phase::FrameEnd] = timer.End();
+
+        if (measure)
+        {
+            for (int j = 0; j < (int) Phase::Count; ++j)
+            {
+                if (j != (int) Phase::Readback || checksum)
+                {
+                    stats[j].Add(ms[j]);
+                }
+            }
+
+            for (int j = 0; j < (int) RenderStat::Count; ++j)
+            {
+                render_stats[j] += RenderStats::Get((RenderStat) j);
+            }
+        }
+    }
+
+    display->WaitDevice();
+
+    auto run_end = std::chrono::high_resolution_clock::now();
+    double run_ms = std::chrono::duration<double, std::milli>(run_end - run_begin).count();
+    int measured = stats[(int) Phase::Draw].count;
+
+    printf("demo %d, %dx%d, %d frames in %.2f ms, %.2f ms/frame\n", demo, width, height, measured, run_ms, measured > 0 ? run_ms / measured : 0.0);
+    printf("%-22s %10s %10s %10s %8s\n", "phase", "avg ms", "min ms", "max ms", "count");
+    for (int i = 0; i < (int) Phase::Count; ++i)
+    {
+        const PhaseStats& s = stats[i];
+        printf("%-22s %10.3f %10.3f %10.3f %8d\n", g_phase_names[i], s.count > 0 ? s.total / s.count : 0.0, s.min, s.max, s.count);
+    }
+
+    GpuFrameTiming gpu = GpuProfiler::GetAverageFrame();
+    printf("gpu frame avg ms %.3f\n", gpu.ms);
+    for (int i = 0; i < gpu.passes.Size(); ++i)
+    {
+        printf("    %-32s %10.3f\n", gpu.passes[i].name.CString(), gpu.passes[i].ms);
+    }
+
+    if (!trace_path.Empty())
+    {
+        Profiler::SetEnabled(false);
+        if (!Profiler::SaveChromeTrace(trace_path))
+        {
+            printf("write trace failed: %s\n", trace_path.CString());
+        }
+    }
+
+    printf("render stats avg per frame\n");
+    for (int i = 0; i < (int) RenderStat::Count; ++i)
+    {
+        printf("    %-32s %10.1f\n", RenderStats::GetName((RenderStat) i), measured > 0 ? render_stats[i] / measured : 0.0);
+    }
+
+    delete app;
+    delete display;
+
+    return 0;
+}
@@ -0,0 +1,63 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "AssetCooking.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace Viry3D;
+
+// converts an exported .mesh into the binary mesh file, whose vertex and index blocks load without conversion.
+// usage: Viry3DMeshConverter input.mesh output.mesh [--zlib 0]
+// the output keeps the .mesh extension, Mesh::LoadFromFile detects the version, so it can replace the input.
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        printf("usage: Viry3DMeshConverter input.mesh output.mesh [--zlib 0]\n");
+        return 1;
+    }
+
+    String input = argv[1];
+    String output = argv[2];
+    bool zlib = false;
+
+    for (int i = 3; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--zlib") == 0)
+        {
+            zlib = atoi(argv[i + 1]) != 0;
+        }
+        else
+        {
+            printf("unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    String info;
+    if (!AssetCooking::CookMesh(input, output, zlib, info))
+    {
+        return 1;
+    }
+
+    printf("%s\n", info.CString());
+
+    return 0;
+}
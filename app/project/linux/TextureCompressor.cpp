@@ -0,0 +1,99 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "AssetCooking.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace Viry3D;
+
+// compresses a png or jpg image, or an exported .tex descriptor with its images, into a ktx or ktx2 file.
+// usage: Viry3DTextureCompressor input.png|input.tex output.ktx|output.ktx2 [--format BC7] [--mipmaps 1] [--zlib 0]
+//                                 [--mip-filter box|kaiser] [--srgb 0] [--alpha-cutoff 0]
+// formats: R8G8B8A8 BC1 BC3 BC4 BC5 BC7 ETC2_R8G8B8 ETC2_R8G8B8A8, mipmaps go down to 1x1.
+// srgb filters color in linear space, alpha cutoff keeps the alpha test coverage on every mip.
+// .tex cubemaps keep their exported mip chain, float textures are stored as R32G32B32A32F.
+// ktx2 files carry the sampler state of the .tex, and Resources loads a .ktx2 next to a .tex in its place.
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        printf("usage: Viry3DTextureCompressor input.png|input.tex output.ktx|output.ktx2 [--format BC7] [--mipmaps 1] [--zlib 0] [--mip-filter box|kaiser] [--srgb 0] [--alpha-cutoff 0]\n");
+        return 1;
+    }
+
+    String input = argv[1];
+    String output = argv[2];
+    TextureFormat format = TextureFormat::BC7;
+    bool mipmaps = true;
+    bool zlib = false;
+    MipmapOptions mipmap_options;
+
+    for (int i = 3; i + 1 < argc; i += 2)
+    {
+        const char* key = argv[i];
+        const char* value = argv[i + 1];
+
+        if (strcmp(key, "--format") == 0)
+        {
+            format = TextureFormatInfo::FromName(value);
+        }
+        else if (strcmp(key, "--mipmaps") == 0)
+        {
+            mipmaps = atoi(value) != 0;
+        }
+        else if (strcmp(key, "--zlib") == 0)
+        {
+            zlib = atoi(value) != 0;
+        }
+        else if (strcmp(key, "--mip-filter") == 0)
+        {
+            mipmap_options.filter = strcmp(value, "kaiser") == 0 ? MipmapFilter::Kaiser : MipmapFilter::Box;
+        }
+        else if (strcmp(key, "--srgb") == 0)
+        {
+            mipmap_options.srgb = atoi(value) != 0;
+        }
+        else if (strcmp(key, "--alpha-cutoff") == 0)
+        {
+            mipmap_options.alpha_cutoff = (float) atof(value);
+        }
+        else
+        {
+            printf("unknown option: %s\n", key);
+            return 1;
+        }
+    }
+
+    TextureCookOptions options;
+    options.format = format;
+    options.mipmaps = mipmaps;
+    options.zlib = zlib;
+    options.mipmap_options = mipmap_options;
+
+    String info;
+    if (!AssetCooking::CookTexture(input, output, options, info))
+    {
+        return 1;
+    }
+
+    printf("%s\n", info.CString());
+
+    return 0;
+}
@@ -348,4 +348,9 @@ namespace Viry3D
     {
         m_app->Update();
     }
+
+    void App::RunDemo(int index)
+    {
+        m_app->ClickDemo(index);
+    }
 }
@@ -30,6 +30,7 @@ namespace Viry3D
         virtual ~App();
         virtual void Init();
         virtual void Update();
+        void RunDemo(int index);
 
     private:
         AppImplement* m_app;
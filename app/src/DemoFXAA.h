@@ -20,6 +20,7 @@
 #include "DemoMesh.h"
 #include "ui/SwitchButton.h"
 #include "ui/SelectButton.h"
+#include "graphics/RenderGraph.h"
 
 #define FXAA_QUALITY_FAST		10
 #define FXAA_QUALITY_DEFAULT	12
@@ -31,7 +32,7 @@ namespace Viry3D
     class DemoFXAA : public DemoMesh
     {
     public:
-        Camera* m_blit_camera = nullptr;
+        Ref<RenderGraph> m_render_graph;
         int m_target_quality = 1;
 
         void InitRenderTexture()
@@ -44,23 +45,15 @@ namespace Viry3D
             };
             int quality = qualities[m_target_quality];
 
-            auto color_texture = Texture::CreateRenderTexture(
-                Display::Instance()->GetWidth(),
-                Display::Instance()->GetHeight(),
-                TextureFormat::R8G8B8A8,
-                1,
-                true,
-                FilterMode::Linear,
-                SamplerAddressMode::ClampToEdge);
-            auto depth_texture = Texture::CreateRenderTexture(
-                Display::Instance()->GetWidth(),
-                Display::Instance()->GetHeight(),
-                Texture::ChooseDepthFormatSupported(true),
-                1,
-                true,
-                FilterMode::Linear,
-                SamplerAddressMode::ClampToEdge);
-            m_camera->SetRenderTarget(color_texture, depth_texture);
+            m_render_graph = RefMake<RenderGraph>();
+
+            RenderGraphTextureDesc color_desc;
+            RenderGraphTextureDesc depth_desc;
+            depth_desc.format = Texture::ChooseDepthFormatSupported(true);
+
+            int color = m_render_graph->CreateTexture("SceneColor", color_desc);
+            int depth = m_render_graph->CreateTexture("SceneDepth", depth_desc);
+            m_render_graph->AddCameraPass("Scene", m_camera, color, depth);
 
             RenderState render_state;
             render_state.cull = RenderState::Cull::Off;
@@ -205,9 +198,10 @@ void main()
             material->SetVector("u_rcp_frame", Vector4(1.0f / Display::Instance()->GetWidth(), 1.0f / Display::Instance()->GetHeight()));
 
             // color -> window
-            m_blit_camera = Display::Instance()->CreateBlitCamera(1, color_texture, material);
+            m_render_graph->AddBlitPass("FXAA", color, m_render_graph->GetBackBuffer(), material);
+            m_render_graph->Compile();
 
-            m_ui_camera->SetDepth(2);
+            m_ui_camera->SetDepth(m_render_graph->GetNextDepth());
         }
 
         void InitUI()
@@ -286,20 +280,14 @@ void main()
         {
             if (on)
             {
-                if (m_blit_camera == nullptr)
+                if (!m_render_graph)
                 {
                     this->InitRenderTexture();
                 }
             }
             else
             {
-                m_camera->SetRenderTarget(Ref<Texture>(), Ref<Texture>());
-                
-                if (m_blit_camera)
-                {
-                    Display::Instance()->DestroyCamera(m_blit_camera);
-                    m_blit_camera = nullptr;
-                }
+                m_render_graph.reset();
             }
         }
 
@@ -307,10 +295,9 @@ void main()
         {
             m_target_quality = index;
 
-            if (m_blit_camera)
+            if (m_render_graph)
             {
-                Display::Instance()->DestroyCamera(m_blit_camera);
-                m_blit_camera = nullptr;
+                m_render_graph.reset();
                 this->InitRenderTexture();
             }
         }
@@ -325,11 +312,7 @@ void main()
 
         virtual void Done()
         {
-            if (m_blit_camera)
-            {
-                Display::Instance()->DestroyCamera(m_blit_camera);
-                m_blit_camera = nullptr;
-            }
+            m_render_graph.reset();
 
             DemoMesh::Done();
         }
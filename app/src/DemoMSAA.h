@@ -39,23 +39,13 @@ namespace Viry3D
                 m_sample_count_target = m_max_sample_count;
             }
 
-            auto color_texture = Texture::CreateRenderTexture(
+            m_camera->AcquireRenderTarget(
                 Display::Instance()->GetWidth(),
                 Display::Instance()->GetHeight(),
                 TextureFormat::R8G8B8A8,
-                m_sample_count,
-                true,
-                FilterMode::Linear,
-                SamplerAddressMode::ClampToEdge);
-            auto depth_texture = Texture::CreateRenderTexture(
-                Display::Instance()->GetWidth(),
-                Display::Instance()->GetHeight(),
                 Texture::ChooseDepthFormatSupported(true),
-                m_sample_count,
-                true,
-                FilterMode::Linear,
-                SamplerAddressMode::ClampToEdge);
-            m_camera->SetRenderTarget(color_texture, depth_texture);
+                m_sample_count);
+            auto color_texture = m_camera->GetRenderTargetColor();
 
             // color -> window
             m_blit_camera = Display::Instance()->CreateBlitCamera(1, color_texture);
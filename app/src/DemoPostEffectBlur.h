@@ -19,6 +19,7 @@
 
 #include "DemoMesh.h"
 #include "ui/Slider.h"
+#include "graphics/RenderGraph.h"
 #include "Debug.h"
 
 namespace Viry3D
@@ -26,7 +27,7 @@ namespace Viry3D
     class DemoPostEffectBlur : public DemoMesh
     {
     public:
-        Vector<Camera*> m_blit_cameras;
+        Ref<RenderGraph> m_render_graph;
         int m_downsample = 2;
         float m_texel_offset = 1.6f;
         int m_iter_count = 3;
@@ -50,41 +51,17 @@ namespace Viry3D
                 return;
             }
 
-            auto color_texture = Texture::CreateRenderTexture(
-                Display::Instance()->GetWidth(),
-                Display::Instance()->GetHeight(),
-                TextureFormat::R8G8B8A8,
-                1,
-                true,
-                FilterMode::Linear,
-                SamplerAddressMode::ClampToEdge);
-            auto depth_texture = Texture::CreateRenderTexture(
-                Display::Instance()->GetWidth(),
-                Display::Instance()->GetHeight(),
-                Texture::ChooseDepthFormatSupported(true),
-                1,
-                true,
-                FilterMode::Linear,
-                SamplerAddressMode::ClampToEdge);
-            m_camera->SetRenderTarget(color_texture, depth_texture);
-
-            // blur
-            auto color_texture_2 = Texture::CreateRenderTexture(
-                width,
-                height,
-                TextureFormat::R8G8B8A8,
-                1,
-                true,
-                FilterMode::Linear,
-                SamplerAddressMode::ClampToEdge);
-            auto color_texture_3 = Texture::CreateRenderTexture(
-                width,
-                height,
-                TextureFormat::R8G8B8A8,
-                1,
-                true,
-                FilterMode::Linear,
-                SamplerAddressMode::ClampToEdge);
+            m_render_graph = RefMake<RenderGraph>();
+
+            RenderGraphTextureDesc color_desc;
+            RenderGraphTextureDesc depth_desc;
+            depth_desc.format = Texture::ChooseDepthFormatSupported(true);
+            RenderGraphTextureDesc blur_desc;
+            blur_desc.downsample = m_downsample;
+
+            int color = m_render_graph->CreateTexture("SceneColor", color_desc);
+            int depth = m_render_graph->CreateTexture("SceneDepth", depth_desc);
+            m_render_graph->AddCameraPass("Scene", m_camera, color, depth);
 
 #if VR_VULKAN
             String vs = R"(
@@ -183,37 +160,34 @@ void main()
                 fs,
                 render_state);
 
-            int camera_depth = 1;
-
-            // color -> color2, down sample
-            auto blit_color_camera = Display::Instance()->CreateBlitCamera(camera_depth++, color_texture);
-            blit_color_camera->SetRenderTarget(color_texture_2, Ref<Texture>());
-            m_blit_cameras.Add(blit_color_camera);
+            // color -> blur, down sample
+            int blur = m_render_graph->CreateTexture("Downsample", blur_desc);
+            m_render_graph->AddBlitPass("Downsample", color, blur);
 
             for (int i = 0; i < m_iter_count; ++i)
             {
-                // color2 -> color, h blur
+                // h blur
                 auto material_h = RefMake<Material>(shader);
                 material_h->SetVector("u_texel_size", Vector4(1.0f / width * m_texel_offset * (1.0f + i * m_iter_step), 0, 0, 0));
 
-                blit_color_camera = Display::Instance()->CreateBlitCamera(camera_depth++, color_texture_2, material_h);
-                blit_color_camera->SetRenderTarget(color_texture, Ref<Texture>());
-                m_blit_cameras.Add(blit_color_camera);
+                int blur_h = m_render_graph->CreateTexture(String::Format("BlurH%d", i), blur_desc);
+                m_render_graph->AddBlitPass(String::Format("BlurH%d", i), blur, blur_h, material_h);
 
-                // color -> color2, v blur
+                // v blur
                 auto material_v = RefMake<Material>(shader);
                 material_v->SetVector("u_texel_size", Vector4(0, 1.0f / height * m_texel_offset * (1.0f + i * m_iter_step), 0, 0));
 
-                blit_color_camera = Display::Instance()->CreateBlitCamera(camera_depth++, color_texture, material_v);
-                blit_color_camera->SetRenderTarget(color_texture_2, Ref<Texture>());
-                m_blit_cameras.Add(blit_color_camera);
+                int blur_v = m_render_graph->CreateTexture(String::Format("BlurV%d", i), blur_desc);
+                m_render_graph->AddBlitPass(String::Format("BlurV%d", i), blur_h, blur_v, material_v);
+
+                blur = blur_v;
             }
 
-            // color -> window
-            blit_color_camera = Display::Instance()->CreateBlitCamera(camera_depth++, color_texture_2);
-            m_blit_cameras.Add(blit_color_camera);
+            // blur -> window
+            m_render_graph->AddBlitPass("Present", blur, m_render_graph->GetBackBuffer());
+            m_render_graph->Compile();
 
-            m_ui_camera->SetDepth(camera_depth++);
+            m_ui_camera->SetDepth(m_render_graph->GetNextDepth());
         }
 
         void InitUI()
@@ -312,11 +286,7 @@ void main()
 
         virtual void Done()
         {
-            for (auto i : m_blit_cameras)
-            {
-                Display::Instance()->DestroyCamera(i);
-            }
-            m_blit_cameras.Clear();
+            m_render_graph.reset();
 
             DemoMesh::Done();
         }
@@ -335,13 +305,7 @@ void main()
                 m_iter_count = m_iter_count_target;
                 m_iter_step = m_iter_step_target;
 
-                m_camera->SetRenderTarget(Ref<Texture>(), Ref<Texture>());
-
-                for (auto i : m_blit_cameras)
-                {
-                    Display::Instance()->DestroyCamera(i);
-                }
-                m_blit_cameras.Clear();
+                m_render_graph.reset();
 
                 this->InitPostEffectBlur();
             }
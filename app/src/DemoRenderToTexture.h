@@ -29,23 +29,14 @@ namespace Viry3D
 
         void InitRenderTexture()
         {
-            auto color_texture = Texture::CreateRenderTexture(
+            m_camera->AcquireRenderTarget(
                 Display::Instance()->GetWidth(),
                 Display::Instance()->GetHeight(),
                 TextureFormat::R8G8B8A8,
-                1,
-                true,
-                FilterMode::Linear,
-                SamplerAddressMode::ClampToEdge);
-            auto depth_texture = Texture::CreateRenderTexture(
-                Display::Instance()->GetWidth(),
-                Display::Instance()->GetHeight(),
                 Texture::ChooseDepthFormatSupported(true),
-                1,
-                true,
-                FilterMode::Nearest,
-                SamplerAddressMode::ClampToEdge);
-            m_camera->SetRenderTarget(color_texture, depth_texture);
+                1);
+            auto color_texture = m_camera->GetRenderTargetColor();
+            auto depth_texture = m_camera->GetRenderTargetDepth();
 
             // depth -> color
             m_blit_depth_camera = Display::Instance()->CreateBlitCamera(1, depth_texture, Ref<Material>(), "", CameraClearFlags::Nothing, Rect(0.75f, 0, 0.25f, 0.25f));
@@ -28,147 +28,42 @@ namespace Viry3D
     public:
         struct ShadowParam
         {
-            float ortho_size;
-            float near_clip;
-            float far_clip;
+            int cascade_count;
+            float distance;
+            float split_lambda;
         };
         ShadowParam m_shadow_param = {
-            2.0f,
-            -5,
-            5
+            SHADOW_CASCADE_MAX,
+            20,
+            0.75f
         };
 
-        Camera* m_shadow_camera = nullptr;
         Camera* m_blit_depth_camera = nullptr;
-        Vector<Ref<MeshRenderer>> m_shadow_renderers;
-        Ref<Texture> m_shadow_texture;
-        Matrix4x4 m_light_view_projection_matrix;
 
         void InitShadowCaster()
         {
-            m_camera->SetDepth(1);
-            m_ui_camera->SetDepth(2);
-
-            m_shadow_texture = Texture::CreateRenderTexture(
-                SHADOW_MAP_SIZE,
-                SHADOW_MAP_SIZE,
-                Texture::ChooseDepthFormatSupported(true),
-                1,
-                true,
-                FilterMode::Nearest,
-                SamplerAddressMode::ClampToEdge);
-
-            m_shadow_camera = Display::Instance()->CreateCamera();
-            m_shadow_camera->SetDepth(0);
-            m_shadow_camera->SetClearFlags(CameraClearFlags::Depth);
-            m_shadow_camera->SetRenderTarget(Ref<Texture>(), m_shadow_texture);
-            m_shadow_camera->SetLocalPosition(m_light->GetPosition());
-            m_shadow_camera->SetLocalRotation(m_light->GetRotation());
-            
-#if VR_GLES
-            bool mac = false;
-#if VR_MAC
-            mac = true;
-#elif VR_WASM
-            mac = Display::Instance()->GetPlatform() == Display::Platform::Mac;
-#endif
-
-            // MARK:
-            // mac gl / webgl framebuffer need a color attachment
-            if (mac)
-            {
-                Ref<Texture> shadow_color_texture = Texture::CreateRenderTexture(
-                    SHADOW_MAP_SIZE,
-                    SHADOW_MAP_SIZE,
-                    TextureFormat::R8G8B8A8,
-                    1,
-                    false,
-                    FilterMode::None,
-                    SamplerAddressMode::None);
-                m_shadow_camera->SetRenderTarget(shadow_color_texture, m_shadow_texture);
-            }
-#endif
-
-            m_shadow_camera->SetNearClip(m_shadow_param.near_clip);
-            m_shadow_camera->SetFarClip(m_shadow_param.far_clip);
-            m_shadow_camera->SetOrthographic(true);
-            m_shadow_camera->SetOrthographicSize(m_shadow_param.ortho_size);
-
-            RenderState render_state;
-            render_state.cull = RenderState::Cull::Front;
-
-#if VR_VULKAN
-            auto shader = RefMake<Shader>(
-                "#define CAST_SHADOW 1",
-                Vector<String>({ "Diffuse.vs.in" }),
-                "",
-                "#define CAST_SHADOW 1",
-                Vector<String>({ "Diffuse.fs.in" }),
-                "",
-                render_state);
-            auto skin_shader = RefMake<Shader>(
-                "#define CAST_SHADOW 1\n"
-                "#define SKINNED_MESH 1",
-                Vector<String>({ "Skin.in", "Diffuse.vs.in" }),
-                "",
-                "#define CAST_SHADOW 1",
-                Vector<String>({ "Diffuse.fs.in" }),
-                "",
-                render_state);
-#elif VR_GLES
-            auto shader = RefMake<Shader>(
-                "#define CAST_SHADOW 1",
-                Vector<String>({ "Diffuse.100.vs.in" }),
-                "",
-                "#define CAST_SHADOW 1",
-                Vector<String>({ "Diffuse.100.fs.in" }),
-                "",
-                render_state);
-            auto skin_shader = RefMake<Shader>(
-                "#define CAST_SHADOW 1\n"
-                "#define SKINNED_MESH 1",
-                Vector<String>({ "Diffuse.100.vs.in" }),
-                "",
-                "#define CAST_SHADOW 1",
-                Vector<String>({ "Diffuse.100.fs.in" }),
-                "",
-                render_state);
-#endif
-
-            auto material = RefMake<Material>(shader);
-            auto skin_material = RefMake<Material>(skin_shader);
-
-            m_light_view_projection_matrix = m_shadow_camera->GetProjectionMatrix() * m_shadow_camera->GetViewMatrix();
-
-            m_shadow_renderers.Resize(m_renderers.Size());
-            for (int i = 0; i < m_shadow_renderers.Size(); ++i)
+            for (int i = 0; i < m_renderers.Size(); ++i)
             {
-                Ref<MeshRenderer> shadow_mesh;
                 Ref<SkinnedMeshRenderer> skin = RefCast<SkinnedMeshRenderer>(m_renderers[i]);
                 if (skin)
                 {
-                    Ref<SkinnedMeshRenderer> shadow_skin = RefMake<SkinnedMeshRenderer>();
-                    shadow_skin->SetBonePaths(skin->GetBonePaths());
-                    shadow_skin->SetBonesRoot(skin->GetBonesRoot());
-                    shadow_mesh = shadow_skin;
-                    shadow_mesh->SetMaterial(skin_material);
-                }
-                else
-                {
-                    shadow_mesh = RefMake<MeshRenderer>();
-                    shadow_mesh->SetMaterial(material);
+                    // skinned once in the pre-pass, every cascade draws the same vertices
+                    skin->SetSkinningPrePass(true);
                 }
-                
-                shadow_mesh->SetMesh(m_renderers[i]->GetMesh(), m_renderers[i]->GetSubmesh());
-                shadow_mesh->SetLocalPosition(m_renderers[i]->GetPosition());
-                shadow_mesh->SetLocalRotation(m_renderers[i]->GetRotation());
-                shadow_mesh->SetLocalScale(m_renderers[i]->GetScale());
-
-                m_shadow_renderers[i] = shadow_mesh;
-                m_shadow_camera->AddRenderer(shadow_mesh);
             }
 
-            m_blit_depth_camera = Display::Instance()->CreateBlitCamera(3, m_shadow_texture, Ref<Material>(), "", CameraClearFlags::Nothing, Rect(0.75f, 0, 0.25f, 0.25f));
+            m_light->SetShadowCascadeCount(m_shadow_param.cascade_count);
+            m_light->SetShadowMapSize(SHADOW_MAP_SIZE);
+            m_light->SetShadowDistance(m_shadow_param.distance);
+            m_light->SetShadowSplitLambda(m_shadow_param.split_lambda);
+            m_light->SetShadowStrength(1.0f);
+            m_light->SetShadowZBias(0.0f);
+            m_light->SetShadowSlopeBias(0.0001f);
+            m_light->SetShadowFilterRadius(3.0f);
+            m_light->EnableShadow(true);
+            m_light->UpdateShadow(m_camera);
+
+            m_blit_depth_camera = Display::Instance()->CreateBlitCamera(2, m_light->GetShadowTexture(), Ref<Material>(), "", CameraClearFlags::Nothing, Rect(0.75f, 0, 0.25f, 0.25f));
         }
 
         void InitShadowReciever()
@@ -184,15 +79,6 @@ namespace Viry3D
                 Vector<String>({ "Shadow.in", "Diffuse.fs.in" }),
                 "",
                 render_state);
-            auto skin_shader = RefMake<Shader>(
-                "#define RECIEVE_SHADOW 1\n"
-                "#define SKINNED_MESH 1",
-                Vector<String>({ "Skin.in", "Diffuse.vs.in" }),
-                "",
-                "#define RECIEVE_SHADOW 1",
-                Vector<String>({ "Shadow.in", "Diffuse.fs.in" }),
-                "",
-                render_state);
 #elif VR_GLES
             auto shader = RefMake<Shader>(
                 "#define RECIEVE_SHADOW 1",
@@ -203,58 +89,30 @@ namespace Viry3D
                 Vector<String>({ "Shadow.in", "Diffuse.100.fs.in" }),
                 "",
                 render_state);
-            auto skin_shader = RefMake<Shader>(
-                "#define RECIEVE_SHADOW 1\n"
-                "#define SKINNED_MESH 1",
-                Vector<String>({ "Diffuse.100.vs.in" }),
-                "",
-                "#define RECIEVE_SHADOW 1\n"
-                "#define VERSION_100_ES 1",
-                Vector<String>({ "Shadow.in", "Diffuse.100.fs.in" }),
-                "",
-                render_state);
 #endif
 
             for (int i = 0; i < m_renderers.Size(); ++i)
             {
                 auto material = m_renderers[i]->GetMaterial();
-
-                Ref<SkinnedMeshRenderer> skin = RefCast<SkinnedMeshRenderer>(m_renderers[i]);
-                if (skin)
-                {
-                    material->SetShader(skin_shader);
-                }
-                else
-                {
-                    material->SetShader(shader);
-                }
-
-                material->SetTexture("u_shadow_texture", m_shadow_texture);
-                material->SetMatrix("u_light_view_projection_matrix", m_light_view_projection_matrix);
-                material->SetFloat("u_shadow_strength", 1.0f);
-                material->SetFloat("u_shadow_z_bias", 0.000f);
-                material->SetFloat("u_shadow_slope_bias", 0.0001f);
-                material->SetFloat("u_shadow_filter_radius", 1.0f / SHADOW_MAP_SIZE * 3);
+                material->SetShader(shader);
             }
         }
 
-        virtual void Init()
+        virtual void OnSkinnedMeshLoaded()
         {
-            DemoSkinnedMesh::Init();
-
-            this->InitShadowCaster();
             this->InitShadowReciever();
+            this->InitShadowCaster();
         }
 
         virtual void Done()
         {
-            m_shadow_texture.reset();
-            m_shadow_renderers.Clear();
+            if (m_blit_depth_camera)
+            {
+                Display::Instance()->DestroyCamera(m_blit_depth_camera);
+                m_blit_depth_camera = nullptr;
+            }
 
-            Display::Instance()->DestroyCamera(m_shadow_camera);
-            m_shadow_camera = nullptr;
-            Display::Instance()->DestroyCamera(m_blit_depth_camera);
-            m_blit_depth_camera = nullptr;
+            m_light->EnableShadow(false);
 
             DemoSkinnedMesh::Done();
         }
@@ -262,6 +120,11 @@ namespace Viry3D
         virtual void Update()
         {
             DemoSkinnedMesh::Update();
+
+            if (m_blit_depth_camera)
+            {
+                m_light->UpdateShadow(m_camera);
+            }
         }
     };
 }
@@ -39,6 +39,7 @@ namespace Viry3D
     public:
         Ref<Animation> m_anim;
         Vector<int> m_clips;
+        bool m_async_load_complete = false;
 
         void InitSkinnedMesh()
         {
@@ -67,45 +68,55 @@ namespace Viry3D
             
             Shader::AddCache("SkinnedMesh/Diffuse", shader);
 
-            // load skinned mesh with animation
-            auto node = Resources::Load("res/model/ToonSoldier 1/ToonSoldier 1.go");
-            m_anim = RefCast<Animation>(node);
+            // load skinned mesh with animation, textures and meshes decode on the thread pool
+            Resources::LoadAsync("res/model/ToonSoldier 1/ToonSoldier 1.go", [this](const Ref<Node>& node) {
+                m_async_load_complete = true;
+                m_anim = RefCast<Animation>(node);
+                if (!m_anim)
+                {
+                    return;
+                }
 
-            auto skin = RefCast<SkinnedMeshRenderer>(m_anim->Find("MESH_Infantry"));
-            skin->GetMaterial()->SetLightProperties(m_light);
+                auto skin = RefCast<SkinnedMeshRenderer>(m_anim->Find("MESH_Infantry"));
+                skin->GetMaterial()->SetLightProperties(m_light);
 
-            // add to camera
-            m_camera->AddRenderer(skin);
-            m_renderers.Add(skin);
+                // add to camera
+                m_camera->AddRenderer(skin);
+                m_renderers.Add(skin);
             
-            m_anim->SetLocalPosition(Vector3(0, 0, -0.5f));
-            m_anim->SetLocalRotation(Quaternion::Euler(0, 90, 0));
+                m_anim->SetLocalPosition(Vector3(0, 0, -0.5f));
+                m_anim->SetLocalRotation(Quaternion::Euler(0, 90, 0));
 
-            // play animation clip
-            m_clips.Resize((int) ClipIndex::Count, -1);
+                // play animation clip
+                m_clips.Resize((int) ClipIndex::Count, -1);
 
-            int clip_count = m_anim->GetClipCount();
-            for (int i = 0; i < clip_count; ++i)
-            {
-                const String& name = m_anim->GetClipName(i);
-
-                if (name == "assault_combat_idle")
+                int clip_count = m_anim->GetClipCount();
+                for (int i = 0; i < clip_count; ++i)
                 {
-                    m_clips[(int) ClipIndex::Idle] = i;
+                    const String& name = m_anim->GetClipName(i);
+
+                    if (name == "assault_combat_idle")
+                    {
+                        m_clips[(int) ClipIndex::Idle] = i;
+                    }
+                    else if (name == "assault_combat_run")
+                    {
+                        m_clips[(int) ClipIndex::Run] = i;
+                    }
+                    else if (name == "assault_combat_shoot")
+                    {
+                        m_clips[(int) ClipIndex::Shoot] = i;
+                    }
                 }
-                else if (name == "assault_combat_run")
-                {
-                    m_clips[(int) ClipIndex::Run] = i;
-                }
-                else if (name == "assault_combat_shoot")
-                {
-                    m_clips[(int) ClipIndex::Shoot] = i;
-                }
-            }
 
-            m_anim->Play(m_clips[(int) ClipIndex::Idle], 0.3f);
+                m_anim->Play(m_clips[(int) ClipIndex::Idle], 0.3f);
+
+                this->OnSkinnedMeshLoaded();
+            });
         }
 
+        virtual void OnSkinnedMeshLoaded() { }
+
         virtual void Init()
         {
             DemoMesh::Init();
@@ -113,6 +124,11 @@ namespace Viry3D
             this->InitSkinnedMesh();
         }
 
+        virtual bool IsInitComplete() const
+        {
+            return m_async_load_complete;
+        }
+
         virtual void Done()
         {
             m_anim.reset();
@@ -124,6 +140,11 @@ namespace Viry3D
         {
             DemoMesh::Update();
 
+            if (!m_anim)
+            {
+                return;
+            }
+
             if (Input::GetTouchCount() > 0)
             {
                 const Touch& touch = Input::GetTouch(0);
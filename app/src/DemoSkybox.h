@@ -18,6 +18,8 @@
 #pragma once
 
 #include "DemoMesh.h"
+#include "graphics/Image.h"
+#include "io/File.h"
 
 namespace Viry3D
 {
@@ -132,13 +134,22 @@ void main()
             Thread::Task task;
             task.job = []() {
                 auto cubemap = Texture::CreateCubemap(1024, TextureFormat::R8G8B8A8, FilterMode::Linear, SamplerAddressMode::ClampToEdge, false);
+
+                // faces decode in parallel into one buffer
+                const int face_size = 1024 * 1024 * 4;
+                Vector<ByteBuffer> files(6);
+                Vector<byte*> faces(6);
+                ByteBuffer pixels(face_size * 6);
+                for (int i = 0; i < 6; ++i)
+                {
+                    files[i] = File::ReadAllBytes(String::Format((Application::Instance()->GetDataPath() + "/texture/dawn/%d.png").CString(), i));
+                    faces[i] = &pixels[face_size * i];
+                }
+                Image::DecodeBatch(files, faces, true);
+
                 for (int i = 0; i < 6; ++i)
                 {
-                    int width;
-                    int height;
-                    int bpp;
-                    ByteBuffer pixels = Texture::LoadImageFromFile(String::Format((Application::Instance()->GetDataPath() + "/texture/dawn/%d.png").CString(), i), width, height, bpp);
-                    cubemap->UpdateCubemap(pixels, (CubemapFace) i, 0);
+                    cubemap->UpdateCubemap(ByteBuffer(faces[i], face_size), (CubemapFace) i, 0);
                 }
                 return cubemap;
             };
@@ -17,15 +17,24 @@
 
 #include "Application.h"
 #include "Input.h"
+#include "Resources.h"
 #include "container/List.h"
 #include "thread/ThreadPool.h"
 #include "time/Time.h"
 #include "graphics/Display.h"
 #include "graphics/Shader.h"
 #include "graphics/Texture.h"
+#include "graphics/BonePalette.h"
+#include "graphics/SkinningPrePass.h"
+#include "graphics/RenderTexturePool.h"
+#include "graphics/TextureStreamer.h"
+#include "graphics/GpuProfiler.h"
+#include "graphics/RenderStats.h"
 #include "ui/Font.h"
 #include "audio/AudioManager.h"
+#include "io/FileSystem.h"
 #include "Debug.h"
+#include "Profiler.h"
 
 #if VR_WINDOWS
 #include <Windows.h>
@@ -35,6 +44,9 @@
 #import <Cocoa/Cocoa.h>
 #elif VR_ANDROID
 #include "android/jni.h"
+#elif VR_LINUX
+#include <unistd.h>
+#include <limits.h>
 #endif
 
 namespace Viry3D
@@ -58,6 +70,7 @@ namespace Viry3D
             m_quit(false)
         {
             m_app = app;
+            Profiler::SetThreadName("Main");
 #if !VR_WASM
             m_thread_pool = RefMake<ThreadPool>(8);
 #if VR_GLES
@@ -67,7 +80,8 @@ namespace Viry3D
                 },
                 []() {
                     Display::Instance()->UnbindSharedContext();
-                });
+                },
+                "Resource");
 #endif
 #endif
             Font::Init();
@@ -77,13 +91,22 @@ namespace Viry3D
         ~ApplicationPrivate()
         {
             AudioManager::Done();
+            RenderStats::Done();
             Font::Done();
+            Resources::Done();
+            RenderTexturePool::Done();
+            TextureStreamer::Done();
+            GpuProfiler::Done();
 			Texture::Done();
 			Shader::Done();
+            SkinningPrePass::Done();
+            BonePalette::Done();
             m_thread_pool.reset();
 #if VR_GLES
             m_resource_thread_pool.reset();
 #endif
+            FileSystem::Done();
+            Profiler::Done();
             m_app = nullptr;
         }
     };
@@ -223,6 +246,30 @@ namespace Viry3D
     {
         Log("web has no save path");
 
+        return m_private->m_save_path;
+    }
+#elif VR_LINUX
+    const String& Application::GetDataPath()
+    {
+        if (m_private->m_data_path.Empty())
+        {
+            char buffer[PATH_MAX];
+            ssize_t size = readlink("/proc/self/exe", buffer, PATH_MAX - 1);
+            String path = size > 0 ? String(buffer, (int) size) : String("./");
+            path = path.Substring(0, path.LastIndexOf("/")) + "/Assets";
+            m_private->m_data_path = path;
+        }
+
+        return m_private->m_data_path;
+    }
+
+    const String& Application::GetSavePath()
+    {
+        if (m_private->m_save_path.Empty())
+        {
+            m_private->m_save_path = this->GetDataPath();
+        }
+
         return m_private->m_save_path;
     }
 #elif VR_UWP
@@ -282,12 +329,18 @@ void Application::SetSavePath(const String& path)
 
     void Application::OnFrameBegin()
     {
+        PROFILE_ZONE("Application::OnFrameBegin");
+
         Time::Update();
         this->ProcessActions();
+        Resources::Update();
+        FileSystem::Update();
     }
 
     void Application::OnFrameEnd()
     {
+        PROFILE_ZONE("Application::OnFrameEnd");
+
 #if VR_ANDROID
         if (Input::GetKeyDown(KeyCode::Backspace))
 #else
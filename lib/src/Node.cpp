@@ -165,6 +165,44 @@ namespace Viry3D
         }
     }
 
+    Ref<Node> Node::Instantiate(const Ref<Node>& source)
+    {
+        Map<Node*, Ref<Node>> copies;
+        Ref<Node> node = CloneHierarchy(source.get(), Ref<Node>(), copies);
+
+        for (const auto& i : copies)
+        {
+            i.second->OnInstantiate(i.first, copies);
+        }
+
+        return node;
+    }
+
+    Ref<Node> Node::CloneHierarchy(Node* source, const Ref<Node>& parent, Map<Node*, Ref<Node>>& copies)
+    {
+        Ref<Node> node = source->Clone();
+        node->SetName(source->GetName());
+        node->m_local_position = source->m_local_position;
+        node->m_local_rotation = source->m_local_rotation;
+        node->m_local_scale = source->m_local_scale;
+        node->m_notify_children_on_matrix_dirty = source->m_notify_children_on_matrix_dirty;
+        node->m_matrix_dirty = true;
+        copies.Add(source, node);
+
+        // added before its children so the dirty mark does not walk them
+        if (parent)
+        {
+            Node::SetParent(node, parent);
+        }
+
+        for (const auto& i : source->m_children)
+        {
+            CloneHierarchy(i.get(), node, copies);
+        }
+
+        return node;
+    }
+
     Ref<Node> Node::Find(const String& path)
     {
         if (path.Empty())
@@ -22,6 +22,7 @@
 #include "math/Quaternion.h"
 #include "math/Matrix4x4.h"
 #include "container/Vector.h"
+#include "container/Map.h"
 
 namespace Viry3D
 {
@@ -30,6 +31,9 @@ namespace Viry3D
     public:
         static void SetParent(const Ref<Node>& node, const Ref<Node>& parent);
         static const Ref<Node>& GetRoot(const Ref<Node>& node);
+        // deep copies the hierarchy without a parent, meshes, materials and animation clips are shared with the source.
+        // bones and animation targets inside the hierarchy are rebound to the copies
+        static Ref<Node> Instantiate(const Ref<Node>& source);
         Node();
         virtual ~Node();
         const Vector3& GetLocalPosition() const { return m_local_position; }
@@ -53,8 +57,14 @@ namespace Viry3D
 
     protected:
         virtual void OnMatrixDirty() { }
+        // a node of the same type with its own state copied, Instantiate copies the transform and children.
+        // types without an override are copied as plain nodes
+        virtual Ref<Node> Clone() const { return RefMake<Node>(); }
+        // called on each copy once the whole hierarchy is copied, copies maps the source nodes to theirs
+        virtual void OnInstantiate(Node* source, const Map<Node*, Ref<Node>>& copies) { }
 
     private:
+        static Ref<Node> CloneHierarchy(Node* source, const Ref<Node>& parent, Map<Node*, Ref<Node>>& copies);
         void MarkMatrixDirty();
 
     private:
@@ -0,0 +1,608 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "PrefabFile.h"
+#include "io/MemoryStream.h"
+#include "memory/Memory.h"
+#include "Debug.h"
+
+#define PREFAB_FILE_VERSION 1
+
+namespace Viry3D
+{
+    static const byte PREFAB_FILE_IDENTIFIER[8] = { 0xAB, 'V', 'P', 'R', 'E', 'F', 0x0D, 0x0A };
+
+    // the size of a cooked prefab is not known ahead, its bytes are appended
+    class PrefabWriter
+    {
+    public:
+        template<class T>
+        void Write(const T& t)
+        {
+            this->Write(&t, sizeof(T));
+        }
+
+        void Write(const void* data, int size)
+        {
+            m_bytes.AddRange((const byte*) data, size);
+        }
+
+        void WriteString(const String& str)
+        {
+            this->Write<int>(str.Size());
+            this->Write(str.CString(), str.Size());
+        }
+
+        void WriteIndices(const Vector<int>& indices)
+        {
+            this->Write<int>(indices.Size());
+            if (indices.Size() > 0)
+            {
+                this->Write(&indices[0], indices.SizeInBytes());
+            }
+        }
+
+        ByteBuffer GetBuffer() const
+        {
+            ByteBuffer buffer(m_bytes.Size());
+            if (m_bytes.Size() > 0)
+            {
+                Memory::Copy(buffer.Bytes(), &m_bytes[0], m_bytes.Size());
+            }
+            return buffer;
+        }
+
+    private:
+        Vector<byte> m_bytes;
+    };
+
+    static String ReadString(MemoryStream& ms)
+    {
+        int size = ms.Read<int>();
+        return ms.ReadString(size);
+    }
+
+    static bool ReadCount(MemoryStream& ms, int element_size, int& count)
+    {
+        count = ms.Read<int>();
+        return count >= 0 && count <= (ms.GetLength() - ms.GetPosition()) / element_size;
+    }
+
+    static bool ReadString(MemoryStream& ms, String& str)
+    {
+        int size;
+        if (!ReadCount(ms, 1, size))
+        {
+            return false;
+        }
+        str = ms.ReadString(size);
+        return true;
+    }
+
+    static bool ReadIndices(MemoryStream& ms, Vector<int>& indices)
+    {
+        int count;
+        if (!ReadCount(ms, sizeof(int), count))
+        {
+            return false;
+        }
+        indices.Resize(count);
+        if (count > 0)
+        {
+            ms.Read(&indices[0], indices.SizeInBytes());
+        }
+        return true;
+    }
+
+    bool PrefabFile::IsCooked(const ByteBuffer& file)
+    {
+        return file.Size() >= (int) sizeof(PREFAB_FILE_IDENTIFIER) && Memory::Compare(file.Bytes(), PREFAB_FILE_IDENTIFIER, sizeof(PREFAB_FILE_IDENTIFIER)) == 0;
+    }
+
+    bool PrefabFile::Load(const ByteBuffer& file, Ref<PrefabNode>& root)
+    {
+        if (PrefabFile::IsCooked(file))
+        {
+            return PrefabFile::LoadCooked(file, root);
+        }
+        else
+        {
+            return PrefabFile::LoadExported(file, root);
+        }
+    }
+
+    static void ReadRenderer(MemoryStream& ms, PrefabNode* node)
+    {
+        int lightmap_index = ms.Read<int>();
+        Vector4 lightmapScaleOffset = ms.Read<Vector4>();
+        node->cast_shadow = ms.Read<byte>() == 1;
+        node->receive_shadow = ms.Read<byte>() == 1;
+
+        (void) lightmap_index;
+        (void) lightmapScaleOffset;
+
+        int material_count = ms.Read<int>();
+        for (int i = 0; i < material_count; ++i)
+        {
+            String material_path = ReadString(ms);
+            if (material_path.Size() > 0)
+            {
+                node->materials.Add(material_path);
+            }
+        }
+
+        node->mesh = ReadString(ms);
+    }
+
+    static void ReadAnimation(MemoryStream& ms, Vector<AnimationClip>& clips)
+    {
+        int clip_count = ms.Read<int>();
+
+        clips.Resize(clip_count);
+
+        for (int i = 0; i < clip_count; ++i)
+        {
+            String clip_name = ReadString(ms);
+            float clip_length = ms.Read<float>();
+            float clip_fps = ms.Read<float>();
+            int clip_wrap_mode = ms.Read<int>();
+            int curve_count = ms.Read<int>();
+
+            AnimationClip& clip = clips[i];
+            clip.name = clip_name;
+            clip.length = clip_length;
+            clip.fps = clip_fps;
+            clip.wrap_mode = (AnimationWrapMode) clip_wrap_mode;
+
+            for (int j = 0; j < curve_count; ++j)
+            {
+                String curve_path = ReadString(ms);
+                int property_type = ms.Read<int>();
+                int key_count = ms.Read<int>();
+
+                AnimationCurveWrapper* curve = nullptr;
+                for (int k = 0; k < clip.curves.Size(); ++k)
+                {
+                    if (clip.curves[k].path == curve_path)
+                    {
+                        curve = &clip.curves[k];
+                        break;
+                    }
+                }
+                if (curve == nullptr)
+                {
+                    AnimationCurveWrapper new_path_curve;
+                    new_path_curve.path = curve_path;
+                    clip.curves.Add(new_path_curve);
+                    curve = &clip.curves[clip.curves.Size() - 1];
+                }
+                
+                curve->property_types.Add((CurvePropertyType) property_type);
+                curve->curves.Add(AnimationCurve());
+
+                AnimationCurve* anim_curve = &curve->curves[curve->curves.Size() - 1];
+
+                for (int k = 0; k < key_count; ++k)
+                {
+                    float time = ms.Read<float>();
+                    float value = ms.Read<float>();
+                    float in_tangent = ms.Read<float>();
+                    float out_tangent = ms.Read<float>();
+
+                    anim_curve->AddKey(time, value, in_tangent, out_tangent);
+                }
+            }
+        }
+    }
+
+    static Ref<PrefabNode> ReadExportedNode(MemoryStream& ms)
+    {
+        Ref<PrefabNode> node = RefMake<PrefabNode>();
+
+        node->name = ReadString(ms);
+        int layer = ms.Read<int>();
+        bool active = ms.Read<byte>() == 1;
+
+        (void) layer;
+        (void) active;
+
+        node->local_position = ms.Read<Vector3>();
+        node->local_rotation = ms.Read<Quaternion>();
+        node->local_scale = ms.Read<Vector3>();
+
+        int com_count = ms.Read<int>();
+        for (int i = 0; i < com_count; ++i)
+        {
+            String com_name = ReadString(ms);
+
+            if (com_name == "MeshRenderer")
+            {
+                assert(node->component.Empty());
+
+                ReadRenderer(ms, node.get());
+                node->component = com_name;
+            }
+            else if (com_name == "SkinnedMeshRenderer")
+            {
+                assert(node->component.Empty());
+
+                ReadRenderer(ms, node.get());
+                int bone_count = ms.Read<int>();
+                node->bones.Resize(bone_count);
+                for (int j = 0; j < bone_count; ++j)
+                {
+                    node->bones[j] = ReadString(ms);
+                }
+                node->component = com_name;
+            }
+            else if (com_name == "Animation")
+            {
+                assert(node->component.Empty());
+
+                ReadAnimation(ms, node->clips);
+                node->component = com_name;
+            }
+        }
+
+        int child_count = ms.Read<int>();
+        for (int i = 0; i < child_count; ++i)
+        {
+            node->children.Add(ReadExportedNode(ms));
+        }
+
+        return node;
+    }
+
+    bool PrefabFile::LoadExported(const ByteBuffer& file, Ref<PrefabNode>& root)
+    {
+        MemoryStream ms(file);
+        root = ReadExportedNode(ms);
+        return true;
+    }
+
+    static bool ReadCookedClips(MemoryStream& ms, PrefabNode* node)
+    {
+        int clip_count;
+        if (!ReadCount(ms, 4, clip_count))
+        {
+            return false;
+        }
+
+        node->clips.Resize(clip_count);
+        node->curve_nodes.Resize(clip_count);
+
+        for (int i = 0; i < clip_count; ++i)
+        {
+            AnimationClip& clip = node->clips[i];
+            if (!ReadString(ms, clip.name))
+            {
+                return false;
+            }
+            clip.length = ms.Read<float>();
+            clip.fps = ms.Read<float>();
+            clip.wrap_mode = (AnimationWrapMode) ms.Read<int>();
+
+            int curve_count;
+            if (!ReadCount(ms, 4, curve_count))
+            {
+                return false;
+            }
+
+            clip.curves.Resize(curve_count);
+            for (int j = 0; j < curve_count; ++j)
+            {
+                AnimationCurveWrapper& curve = clip.curves[j];
+                int property_count;
+                if (!ReadString(ms, curve.path) || !ReadCount(ms, 4, property_count))
+                {
+                    return false;
+                }
+
+                curve.property_types.Resize(property_count);
+                curve.curves.Resize(property_count);
+                for (int k = 0; k < property_count; ++k)
+                {
+                    curve.property_types[k] = (CurvePropertyType) ms.Read<int>();
+
+                    int key_count;
+                    if (!ReadCount(ms, sizeof(AnimationCurve::Key), key_count))
+                    {
+                        return false;
+                    }
+
+                    Vector<AnimationCurve::Key> keys(key_count);
+                    if (key_count > 0)
+                    {
+                        ms.Read(&keys[0], keys.SizeInBytes());
+                    }
+                    curve.curves[k].SetKeys(std::move(keys));
+                }
+            }
+
+            if (!ReadIndices(ms, node->curve_nodes[i]))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static bool ReadCookedNode(MemoryStream& ms, Ref<PrefabNode>& node)
+    {
+        node = RefMake<PrefabNode>();
+
+        if (!ReadString(ms, node->name))
+        {
+            return false;
+        }
+        node->local_position = ms.Read<Vector3>();
+        node->local_rotation = ms.Read<Quaternion>();
+        node->local_scale = ms.Read<Vector3>();
+        if (!ReadString(ms, node->component))
+        {
+            return false;
+        }
+
+        if (node->component == "MeshRenderer" || node->component == "SkinnedMeshRenderer")
+        {
+            node->cast_shadow = ms.Read<byte>() == 1;
+            node->receive_shadow = ms.Read<byte>() == 1;
+
+            int material_count;
+            if (!ReadCount(ms, 4, material_count))
+            {
+                return false;
+            }
+            node->materials.Resize(material_count);
+            for (int i = 0; i < material_count; ++i)
+            {
+                if (!ReadString(ms, node->materials[i]))
+                {
+                    return false;
+                }
+            }
+
+            if (!ReadString(ms, node->mesh))
+            {
+                return false;
+            }
+        }
+
+        if (node->component == "SkinnedMeshRenderer")
+        {
+            int bone_count;
+            if (!ReadCount(ms, 4, bone_count))
+            {
+                return false;
+            }
+            node->bones.Resize(bone_count);
+            for (int i = 0; i < bone_count; ++i)
+            {
+                if (!ReadString(ms, node->bones[i]))
+                {
+                    return false;
+                }
+            }
+
+            if (!ReadIndices(ms, node->bone_nodes))
+            {
+                return false;
+            }
+        }
+        else if (node->component == "Animation")
+        {
+            if (!ReadCookedClips(ms, node.get()))
+            {
+                return false;
+            }
+        }
+
+        int child_count;
+        if (!ReadCount(ms, 4, child_count))
+        {
+            return false;
+        }
+        node->children.Resize(child_count);
+        for (int i = 0; i < child_count; ++i)
+        {
+            if (!ReadCookedNode(ms, node->children[i]))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool PrefabFile::LoadCooked(const ByteBuffer& file, Ref<PrefabNode>& root)
+    {
+        MemoryStream ms(file);
+        ms.ReadBuffer(sizeof(PREFAB_FILE_IDENTIFIER));
+
+        unsigned int version = ms.Read<unsigned int>();
+        if (version != PREFAB_FILE_VERSION)
+        {
+            Log("prefab file version not support: %d", version);
+            return false;
+        }
+
+        return ReadCookedNode(ms, root);
+    }
+
+    static void WriteNode(PrefabWriter& writer, const PrefabNode* node)
+    {
+        writer.WriteString(node->name);
+        writer.Write<Vector3>(node->local_position);
+        writer.Write<Quaternion>(node->local_rotation);
+        writer.Write<Vector3>(node->local_scale);
+        writer.WriteString(node->component);
+
+        if (node->component == "MeshRenderer" || node->component == "SkinnedMeshRenderer")
+        {
+            writer.Write<byte>(node->cast_shadow ? 1 : 0);
+            writer.Write<byte>(node->receive_shadow ? 1 : 0);
+            writer.Write<int>(node->materials.Size());
+            for (const auto& i : node->materials)
+            {
+                writer.WriteString(i);
+            }
+            writer.WriteString(node->mesh);
+        }
+
+        if (node->component == "SkinnedMeshRenderer")
+        {
+            writer.Write<int>(node->bones.Size());
+            for (const auto& i : node->bones)
+            {
+                writer.WriteString(i);
+            }
+            writer.WriteIndices(node->bone_nodes);
+        }
+        else if (node->component == "Animation")
+        {
+            writer.Write<int>(node->clips.Size());
+            for (int i = 0; i < node->clips.Size(); ++i)
+            {
+                const AnimationClip& clip = node->clips[i];
+                writer.WriteString(clip.name);
+                writer.Write<float>(clip.length);
+                writer.Write<float>(clip.fps);
+                writer.Write<int>((int) clip.wrap_mode);
+                writer.Write<int>(clip.curves.Size());
+
+                for (const auto& curve : clip.curves)
+                {
+                    writer.WriteString(curve.path);
+                    writer.Write<int>(curve.curves.Size());
+                    for (int j = 0; j < curve.curves.Size(); ++j)
+                    {
+                        const Vector<AnimationCurve::Key>& keys = curve.curves[j].GetKeys();
+                        writer.Write<int>((int) curve.property_types[j]);
+                        writer.Write<int>(keys.Size());
+                        if (keys.Size() > 0)
+                        {
+                            writer.Write(&keys[0], keys.SizeInBytes());
+                        }
+                    }
+                }
+
+                writer.WriteIndices(i < node->curve_nodes.Size() ? node->curve_nodes[i] : Vector<int>());
+            }
+        }
+
+        writer.Write<int>(node->children.Size());
+        for (const auto& i : node->children)
+        {
+            WriteNode(writer, i.get());
+        }
+    }
+
+    ByteBuffer PrefabFile::Save(const Ref<PrefabNode>& root)
+    {
+        PrefabWriter writer;
+        writer.Write(PREFAB_FILE_IDENTIFIER, sizeof(PREFAB_FILE_IDENTIFIER));
+        writer.Write<unsigned int>(PREFAB_FILE_VERSION);
+        WriteNode(writer, root.get());
+
+        return writer.GetBuffer();
+    }
+
+    static void GetNodeIndices(PrefabNode* node, Map<PrefabNode*, int>& indices)
+    {
+        indices.Add(node, indices.Size());
+        for (const auto& i : node->children)
+        {
+            GetNodeIndices(i.get(), indices);
+        }
+    }
+
+    // as Node::Find, the first child with the name at each level
+    static int FindNode(PrefabNode* from, const String& path, const Map<PrefabNode*, int>& indices)
+    {
+        if (path.Empty())
+        {
+            return -1;
+        }
+
+        PrefabNode* p = from;
+        Vector<String> layers = path.Split("/");
+        for (const auto& layer : layers)
+        {
+            PrefabNode* child = nullptr;
+            for (const auto& i : p->children)
+            {
+                if (i->name == layer)
+                {
+                    child = i.get();
+                    break;
+                }
+            }
+
+            if (child == nullptr)
+            {
+                return -1;
+            }
+            p = child;
+        }
+
+        return indices[p];
+    }
+
+    static void ResolveNode(PrefabNode* root, PrefabNode* node, const Map<PrefabNode*, int>& indices)
+    {
+        if (node->component == "SkinnedMeshRenderer")
+        {
+            // as SkinnedMeshRenderer::FindBones, bone paths start with the name of the root
+            node->bone_nodes.Resize(node->bones.Size());
+            for (int i = 0; i < node->bones.Size(); ++i)
+            {
+                const String& path = node->bones[i];
+                node->bone_nodes[i] = -1;
+                if (path.Size() > root->name.Size() && path.StartsWith(root->name))
+                {
+                    node->bone_nodes[i] = FindNode(root, path.Substring(root->name.Size() + 1), indices);
+                }
+            }
+        }
+        else if (node->component == "Animation")
+        {
+            node->curve_nodes.Resize(node->clips.Size());
+            for (int i = 0; i < node->clips.Size(); ++i)
+            {
+                const auto& curves = node->clips[i].curves;
+                node->curve_nodes[i].Resize(curves.Size());
+                for (int j = 0; j < curves.Size(); ++j)
+                {
+                    node->curve_nodes[i][j] = FindNode(node, curves[j].path, indices);
+                }
+            }
+        }
+
+        for (const auto& i : node->children)
+        {
+            ResolveNode(root, i.get(), indices);
+        }
+    }
+
+    void PrefabFile::ResolveTargets(const Ref<PrefabNode>& root)
+    {
+        Map<PrefabNode*, int> indices;
+        GetNodeIndices(root.get(), indices);
+        ResolveNode(root.get(), root.get(), indices);
+    }
+}
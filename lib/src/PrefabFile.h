@@ -0,0 +1,64 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "animation/Animation.h"
+#include "container/Vector.h"
+#include "memory/ByteBuffer.h"
+#include "string/String.h"
+
+namespace Viry3D
+{
+    struct PrefabNode
+    {
+        String name;
+        Vector3 local_position;
+        Quaternion local_rotation;
+        Vector3 local_scale;
+        String component;
+        bool cast_shadow = false;
+        bool receive_shadow = false;
+        Vector<String> materials;
+        String mesh;
+        Vector<String> bones;
+        Vector<AnimationClip> clips;
+        // pre-order indices of nodes in the prefab, -1 where the path finds none. only a cooked prefab has them
+        Vector<int> bone_nodes;
+        // per clip and curve
+        Vector<Vector<int>> curve_nodes;
+        Vector<Ref<PrefabNode>> children;
+    };
+
+    // prefab files exported by the unity tools, and the cooked version with the animation curves grouped by path
+    // and the bone and curve target paths resolved to node indices, so instantiating searches no path
+    class PrefabFile
+    {
+    public:
+        // detects the cooked version from the file identifier
+        static bool Load(const ByteBuffer& file, Ref<PrefabNode>& root);
+        static ByteBuffer Save(const Ref<PrefabNode>& root);
+        static bool IsCooked(const ByteBuffer& file);
+        // finds the nodes by path the way the runtime does, bones from the prefab root as SkinnedMeshRenderer
+        // and curve targets from the node of the animation as Animation
+        static void ResolveTargets(const Ref<PrefabNode>& root);
+
+    private:
+        static bool LoadExported(const ByteBuffer& file, Ref<PrefabNode>& root);
+        static bool LoadCooked(const ByteBuffer& file, Ref<PrefabNode>& root);
+    };
+}
@@ -0,0 +1,184 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "Profiler.h"
+#include "container/Vector.h"
+#include "memory/Ref.h"
+#include "io/File.h"
+#include "thread/ThreadPool.h"
+#include <chrono>
+
+#define PROFILER_THREAD_EVENT_COUNT 16384
+
+namespace Viry3D
+{
+    struct ProfilerEvent
+    {
+        const char* name;
+        long long begin;
+        long long end;
+    };
+
+    struct ProfilerThread
+    {
+        int id;
+        String name;
+        Vector<ProfilerEvent> events;
+        int next = 0;
+        int count = 0;
+        Mutex mutex;
+    };
+
+    std::atomic<bool> Profiler::m_enabled(false);
+    static Vector<Ref<ProfilerThread>> g_profiler_threads;
+    static Mutex g_profiler_threads_mutex;
+    static thread_local ProfilerThread* g_profiler_thread = nullptr;
+    static const std::chrono::steady_clock::time_point g_profiler_start_time = std::chrono::steady_clock::now();
+
+    static ProfilerThread* GetProfilerThread()
+    {
+        if (g_profiler_thread == nullptr)
+        {
+            std::lock_guard<Mutex> lock(g_profiler_threads_mutex);
+
+            Ref<ProfilerThread> thread = RefMake<ProfilerThread>();
+            thread->id = g_profiler_threads.Size();
+            thread->name = String::Format("Thread %d", thread->id);
+            thread->events.Resize(PROFILER_THREAD_EVENT_COUNT);
+            g_profiler_threads.Add(thread);
+
+            g_profiler_thread = thread.get();
+        }
+
+        return g_profiler_thread;
+    }
+
+    void Profiler::SetThreadName(const String& name)
+    {
+        ProfilerThread* thread = GetProfilerThread();
+
+        std::lock_guard<Mutex> lock(thread->mutex);
+        thread->name = name;
+    }
+
+    long long Profiler::GetTimeUS()
+    {
+        auto time = std::chrono::steady_clock::now() - g_profiler_start_time;
+        return std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+    }
+
+    void Profiler::AddEvent(const char* name, long long begin_us, long long end_us)
+    {
+        ProfilerThread* thread = GetProfilerThread();
+
+        // only contended while a trace is being written
+        std::lock_guard<Mutex> lock(thread->mutex);
+
+        ProfilerEvent& event = thread->events[thread->next];
+        event.name = name;
+        event.begin = begin_us;
+        event.end = end_us;
+
+        thread->next = (thread->next + 1) % thread->events.Size();
+        if (thread->count < thread->events.Size())
+        {
+            thread->count += 1;
+        }
+    }
+
+    void Profiler::Clear()
+    {
+        std::lock_guard<Mutex> lock(g_profiler_threads_mutex);
+
+        for (int i = 0; i < g_profiler_threads.Size(); ++i)
+        {
+            ProfilerThread* thread = g_profiler_threads[i].get();
+
+            std::lock_guard<Mutex> thread_lock(thread->mutex);
+            thread->next = 0;
+            thread->count = 0;
+        }
+    }
+
+    static void AppendJsonString(std::string& json, const char* str)
+    {
+        json += '"';
+        for (const char* c = str; *c; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+            {
+                json += '\\';
+            }
+            json += *c;
+        }
+        json += '"';
+    }
+
+    String Profiler::GetChromeTrace()
+    {
+        std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        char buffer[128];
+
+        std::lock_guard<Mutex> lock(g_profiler_threads_mutex);
+
+        for (int i = 0; i < g_profiler_threads.Size(); ++i)
+        {
+            ProfilerThread* thread = g_profiler_threads[i].get();
+
+            std::lock_guard<Mutex> thread_lock(thread->mutex);
+
+            if (!first)
+            {
+                json += ',';
+            }
+            first = false;
+
+            snprintf(buffer, sizeof(buffer), "{\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":", thread->id);
+            json += buffer;
+            AppendJsonString(json, thread->name.CString());
+            json += "}}";
+
+            int start = (thread->next - thread->count + thread->events.Size()) % thread->events.Size();
+            for (int j = 0; j < thread->count; ++j)
+            {
+                const ProfilerEvent& event = thread->events[(start + j) % thread->events.Size()];
+
+                json += ",{\"ph\":\"X\",\"pid\":0,";
+                snprintf(buffer, sizeof(buffer), "\"tid\":%d,\"ts\":%lld,\"dur\":%lld,\"name\":", thread->id, event.begin, event.end - event.begin);
+                json += buffer;
+                AppendJsonString(json, event.name);
+                json += '}';
+            }
+        }
+
+        json += "]}";
+
+        return String(json.c_str(), (int) json.size());
+    }
+
+    bool Profiler::SaveChromeTrace(const String& path)
+    {
+        return File::WriteAllText(path, GetChromeTrace());
+    }
+
+    void Profiler::Done()
+    {
+        SetEnabled(false);
+        Clear();
+    }
+}
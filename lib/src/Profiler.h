@@ -0,0 +1,84 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "string/String.h"
+#include <atomic>
+
+#ifndef VR_PROFILER
+#define VR_PROFILER 1
+#endif
+
+// zone names must outlive the trace, use string literals
+#if VR_PROFILER
+#define VR_PROFILER_CONCAT_IMPL(a, b) a##b
+#define VR_PROFILER_CONCAT(a, b) VR_PROFILER_CONCAT_IMPL(a, b)
+#define PROFILE_ZONE(name) Viry3D::ProfilerZone VR_PROFILER_CONCAT(profiler_zone_, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
+
+namespace Viry3D
+{
+    // records zones into a ring buffer per thread, each thread becomes a track in the chrome trace,
+    // old events are overwritten when a buffer is full. zones cost one atomic load while disabled.
+    class Profiler
+    {
+    public:
+        static void SetEnabled(bool enable) { m_enabled.store(enable, std::memory_order_relaxed); }
+        static bool IsEnabled() { return m_enabled.load(std::memory_order_relaxed); }
+        // names the track of the calling thread
+        static void SetThreadName(const String& name);
+        static long long GetTimeUS();
+        static void AddEvent(const char* name, long long begin_us, long long end_us);
+        static void Clear();
+        // chrome://tracing or perfetto json
+        static String GetChromeTrace();
+        static bool SaveChromeTrace(const String& path);
+        static void Done();
+
+    private:
+        static std::atomic<bool> m_enabled;
+    };
+
+    class ProfilerZone
+    {
+    public:
+        ProfilerZone(const char* name):
+            m_name(name),
+            m_begin(-1)
+        {
+            if (Profiler::IsEnabled())
+            {
+                m_begin = Profiler::GetTimeUS();
+            }
+        }
+
+        ~ProfilerZone()
+        {
+            if (m_begin >= 0)
+            {
+                Profiler::AddEvent(m_name, m_begin, Profiler::GetTimeUS());
+            }
+        }
+
+    private:
+        const char* m_name;
+        long long m_begin;
+    };
+}
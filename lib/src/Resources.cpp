@@ -17,20 +17,128 @@
 
 #include "Resources.h"
 #include "Node.h"
+#include "PrefabFile.h"
 #include "Application.h"
+#include "Profiler.h"
 #include "io/File.h"
+#include "io/MappedFile.h"
 #include "io/MemoryStream.h"
 #include "graphics/MeshRenderer.h"
 #include "graphics/SkinnedMeshRenderer.h"
 #include "graphics/Mesh.h"
+#include "graphics/MeshFile.h"
 #include "graphics/Material.h"
+#include "graphics/MaterialFile.h"
 #include "graphics/Shader.h"
 #include "graphics/Texture.h"
+#include "graphics/KTX.h"
+#include "graphics/MipmapGenerator.h"
+#include "graphics/TextureStreamer.h"
 #include "animation/Animation.h"
+#include "container/List.h"
 
 namespace Viry3D
 {
-    static Map<String, Ref<Object>> g_loading_cache;
+    struct TextureDesc
+    {
+        String name;
+        // a cooked ktx2 next to the .tex descriptor replaces it when the device can sample its format,
+        // otherwise the image of the .tex is loaded
+        String ktx_path;
+        TextureFormat ktx_format;
+        String image_path;
+        FilterMode filter_mode;
+        SamplerAddressMode wrap_mode;
+        bool gen_mipmap;
+    };
+
+    // everything a prefab references, parsed without touching the gpu so it can run on a worker
+    class PrefabDesc : public Object
+    {
+    public:
+        String path;
+        Ref<PrefabNode> root;
+        Map<String, TextureDesc> textures;
+        Map<String, MaterialFileData> materials;
+        Vector<String> meshes;
+    };
+
+    class TextureData : public Object
+    {
+    public:
+        ByteBuffer pixels;
+        int width = 0;
+        int height = 0;
+        int bpp = 0;
+        // mip chain built on the worker, empty when the texture has no mipmaps
+        Vector<ByteBuffer> levels;
+    };
+
+    class MeshData : public Object
+    {
+    public:
+        // stored blocks are views into the mapping
+        Ref<MappedFile> file;
+        MeshFileData data;
+    };
+
+    struct LoadContext
+    {
+        Ref<PrefabDesc> prefab;
+        Map<String, Ref<Texture>> textures;
+        Map<String, Ref<Mesh>> meshes;
+        Map<String, Ref<Material>> materials;
+    };
+
+    struct AsyncLoadItem
+    {
+        bool texture;
+        String path;
+        Ref<Object> data;
+    };
+
+    class AsyncLoad : public Object
+    {
+    public:
+        LoadContext context;
+        Resources::LoadComplete complete;
+        Resources::LoadProgress progress;
+        // decoded dependencies waiting for their gpu objects
+        List<AsyncLoadItem> ready;
+        int decode_pending = 0;
+        int step_count = 0;
+        int step_done = 0;
+    };
+
+    enum class CacheType
+    {
+        Texture,
+        Material,
+        Mesh,
+        Animation,
+    };
+
+    struct CacheEntry
+    {
+        WeakRef<Object> object;
+        CacheType type;
+        // size when loaded, streamed textures are asked for their resident size
+        int bytes;
+    };
+
+    static List<Ref<AsyncLoad>> g_async_loads;
+    // weak, so an asset is released with its last user and a later load reads it again
+    static Map<String, CacheEntry> g_cache;
+    // files an async load is reading, other loads needing them wait for its object
+    static Map<String, List<Ref<AsyncLoad>>> g_waiting;
+    // strong, the copies share their meshes, materials and clips
+    static Map<String, Ref<Node>> g_prototypes;
+    int Resources::m_async_batch_size = 4;
+
+    static String GetFullPath(const String& path)
+    {
+        return Application::Instance()->GetDataPath() + "/" + path;
+    }
 
     static String ReadString(MemoryStream& ms)
     {
@@ -38,331 +146,883 @@ namespace Viry3D
         return ms.ReadString(size);
     }
 
-    static Ref<Texture> ReadTexture(const String& path)
+    static void ParseTexture(const String& path, PrefabDesc* prefab)
     {
-        if (g_loading_cache.Contains(path))
+        if (prefab->textures.Contains(path))
         {
-            return RefCast<Texture>(g_loading_cache[path]);
+            return;
         }
 
-        Ref<Texture> texture;
+        TextureDesc desc;
+        desc.ktx_format = TextureFormat::None;
+        desc.filter_mode = FilterMode::Linear;
+        desc.wrap_mode = SamplerAddressMode::Repeat;
+        desc.gen_mipmap = false;
+
+        String full_path = GetFullPath(path);
 
-        String full_path = Application::Instance()->GetDataPath() + "/" + path;
-        if (File::Exist(full_path))
+        String ktx_path = full_path;
+        if (ktx_path.EndsWith(".tex"))
         {
-            MemoryStream ms(File::ReadAllBytes(full_path));
+            ktx_path = ktx_path.Substring(0, ktx_path.Size() - 4) + ".ktx2";
+        }
+
+        if ((ktx_path.EndsWith(".ktx2") || ktx_path.EndsWith(".ktx")) && File::Exist(ktx_path))
+        {
+            String name = path.Substring(path.LastIndexOf("/") + 1);
+            desc.name = name.Substring(0, name.IndexOf("."));
+            desc.ktx_path = ktx_path;
 
-            String texture_name = ReadString(ms);
-            int width = ms.Read<int>();
-            int height = ms.Read<int>();
-            SamplerAddressMode wrap_mode = (SamplerAddressMode) ms.Read<int>();
-            FilterMode filter_mode = (FilterMode) ms.Read<int>();
+            // the header is enough to choose, the device is asked on the main thread
+            Ref<MappedFile> file = MappedFile::Open(ktx_path);
+            if (file)
+            {
+                desc.ktx_format = KTX::ReadFormat(file->GetBuffer());
+            }
+        }
+
+        if (full_path.EndsWith(".tex") && File::Exist(full_path))
+        {
+            MemoryStream ms(MappedFile::Open(full_path));
+
+            desc.name = ReadString(ms);
+            ms.Read<int>();
+            ms.Read<int>();
+            desc.wrap_mode = (SamplerAddressMode) ms.Read<int>();
+            desc.filter_mode = (FilterMode) ms.Read<int>();
             String texture_type = ReadString(ms);
 
             if (texture_type == "Texture2D")
             {
                 int mipmap_count = ms.Read<int>();
-                String png_path = ReadString(ms);
+                desc.image_path = GetFullPath(ReadString(ms));
+                desc.gen_mipmap = mipmap_count > 1;
+            }
+        }
+
+        prefab->textures.Add(path, desc);
+    }
+
+    static void ParseMaterial(const String& path, PrefabDesc* prefab)
+    {
+        if (prefab->materials.Contains(path))
+        {
+            return;
+        }
+
+        MaterialFileData data;
+
+        String full_path = GetFullPath(path);
+        Ref<MappedFile> file = MappedFile::Open(full_path);
+        if (file && !MaterialFile::Load(file->GetBuffer(), data))
+        {
+            Log("material load failed: %s", full_path.CString());
+        }
 
-                texture = Texture::LoadTexture2DFromFile(Application::Instance()->GetDataPath() + "/" + png_path, filter_mode, wrap_mode, mipmap_count > 1);
-                texture->SetName(texture_name);
+        for (const auto& i : data.properties)
+        {
+            if (i.type == MaterialProperty::Type::Texture && i.texture.Size() > 0)
+            {
+                ParseTexture(i.texture, prefab);
+            }
+        }
+
+        prefab->materials.Add(path, data);
+    }
+
+    static void ParseDependencies(const PrefabNode* node, PrefabDesc* prefab)
+    {
+        for (const auto& i : node->materials)
+        {
+            ParseMaterial(i, prefab);
+        }
+
+        if (node->component == "MeshRenderer" || node->component == "SkinnedMeshRenderer")
+        {
+            bool found = false;
+            for (const auto& i : prefab->meshes)
+            {
+                if (i == node->mesh)
+                {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found)
+            {
+                prefab->meshes.Add(node->mesh);
+            }
+        }
+
+        for (const auto& i : node->children)
+        {
+            ParseDependencies(i.get(), prefab);
+        }
+    }
+
+    static Ref<PrefabDesc> ParsePrefab(const String& path)
+    {
+        Ref<PrefabDesc> prefab;
+
+        String full_path = GetFullPath(path);
+        Ref<MappedFile> file = MappedFile::Open(full_path);
+        if (file)
+        {
+            Ref<PrefabNode> root;
+            if (!PrefabFile::Load(file->GetBuffer(), root))
+            {
+                Log("prefab load failed: %s", full_path.CString());
+                return prefab;
             }
+
+            prefab = RefMake<PrefabDesc>();
+            prefab->path = path;
+            prefab->root = root;
+            ParseDependencies(root.get(), prefab.get());
+        }
+
+        return prefab;
+    }
+
+    template<class T>
+    static Ref<T> FindCache(const String& path)
+    {
+        CacheEntry* entry;
+        if (g_cache.TryGet(path, &entry))
+        {
+            Ref<T> object = RefCast<T>(entry->object.lock());
+            if (object)
+            {
+                return object;
+            }
+            g_cache.Remove(path);
+        }
+
+        return Ref<T>();
+    }
+
+    static void AddCache(const String& path, const Ref<Object>& object, CacheType type, int bytes)
+    {
+        if (object)
+        {
+            CacheEntry entry;
+            entry.object = object;
+            entry.type = type;
+            entry.bytes = bytes;
+            g_cache.Remove(path);
+            g_cache.Add(path, entry);
+        }
+    }
+
+    static void StoreObject(LoadContext& context, bool texture, const String& path, const Ref<Object>& object)
+    {
+        if (texture)
+        {
+            context.textures.Add(path, RefCast<Texture>(object));
+        }
+        else
+        {
+            context.meshes.Add(path, RefCast<Mesh>(object));
+        }
+    }
+
+    static bool StoreCached(LoadContext& context, bool texture, const String& path)
+    {
+        Ref<Object> object;
+        if (texture)
+        {
+            object = FindCache<Texture>(path);
+        }
+        else
+        {
+            object = FindCache<Mesh>(path);
         }
 
-        g_loading_cache.Add(path, texture);
+        if (object)
+        {
+            StoreObject(context, texture, path, object);
+            return true;
+        }
 
-        return texture;
+        return false;
     }
 
-    static Ref<Material> ReadMaterial(const String& path)
+    // main thread only, gles asks the context for extensions
+    static bool UseKTX(const TextureDesc& desc)
     {
-        if (g_loading_cache.Contains(path))
+        if (desc.ktx_path.Empty())
         {
-            return RefCast<Material>(g_loading_cache[path]);
+            return false;
         }
+        return desc.image_path.Empty() || Texture::IsFormatSupported(desc.ktx_format);
+    }
 
-        Ref<Material> material;
+    // worker side of a dependency, reads and decodes the file
+    static Ref<Object> LoadData(bool texture, const String& path, const PrefabDesc* prefab)
+    {
+        if (texture)
+        {
+            const TextureDesc& desc = prefab->textures[path];
 
-        String full_path = Application::Instance()->GetDataPath() + "/" + path;
-        if (File::Exist(full_path))
+            Ref<TextureData> data = RefMake<TextureData>();
+            data->pixels = Texture::LoadImageFromFile(desc.image_path, data->width, data->height, data->bpp);
+            if (desc.gen_mipmap && data->pixels.Size() > 0)
+            {
+                data->levels = MipmapGenerator::Generate(data->pixels, data->width, data->height, data->bpp / 8, MipmapOptions());
+            }
+            return data;
+        }
+        else
         {
-            MemoryStream ms(File::ReadAllBytes(full_path));
+            String full_path = GetFullPath(path);
 
-            String material_name = ReadString(ms);
-            String shader_name = ReadString(ms);
-            int property_count = ms.Read<int>();
+            Ref<MeshData> data = RefMake<MeshData>();
+            data->file = MappedFile::Open(full_path);
+            if (!data->file || !MeshFile::Load(data->file->GetBuffer(), data->data))
+            {
+                Log("mesh load failed: %s", full_path.CString());
+                return Ref<Object>();
+            }
+            return data;
+        }
+    }
 
-            Ref<Shader> shader = Shader::Find(shader_name);
-            if (shader)
+    // main thread side of a dependency, creates the gpu object
+    static void CreateObject(LoadContext& context, bool texture, const String& path, const Ref<Object>& data)
+    {
+        if (texture)
+        {
+            const TextureDesc& desc = context.prefab->textures[path];
+
+            Ref<Texture> texture;
+            int bytes = 0;
+            if (UseKTX(desc))
             {
-                material = RefMake<Material>(shader);
-                material->SetName(material_name);
+                texture = TextureStreamer::LoadTexture(desc.ktx_path, desc.filter_mode, desc.wrap_mode);
+                if (texture && !TextureStreamer::IsStreamed(texture))
+                {
+                    // the file size, close enough for uncompressed levels
+                    Ref<MappedFile> file = MappedFile::Open(desc.ktx_path);
+                    if (file)
+                    {
+                        bytes = file->GetSize();
+                    }
+                }
             }
+            else
+            {
+                Ref<TextureData> texture_data = RefCast<TextureData>(data);
+                if (texture_data && texture_data->pixels.Size() > 0)
+                {
+                    TextureFormat format = texture_data->bpp == 8 ? TextureFormat::R8 : TextureFormat::R8G8B8A8;
+                    if (texture_data->levels.Size() > 0)
+                    {
+                        texture = Texture::CreateTexture2DFromLevels(
+                            texture_data->levels,
+                            texture_data->width,
+                            texture_data->height,
+                            format,
+                            desc.filter_mode,
+                            desc.wrap_mode);
+                    }
+                    else
+                    {
+                        texture = Texture::CreateTexture2DFromMemory(
+                            texture_data->pixels,
+                            texture_data->width,
+                            texture_data->height,
+                            format,
+                            desc.filter_mode,
+                            desc.wrap_mode,
+                            desc.gen_mipmap,
+                            false);
+                    }
 
-            for (int i = 0; i < property_count; ++i)
+                    for (int i = 0; texture && i < texture->GetMipmapLevelCount(); ++i)
+                    {
+                        bytes += Mathf::Max(texture->GetWidth() >> i, 1) * Mathf::Max(texture->GetHeight() >> i, 1) * texture_data->bpp / 8;
+                    }
+                }
+            }
+
+            if (texture)
             {
-                String property_name = ReadString(ms);
-                MaterialProperty::Type property_type = (MaterialProperty::Type) ms.Read<int>();
+                texture->SetName(desc.name);
+            }
+            AddCache(path, texture, CacheType::Texture, bytes);
+            context.textures.Add(path, texture);
+        }
+        else
+        {
+            Ref<MeshData> mesh_data = RefCast<MeshData>(data);
+
+            Ref<Mesh> mesh;
+            if (mesh_data)
+            {
+                const MeshFileData& file_data = mesh_data->data;
+                mesh = RefMake<Mesh>(file_data.vertices, file_data.indices, file_data.submeshes);
+                mesh->SetName(file_data.name);
+                mesh->SetBindposes(file_data.bindposes);
+                mesh->SetSourcePath(path);
+                AddCache(path, mesh, CacheType::Mesh, file_data.vertices.Size() + file_data.indices.Size());
+            }
+            context.meshes.Add(path, mesh);
+        }
+    }
+
+    static bool NeedDecode(const PrefabDesc* prefab, bool texture, const String& path)
+    {
+        if (!texture)
+        {
+            return true;
+        }
+
+        const TextureDesc& desc = prefab->textures[path];
+        return !UseKTX(desc) && desc.image_path.Size() > 0;
+    }
+
+    static Ref<Material> GetMaterial(LoadContext& context, const String& path)
+    {
+        Ref<Material>* cached;
+        if (context.materials.TryGet(path, &cached))
+        {
+            return *cached;
+        }
+
+        Ref<Material> material = FindCache<Material>(path);
+        if (material)
+        {
+            context.materials.Add(path, material);
+            return material;
+        }
+
+        const MaterialFileData& desc = context.prefab->materials[path];
+        Ref<Shader> shader = Shader::Find(desc.shader);
+        if (shader)
+        {
+            material = RefMake<Material>(shader);
+            material->SetName(desc.name);
 
-                switch (property_type)
+            for (const auto& property : desc.properties)
+            {
+                switch (property.type)
                 {
                     case MaterialProperty::Type::Color:
-                    {
-                        Color value = ms.Read<Color>();
-                        if (material)
-                        {
-                            material->SetColor(property_name, value);
-                        }
+                        material->SetColor(property.name, Color(property.value.x, property.value.y, property.value.z, property.value.w));
                         break;
-                    }
                     case MaterialProperty::Type::Vector:
-                    {
-                        Vector4 value = ms.Read<Vector4>();
-                        if (material)
-                        {
-                            material->SetVector(property_name, value);
-                        }
+                        material->SetVector(property.name, property.value);
                         break;
-                    }
                     case MaterialProperty::Type::Float:
                     case MaterialProperty::Type::Range:
-                    {
-                        float value = ms.Read<float>();
-                        if (material)
-                        {
-                            material->SetFloat(property_name, value);
-                        }
+                        material->SetFloat(property.name, property.value.x);
                         break;
-                    }
                     case MaterialProperty::Type::Texture:
                     {
-                        Vector4 uv_scale_offset = ms.Read<Vector4>();
-                        String texture_path = ReadString(ms);
-                        if (texture_path.Size() > 0)
+                        Ref<Texture>* texture;
+                        if (property.texture.Size() > 0 && context.textures.TryGet(property.texture, &texture) && *texture)
                         {
-                            Ref<Texture> texture = ReadTexture(texture_path);
-                            if (material && texture)
-                            {
-                                material->SetTexture(property_name, texture);
-                            }
+                            material->SetTexture(property.name, *texture);
                         }
                         break;
                     }
+                    default:
+                        break;
                 }
+
+#if VR_VULKAN
+                material->SetPropertySlot(property.name, property.slot);
+#endif
             }
         }
 
-        g_loading_cache.Add(path, material);
+        AddCache(path, material, CacheType::Material, 0);
+        context.materials.Add(path, material);
 
         return material;
     }
 
-    static void ReadRenderer(MemoryStream& ms, const Ref<Renderer>& renderer)
+    static void InstantiateRenderer(LoadContext& context, const PrefabNode* desc, const Ref<MeshRenderer>& renderer)
     {
-        int lightmap_index = ms.Read<int>();
-        Vector4 lightmapScaleOffset = ms.Read<Vector4>();
-        bool cast_shadow = ms.Read<byte>() == 1;
-        bool receive_shadow = ms.Read<byte>() == 1;
+        renderer->SetCastShadow(desc->cast_shadow);
+        renderer->SetReceiveShadow(desc->receive_shadow);
 
-        (void) lightmap_index;
-        (void) lightmapScaleOffset;
-        (void) cast_shadow;
-        (void) receive_shadow;
-        
-        int material_count = ms.Read<int>();
-        for (int i = 0; i < material_count; ++i)
+        for (const auto& i : desc->materials)
         {
-            String material_path = ReadString(ms);
-            if (material_path.Size() > 0)
+            Ref<Material> material = GetMaterial(context, i);
+            if (material)
             {
-                Ref<Material> material = ReadMaterial(material_path);
-                if (material)
-                {
-                    renderer->SetMaterial(material);
-                }
+                renderer->SetMaterial(material);
             }
         }
+
+        renderer->SetMesh(context.meshes[desc->mesh]);
     }
 
-    static void ReadMeshRenderer(MemoryStream& ms, const Ref<MeshRenderer>& renderer)
+    static Ref<Node> InstantiateNode(LoadContext& context, const PrefabNode* desc, const Ref<Node>& parent, Vector<Ref<Node>>& nodes)
     {
-        ReadRenderer(ms, renderer);
+        Ref<Node> node;
 
-        String mesh_path = ReadString(ms);
-        auto mesh = Mesh::LoadFromFile(Application::Instance()->GetDataPath() + "/" + mesh_path);
-        renderer->SetMesh(mesh);
-    }
+        if (desc->component == "MeshRenderer")
+        {
+            auto com = RefMake<MeshRenderer>();
+            InstantiateRenderer(context, desc, com);
+            node = com;
+        }
+        else if (desc->component == "SkinnedMeshRenderer")
+        {
+            auto com = RefMake<SkinnedMeshRenderer>();
+            InstantiateRenderer(context, desc, com);
+            com->SetBonePaths(desc->bones);
+            node = com;
 
-    static void ReadSkinnedMeshRenderer(MemoryStream& ms, const Ref<SkinnedMeshRenderer>& renderer)
-    {
-        ReadMeshRenderer(ms, renderer);
+            if (parent)
+            {
+                com->SetBonesRoot(Node::GetRoot(parent));
+            }
+            else
+            {
+                com->SetBonesRoot(com);
+            }
+        }
+        else if (desc->component == "Animation")
+        {
+            String key = context.prefab->path + "#" + desc->name;
+            Ref<AnimationClips> clips = FindCache<AnimationClips>(key);
+            if (!clips)
+            {
+                clips = RefMake<AnimationClips>();
+                clips->clips = desc->clips;
 
-        int bone_count = ms.Read<int>();
+                int bytes = 0;
+                for (const auto& clip : clips->clips)
+                {
+                    for (const auto& curve : clip.curves)
+                    {
+                        for (const auto& i : curve.curves)
+                        {
+                            bytes += i.GetKeyCount() * sizeof(float) * 4;
+                        }
+                    }
+                }
+                AddCache(key, clips, CacheType::Animation, bytes);
+            }
 
-        Vector<String> bones(bone_count);
-        for (int i = 0; i < bone_count; ++i)
+            auto com = RefMake<Animation>();
+            com->SetClips(clips);
+            node = com;
+        }
+        else
         {
-            bones[i] = ReadString(ms);
+            node = RefMake<Node>();
         }
-        renderer->SetBonePaths(bones);
-    }
 
-    static void ReadAnimation(MemoryStream& ms, const Ref<Animation>& animation)
-    {
-        int clip_count = ms.Read<int>();
+        if (parent)
+        {
+            Node::SetParent(node, parent);
+        }
+
+        node->SetName(desc->name);
+        node->SetLocalPosition(desc->local_position);
+        node->SetLocalRotation(desc->local_rotation);
+        node->SetLocalScale(desc->local_scale);
 
-        Vector<AnimationClip> clips(clip_count);
+        nodes.Add(node);
 
-        for (int i = 0; i < clip_count; ++i)
+        for (const auto& i : desc->children)
         {
-            String clip_name = ReadString(ms);
-            float clip_length = ms.Read<float>();
-            float clip_fps = ms.Read<float>();
-            int clip_wrap_mode = ms.Read<int>();
-            int curve_count = ms.Read<int>();
+            InstantiateNode(context, i.get(), node, nodes);
+        }
 
-            AnimationClip& clip = clips[i];
-            clip.name = clip_name;
-            clip.length = clip_length;
-            clip.fps = clip_fps;
-            clip.wrap_mode = (AnimationWrapMode) clip_wrap_mode;
+        return node;
+    }
 
-            for (int j = 0; j < curve_count; ++j)
-            {
-                String curve_path = ReadString(ms);
-                int property_type = ms.Read<int>();
-                int key_count = ms.Read<int>();
+    // a cooked prefab has its bones and curve targets as indices of the nodes in pre-order
+    static void SetTargets(const PrefabNode* desc, const Vector<Ref<Node>>& nodes, int& index)
+    {
+        const Ref<Node>& node = nodes[index];
+        index += 1;
 
-                AnimationCurveWrapper* curve = nullptr;
-                for (int k = 0; k < clip.curves.Size(); ++k)
+        if (desc->component == "SkinnedMeshRenderer" && desc->bone_nodes.Size() > 0 && desc->bone_nodes.Size() == desc->bones.Size())
+        {
+            Vector<Ref<Node>> bones(desc->bone_nodes.Size());
+            for (int i = 0; i < bones.Size(); ++i)
+            {
+                int bone = desc->bone_nodes[i];
+                if (bone >= 0 && bone < nodes.Size())
                 {
-                    if (clip.curves[k].path == curve_path)
-                    {
-                        curve = &clip.curves[k];
-                        break;
-                    }
+                    bones[i] = nodes[bone];
                 }
-                if (curve == nullptr)
+            }
+            RefCast<SkinnedMeshRenderer>(node)->SetBones(bones);
+        }
+        else if (desc->component == "Animation" && desc->curve_nodes.Size() == desc->clips.Size())
+        {
+            Ref<Animation> animation = RefCast<Animation>(node);
+            for (int i = 0; i < desc->curve_nodes.Size() && i < animation->GetClipCount(); ++i)
+            {
+                const Vector<int>& curve_nodes = desc->curve_nodes[i];
+                if (curve_nodes.Size() != animation->GetClips()->clips[i].curves.Size())
                 {
-                    AnimationCurveWrapper new_path_curve;
-                    new_path_curve.path = curve_path;
-                    clip.curves.Add(new_path_curve);
-                    curve = &clip.curves[clip.curves.Size() - 1];
+                    continue;
                 }
-                
-                curve->property_types.Add((CurvePropertyType) property_type);
-                curve->curves.Add(AnimationCurve());
-
-                AnimationCurve* anim_curve = &curve->curves[curve->curves.Size() - 1];
 
-                for (int k = 0; k < key_count; ++k)
+                Vector<Node*> targets(curve_nodes.Size());
+                for (int j = 0; j < targets.Size(); ++j)
                 {
-                    float time = ms.Read<float>();
-                    float value = ms.Read<float>();
-                    float in_tangent = ms.Read<float>();
-                    float out_tangent = ms.Read<float>();
-
-                    anim_curve->AddKey(time, value, in_tangent, out_tangent);
+                    int target = curve_nodes[j];
+                    targets[j] = (target >= 0 && target < nodes.Size()) ? nodes[target].get() : nullptr;
                 }
+                animation->SetTargets(i, targets);
             }
         }
 
-        animation->SetClips(std::move(clips));
+        for (const auto& i : desc->children)
+        {
+            SetTargets(i.get(), nodes, index);
+        }
     }
 
-    static Ref<Node> ReadNode(MemoryStream& ms, const Ref<Node>& parent)
+    static Ref<Node> InstantiatePrefab(LoadContext& context)
     {
-        Ref<Node> node;
+        Vector<Ref<Node>> nodes;
+        Ref<Node> node = InstantiateNode(context, context.prefab->root.get(), Ref<Node>(), nodes);
+
+        int index = 0;
+        SetTargets(context.prefab->root.get(), nodes, index);
+
+        return node;
+    }
+
+    static void ReportProgress(AsyncLoad* load)
+    {
+        load->step_done += 1;
+        if (load->progress)
+        {
+            load->progress(load->step_done / (float) load->step_count);
+        }
+    }
+
+    static void RunTask(const Thread::Task& task)
+    {
+        ThreadPool* pool = Application::Instance()->GetThreadPool();
+        if (pool)
+        {
+            pool->AddTask(task);
+        }
+        else
+        {
+            task.complete(task.job());
+        }
+    }
 
-        String name = ReadString(ms);
-        int layer = ms.Read<int>();
-        bool active = ms.Read<byte>() == 1;
+    // hands the object created for path to the loads waiting for it
+    static void NotifyWaiting(const LoadContext& context, bool texture, const String& path)
+    {
+        List<Ref<AsyncLoad>>* waiting;
+        if (g_waiting.TryGet(path, &waiting))
+        {
+            Ref<Object> object;
+            if (texture)
+            {
+                object = context.textures[path];
+            }
+            else
+            {
+                object = context.meshes[path];
+            }
 
-        (void) layer;
-        (void) active;
+            for (const auto& i : *waiting)
+            {
+                StoreObject(i->context, texture, path, object);
+                i->decode_pending -= 1;
+                ReportProgress(i.get());
+            }
+            g_waiting.Remove(path);
+        }
+    }
 
-        Vector3 local_pos = ms.Read<Vector3>();
-        Quaternion local_rot = ms.Read<Quaternion>();
-        Vector3 local_scale = ms.Read<Vector3>();
+    static void StartDecode(const Ref<AsyncLoad>& load)
+    {
+        const Ref<PrefabDesc>& prefab = load->context.prefab;
 
-        int com_count = ms.Read<int>();
-        for (int i = 0; i < com_count; ++i)
+        Vector<AsyncLoadItem> items;
+        for (const auto& i : prefab->textures)
+        {
+            items.Add({ true, i.first, Ref<Object>() });
+        }
+        for (const auto& i : prefab->meshes)
         {
-            String com_name = ReadString(ms);
+            items.Add({ false, i, Ref<Object>() });
+        }
+
+        // parse and instantiation, plus one step per cached or shared dependency, and per decoded file
+        // its decode and its gpu object. tasks start after counting, they may complete inline without a pool
+        load->step_count = 2;
+        load->step_done = 0;
+        int cached_count = 0;
+        Vector<Thread::Task> tasks;
 
-            if (com_name == "MeshRenderer")
+        for (const auto& i : items)
+        {
+            if (StoreCached(load->context, i.texture, i.path))
             {
-                assert(!node);
+                load->step_count += 1;
+                cached_count += 1;
+                continue;
+            }
 
-                auto com = RefMake<MeshRenderer>();
-                ReadMeshRenderer(ms, com);
-                node = com;
+            List<Ref<AsyncLoad>>* waiting;
+            if (g_waiting.TryGet(i.path, &waiting))
+            {
+                // another load is reading the file, NotifyWaiting hands over the object
+                waiting->AddLast(load);
+                load->step_count += 1;
+                load->decode_pending += 1;
+                continue;
             }
-            else if (com_name == "SkinnedMeshRenderer")
+            g_waiting.Add(i.path, List<Ref<AsyncLoad>>());
+
+            if (!NeedDecode(prefab.get(), i.texture, i.path))
             {
-                assert(!node);
+                load->ready.AddLast(i);
+                load->step_count += 1;
+                continue;
+            }
 
-                auto com = RefMake<SkinnedMeshRenderer>();
-                ReadSkinnedMeshRenderer(ms, com);
-                node = com;
+            load->step_count += 2;
+            load->decode_pending += 1;
 
-                if (parent)
+            AsyncLoadItem item = i;
+            Thread::Task task;
+            task.job = [=]() {
+                return LoadData(item.texture, item.path, prefab.get());
+            };
+            task.complete = [=](const Ref<Object>& res) {
+                AsyncLoadItem decoded = item;
+                decoded.data = res;
+                load->ready.AddLast(decoded);
+                load->decode_pending -= 1;
+                ReportProgress(load.get());
+            };
+            tasks.Add(task);
+        }
+
+        ReportProgress(load.get());
+        for (int i = 0; i < cached_count; ++i)
+        {
+            ReportProgress(load.get());
+        }
+
+        g_async_loads.AddLast(load);
+
+        for (const auto& i : tasks)
+        {
+            RunTask(i);
+        }
+    }
+
+    Ref<Node> Resources::Load(const String& path)
+    {
+        PROFILE_ZONE("Resources::Load");
+
+        Ref<Node> node;
+
+        LoadContext context;
+        context.prefab = ParsePrefab(path);
+        if (context.prefab)
+        {
+            const PrefabDesc* prefab = context.prefab.get();
+            for (const auto& i : prefab->textures)
+            {
+                if (StoreCached(context, true, i.first))
                 {
-                    com->SetBonesRoot(Node::GetRoot(parent));
+                    continue;
                 }
-                else
+
+                Ref<Object> data;
+                if (NeedDecode(prefab, true, i.first))
                 {
-                    com->SetBonesRoot(com);
+                    data = LoadData(true, i.first, prefab);
                 }
+                CreateObject(context, true, i.first, data);
             }
-            else if (com_name == "Animation")
+            for (const auto& i : prefab->meshes)
             {
-                assert(!node);
+                if (StoreCached(context, false, i))
+                {
+                    continue;
+                }
 
-                auto com = RefMake<Animation>();
-                ReadAnimation(ms, com);
-                node = com;
+                CreateObject(context, false, i, LoadData(false, i, prefab));
             }
+
+            node = InstantiatePrefab(context);
         }
 
-        if (!node)
+        return node;
+    }
+
+    Ref<Node> Resources::Instantiate(const String& path)
+    {
+        PROFILE_ZONE("Resources::Instantiate");
+
+        Ref<Node>* find;
+        if (g_prototypes.TryGet(path, &find))
         {
-            node = RefMake<Node>();
+            return Node::Instantiate(*find);
         }
 
-        if (parent)
+        Ref<Node> prototype = Resources::Load(path);
+        if (prototype)
         {
-            Node::SetParent(node, parent);
+            g_prototypes.Add(path, prototype);
+            return Node::Instantiate(prototype);
         }
 
-        node->SetName(name);
-        node->SetLocalPosition(local_pos);
-        node->SetLocalRotation(local_rot);
-        node->SetLocalScale(local_scale);
+        return Ref<Node>();
+    }
+
+    void Resources::LoadAsync(const String& path, LoadComplete complete, LoadProgress progress)
+    {
+        Ref<AsyncLoad> load = RefMake<AsyncLoad>();
+        load->complete = complete;
+        load->progress = progress;
+
+        Thread::Task task;
+        task.job = [=]() {
+            return ParsePrefab(path);
+        };
+        task.complete = [=](const Ref<Object>& res) {
+            load->context.prefab = RefCast<PrefabDesc>(res);
+            if (load->context.prefab)
+            {
+                StartDecode(load);
+            }
+            else
+            {
+                Log("prefab load failed: %s", path.CString());
+                if (load->complete)
+                {
+                    load->complete(Ref<Node>());
+                }
+            }
+        };
+        RunTask(task);
+    }
+
+    void Resources::Update()
+    {
+        PROFILE_ZONE("Resources::Update");
+
+        int budget = m_async_batch_size;
 
-        int child_count = ms.Read<int>();
-        for (int i = 0; i < child_count; ++i)
+        for (auto i = g_async_loads.begin(); i != g_async_loads.end(); )
         {
-            ReadNode(ms, node);
-        }
+            Ref<AsyncLoad> load = *i;
 
-        return node;
+            while (!load->ready.Empty() && budget > 0)
+            {
+                AsyncLoadItem item = load->ready.First();
+                load->ready.RemoveFirst();
+                CreateObject(load->context, item.texture, item.path, item.data);
+                NotifyWaiting(load->context, item.texture, item.path);
+                ReportProgress(load.get());
+                budget -= 1;
+            }
+
+            if (load->decode_pending == 0 && load->ready.Empty() && budget > 0)
+            {
+                i = g_async_loads.Remove(i);
+
+                Ref<Node> node = InstantiatePrefab(load->context);
+                budget -= 1;
+                ReportProgress(load.get());
+
+                if (load->complete)
+                {
+                    load->complete(node);
+                }
+            }
+            else
+            {
+                ++i;
+            }
+        }
     }
 
-    Ref<Node> Resources::Load(const String& path)
+    void Resources::Unload(const String& path)
     {
-        Ref<Node> node;
+        g_cache.Remove(path);
+        g_prototypes.Remove(path);
+    }
 
-        String full_path = Application::Instance()->GetDataPath() + "/" + path;
-        if (File::Exist(full_path))
+    void Resources::UnloadUnused()
+    {
+        for (auto i = g_cache.begin(); i != g_cache.end(); )
         {
-            MemoryStream ms(File::ReadAllBytes(full_path));
+            if (i->second.object.expired())
+            {
+                i = g_cache.Remove(i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
 
-            node = ReadNode(ms, Ref<Node>());
+    ResourceCacheStats Resources::GetCacheStats()
+    {
+        ResourceCacheStats stats;
+        stats.prototype_count = g_prototypes.Size();
 
-            g_loading_cache.Clear();
+        for (const auto& i : g_cache)
+        {
+            Ref<Object> object = i.second.object.lock();
+            if (!object)
+            {
+                continue;
+            }
+
+            switch (i.second.type)
+            {
+                case CacheType::Texture:
+                {
+                    Ref<Texture> texture = RefCast<Texture>(object);
+                    stats.texture_count += 1;
+                    if (TextureStreamer::IsStreamed(texture))
+                    {
+                        stats.texture_bytes += TextureStreamer::GetResidentBytes(texture);
+                    }
+                    else
+                    {
+                        stats.texture_bytes += i.second.bytes;
+                    }
+                    break;
+                }
+                case CacheType::Material:
+                    stats.material_count += 1;
+                    break;
+                case CacheType::Mesh:
+                    stats.mesh_count += 1;
+                    stats.mesh_bytes += i.second.bytes;
+                    break;
+                case CacheType::Animation:
+                    stats.animation_count += 1;
+                    stats.animation_bytes += i.second.bytes;
+                    break;
+            }
         }
 
-        return node;
+        return stats;
+    }
+
+    void Resources::Done()
+    {
+        g_async_loads.Clear();
+        g_waiting.Clear();
+        g_prototypes.Clear();
+        g_cache.Clear();
     }
 }
@@ -18,14 +18,53 @@
 #pragma once
 
 #include "string/String.h"
+#include <functional>
 
 namespace Viry3D
 {
     class Node;
 
+    struct ResourceCacheStats
+    {
+        int texture_count = 0;
+        int texture_bytes = 0;
+        int mesh_count = 0;
+        int mesh_bytes = 0;
+        int material_count = 0;
+        int animation_count = 0;
+        int animation_bytes = 0;
+        int prototype_count = 0;
+    };
+
+    // textures, meshes, materials and animation clips are shared by path between the loads while anything uses them.
+    // the cache holds weak references and is used on the main thread only
     class Resources
     {
     public:
+        typedef std::function<void(const Ref<Node>&)> LoadComplete;
+        typedef std::function<void(float)> LoadProgress;
+
         static Ref<Node> Load(const String& path);
+        // loads the prefab once into a prototype kept until Unload, each call returns a copy made without reading the file
+        static Ref<Node> Instantiate(const String& path);
+        // parses the prefab on a worker, decodes its textures and meshes in parallel on the thread pool,
+        // then creates the gpu objects in batches each frame. callbacks run on the main thread,
+        // complete gets a null node if the prefab can not be read
+        static void LoadAsync(const String& path, LoadComplete complete, LoadProgress progress = nullptr);
+        // once per frame, creates up to the batch size of gpu objects for the async loads
+        static void Update();
+        static void Done();
+        // the next load reads the file again, objects already in use stay alive with their users.
+        // a prefab path also releases the prototype of Instantiate
+        static void Unload(const String& path);
+        // drops the entries of released objects
+        static void UnloadUnused();
+        // live objects only, streamed textures count their resident levels
+        static ResourceCacheStats GetCacheStats();
+        static int GetAsyncBatchSize() { return m_async_batch_size; }
+        static void SetAsyncBatchSize(int count) { m_async_batch_size = count; }
+
+    private:
+        static int m_async_batch_size;
     };
 }
@@ -20,7 +20,8 @@
 
 namespace Viry3D
 {
-    Animation::Animation()
+    Animation::Animation():
+        m_clips(RefMake<AnimationClips>())
     {
     
     }
@@ -30,9 +31,96 @@ namespace Viry3D
     
     }
 
+    void Animation::SetClips(Vector<AnimationClip>&& clips)
+    {
+        m_clips = RefMake<AnimationClips>();
+        m_clips->clips = std::move(clips);
+        m_targets.Clear();
+    }
+
+    void Animation::SetClips(const Ref<AnimationClips>& clips)
+    {
+        m_clips = clips;
+        m_targets.Clear();
+    }
+
+    Ref<Node> Animation::Clone() const
+    {
+        Ref<Animation> animation = RefMake<Animation>();
+        animation->SetClips(m_clips);
+        return animation;
+    }
+
+    void Animation::OnInstantiate(Node* source, const Map<Node*, Ref<Node>>& copies)
+    {
+        Animation* animation = (Animation*) source;
+
+        // targets are found by path once on the source, the copies reuse them through the node map
+        m_targets.Resize(m_clips->clips.Size());
+        for (int i = 0; i < m_targets.Size(); ++i)
+        {
+            animation->FindTargets(i);
+
+            const auto& source_targets = animation->m_targets[i];
+            m_targets[i].Resize(source_targets.Size(), nullptr);
+            for (int j = 0; j < m_targets[i].Size(); ++j)
+            {
+                const Ref<Node>* copy;
+                if (source_targets[j] && copies.TryGet(source_targets[j], &copy))
+                {
+                    m_targets[i][j] = copy->get();
+                    m_targets[i][j]->EnableNotifyChildrenOnMatrixDirty(false);
+                }
+            }
+        }
+    }
+
+    void Animation::FindTargets(int clip_index)
+    {
+        if (m_targets.Size() == 0)
+        {
+            m_targets.Resize(m_clips->clips.Size());
+        }
+
+        auto& targets = m_targets[clip_index];
+        if (targets.Size() > 0)
+        {
+            return;
+        }
+
+        const auto& clip = m_clips->clips[clip_index];
+        targets.Resize(clip.curves.Size(), nullptr);
+        for (int i = 0; i < clip.curves.Size(); ++i)
+        {
+            Node* target = this->Find(clip.curves[i].path).get();
+            targets[i] = target;
+            if (target)
+            {
+                target->EnableNotifyChildrenOnMatrixDirty(false);
+            }
+        }
+    }
+
+    void Animation::SetTargets(int clip_index, const Vector<Node*>& targets)
+    {
+        if (m_targets.Size() == 0)
+        {
+            m_targets.Resize(m_clips->clips.Size());
+        }
+
+        m_targets[clip_index] = targets;
+        for (auto i : targets)
+        {
+            if (i)
+            {
+                i->EnableNotifyChildrenOnMatrixDirty(false);
+            }
+        }
+    }
+
     const String& Animation::GetClipName(int index) const
     {
-        return m_clips[index].name;
+        return m_clips->clips[index].name;
     }
 
     void Animation::Play(int index, float fade_length)
@@ -91,7 +179,7 @@ namespace Viry3D
         {
             auto& state = *i;
             float time = Time::GetTime() - state.play_start_time;
-            const auto& clip = m_clips[state.clip_index];
+            const auto& clip = m_clips->clips[state.clip_index];
             bool remove_later = false;
 
             if (time >= clip.length)
@@ -178,20 +266,19 @@ namespace Viry3D
 
     void Animation::Sample(AnimationState& state, float time, float weight, bool first_state, bool last_state)
     {
-        const auto& clip = m_clips[state.clip_index];
-        if (state.targets.Size() == 0)
-        {
-            state.targets.Resize(clip.curves.Size(), nullptr);
-        }
+        const auto& clip = m_clips->clips[state.clip_index];
+        this->FindTargets(state.clip_index);
+
+        auto& targets = m_targets[state.clip_index];
 
         for (int i = 0; i < clip.curves.Size(); ++i)
         {
             const auto& curve = clip.curves[i];
-            Node* target = state.targets[i];
+            Node* target = targets[i];
             if (target == nullptr)
             {
                 target = this->Find(curve.path).get();
-                state.targets[i] = target;
+                targets[i] = target;
                 if (target)
                 {
                     target->EnableNotifyChildrenOnMatrixDirty(false);
@@ -64,6 +64,13 @@ namespace Viry3D
         Vector<AnimationCurveWrapper> curves;
     };
 
+    // clips shared by the animations instantiated from the same file
+    class AnimationClips : public Object
+    {
+    public:
+        Vector<AnimationClip> clips;
+    };
+
     enum class FadeState
     {
         In,
@@ -75,7 +82,6 @@ namespace Viry3D
     {
         int clip_index;
         float play_start_time;
-        Vector<Node*> targets;
         FadeState fade_state;
         float fade_start_time;
         float fade_length;
@@ -88,18 +94,29 @@ namespace Viry3D
     public:
         Animation();
         virtual ~Animation();
-        void SetClips(Vector<AnimationClip>&& clips) { m_clips = std::move(clips); }
-        int GetClipCount() const { return m_clips.Size(); }
+        void SetClips(Vector<AnimationClip>&& clips);
+        void SetClips(const Ref<AnimationClips>& clips);
+        const Ref<AnimationClips>& GetClips() const { return m_clips; }
+        int GetClipCount() const { return m_clips->clips.Size(); }
         const String& GetClipName(int index) const;
+        // curve targets found ahead, e.g. from a cooked prefab, instead of by path when the clip is first sampled
+        void SetTargets(int clip_index, const Vector<Node*>& targets);
         void Play(int index, float fade_length);
         void Stop();
         void Update();
 
+    protected:
+        virtual Ref<Node> Clone() const;
+        virtual void OnInstantiate(Node* source, const Map<Node*, Ref<Node>>& copies);
+
     private:
+        void FindTargets(int clip_index);
         void Sample(AnimationState& state, float time, float weight, bool first_state, bool last_state);
 
     private:
-        Vector<AnimationClip> m_clips;
+        Ref<AnimationClips> m_clips;
         List<AnimationState> m_states;
+        // curve targets of each clip, found by path the first time the clip is sampled
+        Vector<Vector<Node*>> m_targets;
     };
 }
@@ -23,7 +23,7 @@ namespace Viry3D
 {
     class AnimationCurve
     {
-    private:
+    public:
         struct Key
         {
             float time;
@@ -34,7 +34,10 @@ namespace Viry3D
 
     public:
         void AddKey(float time, float value, float in_tangent, float out_tangent);
+        const Vector<Key>& GetKeys() const { return m_keys; }
+        void SetKeys(Vector<Key>&& keys) { m_keys = std::move(keys); }
         float Evaluate(float time) const;
+        int GetKeyCount() const { return m_keys.Size(); }
 
     private:
         static float Evaluate(float time, const Key& k0, const Key& k1);
@@ -0,0 +1,270 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "BonePalette.h"
+#include "BufferObject.h"
+#include "Texture.h"
+#include "Debug.h"
+#include "memory/Memory.h"
+#include "math/Mathf.h"
+
+namespace Viry3D
+{
+    int BonePalette::m_capacity = 0;
+    List<BonePalette::Span> BonePalette::m_free_spans;
+    Vector<Vector4> BonePalette::m_vectors;
+    int BonePalette::m_dirty_begin = 0;
+    int BonePalette::m_dirty_end = 0;
+#if VR_VULKAN
+    Ref<BufferObject> BonePalette::m_buffer;
+    Vector<Ref<BufferObject>> BonePalette::m_retired_buffers;
+    Vector<Ref<BufferObject>> BonePalette::m_retired_buffers_prev;
+#elif VR_GLES
+    Ref<Texture> BonePalette::m_texture;
+    Vector<Ref<Texture>> BonePalette::m_retired_textures;
+#endif
+
+    int BonePalette::Alloc(int bone_count)
+    {
+        assert(bone_count > 0);
+
+        for (auto i = m_free_spans.begin(); i != m_free_spans.end(); ++i)
+        {
+            if (i->count >= bone_count)
+            {
+                int offset = i->offset;
+                i->offset += bone_count;
+                i->count -= bone_count;
+                if (i->count == 0)
+                {
+                    m_free_spans.Remove(i);
+                }
+                return offset;
+            }
+        }
+
+        int free_tail = 0;
+        if (!m_free_spans.Empty() && m_free_spans.Last().offset + m_free_spans.Last().count == m_capacity)
+        {
+            free_tail = m_free_spans.Last().count;
+        }
+
+        int capacity = Mathf::Max(m_capacity * 2, BONE_PALETTE_ROW_BONES * 4);
+        while (capacity - m_capacity + free_tail < bone_count)
+        {
+            capacity *= 2;
+        }
+        BonePalette::Resize(capacity);
+
+        return BonePalette::Alloc(bone_count);
+    }
+
+    void BonePalette::Free(int offset, int bone_count)
+    {
+        if (offset < 0 || bone_count <= 0 || offset + bone_count > m_capacity)
+        {
+            return;
+        }
+
+        auto i = m_free_spans.begin();
+        while (i != m_free_spans.end() && i->offset < offset)
+        {
+            ++i;
+        }
+
+        Span span;
+        span.offset = offset;
+        span.count = bone_count;
+        i = m_free_spans.AddBefore(i, span);
+
+        auto next = i;
+        ++next;
+        if (next != m_free_spans.end() && i->offset + i->count == next->offset)
+        {
+            i->count += next->count;
+            m_free_spans.Remove(next);
+        }
+
+        if (i != m_free_spans.begin())
+        {
+            auto prev = i;
+            --prev;
+            if (prev->offset + prev->count == i->offset)
+            {
+                prev->count += i->count;
+                m_free_spans.Remove(i);
+            }
+        }
+    }
+
+    void BonePalette::SetBones(int offset, const Vector<Vector4>& bone_vectors)
+    {
+        int bone_count = bone_vectors.Size() / BONE_VECTOR_COUNT;
+        assert(offset >= 0 && offset + bone_count <= m_capacity);
+
+        Memory::Copy(&m_vectors[offset * BONE_VECTOR_COUNT], bone_vectors.Bytes(), bone_count * BONE_VECTOR_COUNT * sizeof(Vector4));
+
+        if (m_dirty_begin < m_dirty_end)
+        {
+            m_dirty_begin = Mathf::Min(m_dirty_begin, offset);
+            m_dirty_end = Mathf::Max(m_dirty_end, offset + bone_count);
+        }
+        else
+        {
+            m_dirty_begin = offset;
+            m_dirty_end = offset + bone_count;
+        }
+    }
+
+    void BonePalette::Update()
+    {
+        if (m_dirty_begin < m_dirty_end)
+        {
+            BonePalette::Flush(m_dirty_begin, m_dirty_end);
+
+            m_dirty_begin = 0;
+            m_dirty_end = 0;
+        }
+
+#if VR_VULKAN
+        // buffers retired last frame are no longer referenced by any submitted command
+        VkDevice device = Display::Instance()->GetDevice();
+        for (int i = 0; i < m_retired_buffers_prev.Size(); ++i)
+        {
+            m_retired_buffers_prev[i]->Destroy(device);
+        }
+        m_retired_buffers_prev = m_retired_buffers;
+        m_retired_buffers.Clear();
+#elif VR_GLES
+        m_retired_textures.Clear();
+#endif
+    }
+
+    void BonePalette::Done()
+    {
+#if VR_VULKAN
+        VkDevice device = Display::Instance()->GetDevice();
+        for (int i = 0; i < m_retired_buffers_prev.Size(); ++i)
+        {
+            m_retired_buffers_prev[i]->Destroy(device);
+        }
+        for (int i = 0; i < m_retired_buffers.Size(); ++i)
+        {
+            m_retired_buffers[i]->Destroy(device);
+        }
+        m_retired_buffers_prev.Clear();
+        m_retired_buffers.Clear();
+
+        if (m_buffer)
+        {
+            m_buffer->Destroy(device);
+            m_buffer.reset();
+        }
+#elif VR_GLES
+        m_retired_textures.Clear();
+        m_texture.reset();
+#endif
+
+        m_capacity = 0;
+        m_free_spans.Clear();
+        m_vectors.Clear();
+        m_dirty_begin = 0;
+        m_dirty_end = 0;
+    }
+
+    void BonePalette::Resize(int capacity)
+    {
+        assert(capacity % BONE_PALETTE_ROW_BONES == 0);
+
+        if (!m_free_spans.Empty() && m_free_spans.Last().offset + m_free_spans.Last().count == m_capacity)
+        {
+            m_free_spans.Last().count += capacity - m_capacity;
+        }
+        else
+        {
+            Span span;
+            span.offset = m_capacity;
+            span.count = capacity - m_capacity;
+            m_free_spans.AddLast(span);
+        }
+
+        m_capacity = capacity;
+        m_vectors.Resize(m_capacity * BONE_VECTOR_COUNT, Vector4(0, 0, 0, 0));
+
+#if VR_VULKAN
+        if (m_buffer)
+        {
+            m_retired_buffers.Add(m_buffer);
+        }
+        m_buffer = Display::Instance()->CreateBuffer(m_vectors.Bytes(), m_vectors.SizeInBytes(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+#elif VR_GLES
+        if (m_texture)
+        {
+            m_retired_textures.Add(m_texture);
+        }
+        m_texture = Texture::CreateTexture2DFromMemory(
+            ByteBuffer(m_vectors.Bytes(), m_vectors.SizeInBytes()),
+            BonePalette::GetTextureWidth(),
+            BonePalette::GetTextureHeight(),
+            TextureFormat::R32G32B32A32F,
+            FilterMode::Nearest,
+            SamplerAddressMode::ClampToEdge,
+            false,
+            true);
+#endif
+    }
+
+    void BonePalette::Flush(int begin, int end)
+    {
+#if VR_VULKAN
+        int vector_size = BONE_VECTOR_COUNT * sizeof(Vector4);
+
+        Display::Instance()->UpdateBuffer(m_buffer, begin * vector_size, m_vectors.Bytes(begin * BONE_VECTOR_COUNT), (end - begin) * vector_size);
+
+        // renderers updated before a resize in this frame still read the old buffer
+        for (int i = 0; i < m_retired_buffers.Size(); ++i)
+        {
+            int retired_end = Mathf::Min(end, m_retired_buffers[i]->GetSize() / vector_size);
+            if (begin < retired_end)
+            {
+                Display::Instance()->UpdateBuffer(m_retired_buffers[i], begin * vector_size, m_vectors.Bytes(begin * BONE_VECTOR_COUNT), (retired_end - begin) * vector_size);
+            }
+        }
+#elif VR_GLES
+        int row_size = BONE_PALETTE_ROW_BONES * BONE_VECTOR_COUNT;
+        int row_begin = begin / BONE_PALETTE_ROW_BONES;
+        int row_end = (end - 1) / BONE_PALETTE_ROW_BONES + 1;
+
+        m_texture->UpdateTexture2D(
+            ByteBuffer(m_vectors.Bytes(row_begin * row_size), (row_end - row_begin) * row_size * sizeof(Vector4)),
+            0, row_begin,
+            row_size, row_end - row_begin);
+
+        for (int i = 0; i < m_retired_textures.Size(); ++i)
+        {
+            int retired_row_end = Mathf::Min(row_end, m_retired_textures[i]->GetHeight());
+            if (row_begin < retired_row_end)
+            {
+                m_retired_textures[i]->UpdateTexture2D(
+                    ByteBuffer(m_vectors.Bytes(row_begin * row_size), (retired_row_end - row_begin) * row_size * sizeof(Vector4)),
+                    0, row_begin,
+                    row_size, retired_row_end - row_begin);
+            }
+        }
+#endif
+    }
+}
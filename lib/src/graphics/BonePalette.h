@@ -0,0 +1,80 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "Display.h"
+#include "container/List.h"
+#include "container/Vector.h"
+#include "math/Vector4.h"
+
+#define BONE_PALETTE "u_bone_palette"
+#define BONE_PALETTE_INFO "u_bone_palette_info"
+#define BONE_VECTOR_COUNT 3
+#define BONE_PALETTE_ROW_BONES 256
+#define BONE_MAX_GLESV2 30
+
+namespace Viry3D
+{
+    class BufferObject;
+    class Texture;
+
+    // all skinned meshes write bone matrices (3 rows per bone) into one shared palette,
+    // vulkan binds it as a storage buffer, gles3 as a float texture with BONE_PALETTE_ROW_BONES bones per row.
+    class BonePalette
+    {
+    public:
+        static int Alloc(int bone_count);
+        static void Free(int offset, int bone_count);
+        static void SetBones(int offset, const Vector<Vector4>& bone_vectors);
+        static void Update();
+        static void Done();
+        static int GetCapacity() { return m_capacity; }
+        static int GetTextureWidth() { return BONE_PALETTE_ROW_BONES * BONE_VECTOR_COUNT; }
+        static int GetTextureHeight() { return m_capacity / BONE_PALETTE_ROW_BONES; }
+#if VR_VULKAN
+        static const Ref<BufferObject>& GetBuffer() { return m_buffer; }
+#elif VR_GLES
+        static const Ref<Texture>& GetTexture() { return m_texture; }
+#endif
+
+    private:
+        struct Span
+        {
+            int offset;
+            int count;
+        };
+
+        static void Resize(int capacity);
+        static void Flush(int begin, int end);
+
+    private:
+        static int m_capacity;
+        static List<Span> m_free_spans;
+        static Vector<Vector4> m_vectors;
+        static int m_dirty_begin;
+        static int m_dirty_end;
+#if VR_VULKAN
+        static Ref<BufferObject> m_buffer;
+        static Vector<Ref<BufferObject>> m_retired_buffers;
+        static Vector<Ref<BufferObject>> m_retired_buffers_prev;
+#elif VR_GLES
+        static Ref<Texture> m_texture;
+        static Vector<Ref<Texture>> m_retired_textures;
+#endif
+    };
+}
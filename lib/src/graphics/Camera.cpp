@@ -20,7 +20,12 @@
 #include "Renderer.h"
 #include "Material.h"
 #include "Shader.h"
+#include "OcclusionCulling.h"
+#include "RenderTexturePool.h"
+#include "TextureStreamer.h"
+#include "RenderStats.h"
 #include "Debug.h"
+#include "Profiler.h"
 
 namespace Viry3D
 {
@@ -39,6 +44,7 @@ namespace Viry3D
 		m_clear_color(0, 0, 0, 1),
 		m_viewport_rect(0, 0, 1, 1),
 		m_depth(0),
+        m_render_target_pooled(false),
         m_view_matrix_dirty(true),
         m_projection_matrix_dirty(true),
         m_field_of_view(45),
@@ -54,6 +60,8 @@ namespace Viry3D
 
 	Camera::~Camera()
 	{
+        this->SetRenderTarget(Ref<Texture>(), Ref<Texture>());
+
 #if VR_VULKAN
 		this->ClearRenderPass();
 		this->ClearInstanceCmds();
@@ -221,6 +229,13 @@ namespace Viry3D
 
 	void Camera::SetRenderTarget(const Ref<Texture>& color_texture, const Ref<Texture>& depth_texture)
 	{
+        if (m_render_target_pooled)
+        {
+            RenderTexturePool::Release(m_render_target_color);
+            RenderTexturePool::Release(m_render_target_depth);
+            m_render_target_pooled = false;
+        }
+
 		m_render_target_color = color_texture;
 		m_render_target_depth = depth_texture;
 
@@ -229,8 +244,34 @@ namespace Viry3D
 #endif
 	}
 
+    void Camera::AcquireRenderTarget(
+        int width,
+        int height,
+        TextureFormat color_format,
+        TextureFormat depth_format,
+        int sample_count,
+        FilterMode filter_mode)
+    {
+        Ref<Texture> color_texture;
+        Ref<Texture> depth_texture;
+
+        if (color_format != TextureFormat::None)
+        {
+            color_texture = RenderTexturePool::Acquire(width, height, color_format, sample_count, true, filter_mode);
+        }
+        if (depth_format != TextureFormat::None)
+        {
+            depth_texture = RenderTexturePool::Acquire(width, height, depth_format, sample_count, true, FilterMode::Nearest);
+        }
+
+        this->SetRenderTarget(color_texture, depth_texture);
+        m_render_target_pooled = true;
+    }
+
 	void Camera::Update()
 	{
+        PROFILE_ZONE("Camera::Update");
+
         if (m_view_matrix_dirty)
         {
             this->GetViewMatrix();
@@ -262,10 +303,28 @@ namespace Viry3D
 #endif
 		}
 
+        if (m_occlusion_culling)
+        {
+            m_occlusion_culling->Cull(this);
+        }
+
+        TextureStreamer::OnCameraUpdate(this);
+
 		this->UpdateRenderers();
 
 #if VR_VULKAN
 		this->UpdateInstanceCmds();
+
+        // recorded cmds replay every frame
+        for (const auto& i : m_renderers)
+        {
+            if (i.cmd_draw)
+            {
+                RenderStats::Add(RenderStat::PipelineBinds);
+                RenderStats::Add(RenderStat::DescriptorSetBinds);
+                RenderStats::AddDraw(i.renderer->GetDrawInstanceCount(), i.renderer->GetDrawIndexCount());
+            }
+        }
 #endif
 	}
 
@@ -551,6 +610,11 @@ namespace Viry3D
 
     void Camera::RemoveRenderer(const Ref<Renderer>& renderer)
     {
+        if (m_occlusion_culling)
+        {
+            renderer->SetCulled(false);
+        }
+
 #if VR_VULKAN
         VkDevice device = Display::Instance()->GetDevice();
         Display::Instance()->WaitDevice();
@@ -583,6 +647,19 @@ namespace Viry3D
         m_renderer_order_dirty = true;
     }
 
+    void Camera::SetOcclusionCulling(const Ref<OcclusionCulling>& culling)
+    {
+        if (m_occlusion_culling && !culling)
+        {
+            for (auto& i : m_renderers)
+            {
+                i.renderer->SetCulled(false);
+            }
+        }
+
+        m_occlusion_culling = culling;
+    }
+
     void Camera::UpdateRenderers()
     {
         for (auto& i : m_renderers)
@@ -640,7 +717,8 @@ namespace Viry3D
                     Display::Instance()->CreateCommandBuffer(m_cmd_pool, VK_COMMAND_BUFFER_LEVEL_SECONDARY, &i.cmd);
                 }
 
-                this->BuildInstanceCmd(i.cmd, i.renderer);
+                i.cmd_draw = this->BuildInstanceCmd(i.cmd, i.renderer);
+                RenderStats::Add(RenderStat::CmdsRecorded);
 
                 Display::Instance()->MarkPrimaryCmdDirty();
             }
@@ -705,7 +783,7 @@ namespace Viry3D
         }
     }
 
-    void Camera::BuildInstanceCmd(VkCommandBuffer cmd, const Ref<Renderer>& renderer)
+    bool Camera::BuildInstanceCmd(VkCommandBuffer cmd, const Ref<Renderer>& renderer)
     {
         const Ref<Material>& material = renderer->GetMaterial();
         Ref<BufferObject> vertex_buffer = renderer->GetVertexBuffer();
@@ -718,7 +796,7 @@ namespace Viry3D
         if (!material || !vertex_buffer || !index_buffer || !draw_buffer || instance_count <= 0)
         {
             Display::Instance()->BuildEmptyInstanceCmd(cmd, m_render_pass);
-            return;
+            return false;
         }
 
         const Ref<Material>& instance_material = renderer->GetInstanceMaterial();
@@ -770,6 +848,8 @@ namespace Viry3D
             index_buffer,
             draw_buffer,
             instance_buffer);
+
+        return true;
     }
 #endif
 }
@@ -19,6 +19,7 @@
 
 #include "Node.h"
 #include "Display.h"
+#include "Texture.h"
 #include "CameraClearFlags.h"
 #include "Color.h"
 #include "math/Rect.h"
@@ -30,12 +31,14 @@ namespace Viry3D
 {
     class Texture;
     class Renderer;
+    class OcclusionCulling;
 
     struct RendererInstance
     {
         Ref<Renderer> renderer;
 #if VR_VULKAN
         bool cmd_dirty = true;
+        bool cmd_draw = false;
         VkCommandBuffer cmd = VK_NULL_HANDLE;
 #endif
 
@@ -63,6 +66,15 @@ namespace Viry3D
         const Ref<Texture>& GetRenderTargetColor() const { return m_render_target_color; }
         const Ref<Texture>& GetRenderTargetDepth() const { return m_render_target_depth; }
         void SetRenderTarget(const Ref<Texture>& color_texture, const Ref<Texture>& depth_texture);
+        // color and depth from RenderTexturePool, TextureFormat::None skips one, depth is sampled nearest.
+        // they go back to the pool when the target is set again or the camera is destroyed
+        void AcquireRenderTarget(
+            int width,
+            int height,
+            TextureFormat color_format,
+            TextureFormat depth_format,
+            int sample_count = 1,
+            FilterMode filter_mode = FilterMode::Linear);
         void Update();
         void OnFrameEnd();
         void OnResize(int width, int height);
@@ -71,6 +83,7 @@ namespace Viry3D
         int GetTargetHeight() const;
         void AddRenderer(const Ref<Renderer>& renderer);
         void RemoveRenderer(const Ref<Renderer>& renderer);
+        const List<RendererInstance>& GetRenderers() const { return m_renderers; }
         float GetFieldOfView() const { return m_field_of_view; }
         void SetFieldOfView(float fov);
         float GetNearClip() const { return m_near_clip; }
@@ -86,6 +99,8 @@ namespace Viry3D
         const Matrix4x4& GetViewMatrix();
         const Matrix4x4& GetProjectionMatrix();
         void MarkRendererOrderDirty();
+        const Ref<OcclusionCulling>& GetOcclusionCulling() const { return m_occlusion_culling; }
+        void SetOcclusionCulling(const Ref<OcclusionCulling>& culling);
 #if VR_VULKAN
         void MarkInstanceCmdDirty(Renderer* renderer);
         VkRenderPass GetRenderPass() const { return m_render_pass; }
@@ -106,7 +121,7 @@ namespace Viry3D
         void ClearRenderPass();
         void UpdateInstanceCmds();
         void ClearInstanceCmds();
-        void BuildInstanceCmd(VkCommandBuffer cmd, const Ref<Renderer>& renderer);
+        bool BuildInstanceCmd(VkCommandBuffer cmd, const Ref<Renderer>& renderer);
 #elif VR_GLES
         void BindTarget();
         void ClearTarget();
@@ -131,6 +146,7 @@ namespace Viry3D
         int m_depth;
         Ref<Texture> m_render_target_color;
         Ref<Texture> m_render_target_depth;
+        bool m_render_target_pooled;
         List<RendererInstance> m_renderers;
         Matrix4x4 m_view_matrix;
         bool m_view_matrix_dirty;
@@ -143,5 +159,6 @@ namespace Viry3D
         float m_orthographic_size;
         bool m_view_matrix_external;
         bool m_projection_matrix_external;
+        Ref<OcclusionCulling> m_occlusion_culling;
     };
 }
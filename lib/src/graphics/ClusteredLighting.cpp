@@ -0,0 +1,353 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "ClusteredLighting.h"
+#include "Application.h"
+#include "Camera.h"
+#include "Light.h"
+#include "Material.h"
+#include "Renderer.h"
+#include "BufferObject.h"
+#include "Texture.h"
+#include "Debug.h"
+#include "math/Mathf.h"
+#include "thread/ThreadPool.h"
+
+namespace Viry3D
+{
+    ClusteredLighting::ClusteredLighting(int cluster_x, int cluster_y, int cluster_z):
+        m_cluster_x(cluster_x),
+        m_cluster_y(cluster_y),
+        m_cluster_z(cluster_z),
+        m_max_distance(100)
+    {
+        m_slices.Resize(m_cluster_z);
+
+#if VR_GLES
+        // gles2 needs OES_texture_float
+        m_float_texture_supported = Texture::IsFormatSupported(TextureFormat::R32G32B32A32F);
+        if (!m_float_texture_supported)
+        {
+            Log("clustered lighting disabled, float texture not supported");
+        }
+#endif
+    }
+
+    ClusteredLighting::~ClusteredLighting()
+    {
+#if VR_VULKAN
+        VkDevice device = Display::Instance()->GetDevice();
+        for (int i = 0; i < m_retired_buffers_prev.Size(); ++i)
+        {
+            m_retired_buffers_prev[i]->Destroy(device);
+        }
+        for (int i = 0; i < m_retired_buffers.Size(); ++i)
+        {
+            m_retired_buffers[i]->Destroy(device);
+        }
+        if (m_buffer)
+        {
+            m_buffer->Destroy(device);
+            m_buffer.reset();
+        }
+#endif
+    }
+
+    void ClusteredLighting::AddLight(const Ref<Light>& light)
+    {
+        assert(light->GetType() == LightType::Point || light->GetType() == LightType::Spotlight);
+
+        for (const auto& i : m_lights)
+        {
+            if (i == light)
+            {
+                return;
+            }
+        }
+
+        m_lights.Add(light);
+    }
+
+    void ClusteredLighting::RemoveLight(const Ref<Light>& light)
+    {
+        m_lights.Remove(light);
+    }
+
+    void ClusteredLighting::Update(Camera* view_camera)
+    {
+#if VR_GLES
+        if (!m_float_texture_supported)
+        {
+            return;
+        }
+#endif
+
+        const Matrix4x4& view = view_camera->GetViewMatrix();
+        Matrix4x4 inverse_projection = view_camera->GetProjectionMatrix().Inverse();
+
+        float near_clip = Mathf::Max(view_camera->GetNearClip(), 0.01f);
+        float far_clip = Mathf::Max(Mathf::Min(view_camera->GetFarClip(), m_max_distance), near_clip * 2);
+        float log_depth = logf(far_clip / near_clip);
+
+        // exponential slices keep clusters roughly cubic along the view depth
+        m_slice_depths.Resize(m_cluster_z + 1);
+        for (int i = 0; i <= m_cluster_z; ++i)
+        {
+            m_slice_depths[i] = near_clip * powf(far_clip / near_clip, i / (float) m_cluster_z);
+        }
+        m_slice_depths[m_cluster_z] = Mathf::Max(view_camera->GetFarClip(), far_clip);
+
+        m_grid = Vector4((float) m_cluster_x, (float) m_cluster_y, (float) m_cluster_z, 0);
+        m_depth = Vector4(near_clip, m_cluster_z / log_depth, -m_cluster_z * logf(near_clip) / log_depth, 0);
+
+        // view space rays through the tile corners
+        m_tile_near_points.Resize((m_cluster_x + 1) * (m_cluster_y + 1));
+        m_tile_far_points.Resize((m_cluster_x + 1) * (m_cluster_y + 1));
+        for (int i = 0; i <= m_cluster_y; ++i)
+        {
+            for (int j = 0; j <= m_cluster_x; ++j)
+            {
+                float x = -1.0f + 2.0f * j / m_cluster_x;
+                float y = -1.0f + 2.0f * i / m_cluster_y;
+                m_tile_near_points[i * (m_cluster_x + 1) + j] = inverse_projection.MultiplyPoint(Vector3(x, y, -1));
+                m_tile_far_points[i * (m_cluster_x + 1) + j] = inverse_projection.MultiplyPoint(Vector3(x, y, 1));
+            }
+        }
+
+        m_view_lights.Resize(m_lights.Size());
+        for (int i = 0; i < m_lights.Size(); ++i)
+        {
+            m_view_lights[i].position = view.MultiplyPoint(m_lights[i]->GetPosition());
+            m_view_lights[i].range = m_lights[i]->GetRange();
+        }
+
+        ThreadPool::ParallelFor(Application::Instance()->GetThreadPool(), m_cluster_z, [this](int i) {
+            this->BinSlice(i);
+        });
+
+        this->Upload();
+
+        for (const auto& i : view_camera->GetRenderers())
+        {
+            const Ref<Material>& material = i.renderer->GetMaterial();
+            if (!material)
+            {
+                continue;
+            }
+
+            // rebinding the same buffer would rewrite descriptors still used by the last frame
+            const MaterialProperty* property;
+#if VR_VULKAN
+            if (!material->GetProperties().TryGet(CLUSTER_DATA, &property) || property->buffer != m_buffer)
+            {
+                material->SetStorageBuffer(CLUSTER_DATA, m_buffer);
+            }
+#elif VR_GLES
+            if (!material->GetProperties().TryGet(CLUSTER_TEXTURE, &property) || property->texture != m_texture)
+            {
+                material->SetTexture(CLUSTER_TEXTURE, m_texture);
+            }
+            material->SetVector(CLUSTER_TEXTURE_SIZE, Vector4((float) m_texture->GetWidth(), (float) m_texture->GetHeight(), 1.0f / m_texture->GetWidth(), 1.0f / m_texture->GetHeight()));
+#endif
+            material->SetVector(CLUSTER_GRID, m_grid);
+            material->SetVector(CLUSTER_DEPTH, m_depth);
+        }
+    }
+
+    void ClusteredLighting::BinSlice(int z)
+    {
+        Slice& slice = m_slices[z];
+        slice.light_indices.Clear();
+        slice.cluster_offsets.Resize(m_cluster_x * m_cluster_y);
+        slice.cluster_counts.Resize(m_cluster_x * m_cluster_y);
+
+        float near_depth = m_slice_depths[z];
+        float far_depth = m_slice_depths[z + 1];
+
+        Vector<int> slice_lights;
+        for (int i = 0; i < m_view_lights.Size(); ++i)
+        {
+            float depth = -m_view_lights[i].position.z;
+            if (depth + m_view_lights[i].range >= near_depth && depth - m_view_lights[i].range <= far_depth)
+            {
+                slice_lights.Add(i);
+            }
+        }
+
+        for (int i = 0; i < m_cluster_y; ++i)
+        {
+            for (int j = 0; j < m_cluster_x; ++j)
+            {
+                Vector3 min(Mathf::MaxFloatValue, Mathf::MaxFloatValue, Mathf::MaxFloatValue);
+                Vector3 max(Mathf::MinFloatValue, Mathf::MinFloatValue, Mathf::MinFloatValue);
+                for (int k = 0; k < 4; ++k)
+                {
+                    int corner = (i + k / 2) * (m_cluster_x + 1) + j + k % 2;
+                    const Vector3& near_point = m_tile_near_points[corner];
+                    const Vector3& far_point = m_tile_far_points[corner];
+
+                    for (int l = 0; l < 2; ++l)
+                    {
+                        float depth = l == 0 ? near_depth : far_depth;
+                        float t = (depth + near_point.z) / (near_point.z - far_point.z);
+                        Vector3 p = near_point + (far_point - near_point) * t;
+                        min = Vector3::Min(min, p);
+                        max = Vector3::Max(max, p);
+                    }
+                }
+
+                int cluster = i * m_cluster_x + j;
+                int offset = slice.light_indices.Size();
+                int count = 0;
+
+                for (int k = 0; k < slice_lights.Size() && count < CLUSTER_LIGHT_MAX; ++k)
+                {
+                    const ViewLight& light = m_view_lights[slice_lights[k]];
+                    Vector3 closest = Vector3::Max(min, Vector3::Min(max, light.position));
+                    if ((closest - light.position).SqrMagnitude() <= light.range * light.range)
+                    {
+                        slice.light_indices.Add(slice_lights[k]);
+                        ++count;
+                    }
+                }
+
+                // lists are padded to whole vectors, shaders skip negative indices
+                while (slice.light_indices.Size() % 4 != 0)
+                {
+                    slice.light_indices.Add(-1);
+                }
+
+                slice.cluster_offsets[cluster] = offset / 4;
+                slice.cluster_counts[cluster] = (slice.light_indices.Size() - offset) / 4;
+            }
+        }
+    }
+
+    void ClusteredLighting::Upload()
+    {
+        int cluster_count = m_cluster_x * m_cluster_y * m_cluster_z;
+        int index_vector_count = 0;
+        for (int i = 0; i < m_slices.Size(); ++i)
+        {
+            index_vector_count += m_slices[i].light_indices.Size() / 4;
+        }
+        int light_base = cluster_count + index_vector_count;
+
+        m_data.Resize(light_base + m_lights.Size() * CLUSTER_LIGHT_VECTOR_COUNT);
+        m_grid.w = (float) light_base;
+
+        int index_base = cluster_count;
+        for (int i = 0; i < m_slices.Size(); ++i)
+        {
+            const Slice& slice = m_slices[i];
+            int slice_cluster_count = m_cluster_x * m_cluster_y;
+
+            for (int j = 0; j < slice_cluster_count; ++j)
+            {
+                m_data[i * slice_cluster_count + j] = Vector4((float) (index_base + slice.cluster_offsets[j]), (float) slice.cluster_counts[j], 0, 0);
+            }
+
+            for (int j = 0; j < slice.light_indices.Size(); j += 4)
+            {
+                m_data[index_base + j / 4] = Vector4(
+                    (float) slice.light_indices[j + 0],
+                    (float) slice.light_indices[j + 1],
+                    (float) slice.light_indices[j + 2],
+                    (float) slice.light_indices[j + 3]);
+            }
+            index_base += slice.light_indices.Size() / 4;
+        }
+
+        for (int i = 0; i < m_lights.Size(); ++i)
+        {
+            const Ref<Light>& light = m_lights[i];
+            const Color& color = light->GetColor();
+            Vector3 position = light->GetPosition();
+            Vector3 direction = light->GetForward();
+
+            // point lights get a cone no direction can fall outside of,
+            // spot lights fade out over the outer quarter of the cone
+            float cos_outer = -2.0f;
+            float cos_inner = -1.0f;
+            if (light->GetType() == LightType::Spotlight)
+            {
+                float half_angle = light->GetSpotAngle() * 0.5f * Mathf::Deg2Rad;
+                cos_outer = cosf(half_angle);
+                cos_inner = cosf(half_angle * 0.75f);
+            }
+
+            Vector4* vectors = &m_data[light_base + i * CLUSTER_LIGHT_VECTOR_COUNT];
+            vectors[0] = Vector4(position.x, position.y, position.z, light->GetRange());
+            vectors[1] = Vector4(color.r * light->GetIntensity(), color.g * light->GetIntensity(), color.b * light->GetIntensity(), cos_outer);
+            vectors[2] = Vector4(direction.x, direction.y, direction.z, cos_inner);
+        }
+
+#if VR_VULKAN
+        VkDevice device = Display::Instance()->GetDevice();
+        for (int i = 0; i < m_retired_buffers_prev.Size(); ++i)
+        {
+            m_retired_buffers_prev[i]->Destroy(device);
+        }
+        m_retired_buffers_prev = m_retired_buffers;
+        m_retired_buffers.Clear();
+
+        if (!m_buffer || m_buffer->GetSize() < m_data.SizeInBytes())
+        {
+            int size = m_data.SizeInBytes();
+            if (m_buffer)
+            {
+                size = Mathf::Max(size, m_buffer->GetSize() * 2);
+
+                // the last frame may still read the old buffer
+                m_retired_buffers.Add(m_buffer);
+            }
+            m_buffer = Display::Instance()->CreateBuffer(nullptr, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        }
+
+        Display::Instance()->UpdateBuffer(m_buffer, 0, m_data.Bytes(), m_data.SizeInBytes());
+#elif VR_GLES
+        int rows = (m_data.Size() + CLUSTER_TEXTURE_WIDTH - 1) / CLUSTER_TEXTURE_WIDTH;
+        m_data.Resize(rows * CLUSTER_TEXTURE_WIDTH, Vector4(0, 0, 0, 0));
+
+        if (!m_texture || m_texture->GetHeight() < rows)
+        {
+            if (m_texture)
+            {
+                rows = Mathf::Max(rows, m_texture->GetHeight() * 2);
+                m_data.Resize(rows * CLUSTER_TEXTURE_WIDTH, Vector4(0, 0, 0, 0));
+            }
+
+            m_texture = Texture::CreateTexture2DFromMemory(
+                ByteBuffer(m_data.Bytes(), m_data.SizeInBytes()),
+                CLUSTER_TEXTURE_WIDTH,
+                rows,
+                TextureFormat::R32G32B32A32F,
+                FilterMode::Nearest,
+                SamplerAddressMode::ClampToEdge,
+                false,
+                true);
+        }
+        else
+        {
+            m_texture->UpdateTexture2D(
+                ByteBuffer(m_data.Bytes(), m_data.SizeInBytes()),
+                0, 0,
+                CLUSTER_TEXTURE_WIDTH, rows);
+        }
+#endif
+    }
+}
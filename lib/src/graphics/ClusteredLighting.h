@@ -0,0 +1,99 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "Display.h"
+#include "container/Vector.h"
+#include "math/Vector3.h"
+#include "math/Vector4.h"
+
+#define CLUSTER_DATA "u_cluster_data"
+#define CLUSTER_TEXTURE "u_cluster_texture"
+#define CLUSTER_TEXTURE_SIZE "u_cluster_texture_size"
+#define CLUSTER_GRID "u_cluster_grid"
+#define CLUSTER_DEPTH "u_cluster_depth"
+
+#define CLUSTER_LIGHT_MAX 64
+#define CLUSTER_LIGHT_VECTOR_COUNT 3
+#define CLUSTER_TEXTURE_WIDTH 1024
+
+namespace Viry3D
+{
+    class Light;
+    class Camera;
+    class BufferObject;
+    class Texture;
+
+    // bins point and spot lights into view frustum clusters on the cpu every frame.
+    // one vec4 array holds the cluster headers, the per cluster light index lists and the lights,
+    // vulkan reads it from a storage buffer, gles from a float texture, without float textures Update does nothing.
+    class ClusteredLighting
+    {
+    public:
+        ClusteredLighting(int cluster_x = 16, int cluster_y = 9, int cluster_z = 24);
+        ~ClusteredLighting();
+        void AddLight(const Ref<Light>& light);
+        void RemoveLight(const Ref<Light>& light);
+        int GetLightCount() const { return m_lights.Size(); }
+        // depth covered by the z slices, the last slice extends to the camera far clip
+        float GetMaxDistance() const { return m_max_distance; }
+        void SetMaxDistance(float distance) { m_max_distance = distance; }
+        // call once per frame, feeds the materials of all renderers of view_camera
+        void Update(Camera* view_camera);
+
+    private:
+        struct ViewLight
+        {
+            Vector3 position;
+            float range;
+        };
+
+        struct Slice
+        {
+            Vector<int> light_indices;
+            Vector<int> cluster_offsets;
+            Vector<int> cluster_counts;
+        };
+
+        void BinSlice(int z);
+        void Upload();
+
+    private:
+        int m_cluster_x;
+        int m_cluster_y;
+        int m_cluster_z;
+        float m_max_distance;
+        Vector<Ref<Light>> m_lights;
+        Vector<ViewLight> m_view_lights;
+        Vector<Vector3> m_tile_near_points;
+        Vector<Vector3> m_tile_far_points;
+        Vector<float> m_slice_depths;
+        Vector<Slice> m_slices;
+        Vector<Vector4> m_data;
+        Vector4 m_grid;
+        Vector4 m_depth;
+#if VR_VULKAN
+        Ref<BufferObject> m_buffer;
+        Vector<Ref<BufferObject>> m_retired_buffers;
+        Vector<Ref<BufferObject>> m_retired_buffers_prev;
+#elif VR_GLES
+        Ref<Texture> m_texture;
+        bool m_float_texture_supported;
+#endif
+    };
+}
@@ -27,6 +27,13 @@
 #include "Mesh.h"
 #include "Material.h"
 #include "MeshRenderer.h"
+#include "BonePalette.h"
+#include "SkinningPrePass.h"
+#include "RenderTexturePool.h"
+#include "TextureStreamer.h"
+#include "GpuProfiler.h"
+#include "RenderStats.h"
+#include "time/Time.h"
 #include "container/List.h"
 #include "string/String.h"
 #include "memory/Memory.h"
@@ -34,11 +41,6 @@
 #include "io/File.h"
 #include "Debug.h"
 
-extern "C"
-{
-#include "crypto/md5/md5.h"
-}
-
 #ifdef max
 #undef max
 #endif
@@ -48,9 +50,7 @@ extern "C"
 #endif
 
 #if VR_VULKAN
-#include "vulkan/spirv_cross/spirv_glsl.hpp"
-
-#if VR_WINDOWS || VR_ANDROID
+#if VR_WINDOWS || VR_ANDROID || VR_LINUX
 #include "vulkan/vulkan_shader_compiler.h"
 #elif VR_IOS || VR_MAC
 #include "GLSLConversion.h"
@@ -104,18 +104,22 @@ namespace Viry3D
 
     static void GlslToSpirvCached(const String& glsl, VkShaderStageFlagBits shader_type, Vector<unsigned int>& spirv)
     {
-        unsigned char hash_bytes[16];
-        MD5_CTX md5_context;
-        MD5_Init(&md5_context);
-        MD5_Update(&md5_context, (void*) glsl.CString(), glsl.Size());
-        MD5_Final(hash_bytes, &md5_context);
-        String md5_str;
-        for (int i = 0; i < sizeof(hash_bytes); ++i)
+        String spirv_name = Shader::GetSpirvName(glsl);
+
+        // spir-v from the asset cooker, read through the file system so it also comes from a pak
+        String cooked_path = Application::Instance()->GetDataPath() + "/shader/Cache/" + spirv_name + ".spv";
+        if (File::Exist(cooked_path))
         {
-            md5_str += String::Format("%02x", hash_bytes[i]);
+            auto buffer = File::ReadAllBytes(cooked_path);
+            if (buffer.Size() > 0 && buffer.Size() % 4 == 0)
+            {
+                spirv.Resize(buffer.Size() / 4);
+                Memory::Copy(&spirv[0], buffer.Bytes(), buffer.Size());
+                return;
+            }
         }
 
-        String cache_path = Application::Instance()->GetSavePath() + "/" + md5_str + ".cache";
+        String cache_path = Application::Instance()->GetSavePath() + "/" + spirv_name + ".cache";
         if (File::Exist(cache_path))
         {
             auto buffer = File::ReadAllBytes(cache_path);
@@ -124,7 +128,7 @@ namespace Viry3D
         }
         else
         {
-#if VR_WINDOWS || VR_ANDROID
+#if VR_WINDOWS || VR_ANDROID || VR_LINUX
             String error;
             bool success = GlslToSpv(shader_type, glsl.CString(), spirv, error);
             if (!success)
@@ -141,6 +145,9 @@ namespace Viry3D
                 case VK_SHADER_STAGE_FRAGMENT_BIT:
                     stage = kMVKShaderStageFragment;
                     break;
+                case VK_SHADER_STAGE_COMPUTE_BIT:
+                    stage = kMVKShaderStageCompute;
+                    break;
                 default:
                     stage = kMVKShaderStageAuto;
                     break;
@@ -174,33 +181,6 @@ namespace Viry3D
         }
     }
 
-    static String ProcessShaderSource(const String& glsl, const String& predefine, const Vector<String>& includes)
-    {
-        static const String s_shader_header =
-            "#version 310 es\n"
-            "#extension GL_ARB_separate_shader_objects : enable\n"
-            "#extension GL_ARB_shading_language_420pack : enable\n"
-            "#define VR_VULKAN 1\n"
-            "#define UniformBuffer(set_index, binding_index) layout(std140, set = set_index, binding = binding_index)\n"
-            "#define UniformTexture(set_index, binding_index) layout(set = set_index, binding = binding_index)\n"
-            "#define Input(location_index) layout(location = location_index) in\n"
-            "#define Output(location_index) layout(location = location_index) out\n";
-
-        String source = s_shader_header;
-        source += predefine + "\n";
-
-        for (const auto& i : includes)
-        {
-            auto include_path = Application::Instance()->GetDataPath() + "/shader/Include/" + i;
-            auto bytes = File::ReadAllBytes(include_path);
-            auto include_str = String(bytes);
-            source += include_str + "\n";
-        }
-        source += glsl;
-
-        return source;
-    }
-
     static VKAPI_ATTR VkBool32 VKAPI_CALL
         DebugFunc(VkFlags msgFlags, VkDebugReportObjectTypeEXT objType,
             uint64_t srcObject, size_t location, int32_t msgCode,
@@ -259,6 +239,7 @@ extern void UnbindSharedContext();
         List<Ref<Camera>> m_cameras;
         Ref<Shader> m_blit_shader;
         Ref<Mesh> m_blit_mesh;
+        bool m_headless = false;
 #if VR_VULKAN
         Vector<char*> m_enabled_layers;
         Vector<char*> m_instance_extension_names;
@@ -300,6 +281,16 @@ extern void UnbindSharedContext();
         VkCommandBuffer m_image_cmd = VK_NULL_HANDLE;
         Mutex m_image_cmd_mutex;
         Ref<Texture> m_depth_texture;
+        Ref<Texture> m_headless_color_texture;
+        Ref<BufferObject> m_headless_read_buffer;
+        VkImageLayout m_present_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        VkQueryPool m_timestamp_pool = VK_NULL_HANDLE;
+        int m_timestamp_pool_size = 0;
+        int m_timestamp_stride = 0;
+        // pass names recorded in each swapchain image cmd, empty when recorded without timestamps
+        Vector<Vector<String>> m_timestamp_names;
+        int m_timestamp_submit_index = -1;
+        int m_timestamp_submit_frame = -1;
         bool m_primary_cmd_dirty = true;
         bool m_pause_draw = false;
 #endif
@@ -327,6 +318,7 @@ extern void UnbindSharedContext();
             m_cameras.Clear();
 
             this->DestroySizeDependentResources();
+            this->DestroyTimestampPool();
 
             vkFreeCommandBuffers(m_device, m_image_cmd_pool, 1, &m_image_cmd);
             vkDestroyCommandPool(m_device, m_image_cmd_pool, nullptr);
@@ -489,8 +481,11 @@ extern void UnbindSharedContext();
                 }
             }
 
-            assert(surface_ext_found);
-            assert(platform_surface_ext_found);
+            if (!m_headless)
+            {
+                assert(surface_ext_found);
+                assert(platform_surface_ext_found);
+            }
         }
 
         void CreateInstance(const String& name)
@@ -584,7 +579,7 @@ extern void UnbindSharedContext();
                     StringVectorAdd(m_device_extension_names, VK_KHR_SWAPCHAIN_EXTENSION_NAME);
                 }
             }
-            assert(swapchain_ext_found);
+            assert(swapchain_ext_found || m_headless);
 
             vkGetPhysicalDeviceProperties(m_gpu, &m_gpu_properties);
 
@@ -705,6 +700,25 @@ extern void UnbindSharedContext();
             m_surface_format.colorSpace = surface_formats[0].colorSpace;
         }
 
+        void ChooseHeadlessQueue()
+        {
+            int graphics_queue_index = -1;
+            for (int i = 0; i < m_queue_properties.Size(); ++i)
+            {
+                if ((m_queue_properties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0)
+                {
+                    graphics_queue_index = i;
+                    break;
+                }
+            }
+
+            assert(graphics_queue_index >= 0);
+
+            m_graphics_queue_family_index = graphics_queue_index;
+            m_surface_format.format = VK_FORMAT_R8G8B8A8_UNORM;
+            m_surface_format.colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+        }
+
         void CreateDevice()
         {
             VkResult err;
@@ -716,7 +730,8 @@ extern void UnbindSharedContext();
             queue_info.pNext = nullptr;
             queue_info.flags = 0;
             queue_info.queueFamilyIndex = m_graphics_queue_family_index;
-            queue_info.queueCount = 2;
+            // software drivers may expose a single queue, image cmds then share it with drawing
+            queue_info.queueCount = m_queue_properties[m_graphics_queue_family_index].queueCount > 1 ? 2 : 1;
             queue_info.pQueuePriorities = queue_priorities;
 
             VkDeviceCreateInfo device_info;
@@ -745,7 +760,7 @@ extern void UnbindSharedContext();
         void GetQueues()
         {
             vkGetDeviceQueue(m_device, m_graphics_queue_family_index, 0, &m_graphics_queue);
-            vkGetDeviceQueue(m_device, m_graphics_queue_family_index, 1, &m_image_queue);
+            vkGetDeviceQueue(m_device, m_graphics_queue_family_index, m_queue_properties[m_graphics_queue_family_index].queueCount > 1 ? 1 : 0, &m_image_queue);
         }
 
         void CreateSignals()
@@ -780,7 +795,14 @@ extern void UnbindSharedContext();
 
         void CreateSizeDependentResources()
         {
-            this->CreateSwapChain();
+            if (m_headless)
+            {
+                this->CreateHeadlessImage();
+            }
+            else
+            {
+                this->CreateSwapChain();
+            }
             this->CreateCommandPool(&m_graphics_cmd_pool);
             for (int i = 0; i < m_swapchain_image_resources.Size(); ++i)
             {
@@ -810,9 +832,17 @@ extern void UnbindSharedContext();
                 m_graphics_cmd_pool = VK_NULL_HANDLE;
             }
 
-            for (int i = 0; i < m_swapchain_image_resources.Size(); ++i)
+            if (m_headless)
             {
-                vkDestroyImageView(m_device, m_swapchain_image_resources[i].image_view, nullptr);
+                m_headless_color_texture.reset();
+                m_headless_read_buffer.reset();
+            }
+            else
+            {
+                for (int i = 0; i < m_swapchain_image_resources.Size(); ++i)
+                {
+                    vkDestroyImageView(m_device, m_swapchain_image_resources[i].image_view, nullptr);
+                }
             }
             m_swapchain_image_resources.Clear();
             if (m_swapchain != VK_NULL_HANDLE)
@@ -835,10 +865,13 @@ extern void UnbindSharedContext();
             }
 
             this->DestroySizeDependentResources();
-            vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
-            m_surface = VK_NULL_HANDLE;
-            this->CreateSurface();
-            this->GetQueues();
+            if (!m_headless)
+            {
+                vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+                m_surface = VK_NULL_HANDLE;
+                this->CreateSurface();
+                this->GetQueues();
+            }
             this->CreateSizeDependentResources();
 
             m_primary_cmd_dirty = true;
@@ -856,16 +889,22 @@ extern void UnbindSharedContext();
             }
 
             this->DestroySizeDependentResources();
-            vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
-            m_surface = VK_NULL_HANDLE;
+            if (!m_headless)
+            {
+                vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+                m_surface = VK_NULL_HANDLE;
+            }
         }
 
         void OnResume()
         {
             m_pause_draw = false;
 
-            this->CreateSurface();
-            this->GetQueues();
+            if (!m_headless)
+            {
+                this->CreateSurface();
+                this->GetQueues();
+            }
             this->CreateSizeDependentResources();
         }
 
@@ -1010,6 +1049,104 @@ extern void UnbindSharedContext();
             }
         }
 
+        // a single offscreen image stands in for the swapchain, present cameras leave it in transfer src layout
+        void CreateHeadlessImage()
+        {
+            m_headless_color_texture = this->CreateTexture(
+                VK_IMAGE_TYPE_2D,
+                VK_IMAGE_VIEW_TYPE_2D,
+                m_width,
+                m_height,
+                m_surface_format.format,
+                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                VK_IMAGE_ASPECT_COLOR_BIT,
+                {
+                    VK_COMPONENT_SWIZZLE_R,
+                    VK_COMPONENT_SWIZZLE_G,
+                    VK_COMPONENT_SWIZZLE_B,
+                    VK_COMPONENT_SWIZZLE_A,
+                },
+                1,
+                false,
+                1,
+                1);
+
+            this->BeginImageCmd();
+            this->SetImageLayout(
+                m_image_cmd,
+                m_headless_color_texture->GetImage(),
+                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 },
+                VK_IMAGE_LAYOUT_UNDEFINED,
+                m_present_layout,
+                (VkAccessFlagBits) 0);
+            this->EndImageCmd();
+
+            m_swapchain_image_resources.Resize(1);
+
+            SwapchainImageResources& resource = m_swapchain_image_resources[0];
+            resource.width = m_width;
+            resource.height = m_height;
+            resource.format = m_surface_format.format;
+            resource.image = m_headless_color_texture->GetImage();
+            resource.image_view = m_headless_color_texture->GetImageView();
+        }
+
+        bool ReadHeadlessImage(ByteBuffer& pixels)
+        {
+            if (!m_headless)
+            {
+                return false;
+            }
+
+            VkResult err = vkWaitForFences(m_device, 1, &m_draw_complete_fence, VK_TRUE, UINT64_MAX);
+            assert(!err);
+
+            const SwapchainImageResources& resource = m_swapchain_image_resources[0];
+            int size = resource.width * resource.height * 4;
+            if (!m_headless_read_buffer)
+            {
+                m_headless_read_buffer = this->CreateBuffer(nullptr, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+            }
+
+            VkBufferImageCopy copy;
+            Memory::Zero(&copy, sizeof(copy));
+            copy.bufferOffset = 0;
+            copy.bufferRowLength = 0;
+            copy.bufferImageHeight = 0;
+            copy.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+            copy.imageOffset = { 0, 0, 0 };
+            copy.imageExtent = { (uint32_t) resource.width, (uint32_t) resource.height, 1 };
+
+            this->BeginImageCmd();
+            this->SetImageLayout(
+                m_image_cmd,
+                resource.image,
+                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 },
+                m_present_layout,
+                m_present_layout,
+                VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+            vkCmdCopyImageToBuffer(
+                m_image_cmd,
+                resource.image,
+                m_present_layout,
+                m_headless_read_buffer->GetBuffer(),
+                1,
+                &copy);
+            this->EndImageCmd();
+
+            if (pixels.Size() != size)
+            {
+                pixels = ByteBuffer(size);
+            }
+            this->ReadBuffer(m_headless_read_buffer, pixels);
+
+            return true;
+        }
+
         void CreateCommandPool(VkCommandPool* cmd_pool)
         {
             VkCommandPoolCreateInfo pool_info;
@@ -1091,13 +1228,24 @@ extern void UnbindSharedContext();
 
             if (present)
             {
-                color_final_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+                color_final_layout = m_present_layout;
                 depth_final_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
             }
             else
             {
                 color_final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
                 depth_final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+                // render textures are created and left by every pass in shader read layout,
+                // so a pass loading one, e.g. another shadow cascade in the same atlas, starts from it
+                if (color_load == VK_ATTACHMENT_LOAD_OP_LOAD)
+                {
+                    color_initial_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+                }
+                if (depth_load == VK_ATTACHMENT_LOAD_OP_LOAD)
+                {
+                    depth_initial_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+                }
             }
 
             VkAttachmentReference color_reference = {
@@ -1640,115 +1788,7 @@ extern void UnbindSharedContext();
             GlslToSpirvCached(glsl, shader_type, spirv);
             this->CreateSpirvShaderModule(spirv, module);
 
-            // reflect spirv
-            spirv_cross::CompilerGLSL compiler(&spirv[0], spirv.Size());
-            spirv_cross::ShaderResources resources = compiler.get_shader_resources();
-
-            if (shader_type == VK_SHADER_STAGE_VERTEX_BIT)
-            {
-                for (const auto& resource : resources.stage_inputs)
-                {
-                    uint32_t location = compiler.get_decoration(resource.id, spv::DecorationLocation);
-                    const std::string& name = compiler.get_name(resource.id);
-                    const auto& type = compiler.get_type(resource.type_id);
-
-                    assert(type.basetype == spirv_cross::SPIRType::Float);
-                    assert(type.array.size() == 0);
-
-                    VertexAttribute attr;
-                    attr.location = location;
-                    attr.name = name.c_str();
-                    attr.vector_size = type.vecsize;
-
-                    attributes.Add(attr);
-                }
-            }
-
-            for (const auto& resource : resources.uniform_buffers)
-            {
-                uint32_t set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
-                uint32_t binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
-                const std::string& name = compiler.get_name(resource.id);
-
-                UniformSet* set_ptr = nullptr;
-                for (int i = 0; i < uniform_sets.Size(); ++i)
-                {
-                    if (set == uniform_sets[i].set)
-                    {
-                        set_ptr = &uniform_sets[i];
-                        break;
-                    }
-                }
-                if (set_ptr == nullptr)
-                {
-                    uniform_sets.Add(UniformSet());
-                    set_ptr = &uniform_sets[uniform_sets.Size() - 1];
-                    set_ptr->set = set;
-                }
-
-                UniformBuffer buffer;
-                buffer.name = name.c_str();
-                buffer.binding = (int) binding;
-                buffer.stage = shader_type;
-
-                const spirv_cross::SPIRType& type = compiler.get_type(resource.base_type_id);
-
-                int max_offset_member = -1;
-                int max_offset = -1;
-                for (size_t i = 0; i < type.member_types.size(); ++i)
-                {
-                    const std::string& member_name = compiler.get_member_name(type.self, (uint32_t) i);
-                    int member_offset = (int) compiler.type_struct_member_offset(type, (uint32_t) i);
-                    int member_size = (int) compiler.get_declared_struct_member_size(type, (uint32_t) i);
-
-                    UniformMember member;
-                    member.name = member_name.c_str();
-                    member.offset = member_offset;
-                    member.size = member_size;
-
-                    buffer.members.Add(member);
-
-                    if (member.offset > max_offset)
-                    {
-                        max_offset = member.offset;
-                        max_offset_member = (int) i;
-                    }
-                }
-
-                buffer.size = buffer.members[max_offset_member].offset + buffer.members[max_offset_member].size;
-
-                set_ptr->buffers.Add(buffer);
-            }
-
-            for (const auto& resource : resources.sampled_images)
-            {
-                uint32_t set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
-                uint32_t binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
-                const std::string& name = resource.name;
-
-                UniformSet* set_ptr = nullptr;
-                for (int i = 0; i < uniform_sets.Size(); ++i)
-                {
-                    if (set == uniform_sets[i].set)
-                    {
-                        set_ptr = &uniform_sets[i];
-                        break;
-                    }
-                }
-                if (set_ptr == nullptr)
-                {
-                    uniform_sets.Add(UniformSet());
-                    set_ptr = &uniform_sets[uniform_sets.Size() - 1];
-                    set_ptr->set = set;
-                }
-
-                UniformTexture texture;
-                texture.name = name.c_str();
-                texture.binding = (int) binding;
-                texture.stage = shader_type;
-
-                set_ptr->textures.Add(texture);
-            }
+            Shader::Reflect(spirv, shader_type, attributes, uniform_sets);
         }
 
         void CreatePipelineCache(VkPipelineCache* pipeline_cache)
@@ -1778,34 +1818,30 @@ extern void UnbindSharedContext();
             Vector<VertexAttribute>& attributes,
             Vector<UniformSet>& uniform_sets)
         {
-            Vector<String> includes;
-            includes.Add("Base.in");
-            if (vs_includes.Size() > 0)
-            {
-                includes.AddRange(&vs_includes[0], vs_includes.Size());
-            }
-            String vs = ProcessShaderSource(vs_source, vs_predefine, includes);
-            String fs = ProcessShaderSource(fs_source, fs_predefine, fs_includes);
+            String include_dir = Application::Instance()->GetDataPath() + "/shader/Include";
+            String vs = Shader::ProcessSource(VK_SHADER_STAGE_VERTEX_BIT, vs_source, vs_predefine, vs_includes, include_dir);
+            String fs = Shader::ProcessSource(VK_SHADER_STAGE_FRAGMENT_BIT, fs_source, fs_predefine, fs_includes, include_dir);
 
             this->CreateGlslShaderModule(vs, VK_SHADER_STAGE_VERTEX_BIT, vs_module, attributes, uniform_sets);
             this->CreateGlslShaderModule(fs, VK_SHADER_STAGE_FRAGMENT_BIT, fs_module, attributes, uniform_sets);
 
-            // sort by set
-            List<UniformSet*> sets;
-            for (int i = 0; i < uniform_sets.Size(); ++i)
-            {
-                sets.AddLast(&uniform_sets[i]);
-            }
-            sets.Sort([](const UniformSet* a, const UniformSet* b) {
-                return a->set < b->set;
-            });
+            Shader::SortUniformSets(uniform_sets);
+        }
 
-            Vector<UniformSet> sets_sorted;
-            for (auto i : sets)
-            {
-                sets_sorted.Add(*i);
-            }
-            uniform_sets = sets_sorted;
+        void CreateComputeShaderModule(
+            const String& cs_predefine,
+            const Vector<String>& cs_includes,
+            const String& cs_source,
+            VkShaderModule* cs_module,
+            Vector<UniformSet>& uniform_sets)
+        {
+            String include_dir = Application::Instance()->GetDataPath() + "/shader/Include";
+            String cs = Shader::ProcessSource(VK_SHADER_STAGE_COMPUTE_BIT, cs_source, cs_predefine, cs_includes, include_dir);
+
+            Vector<VertexAttribute> attributes;
+            this->CreateGlslShaderModule(cs, VK_SHADER_STAGE_COMPUTE_BIT, cs_module, attributes, uniform_sets);
+
+            Shader::SortUniformSets(uniform_sets);
         }
 
         void CreatePipelineLayout(
@@ -1850,6 +1886,21 @@ extern void UnbindSharedContext();
                     layout_bindings.Add(layout_binding);
                 }
 
+                for (int j = 0; j < uniform_sets[i].storage_buffers.Size(); ++j)
+                {
+                    const auto& storage_buffer = uniform_sets[i].storage_buffers[j];
+
+                    VkDescriptorSetLayoutBinding layout_binding;
+                    Memory::Zero(&layout_binding, sizeof(layout_binding));
+                    layout_binding.binding = storage_buffer.binding;
+                    layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                    layout_binding.descriptorCount = 1;
+                    layout_binding.stageFlags = storage_buffer.stage;
+                    layout_binding.pImmutableSamplers = nullptr;
+
+                    layout_bindings.Add(layout_binding);
+                }
+
                 VkDescriptorSetLayoutCreateInfo descriptor_layout;
                 Memory::Zero(&descriptor_layout, sizeof(descriptor_layout));
                 descriptor_layout.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -2135,10 +2186,37 @@ extern void UnbindSharedContext();
             assert(!err);
         }
 
+        void CreateComputePipeline(
+            VkShaderModule cs_module,
+            VkPipelineLayout pipeline_layout,
+            VkPipelineCache pipeline_cache,
+            VkPipeline* pipeline)
+        {
+            VkComputePipelineCreateInfo pipeline_info;
+            Memory::Zero(&pipeline_info, sizeof(pipeline_info));
+            pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+            pipeline_info.pNext = nullptr;
+            pipeline_info.flags = 0;
+            pipeline_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            pipeline_info.stage.pNext = nullptr;
+            pipeline_info.stage.flags = 0;
+            pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+            pipeline_info.stage.module = cs_module;
+            pipeline_info.stage.pName = "main";
+            pipeline_info.stage.pSpecializationInfo = nullptr;
+            pipeline_info.layout = pipeline_layout;
+            pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
+            pipeline_info.basePipelineIndex = 0;
+
+            VkResult err = vkCreateComputePipelines(m_device, pipeline_cache, 1, &pipeline_info, nullptr, pipeline);
+            assert(!err);
+        }
+
         void CreateDescriptorSetPool(const Vector<UniformSet>& uniform_sets, VkDescriptorPool* descriptor_pool)
         {
             int buffer_count = 0;
             int texture_count = 0;
+            int storage_buffer_count = 0;
 
             for (int i = 0; i < uniform_sets.Size(); ++i)
             {
@@ -2151,6 +2229,11 @@ extern void UnbindSharedContext();
                 {
                     ++texture_count;
                 }
+
+                for (int j = 0; j < uniform_sets[i].storage_buffers.Size(); ++j)
+                {
+                    ++storage_buffer_count;
+                }
             }
 
             Vector<VkDescriptorPoolSize> pool_sizes;
@@ -2168,6 +2251,13 @@ extern void UnbindSharedContext();
 				pool_size.descriptorCount = (uint32_t) texture_count * DESCRIPTOR_POOL_SIZE_MAX;
 				pool_sizes.Add(pool_size);
 			}
+			if (storage_buffer_count > 0)
+			{
+				VkDescriptorPoolSize pool_size;
+				pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				pool_size.descriptorCount = (uint32_t) storage_buffer_count * DESCRIPTOR_POOL_SIZE_MAX;
+				pool_sizes.Add(pool_size);
+			}
             
             VkDescriptorPoolCreateInfo pool_info;
             Memory::Zero(&pool_info, sizeof(pool_info));
@@ -2249,6 +2339,29 @@ extern void UnbindSharedContext();
             vkUpdateDescriptorSets(m_device, 1, &desc_write, 0, nullptr);
         }
 
+        void UpdateStorageBuffer(VkDescriptorSet descriptor_set, int binding, const Ref<BufferObject>& buffer)
+        {
+            VkDescriptorBufferInfo buffer_info;
+            buffer_info.buffer = buffer->GetBuffer();
+            buffer_info.offset = 0;
+            buffer_info.range = VK_WHOLE_SIZE;
+
+            VkWriteDescriptorSet desc_write;
+            Memory::Zero(&desc_write, sizeof(desc_write));
+            desc_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            desc_write.pNext = nullptr;
+            desc_write.dstSet = descriptor_set;
+            desc_write.dstBinding = binding;
+            desc_write.dstArrayElement = 0;
+            desc_write.descriptorCount = 1;
+            desc_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            desc_write.pImageInfo = nullptr;
+            desc_write.pBufferInfo = &buffer_info;
+            desc_write.pTexelBufferView = nullptr;
+
+            vkUpdateDescriptorSets(m_device, 1, &desc_write, 0, nullptr);
+        }
+
         void BuildInstanceCmd(
             VkCommandBuffer cmd,
             VkRenderPass render_pass,
@@ -2464,7 +2577,7 @@ extern void UnbindSharedContext();
                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
                         { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 },
-                        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                        m_present_layout,
                         VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
                         VK_ACCESS_MEMORY_READ_BIT);
                 }
@@ -2550,20 +2663,153 @@ extern void UnbindSharedContext();
                 0, nullptr);
         }
 
+        bool IsTimestampSupported()
+        {
+            return m_gpu_properties.limits.timestampComputeAndGraphics == VK_TRUE &&
+                m_queue_properties[m_graphics_queue_family_index].timestampValidBits > 0;
+        }
+
+        void DestroyTimestampPool()
+        {
+            if (m_timestamp_pool != VK_NULL_HANDLE)
+            {
+                vkDestroyQueryPool(m_device, m_timestamp_pool, nullptr);
+                m_timestamp_pool = VK_NULL_HANDLE;
+            }
+            m_timestamp_pool_size = 0;
+            m_timestamp_names.Clear();
+            m_timestamp_submit_index = -1;
+        }
+
+        // query 0 and 1 wrap the whole cmd, then a begin and end query per camera
+        void PrepareTimestampPool()
+        {
+            m_timestamp_stride = 2 + m_cameras.Size() * 2;
+
+            int size = m_timestamp_stride * m_swapchain_image_resources.Size();
+            if (size > m_timestamp_pool_size)
+            {
+                this->DestroyTimestampPool();
+
+                VkQueryPoolCreateInfo pool_info;
+                Memory::Zero(&pool_info, sizeof(pool_info));
+                pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+                pool_info.pNext = nullptr;
+                pool_info.flags = 0;
+                pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+                pool_info.queryCount = size;
+                pool_info.pipelineStatistics = 0;
+
+                VkResult err = vkCreateQueryPool(m_device, &pool_info, nullptr, &m_timestamp_pool);
+                assert(!err);
+
+                m_timestamp_pool_size = size;
+            }
+        }
+
+        static String GetTimestampName(Camera* camera)
+        {
+            if (camera->GetName().Empty())
+            {
+                return String::Format("Camera %d", camera->GetDepth());
+            }
+            return camera->GetName();
+        }
+
+        void ReadTimestamps()
+        {
+            if (m_timestamp_submit_index < 0 || m_timestamp_submit_index >= m_timestamp_names.Size())
+            {
+                return;
+            }
+
+            const Vector<String>& names = m_timestamp_names[m_timestamp_submit_index];
+            if (names.Size() == 0)
+            {
+                return;
+            }
+
+            int query_count = 2 + names.Size() * 2;
+            Vector<uint64_t> timestamps(query_count);
+            VkResult err = vkGetQueryPoolResults(
+                m_device,
+                m_timestamp_pool,
+                m_timestamp_submit_index * m_timestamp_stride,
+                query_count,
+                timestamps.SizeInBytes(),
+                &timestamps[0],
+                sizeof(uint64_t),
+                VK_QUERY_RESULT_64_BIT);
+            if (err != VK_SUCCESS)
+            {
+                return;
+            }
+
+            uint32_t valid_bits = m_queue_properties[m_graphics_queue_family_index].timestampValidBits;
+            uint64_t mask = valid_bits >= 64 ? ~(uint64_t) 0 : (((uint64_t) 1 << valid_bits) - 1);
+            double period_ms = m_gpu_properties.limits.timestampPeriod / 1000000.0;
+            auto elapsed = [&](int begin, int end) {
+                return (float) (((timestamps[end] - timestamps[begin]) & mask) * period_ms);
+            };
+
+            GpuFrameTiming frame;
+            frame.frame = m_timestamp_submit_frame;
+            frame.ms = elapsed(0, 1);
+            frame.passes.Resize(names.Size());
+            for (int i = 0; i < names.Size(); ++i)
+            {
+                frame.passes[i].name = names[i];
+                frame.passes[i].ms = elapsed(2 + i * 2, 3 + i * 2);
+            }
+
+            GpuProfiler::AddFrame(frame);
+        }
+
         void BuildPrimaryCmds()
         {
             m_cameras.Sort([](const Ref<Camera>& a, const Ref<Camera>& b) {
                 return a->GetDepth() < b->GetDepth();
             });
 
+            bool timestamp = false;
+            if (GpuProfiler::IsEnabled())
+            {
+                if (this->IsTimestampSupported())
+                {
+                    this->PrepareTimestampPool();
+                    timestamp = true;
+                }
+                else
+                {
+                    Log("gpu timestamp query not supported");
+                    GpuProfiler::SetEnabled(false);
+                }
+            }
+            m_timestamp_names.Resize(m_swapchain_image_resources.Size());
+
             for (int i = 0; i < m_swapchain_image_resources.Size(); ++i)
             {
                 VkCommandBuffer cmd = m_swapchain_image_resources[i].cmd;
+                int query = i * m_timestamp_stride;
 
                 this->BuildPrimaryCmdBegin(cmd);
 
+                m_timestamp_names[i].Clear();
+                if (timestamp)
+                {
+                    vkCmdResetQueryPool(cmd, m_timestamp_pool, query, m_timestamp_stride);
+                    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestamp_pool, query);
+                }
+
+                SkinningPrePass::BuildCmd(cmd);
+
                 for (auto j : m_cameras)
                 {
+                    if (timestamp)
+                    {
+                        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestamp_pool, query + 2 + m_timestamp_names[i].Size() * 2);
+                    }
+
                     this->BuildPrimaryCmd(
                         cmd,
                         i,
@@ -2576,10 +2822,23 @@ extern void UnbindSharedContext();
                         j->GetClearColor(),
 						j->GetRenderTargetColor(),
 						j->GetRenderTargetDepth());
+
+                    if (timestamp)
+                    {
+                        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestamp_pool, query + 3 + m_timestamp_names[i].Size() * 2);
+                        m_timestamp_names[i].Add(GetTimestampName(j.get()));
+                    }
+                }
+
+                if (timestamp)
+                {
+                    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestamp_pool, query + 1);
                 }
 
                 this->BuildPrimaryCmdEnd(cmd);
             }
+
+            RenderStats::Add(RenderStat::CmdsRecorded, m_swapchain_image_resources.Size());
         }
 
         void Update()
@@ -2589,6 +2848,8 @@ extern void UnbindSharedContext();
                 i->Update();
             }
 
+            BonePalette::Update();
+
             if (m_primary_cmd_dirty)
             {
                 m_primary_cmd_dirty = false;
@@ -2625,8 +2886,38 @@ extern void UnbindSharedContext();
             err = vkResetFences(m_device, 1, &m_draw_complete_fence);
             assert(!err);
 
+            if (GpuProfiler::IsEnabled())
+            {
+                this->ReadTimestamps();
+            }
+
             this->Update();
 
+            if (m_headless)
+            {
+                VkSubmitInfo submit_info;
+                Memory::Zero(&submit_info, sizeof(submit_info));
+                submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+                submit_info.pNext = nullptr;
+                submit_info.waitSemaphoreCount = 0;
+                submit_info.pWaitSemaphores = nullptr;
+                submit_info.pWaitDstStageMask = nullptr;
+                submit_info.commandBufferCount = 1;
+                submit_info.pCommandBuffers = &m_swapchain_image_resources[0].cmd;
+                submit_info.signalSemaphoreCount = 0;
+                submit_info.pSignalSemaphores = nullptr;
+
+                // the image queue may be this queue, and image cmds are submitted from loading threads
+                m_image_cmd_mutex.lock();
+                err = vkQueueSubmit(m_graphics_queue, 1, &submit_info, m_draw_complete_fence);
+                m_image_cmd_mutex.unlock();
+                assert(!err);
+
+                m_timestamp_submit_index = m_image_index;
+                m_timestamp_submit_frame = Time::GetFrameCount();
+                return;
+            }
+
             err = fpAcquireNextImageKHR(m_device, m_swapchain, UINT64_MAX, m_image_acquired_semaphore, VK_NULL_HANDLE, (uint32_t*) &m_image_index);
             assert(!err);
 
@@ -2646,6 +2937,9 @@ extern void UnbindSharedContext();
             err = vkQueueSubmit(m_graphics_queue, 1, &submit_info, m_draw_complete_fence);
             assert(!err);
 
+            m_timestamp_submit_index = m_image_index;
+            m_timestamp_submit_frame = Time::GetFrameCount();
+
             VkPresentInfoKHR present_info;
             Memory::Zero(&present_info, sizeof(present_info));
             present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -3068,6 +3362,8 @@ extern void UnbindSharedContext();
                 i->Update();
             }
 
+            BonePalette::Update();
+
             for (auto i : m_cameras)
             {
                 i->OnDraw();
@@ -3191,28 +3487,46 @@ void main()
         return DisplayPrivate::m_display;
     }
 
-    Display::Display(const String& name, void* window, int width, int height):
+    Display::Display(const String& name, void* window, int width, int height, bool headless):
         m_private(new DisplayPrivate(this, window, width, height))
     {
 #if VR_VULKAN
-#if VR_WINDOWS
+#if VR_WINDOWS || VR_LINUX
         InitShaderCompiler();
 #elif VR_ANDROID
         InitVulkan();
 #endif
+
+        m_private->m_headless = headless;
+        if (headless)
+        {
+            m_private->m_present_layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        }
         
         m_private->CheckInstanceLayers();
         m_private->CheckInstanceExtensions();
         m_private->CreateInstance(name);
         m_private->CreateDebugReportCallback();
         m_private->InitPhysicalDevice();
-        m_private->CreateSurface();
+        if (headless)
+        {
+            m_private->ChooseHeadlessQueue();
+        }
+        else
+        {
+            m_private->CreateSurface();
+        }
         m_private->CreateDevice();
         m_private->GetQueues();
         m_private->CreateSignals();
         m_private->CreateImageCmd();
         m_private->CreateSizeDependentResources();
 #elif VR_GLES
+        if (headless)
+        {
+            Log("headless display is implemented in vulkan only");
+        }
+
         String version = (const char*) glGetString(GL_VERSION);
         Log("GL Version: %s", version.CString());
 
@@ -3234,7 +3548,7 @@ void main()
         delete m_private;
         
 #if VR_VULKAN
-#if VR_WINDOWS
+#if VR_WINDOWS || VR_LINUX
         DeinitShaderCompiler();
 #endif
 #endif
@@ -3259,6 +3573,14 @@ void main()
     {
         m_private->OnDraw();
         m_private->OnFrameEnd();
+        RenderTexturePool::OnFrameEnd();
+        TextureStreamer::Update();
+        RenderStats::OnFrameEnd();
+    }
+
+    bool Display::IsHeadless() const
+    {
+        return m_private->m_headless;
     }
 
     int Display::GetWidth() const
@@ -3283,7 +3605,7 @@ void main()
         return camera.get();
     }
 
-    Camera* Display::CreateBlitCamera(int depth, const Ref<Texture>& texture, const Ref<Material>& material, const String& texture_name, CameraClearFlags clear_flags, const Rect& rect)
+    Ref<MeshRenderer> Display::CreateBlitRenderer(const Ref<Texture>& texture, const Ref<Material>& material, const String& texture_name)
     {
         Ref<Material> blit_material = material;
 
@@ -3305,12 +3627,6 @@ void main()
         renderer->SetMaterial(blit_material);
         renderer->SetMesh(m_private->m_blit_mesh);
 
-        Camera* camera = this->CreateCamera();
-        camera->SetViewportRect(rect);
-        camera->SetClearFlags(clear_flags);
-        camera->SetDepth(depth);
-        camera->AddRenderer(renderer);
-
         if (texture)
         {
             String blit_texture_name = texture_name;
@@ -3325,6 +3641,19 @@ void main()
 #endif
         }
 
+        return renderer;
+    }
+
+    Camera* Display::CreateBlitCamera(int depth, const Ref<Texture>& texture, const Ref<Material>& material, const String& texture_name, CameraClearFlags clear_flags, const Rect& rect)
+    {
+        Ref<MeshRenderer> renderer = this->CreateBlitRenderer(texture, material, texture_name);
+
+        Camera* camera = this->CreateCamera();
+        camera->SetViewportRect(rect);
+        camera->SetClearFlags(clear_flags);
+        camera->SetDepth(depth);
+        camera->AddRenderer(renderer);
+
         return camera;
     }
 
@@ -3498,6 +3827,21 @@ void main()
             uniform_sets);
     }
 
+    void Display::CreateComputeShaderModule(
+        const String& cs_predefine,
+        const Vector<String>& cs_includes,
+        const String& cs_source,
+        VkShaderModule* cs_module,
+        Vector<UniformSet>& uniform_sets)
+    {
+        m_private->CreateComputeShaderModule(
+            cs_predefine,
+            cs_includes,
+            cs_source,
+            cs_module,
+            uniform_sets);
+    }
+
     void Display::CreatePipelineCache(VkPipelineCache* pipeline_cache)
     {
         m_private->CreatePipelineCache(pipeline_cache);
@@ -3542,6 +3886,15 @@ void main()
             instance_stride);
     }
 
+    void Display::CreateComputePipeline(
+        VkShaderModule cs_module,
+        VkPipelineLayout pipeline_layout,
+        VkPipelineCache pipeline_cache,
+        VkPipeline* pipeline)
+    {
+        m_private->CreateComputePipeline(cs_module, pipeline_layout, pipeline_cache, pipeline);
+    }
+
     void Display::CreateDescriptorSetPool(const Vector<UniformSet>& uniform_sets, VkDescriptorPool* descriptor_pool)
     {
         m_private->CreateDescriptorSetPool(uniform_sets, descriptor_pool);
@@ -3570,6 +3923,11 @@ void main()
         m_private->UpdateUniformTexture(descriptor_set, binding, texture);
     }
 
+    void Display::UpdateStorageBuffer(VkDescriptorSet descriptor_set, int binding, const Ref<BufferObject>& buffer)
+    {
+        m_private->UpdateStorageBuffer(descriptor_set, binding, buffer);
+    }
+
     Ref<BufferObject> Display::CreateBuffer(const void* data, int size, VkBufferUsageFlags usage)
     {
         return m_private->CreateBuffer(data, size, usage);
@@ -3578,6 +3936,9 @@ void main()
     void Display::UpdateBuffer(const Ref<BufferObject>& buffer, int buffer_offset, const void* data, int size)
     {
         m_private->UpdateBuffer(buffer, buffer_offset, data, size);
+
+        RenderStats::Add(RenderStat::BufferUpdates);
+        RenderStats::Add(RenderStat::BufferUpdateBytes, size);
     }
 
     void Display::ReadBuffer(const Ref<BufferObject>& buffer, ByteBuffer& data)
@@ -3585,6 +3946,11 @@ void main()
         m_private->ReadBuffer(buffer, data);
     }
 
+    bool Display::ReadHeadlessImage(ByteBuffer& pixels)
+    {
+        return m_private->ReadHeadlessImage(pixels);
+    }
+
     void Display::BuildInstanceCmd(
         VkCommandBuffer cmd,
         VkRenderPass render_pass,
@@ -3716,6 +4082,9 @@ void main()
         glBindBuffer(buffer->GetTarget(), buffer->GetBuffer());
         glBufferSubData(buffer->GetTarget(), buffer_offset, size, data);
         glBindBuffer(buffer->GetTarget(), 0);
+
+        RenderStats::Add(RenderStat::BufferUpdates);
+        RenderStats::Add(RenderStat::BufferUpdateBytes, size);
     }
 
     void Display::BindSharedContext() const
@@ -38,21 +38,24 @@ namespace Viry3D
     class Material;
     struct RenderState;
     class BufferObject;
+    class MeshRenderer;
     class DisplayPrivate;
 
     class Display
     {
     public:
         static Display* Instance();
-        Display(const String& name, void* window, int width, int height);
+        Display(const String& name, void* window, int width, int height, bool headless = false);
         virtual ~Display();
         void OnResize(int width, int height);
         void OnPause();
 		void OnResume();
         void OnDraw();
+        bool IsHeadless() const;
         int GetWidth() const;
         int GetHeight() const;
         Camera* CreateCamera();
+        Ref<MeshRenderer> CreateBlitRenderer(const Ref<Texture>& texture, const Ref<Material>& material = Ref<Material>(), const String& texture_name = "");
         Camera* CreateBlitCamera(int depth, const Ref<Texture>& texture, const Ref<Material>& material = Ref<Material>(), const String& texture_name = "", CameraClearFlags clear_flags = CameraClearFlags::Invalidate, const Rect& rect = Rect(0, 0, 1, 1));
         void DestroyCamera(Camera* camera);
         int GetMaxSamples();
@@ -79,6 +82,12 @@ namespace Viry3D
             VkShaderModule* fs_module,
             Vector<VertexAttribute>& attributes,
             Vector<UniformSet>& uniform_sets);
+        void CreateComputeShaderModule(
+            const String& cs_predefine,
+            const Vector<String>& cs_includes,
+            const String& cs_source,
+            VkShaderModule* cs_module,
+            Vector<UniformSet>& uniform_sets);
         void CreatePipelineCache(VkPipelineCache* pipeline_cache);
         void CreatePipelineLayout(
             const Vector<UniformSet>& uniform_sets,
@@ -98,6 +107,11 @@ namespace Viry3D
             int sample_count,
             bool instancing,
             int instance_stride);
+        void CreateComputePipeline(
+            VkShaderModule cs_module,
+            VkPipelineLayout pipeline_layout,
+            VkPipelineCache pipeline_cache,
+            VkPipeline* pipeline);
         void CreateDescriptorSetPool(const Vector<UniformSet>& uniform_sets, VkDescriptorPool* descriptor_pool);
         void CreateDescriptorSets(
             const Vector<UniformSet>& uniform_sets,
@@ -106,9 +120,12 @@ namespace Viry3D
             Vector<VkDescriptorSet>& descriptor_sets);
         void CreateUniformBuffer(VkDescriptorSet descriptor_set, UniformBuffer& buffer);
         void UpdateUniformTexture(VkDescriptorSet descriptor_set, int binding, const Ref<Texture>& texture);
+        void UpdateStorageBuffer(VkDescriptorSet descriptor_set, int binding, const Ref<BufferObject>& buffer);
         Ref<BufferObject> CreateBuffer(const void* data, int size, VkBufferUsageFlags usage);
         void UpdateBuffer(const Ref<BufferObject>& buffer, int buffer_offset, const void* data, int size);
         void ReadBuffer(const Ref<BufferObject>& buffer, ByteBuffer& data);
+        // headless only, waits for the last frame and reads its R8G8B8A8 pixels
+        bool ReadHeadlessImage(ByteBuffer& pixels);
         void BuildInstanceCmd(
             VkCommandBuffer cmd,
             VkRenderPass render_pass,
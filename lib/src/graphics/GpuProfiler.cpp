@@ -0,0 +1,135 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "GpuProfiler.h"
+#include "Display.h"
+#include "Debug.h"
+
+namespace Viry3D
+{
+    bool GpuProfiler::m_enabled = false;
+    int GpuProfiler::m_history_size = 60;
+    GpuFrameTiming GpuProfiler::m_last_frame;
+    List<GpuFrameTiming> GpuProfiler::m_history;
+
+    void GpuProfiler::SetEnabled(bool enable)
+    {
+        if (m_enabled == enable)
+        {
+            return;
+        }
+
+#if VR_VULKAN
+        m_enabled = enable;
+        if (!m_enabled)
+        {
+            m_last_frame = GpuFrameTiming();
+            m_history.Clear();
+        }
+
+        if (Display::Instance())
+        {
+            Display::Instance()->MarkPrimaryCmdDirty();
+        }
+#elif VR_GLES
+        Log("gpu profiler is implemented in vulkan only");
+#endif
+    }
+
+    void GpuProfiler::SetHistorySize(int size)
+    {
+        assert(size > 0);
+
+        m_history_size = size;
+        while (m_history.Size() > m_history_size)
+        {
+            m_history.RemoveFirst();
+        }
+    }
+
+    GpuFrameTiming GpuProfiler::GetAverageFrame()
+    {
+        GpuFrameTiming average;
+        average.frame = m_last_frame.frame;
+
+        if (m_history.Size() == 0)
+        {
+            return average;
+        }
+
+        for (const auto& i : m_history)
+        {
+            average.ms += i.ms;
+        }
+        average.ms /= m_history.Size();
+
+        average.passes.Resize(m_last_frame.passes.Size());
+        for (int i = 0; i < average.passes.Size(); ++i)
+        {
+            average.passes[i].name = m_last_frame.passes[i].name;
+            average.passes[i].ms = GetAverageTime(average.passes[i].name);
+        }
+
+        return average;
+    }
+
+    float GpuProfiler::GetAverageTime(const String& pass_name)
+    {
+        float total = 0;
+        int count = 0;
+
+        for (const auto& i : m_history)
+        {
+            for (int j = 0; j < i.passes.Size(); ++j)
+            {
+                if (i.passes[j].name == pass_name)
+                {
+                    total += i.passes[j].ms;
+                    count += 1;
+                }
+            }
+        }
+
+        if (count > 0)
+        {
+            return total / count;
+        }
+        return 0;
+    }
+
+    void GpuProfiler::AddFrame(const GpuFrameTiming& frame)
+    {
+        if (!m_enabled)
+        {
+            return;
+        }
+
+        m_last_frame = frame;
+        m_history.AddLast(frame);
+        while (m_history.Size() > m_history_size)
+        {
+            m_history.RemoveFirst();
+        }
+    }
+
+    void GpuProfiler::Done()
+    {
+        m_enabled = false;
+        m_last_frame = GpuFrameTiming();
+        m_history.Clear();
+    }
+}
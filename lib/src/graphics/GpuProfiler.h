@@ -0,0 +1,63 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "container/List.h"
+#include "container/Vector.h"
+#include "string/String.h"
+
+namespace Viry3D
+{
+    struct GpuPassTiming
+    {
+        // camera name, or Camera + depth when it has none
+        String name;
+        float ms = 0;
+    };
+
+    struct GpuFrameTiming
+    {
+        int frame = -1;
+        // whole primary cmd, skinning included
+        float ms = 0;
+        Vector<GpuPassTiming> passes;
+    };
+
+    // gpu time of each camera render pass, blit cameras included, from timestamp queries in the primary cmds.
+    // a frame is read after its fence signals, so results lag one frame behind and never stall the cpu.
+    class GpuProfiler
+    {
+    public:
+        static void SetEnabled(bool enable);
+        static bool IsEnabled() { return m_enabled; }
+        static int GetHistorySize() { return m_history_size; }
+        static void SetHistorySize(int size);
+        static const GpuFrameTiming& GetLastFrame() { return m_last_frame; }
+        // averages over the kept history, passes are matched by name and ordered as in the last frame
+        static GpuFrameTiming GetAverageFrame();
+        static float GetAverageTime(const String& pass_name);
+        static void AddFrame(const GpuFrameTiming& frame);
+        static void Done();
+
+    private:
+        static bool m_enabled;
+        static int m_history_size;
+        static GpuFrameTiming m_last_frame;
+        static List<GpuFrameTiming> m_history;
+    };
+}
@@ -1,24 +1,19 @@
-/*
-* Viry3D
-* Copyright 2014-2018 by Stack - stackos@qq.com
-*
-* Licensed under the Apache License, Version 2.0 (the "License");
-* you may not use this file except in compliance with the License.
-* You may obtain a copy of the License at
-*
-*     http://www.apache.org/licenses/LICENSE-2.0
-*
-* Unless required by applicable law or agreed to in writing, software
-* distributed under the License is distributed on an "AS IS" BASIS,
-* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
-* See the License for the specific language governing permissions and
-* limitations under the License.
-*/
-
 #include "Image.h"
+#include "Application.h"
 #include "io/File.h"
 #include "memory/Memory.h"
+#include "math/Mathf.h"
 #include "Debug.h"
+#include <atomic>
+#include <setjmp.h>
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#define VR_IMAGE_SSSE3 1
+#include <tmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define VR_IMAGE_NEON 1
+#include <arm_neon.h>
+#endif
 
 extern "C"
 {
@@ -35,52 +30,91 @@ namespace Viry3D
         int size;
     };
 
-    ByteBuffer Image::LoadJPEG(const ByteBuffer& jpeg, int& width, int& height, int& bpp)
+    struct JPEGError
+    {
+        jpeg_error_mgr mgr;
+        jmp_buf jump;
+    };
+
+    // shared by the calling thread and the pool tasks helping it
+    static void JPEGErrorExit(j_common_ptr cinfo)
+    {
+        (*cinfo->err->output_message)(cinfo);
+        longjmp(((JPEGError*) cinfo->err)->jump, 1);
+    }
+
+    // largest dct scale in eighths whose output fits max_size, 1/8 at least
+    static void SetJPEGScale(jpeg_decompress_struct& cinfo, int max_size)
+    {
+        int size = Mathf::Max((int) cinfo.image_width, (int) cinfo.image_height);
+        int num = 8;
+        while (num > 1 && (size * num + 7) / 8 > max_size)
+        {
+            num -= 1;
+        }
+        cinfo.scale_num = num;
+        cinfo.scale_denom = 8;
+    }
+
+    static bool ReadJPEG(const ByteBuffer& jpeg, ImageInfo& info, byte* pixels, bool rgba, int max_size)
     {
-        //use lib jpeg
         jpeg_decompress_struct cinfo;
-        jpeg_error_mgr jerr;
-        JSAMPARRAY buffer;		/* Output row buffer */
-        int row_stride;		/* physical row width in output buffer */
+        JPEGError jerr;
 
-        cinfo.err = jpeg_std_error(&jerr);
+        cinfo.err = jpeg_std_error(&jerr.mgr);
+        jerr.mgr.error_exit = JPEGErrorExit;
+        if (setjmp(jerr.jump))
+        {
+            jpeg_destroy_decompress(&cinfo);
+            return false;
+        }
 
         jpeg_create_decompress(&cinfo);
         jpeg_mem_src(&cinfo, jpeg.Bytes(), jpeg.Size());
         jpeg_read_header(&cinfo, TRUE);
-        jpeg_start_decompress(&cinfo);
-        row_stride = cinfo.output_width * cinfo.output_components;
-        /* Make a one-row-high sample array that will go away when done with image */
-        buffer = (*cinfo.mem->alloc_sarray)
-            ((j_common_ptr) &cinfo, JPOOL_IMAGE, row_stride, 1);
-
-        width = cinfo.output_width;
-        height = cinfo.output_height;
-        bpp = cinfo.output_components * 8;
+        if (max_size > 0)
+        {
+            SetJPEGScale(cinfo, max_size);
+        }
+        jpeg_calc_output_dimensions(&cinfo);
 
-        ByteBuffer colors(width * height * cinfo.output_components);
+        int components = cinfo.output_components;
+        bool expand = rgba && components == 3;
 
-        unsigned char* pPixel = colors.Bytes();
+        info.width = cinfo.output_width;
+        info.height = cinfo.output_height;
+        info.bpp = (expand ? 4 : components) * 8;
 
-        while (cinfo.output_scanline < cinfo.output_height)
+        if (pixels)
         {
-            jpeg_read_scanlines(&cinfo, buffer, 1);
-
-            unsigned char *pixel_data = buffer[0];
+            jpeg_start_decompress(&cinfo);
 
-            for (int j = 0; j < width; ++j)
+            int stride = info.width * info.bpp / 8;
+            if (expand)
             {
-                memcpy(pPixel, pixel_data, cinfo.output_components);
-
-                pPixel += cinfo.output_components;
-                pixel_data += cinfo.output_components;
+                JSAMPARRAY row = (*cinfo.mem->alloc_sarray)((j_common_ptr) &cinfo, JPOOL_IMAGE, info.width * components, 1);
+                while (cinfo.output_scanline < cinfo.output_height)
+                {
+                    byte* dest = &pixels[cinfo.output_scanline * stride];
+                    jpeg_read_scanlines(&cinfo, row, 1);
+                    Image::ExpandRGBToRGBA(row[0], dest, info.width);
+                }
+            }
+            else
+            {
+                while (cinfo.output_scanline < cinfo.output_height)
+                {
+                    JSAMPROW row = &pixels[cinfo.output_scanline * stride];
+                    jpeg_read_scanlines(&cinfo, &row, 1);
+                }
             }
+
+            jpeg_finish_decompress(&cinfo);
         }
 
-        jpeg_finish_decompress(&cinfo);
         jpeg_destroy_decompress(&cinfo);
 
-        return colors;
+        return true;
     }
 
     static void PngRead(png_structp png_ptr, png_bytep data, png_size_t length)
@@ -111,102 +145,292 @@ namespace Viry3D
 
     }
 
-    ByteBuffer Image::LoadPNG(const ByteBuffer& png, int& width, int& height, int& bpp)
+    static bool ReadPNG(const ByteBuffer& png, ImageInfo& info, byte* pixels, bool rgba)
     {
-        ByteBuffer colors;
-
         png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
         png_infop info_ptr = png_create_info_struct(png_ptr);
-        setjmp(png_jmpbuf(png_ptr));
+        if (setjmp(png_jmpbuf(png_ptr)))
+        {
+            png_destroy_read_struct(&png_ptr, &info_ptr, 0);
+            return false;
+        }
 
         png_set_read_fn(png_ptr, png.Bytes(), PngRead);
-        png_read_png(png_ptr, info_ptr, PNG_TRANSFORM_EXPAND, 0);
-
-        width = png_get_image_width(png_ptr, info_ptr);
-        height = png_get_image_height(png_ptr, info_ptr);
+        png_read_info(png_ptr, info_ptr);
 
+        // palette, low bit gray and transparency expand to 8 bit channels
         int color_type = png_get_color_type(png_ptr, info_ptr);
-        if (color_type == PNG_COLOR_TYPE_RGBA)
-        {
-            bpp = png_get_bit_depth(png_ptr, info_ptr) * 4;
+        bool alpha = (color_type & PNG_COLOR_MASK_ALPHA) || png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS);
+        bool color = (color_type & PNG_COLOR_MASK_COLOR) != 0;
+        png_set_expand(png_ptr);
+        png_set_strip_16(png_ptr);
 
-            png_bytep* row_pointers = png_get_rows(png_ptr, info_ptr);
+        int channels;
+        if (alpha)
+        {
+            if (!color)
+            {
+                png_set_gray_to_rgb(png_ptr);
+            }
+            channels = 4;
+        }
+        else if (color)
+        {
+            channels = 3;
+            if (rgba)
+            {
+                png_set_filler(png_ptr, 0xff, PNG_FILLER_AFTER);
+                channels = 4;
+            }
+        }
+        else
+        {
+            channels = 1;
+        }
 
-            colors = ByteBuffer(width * height * 4);
+        info.width = png_get_image_width(png_ptr, info_ptr);
+        info.height = png_get_image_height(png_ptr, info_ptr);
+        info.bpp = channels * 8;
 
-            unsigned char* pPixel = colors.Bytes();
+        if (pixels)
+        {
+            png_set_interlace_handling(png_ptr);
+            png_read_update_info(png_ptr, info_ptr);
 
-            for (int i = 0; i < height; ++i)
+            Vector<png_bytep> rows(info.height);
+            for (int i = 0; i < info.height; ++i)
             {
-                memcpy(pPixel, row_pointers[i], width * 4);
-                pPixel += width * 4;
+                rows[i] = &pixels[i * info.width * channels];
             }
+            png_read_image(png_ptr, &rows[0]);
+            png_read_end(png_ptr, 0);
         }
-        else if (color_type == PNG_COLOR_TYPE_RGB)
-        {
-            bpp = png_get_bit_depth(png_ptr, info_ptr) * 3;
 
-            png_bytep* row_pointers = png_get_rows(png_ptr, info_ptr);
+        png_destroy_read_struct(&png_ptr, &info_ptr, 0);
 
-            colors = ByteBuffer(width * height * 3);
+        return true;
+    }
 
-            unsigned char* pPixel = colors.Bytes();
+    static void GetHalvedSize(int& width, int& height, int max_size)
+    {
+        while (Mathf::Max(width, height) > max_size && (width > 1 || height > 1))
+        {
+            width = Mathf::Max(width >> 1, 1);
+            height = Mathf::Max(height >> 1, 1);
+        }
+    }
+
+    // 2x2 box like the next mip level, in place since each output pixel is written before any later read
+    static void HalveToFit(byte* pixels, int width, int height, int channels, int max_size)
+    {
+        while (Mathf::Max(width, height) > max_size && (width > 1 || height > 1))
+        {
+            int half_width = Mathf::Max(width >> 1, 1);
+            int half_height = Mathf::Max(height >> 1, 1);
 
-            for (int i = 0; i < height; ++i)
+            for (int i = 0; i < half_height; ++i)
             {
-                memcpy(pPixel, row_pointers[i], width * 3);
-                pPixel += width * 3;
+                const byte* row0 = &pixels[i * 2 * width * channels];
+                const byte* row1 = &pixels[Mathf::Min(i * 2 + 1, height - 1) * width * channels];
+                byte* dest = &pixels[i * half_width * channels];
+
+                for (int j = 0; j < half_width; ++j)
+                {
+                    int x0 = j * 2 * channels;
+                    int x1 = Mathf::Min(j * 2 + 1, width - 1) * channels;
+
+                    for (int k = 0; k < channels; ++k)
+                    {
+                        int sum = row0[x0 + k] + row0[x1 + k] + row1[x0 + k] + row1[x1 + k];
+                        dest[j * channels + k] = (byte) ((sum + 2) >> 2);
+                    }
+                }
             }
+
+            width = half_width;
+            height = half_height;
         }
-        else if (color_type == PNG_COLOR_TYPE_GRAY)
+    }
+
+    static bool IsPNG(const ByteBuffer& file)
+    {
+        return file.Size() >= 8 && png_sig_cmp(file.Bytes(), 0, 8) == 0;
+    }
+
+    static bool IsJPEG(const ByteBuffer& file)
+    {
+        return file.Size() >= 3 && file[0] == 0xff && file[1] == 0xd8 && file[2] == 0xff;
+    }
+
+    static bool ReadImage(const ByteBuffer& file, ImageInfo& info, byte* pixels, bool rgba, int max_size)
+    {
+        bool png = IsPNG(file);
+        if (!png && !IsJPEG(file))
         {
-            bpp = png_get_bit_depth(png_ptr, info_ptr) * 1;
+            return false;
+        }
 
-            png_bytep* row_pointers = png_get_rows(png_ptr, info_ptr);
+        // jpeg scales in the dct, the rest is halved after decoding
+        ImageInfo decoded;
+        if (!(png ? ReadPNG(file, decoded, nullptr, rgba) : ReadJPEG(file, decoded, nullptr, rgba, max_size)))
+        {
+            return false;
+        }
 
-            colors = ByteBuffer(width * height);
+        info = decoded;
+        if (max_size > 0)
+        {
+            GetHalvedSize(info.width, info.height, max_size);
+        }
 
-            unsigned char* pPixel = colors.Bytes();
+        if (pixels == nullptr)
+        {
+            return true;
+        }
 
-            for (int i = 0; i < height; ++i)
-            {
-                memcpy(pPixel, row_pointers[i], width * 1);
-                pPixel += width * 1;
-            }
+        if (info.width == decoded.width && info.height == decoded.height)
+        {
+            return png ? ReadPNG(file, decoded, pixels, rgba) : ReadJPEG(file, decoded, pixels, rgba, max_size);
         }
-        else if (color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
+
+        ByteBuffer buffer(Image::GetPixelsSize(decoded));
+        if (!(png ? ReadPNG(file, decoded, buffer.Bytes(), rgba) : ReadJPEG(file, decoded, buffer.Bytes(), rgba, max_size)))
         {
-            bpp = png_get_bit_depth(png_ptr, info_ptr) * 4;
+            return false;
+        }
+        HalveToFit(buffer.Bytes(), decoded.width, decoded.height, decoded.bpp / 8, max_size);
+        Memory::Copy(pixels, buffer.Bytes(), Image::GetPixelsSize(info));
 
-            png_bytep* row_pointers = png_get_rows(png_ptr, info_ptr);
+        return true;
+    }
 
-            colors = ByteBuffer(width * height * 4);
+    bool Image::ReadInfo(const ByteBuffer& file, ImageInfo& info, bool rgba, int max_size)
+    {
+        return ReadImage(file, info, nullptr, rgba, max_size);
+    }
+
+    bool Image::Decode(const ByteBuffer& file, byte* pixels, bool rgba, int max_size)
+    {
+        ImageInfo info;
+        return ReadImage(file, info, pixels, rgba, max_size);
+    }
 
-            byte* pPixel = colors.Bytes();
+    static ByteBuffer LoadImage(const ByteBuffer& file, int& width, int& height, int& bpp, int max_size)
+    {
+        ByteBuffer colors;
 
-            for (int i = 0; i < height; ++i)
+        ImageInfo info;
+        if (ReadImage(file, info, nullptr, false, max_size))
+        {
+            colors = ByteBuffer(Image::GetPixelsSize(info));
+            if (!ReadImage(file, info, colors.Bytes(), false, max_size))
             {
-                for (int j = 0; j < width; ++j)
-                {
-                    png_byte g = row_pointers[i][j * 2];
-                    png_byte a = row_pointers[i][j * 2 + 1];
-                    pPixel[0] = g;
-                    pPixel[1] = g;
-                    pPixel[2] = g;
-                    pPixel[3] = a;
-
-                    pPixel += 4;
-                }
+                colors = ByteBuffer();
             }
         }
-        else
+
+        width = info.width;
+        height = info.height;
+        bpp = info.bpp;
+
+        return colors;
+    }
+
+    ByteBuffer Image::LoadJPEG(const ByteBuffer& jpeg, int& width, int& height, int& bpp, int max_size)
+    {
+        if (!IsJPEG(jpeg))
         {
-            assert(!"color type not support");
+            width = height = bpp = 0;
+            return ByteBuffer();
         }
+        return LoadImage(jpeg, width, height, bpp, max_size);
+    }
 
-        png_destroy_read_struct(&png_ptr, &info_ptr, 0);
+    ByteBuffer Image::LoadPNG(const ByteBuffer& png, int& width, int& height, int& bpp, int max_size)
+    {
+        if (!IsPNG(png))
+        {
+            width = height = bpp = 0;
+            return ByteBuffer();
+        }
+        return LoadImage(png, width, height, bpp, max_size);
+    }
 
-        return colors;
+    void Image::ExpandRGBToRGBA(const byte* rgb, byte* rgba, int pixel_count)
+    {
+        int i = 0;
+
+#if VR_IMAGE_SSSE3
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i alpha = _mm_set1_epi32((int) 0xff000000);
+        for (; i + 16 <= pixel_count; i += 16)
+        {
+            const __m128i* src = (const __m128i*) &rgb[i * 3];
+            __m128i* dst = (__m128i*) &rgba[i * 4];
+            __m128i a = _mm_loadu_si128(src);
+            __m128i b = _mm_loadu_si128(src + 1);
+            __m128i c = _mm_loadu_si128(src + 2);
+            _mm_storeu_si128(dst, _mm_or_si128(_mm_shuffle_epi8(a, shuffle), alpha));
+            _mm_storeu_si128(dst + 1, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12), shuffle), alpha));
+            _mm_storeu_si128(dst + 2, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(c, b, 8), shuffle), alpha));
+            _mm_storeu_si128(dst + 3, _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(c, 4), shuffle), alpha));
+        }
+#elif VR_IMAGE_NEON
+        for (; i + 16 <= pixel_count; i += 16)
+        {
+            uint8x16x3_t src = vld3q_u8(&rgb[i * 3]);
+            uint8x16x4_t dst;
+            dst.val[0] = src.val[0];
+            dst.val[1] = src.val[1];
+            dst.val[2] = src.val[2];
+            dst.val[3] = vdupq_n_u8(255);
+            vst4q_u8(&rgba[i * 4], dst);
+        }
+#endif
+
+        for (; i < pixel_count; ++i)
+        {
+            rgba[i * 4 + 0] = rgb[i * 3 + 0];
+            rgba[i * 4 + 1] = rgb[i * 3 + 1];
+            rgba[i * 4 + 2] = rgb[i * 3 + 2];
+            rgba[i * 4 + 3] = 255;
+        }
+    }
+
+    bool Image::DecodeBatch(const Vector<ByteBuffer>& files, const Vector<byte*>& pixels, bool rgba, int max_size)
+    {
+        assert(files.Size() == pixels.Size());
+
+        std::atomic<bool> failed(false);
+
+        ThreadPool* pool = Application::Instance() ? Application::Instance()->GetThreadPool() : nullptr;
+        ThreadPool::ParallelFor(pool, files.Size(), [&](int i) {
+            if (!Image::Decode(files[i], pixels[i], rgba, max_size))
+            {
+                failed = true;
+            }
+        });
+
+        return !failed;
+    }
+
+    bool Image::DecodeBatch(const Vector<ByteBuffer>& files, Vector<ByteBuffer>& pixels, Vector<ImageInfo>& infos, bool rgba, int max_size)
+    {
+        pixels.Resize(files.Size());
+        infos.Resize(files.Size());
+
+        Vector<byte*> dests(files.Size());
+        for (int i = 0; i < files.Size(); ++i)
+        {
+            if (!Image::ReadInfo(files[i], infos[i], rgba, max_size))
+            {
+                return false;
+            }
+            pixels[i] = ByteBuffer(Image::GetPixelsSize(infos[i]));
+            dests[i] = pixels[i].Bytes();
+        }
+
+        return Image::DecodeBatch(files, dests, rgba, max_size);
     }
 
     void Image::EncodeToPNG(const String& file, const ByteBuffer& colors, int width, int height, int bpp)
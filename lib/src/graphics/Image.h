@@ -18,14 +18,36 @@
 #pragma once
 
 #include "string/String.h"
+#include "container/Vector.h"
 
 namespace Viry3D
 {
+    struct ImageInfo
+    {
+        int width = 0;
+        int height = 0;
+        // 8, 24 or 32 bits of the decoded pixels, gray with alpha decodes to rgba
+        int bpp = 0;
+    };
+
 	class Image
 	{
 	public:
-		static ByteBuffer LoadJPEG(const ByteBuffer& jpeg, int& width, int& height, int& bpp);
-		static ByteBuffer LoadPNG(const ByteBuffer& png, int& width, int& height, int& bpp);
+		static ByteBuffer LoadJPEG(const ByteBuffer& jpeg, int& width, int& height, int& bpp, int max_size = 0);
+		static ByteBuffer LoadPNG(const ByteBuffer& png, int& width, int& height, int& bpp, int max_size = 0);
 		static void EncodeToPNG(const String& file, const ByteBuffer& colors, int width, int height, int bpp);
+        // png or jpeg by signature, reads the header only, rgba makes 24 bit images report 32 bit.
+        // a max_size above 0 limits the larger side: jpeg decodes at a reduced dct scale without a full decode,
+        // and what is still larger, or any png, is box halved like mip levels until it fits
+        static bool ReadInfo(const ByteBuffer& file, ImageInfo& info, bool rgba, int max_size = 0);
+        static int GetPixelsSize(const ImageInfo& info) { return info.width * info.height * info.bpp / 8; }
+        // decodes straight into pixels, which holds GetPixelsSize bytes of the info read with the same rgba and max_size
+        static bool Decode(const ByteBuffer& file, byte* pixels, bool rgba, int max_size = 0);
+        // decodes the files on the thread pool with the calling thread helping, and returns when all are done.
+        // pixels[i] may point into one staging buffer, returns false if any file failed
+        static bool DecodeBatch(const Vector<ByteBuffer>& files, const Vector<byte*>& pixels, bool rgba, int max_size = 0);
+        static bool DecodeBatch(const Vector<ByteBuffer>& files, Vector<ByteBuffer>& pixels, Vector<ImageInfo>& infos, bool rgba, int max_size = 0);
+        // opaque alpha, simd where available
+        static void ExpandRGBToRGBA(const byte* rgb, byte* rgba, int pixel_count);
 	};
 }
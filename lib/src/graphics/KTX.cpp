@@ -0,0 +1,690 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "KTX.h"
+#include "io/MemoryStream.h"
+#include "memory/Memory.h"
+#include "math/Mathf.h"
+#include "Debug.h"
+#include "zlib/zlib.h"
+
+#define KTX_ENDIANNESS 0x04030201
+#define KTX_HEADER_SIZE 64
+#define KTX2_HEADER_SIZE 80
+#define KTX2_LEVEL_INDEX_SIZE 24
+#define KTX2_SUPERCOMPRESSION_NONE 0
+#define KTX2_SUPERCOMPRESSION_ZLIB 3
+
+namespace Viry3D
+{
+    static const byte KTX_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+    static const byte KTX2_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+    struct KTXFormat
+    {
+        TextureFormat format;
+        unsigned int gl_type;
+        unsigned int gl_type_size;
+        unsigned int gl_format;
+        unsigned int gl_internal_format;
+        unsigned int gl_base_internal_format;
+        unsigned int vk_format;
+    };
+
+    static const KTXFormat KTX_FORMATS[] = {
+        { TextureFormat::R8, 0x1401, 1, 0x1903, 0x8229, 0x1903, 9 },
+        { TextureFormat::R8G8, 0x1401, 1, 0x8227, 0x822B, 0x8227, 16 },
+        { TextureFormat::R8G8B8A8, 0x1401, 1, 0x1908, 0x8058, 0x1908, 37 },
+        { TextureFormat::R32G32B32A32F, 0x1406, 4, 0x1908, 0x8814, 0x1908, 109 },
+        { TextureFormat::BC1, 0, 1, 0, 0x83F0, 0x1907, 131 },
+        { TextureFormat::BC3, 0, 1, 0, 0x83F3, 0x1908, 137 },
+        { TextureFormat::BC4, 0, 1, 0, 0x8DBB, 0x1903, 139 },
+        { TextureFormat::BC5, 0, 1, 0, 0x8DBD, 0x8227, 141 },
+        { TextureFormat::BC7, 0, 1, 0, 0x8E8C, 0x1908, 145 },
+        { TextureFormat::ETC2_R8G8B8, 0, 1, 0, 0x9274, 0x1907, 147 },
+        { TextureFormat::ETC2_R8G8B8A8, 0, 1, 0, 0x9278, 0x1908, 151 },
+        { TextureFormat::ASTC_4x4, 0, 1, 0, 0x93B0, 0x1908, 157 },
+        { TextureFormat::ASTC_6x6, 0, 1, 0, 0x93B4, 0x1908, 165 },
+        { TextureFormat::ASTC_8x8, 0, 1, 0, 0x93B7, 0x1908, 171 },
+    };
+
+    // khronos data format descriptor sample, channel ids depend on the color model
+    struct KTXSample
+    {
+        int bit_offset;
+        int bit_length;
+        int channel;
+        unsigned int lower;
+        unsigned int upper;
+    };
+
+    static const KTXFormat* FindFormat(TextureFormat format)
+    {
+        for (const auto& i : KTX_FORMATS)
+        {
+            if (i.format == format)
+            {
+                return &i;
+            }
+        }
+
+        return nullptr;
+    }
+
+    unsigned int KTX::FormatToGLInternalFormat(TextureFormat format)
+    {
+        const KTXFormat* ktx_format = FindFormat(format);
+        return ktx_format ? ktx_format->gl_internal_format : 0;
+    }
+
+    TextureFormat KTX::GLInternalFormatToFormat(unsigned int internal_format)
+    {
+        for (const auto& i : KTX_FORMATS)
+        {
+            if (i.gl_internal_format == internal_format)
+            {
+                return i.format;
+            }
+        }
+
+        return TextureFormat::None;
+    }
+
+    unsigned int KTX::FormatToVkFormat(TextureFormat format)
+    {
+        const KTXFormat* ktx_format = FindFormat(format);
+        return ktx_format ? ktx_format->vk_format : 0;
+    }
+
+    TextureFormat KTX::VkFormatToFormat(unsigned int vk_format)
+    {
+        for (const auto& i : KTX_FORMATS)
+        {
+            if (i.vk_format == vk_format)
+            {
+                return i.format;
+            }
+        }
+
+        return TextureFormat::None;
+    }
+
+    static void ReadKeyValues(const byte* data, int size, Map<String, String>& key_values)
+    {
+        int offset = 0;
+        while (offset + 4 <= size)
+        {
+            int length;
+            Memory::Copy(&length, &data[offset], 4);
+            offset += 4;
+
+            if (length <= 0 || offset + length > size)
+            {
+                break;
+            }
+
+            const char* entry = (const char*) &data[offset];
+            int key_size = 0;
+            while (key_size < length && entry[key_size] != 0)
+            {
+                ++key_size;
+            }
+
+            if (key_size < length)
+            {
+                int value_size = length - key_size - 1;
+                if (value_size > 0 && entry[key_size + value_size] == 0)
+                {
+                    --value_size;
+                }
+                key_values.Add(String(entry, key_size), String(&entry[key_size + 1], value_size));
+            }
+
+            offset += (length + 3) & ~3;
+        }
+    }
+
+    bool KTX::Load(const ByteBuffer& file, KTXImage& image)
+    {
+        if (file.Size() >= KTX_HEADER_SIZE && Memory::Compare(file.Bytes(), KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) == 0)
+        {
+            return LoadKTX1(file, image);
+        }
+        if (file.Size() >= KTX2_HEADER_SIZE && Memory::Compare(file.Bytes(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0)
+        {
+            return LoadKTX2(file, image);
+        }
+
+        Log("not a ktx file");
+        return false;
+    }
+
+    TextureFormat KTX::ReadFormat(const ByteBuffer& file)
+    {
+        if (file.Size() >= KTX_HEADER_SIZE && Memory::Compare(file.Bytes(), KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) == 0)
+        {
+            MemoryStream ms(file);
+            ms.Read(nullptr, sizeof(KTX_IDENTIFIER));
+            if (ms.Read<unsigned int>() != KTX_ENDIANNESS)
+            {
+                return TextureFormat::None;
+            }
+            ms.Read<unsigned int>(); // gl_type
+            ms.Read<unsigned int>(); // gl_type_size
+            ms.Read<unsigned int>(); // gl_format
+            return GLInternalFormatToFormat(ms.Read<unsigned int>());
+        }
+        if (file.Size() >= KTX2_HEADER_SIZE && Memory::Compare(file.Bytes(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0)
+        {
+            MemoryStream ms(file);
+            ms.Read(nullptr, sizeof(KTX2_IDENTIFIER));
+            return VkFormatToFormat(ms.Read<unsigned int>());
+        }
+
+        return TextureFormat::None;
+    }
+
+    bool KTX::LoadKTX1(const ByteBuffer& file, KTXImage& image)
+    {
+        MemoryStream ms(file);
+        ms.Read(nullptr, sizeof(KTX_IDENTIFIER));
+
+        unsigned int endianness = ms.Read<unsigned int>();
+        if (endianness != KTX_ENDIANNESS)
+        {
+            Log("ktx endianness not support: %x", endianness);
+            return false;
+        }
+
+        ms.Read<unsigned int>(); // gl_type
+        ms.Read<unsigned int>(); // gl_type_size
+        ms.Read<unsigned int>(); // gl_format
+        unsigned int gl_internal_format = ms.Read<unsigned int>();
+        ms.Read<unsigned int>(); // gl_base_internal_format
+        int width = ms.Read<int>();
+        int height = ms.Read<int>();
+        int depth = ms.Read<int>();
+        int layer_count = ms.Read<int>();
+        int face_count = ms.Read<int>();
+        int level_count = ms.Read<int>();
+        int key_value_size = ms.Read<int>();
+
+        image.format = GLInternalFormatToFormat(gl_internal_format);
+        if (image.format == TextureFormat::None)
+        {
+            Log("ktx format not support: %x", gl_internal_format);
+            return false;
+        }
+        if (depth > 1)
+        {
+            Log("ktx 3d texture not support");
+            return false;
+        }
+
+        image.width = width;
+        image.height = Mathf::Max(height, 1);
+        image.layer_count = Mathf::Max(layer_count, 1);
+        image.face_count = Mathf::Max(face_count, 1);
+        image.level_count = Mathf::Max(level_count, 1);
+        image.images.Clear();
+        image.storage.Clear();
+        image.key_values.Clear();
+
+        if (KTX_HEADER_SIZE + key_value_size > file.Size())
+        {
+            Log("ktx file truncated");
+            return false;
+        }
+        ReadKeyValues(&file.Bytes()[KTX_HEADER_SIZE], key_value_size, image.key_values);
+
+        int offset = KTX_HEADER_SIZE + key_value_size;
+        for (int i = 0; i < image.level_count; ++i)
+        {
+            if (offset + 4 > file.Size())
+            {
+                Log("ktx file truncated");
+                return false;
+            }
+
+            int image_size;
+            Memory::Copy(&image_size, &file.Bytes()[offset], 4);
+            offset += 4;
+
+            // a non array cubemap stores the size of one face, otherwise the size of the whole level
+            int face_size = image_size;
+            if (layer_count != 0 || face_count != 6)
+            {
+                face_size = image_size / (image.layer_count * image.face_count);
+            }
+
+            int level_width = Mathf::Max(image.width >> i, 1);
+            int level_height = Mathf::Max(image.height >> i, 1);
+            if (face_size != TextureFormatInfo::GetImageSize(image.format, level_width, level_height))
+            {
+                Log("ktx level %d size not match", i);
+                return false;
+            }
+
+            for (int j = 0; j < image.layer_count * image.face_count; ++j)
+            {
+                if (offset + face_size > file.Size())
+                {
+                    Log("ktx file truncated");
+                    return false;
+                }
+
+                image.images.Add(ByteBuffer(&file.Bytes()[offset], face_size));
+                offset += (face_size + 3) & ~3;
+            }
+        }
+
+        return true;
+    }
+
+    ByteBuffer KTX::Save(TextureFormat format, int width, int height, const Vector<ByteBuffer>& levels)
+    {
+        const KTXFormat* ktx_format = FindFormat(format);
+        assert(ktx_format);
+
+        int size = KTX_HEADER_SIZE;
+        for (int i = 0; i < levels.Size(); ++i)
+        {
+            size += 4 + ((levels[i].Size() + 3) & ~3);
+        }
+
+        ByteBuffer file(size);
+        Memory::Zero(file.Bytes(), file.Size());
+        MemoryStream ms(file);
+
+        ms.Write((void*) KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER));
+        ms.Write<unsigned int>(KTX_ENDIANNESS);
+        ms.Write<unsigned int>(ktx_format->gl_type);
+        ms.Write<unsigned int>(ktx_format->gl_type_size);
+        ms.Write<unsigned int>(ktx_format->gl_format);
+        ms.Write<unsigned int>(ktx_format->gl_internal_format);
+        ms.Write<unsigned int>(ktx_format->gl_base_internal_format);
+        ms.Write<int>(width);
+        ms.Write<int>(height);
+        ms.Write<int>(0);
+        ms.Write<int>(0);
+        ms.Write<int>(1);
+        ms.Write<int>(levels.Size());
+        ms.Write<int>(0);
+
+        for (int i = 0; i < levels.Size(); ++i)
+        {
+            ms.Write<int>(levels[i].Size());
+            ms.Write(levels[i].Bytes(), levels[i].Size());
+
+            int padding = ((levels[i].Size() + 3) & ~3) - levels[i].Size();
+            if (padding > 0)
+            {
+                byte zero[3] = { 0, 0, 0 };
+                ms.Write(zero, padding);
+            }
+        }
+
+        return file;
+    }
+    bool KTX::LoadKTX2(const ByteBuffer& file, KTXImage& image)
+    {
+        MemoryStream ms(file);
+        ms.Read(nullptr, sizeof(KTX2_IDENTIFIER));
+
+        unsigned int vk_format = ms.Read<unsigned int>();
+        ms.Read<unsigned int>(); // type_size
+        int width = ms.Read<int>();
+        int height = ms.Read<int>();
+        int depth = ms.Read<int>();
+        int layer_count = ms.Read<int>();
+        int face_count = ms.Read<int>();
+        int level_count = ms.Read<int>();
+        unsigned int supercompression = ms.Read<unsigned int>();
+        ms.Read<unsigned int>(); // dfd_offset
+        ms.Read<unsigned int>(); // dfd_size
+        unsigned int kvd_offset = ms.Read<unsigned int>();
+        unsigned int kvd_size = ms.Read<unsigned int>();
+        ms.Read<unsigned long long>(); // sgd_offset
+        ms.Read<unsigned long long>(); // sgd_size
+
+        image.format = VkFormatToFormat(vk_format);
+        if (image.format == TextureFormat::None)
+        {
+            Log("ktx2 format not support: %d", vk_format);
+            return false;
+        }
+        if (depth > 0)
+        {
+            Log("ktx2 3d texture not support");
+            return false;
+        }
+        if (supercompression != KTX2_SUPERCOMPRESSION_NONE && supercompression != KTX2_SUPERCOMPRESSION_ZLIB)
+        {
+            Log("ktx2 supercompression not support: %d", supercompression);
+            return false;
+        }
+
+        image.width = width;
+        image.height = Mathf::Max(height, 1);
+        image.layer_count = Mathf::Max(layer_count, 1);
+        image.face_count = Mathf::Max(face_count, 1);
+        image.level_count = Mathf::Max(level_count, 1);
+        image.images.Clear();
+        image.storage.Clear();
+        image.key_values.Clear();
+
+        if (KTX2_HEADER_SIZE + image.level_count * KTX2_LEVEL_INDEX_SIZE > file.Size() ||
+            (long long) kvd_offset + kvd_size > file.Size())
+        {
+            Log("ktx2 file truncated");
+            return false;
+        }
+        ReadKeyValues(&file.Bytes()[kvd_offset], kvd_size, image.key_values);
+
+        int image_count = image.layer_count * image.face_count;
+
+        for (int i = 0; i < image.level_count; ++i)
+        {
+            unsigned long long offset = ms.Read<unsigned long long>();
+            unsigned long long size = ms.Read<unsigned long long>();
+            unsigned long long uncompressed_size = ms.Read<unsigned long long>();
+
+            if (offset + size > (unsigned long long) file.Size())
+            {
+                Log("ktx2 file truncated");
+                return false;
+            }
+
+            int level_width = Mathf::Max(image.width >> i, 1);
+            int level_height = Mathf::Max(image.height >> i, 1);
+            int image_size = TextureFormatInfo::GetImageSize(image.format, level_width, level_height);
+
+            const byte* level = &file.Bytes()[offset];
+            int level_size = (int) size;
+
+            if (supercompression == KTX2_SUPERCOMPRESSION_ZLIB)
+            {
+                ByteBuffer inflated((int) uncompressed_size);
+                uLongf inflated_size = (uLongf) uncompressed_size;
+                if (uncompress(inflated.Bytes(), &inflated_size, level, (uLong) size) != Z_OK || inflated_size != uncompressed_size)
+                {
+                    Log("ktx2 level %d inflate failed", i);
+                    return false;
+                }
+                image.storage.Add(inflated);
+
+                level = inflated.Bytes();
+                level_size = inflated.Size();
+            }
+
+            if (level_size != image_size * image_count)
+            {
+                Log("ktx2 level %d size not match", i);
+                return false;
+            }
+
+            for (int j = 0; j < image_count; ++j)
+            {
+                image.images.Add(ByteBuffer((byte*) &level[j * image_size], image_size));
+            }
+        }
+
+        return true;
+    }
+
+    static bool GetDataFormat(TextureFormat format, int& color_model, Vector<KTXSample>& samples)
+    {
+        const unsigned int max = 0xFFFFFFFF;
+
+        switch (format)
+        {
+            case TextureFormat::R8:
+                color_model = 1;
+                samples = { { 0, 8, 0, 0, 255 } };
+                break;
+            case TextureFormat::R8G8:
+                color_model = 1;
+                samples = { { 0, 8, 0, 0, 255 }, { 8, 8, 1, 0, 255 } };
+                break;
+            case TextureFormat::R8G8B8A8:
+                color_model = 1;
+                samples = { { 0, 8, 0, 0, 255 }, { 8, 8, 1, 0, 255 }, { 16, 8, 2, 0, 255 }, { 24, 8, 15, 0, 255 } };
+                break;
+            case TextureFormat::R32G32B32A32F:
+            {
+                // float and signed qualifiers, bounds are -1.0f and 1.0f
+                color_model = 1;
+                const int q = 0x80 | 0x40;
+                samples = { { 0, 32, 0 | q, 0xBF800000, 0x3F800000 }, { 32, 32, 1 | q, 0xBF800000, 0x3F800000 }, { 64, 32, 2 | q, 0xBF800000, 0x3F800000 }, { 96, 32, 15 | q, 0xBF800000, 0x3F800000 } };
+                break;
+            }
+            case TextureFormat::BC1:
+                color_model = 128;
+                samples = { { 0, 64, 0, 0, max } };
+                break;
+            case TextureFormat::BC3:
+                color_model = 130;
+                samples = { { 0, 64, 15, 0, max }, { 64, 64, 0, 0, max } };
+                break;
+            case TextureFormat::BC4:
+                color_model = 131;
+                samples = { { 0, 64, 0, 0, max } };
+                break;
+            case TextureFormat::BC5:
+                color_model = 132;
+                samples = { { 0, 64, 0, 0, max }, { 64, 64, 1, 0, max } };
+                break;
+            case TextureFormat::BC7:
+                color_model = 134;
+                samples = { { 0, 128, 0, 0, max } };
+                break;
+            case TextureFormat::ETC2_R8G8B8:
+                color_model = 161;
+                samples = { { 0, 64, 2, 0, max } };
+                break;
+            case TextureFormat::ETC2_R8G8B8A8:
+                color_model = 161;
+                samples = { { 0, 64, 15, 0, max }, { 64, 64, 2, 0, max } };
+                break;
+            case TextureFormat::ASTC_4x4:
+            case TextureFormat::ASTC_6x6:
+            case TextureFormat::ASTC_8x8:
+                color_model = 162;
+                samples = { { 0, 128, 0, 0, max } };
+                break;
+            default:
+                return false;
+        }
+
+        return true;
+    }
+
+    // basic data format descriptor block, linear bt709
+    static ByteBuffer BuildDataFormatDescriptor(TextureFormat format)
+    {
+        int color_model = 0;
+        Vector<KTXSample> samples;
+        bool supported = GetDataFormat(format, color_model, samples);
+        assert(supported);
+        (void) supported;
+
+        int block_width;
+        int block_height;
+        int block_bytes;
+        TextureFormatInfo::GetBlockSize(format, block_width, block_height, block_bytes);
+
+        int block_size = 24 + 16 * samples.Size();
+        ByteBuffer dfd(4 + block_size);
+        Memory::Zero(dfd.Bytes(), dfd.Size());
+        MemoryStream ms(dfd);
+
+        ms.Write<unsigned int>(dfd.Size());
+        ms.Write<unsigned int>(0); // vendor khronos, type basic
+        ms.Write<unsigned short>(2); // version
+        ms.Write<unsigned short>((unsigned short) block_size);
+        ms.Write<byte>((byte) color_model);
+        ms.Write<byte>(1); // primaries bt709
+        ms.Write<byte>(1); // transfer linear
+        ms.Write<byte>(0); // straight alpha
+        ms.Write<byte>((byte) (block_width - 1));
+        ms.Write<byte>((byte) (block_height - 1));
+        ms.Write<byte>(0);
+        ms.Write<byte>(0);
+        ms.Write<byte>((byte) block_bytes);
+        ms.Write(nullptr, 7);
+
+        for (int i = 0; i < samples.Size(); ++i)
+        {
+            ms.Write<unsigned short>((unsigned short) samples[i].bit_offset);
+            ms.Write<byte>((byte) (samples[i].bit_length - 1));
+            ms.Write<byte>((byte) samples[i].channel);
+            ms.Write<unsigned int>(0); // sample position
+            ms.Write<unsigned int>(samples[i].lower);
+            ms.Write<unsigned int>(samples[i].upper);
+        }
+
+        return dfd;
+    }
+
+    ByteBuffer KTX::SaveKTX2(const KTXImage& image, bool zlib)
+    {
+        const KTXFormat* ktx_format = FindFormat(image.format);
+        assert(ktx_format);
+
+        int image_count = image.layer_count * image.face_count;
+        assert(image.images.Size() == image.level_count * image_count);
+
+        int block_width;
+        int block_height;
+        int block_bytes;
+        TextureFormatInfo::GetBlockSize(image.format, block_width, block_height, block_bytes);
+
+        // lcm of the texel block size and 4 when stored, any alignment when supercompressed
+        int alignment = zlib ? 1 : (block_bytes % 4 == 0 ? block_bytes : 4);
+
+        Vector<ByteBuffer> levels(image.level_count);
+        Vector<int> uncompressed_sizes(image.level_count);
+        for (int i = 0; i < image.level_count; ++i)
+        {
+            int size = 0;
+            for (int j = 0; j < image_count; ++j)
+            {
+                size += image.images[i * image_count + j].Size();
+            }
+
+            ByteBuffer level(size);
+            int offset = 0;
+            for (int j = 0; j < image_count; ++j)
+            {
+                const ByteBuffer& src = image.images[i * image_count + j];
+                Memory::Copy(&level[offset], src.Bytes(), src.Size());
+                offset += src.Size();
+            }
+            uncompressed_sizes[i] = size;
+
+            if (zlib)
+            {
+                uLongf compressed_size = compressBound((uLong) size);
+                ByteBuffer compressed((int) compressed_size);
+                int result = compress2(compressed.Bytes(), &compressed_size, level.Bytes(), (uLong) size, Z_BEST_COMPRESSION);
+                assert(result == Z_OK);
+                (void) result;
+                level = ByteBuffer((int) compressed_size);
+                Memory::Copy(level.Bytes(), compressed.Bytes(), (int) compressed_size);
+            }
+
+            levels[i] = level;
+        }
+
+        ByteBuffer dfd = BuildDataFormatDescriptor(image.format);
+
+        Map<String, String> key_values = image.key_values;
+        if (!key_values.Contains("KTXwriter"))
+        {
+            key_values.Add("KTXwriter", "Viry3D");
+        }
+
+        int kvd_size = 0;
+        for (const auto& i : key_values)
+        {
+            kvd_size += 4 + (((int) i.first.Size() + (int) i.second.Size() + 2 + 3) & ~3);
+        }
+
+        int dfd_offset = KTX2_HEADER_SIZE + image.level_count * KTX2_LEVEL_INDEX_SIZE;
+        int kvd_offset = dfd_offset + dfd.Size();
+        int data_offset = kvd_offset + kvd_size;
+
+        // smallest level first in the file
+        Vector<int> level_offsets(image.level_count);
+        int size = data_offset;
+        for (int i = image.level_count - 1; i >= 0; --i)
+        {
+            size = (size + alignment - 1) / alignment * alignment;
+            level_offsets[i] = size;
+            size += levels[i].Size();
+        }
+
+        ByteBuffer file(size);
+        Memory::Zero(file.Bytes(), file.Size());
+        MemoryStream ms(file);
+
+        ms.Write((void*) KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+        ms.Write<unsigned int>(ktx_format->vk_format);
+        ms.Write<unsigned int>(ktx_format->gl_type_size);
+        ms.Write<int>(image.width);
+        ms.Write<int>(image.height);
+        ms.Write<int>(0);
+        ms.Write<int>(image.layer_count > 1 ? image.layer_count : 0);
+        ms.Write<int>(image.face_count);
+        ms.Write<int>(image.level_count);
+        ms.Write<unsigned int>(zlib ? KTX2_SUPERCOMPRESSION_ZLIB : KTX2_SUPERCOMPRESSION_NONE);
+        ms.Write<unsigned int>(dfd_offset);
+        ms.Write<unsigned int>(dfd.Size());
+        ms.Write<unsigned int>(kvd_offset);
+        ms.Write<unsigned int>(kvd_size);
+        ms.Write<unsigned long long>(0);
+        ms.Write<unsigned long long>(0);
+
+        for (int i = 0; i < image.level_count; ++i)
+        {
+            ms.Write<unsigned long long>(level_offsets[i]);
+            ms.Write<unsigned long long>(levels[i].Size());
+            ms.Write<unsigned long long>(uncompressed_sizes[i]);
+        }
+
+        ms.Write(dfd.Bytes(), dfd.Size());
+
+        for (const auto& i : key_values)
+        {
+            int length = (int) i.first.Size() + (int) i.second.Size() + 2;
+            ms.Write<int>(length);
+            ms.Write((void*) i.first.CString(), i.first.Size() + 1);
+            ms.Write((void*) i.second.CString(), i.second.Size() + 1);
+            ms.Write(nullptr, ((length + 3) & ~3) - length);
+        }
+
+        int position = data_offset;
+        for (int i = image.level_count - 1; i >= 0; --i)
+        {
+            ms.Write(nullptr, level_offsets[i] - position);
+            ms.Write(levels[i].Bytes(), levels[i].Size());
+            position = level_offsets[i] + levels[i].Size();
+        }
+
+        return file;
+    }
+}
@@ -0,0 +1,69 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "TextureFormat.h"
+#include "container/Vector.h"
+#include "container/Map.h"
+#include "string/String.h"
+#include "memory/ByteBuffer.h"
+
+// sampler state written by the texture tools, values are the FilterMode and SamplerAddressMode numbers
+#define KTX_KEY_FILTER_MODE "Viry3DFilterMode"
+#define KTX_KEY_WRAP_MODE "Viry3DWrapMode"
+
+namespace Viry3D
+{
+    struct KTXImage
+    {
+        TextureFormat format = TextureFormat::None;
+        int width = 0;
+        int height = 0;
+        int layer_count = 1;
+        int face_count = 1;
+        int level_count = 1;
+        // ordered by level, layer, face. views into the loaded file or into storage, keep them alive while using the images
+        Vector<ByteBuffer> images;
+        // inflated level data of supercompressed files
+        Vector<ByteBuffer> storage;
+        Map<String, String> key_values;
+    };
+
+    // khronos texture container version 1.1 and 2.0.
+    // version 1.1 stores gl internal formats, version 2.0 stores vulkan formats.
+    class KTX
+    {
+    public:
+        // detects the version from the file identifier
+        static bool Load(const ByteBuffer& file, KTXImage& image);
+        // reads only the header, None when it is not a ktx file
+        static TextureFormat ReadFormat(const ByteBuffer& file);
+        // writes a version 1.1 2d texture, one image per mip level
+        static ByteBuffer Save(TextureFormat format, int width, int height, const Vector<ByteBuffer>& levels);
+        // writes a version 2.0 texture with all levels, layers and faces, zlib supercompresses each level
+        static ByteBuffer SaveKTX2(const KTXImage& image, bool zlib);
+        static unsigned int FormatToGLInternalFormat(TextureFormat format);
+        static TextureFormat GLInternalFormatToFormat(unsigned int internal_format);
+        static unsigned int FormatToVkFormat(TextureFormat format);
+        static TextureFormat VkFormatToFormat(unsigned int vk_format);
+
+    private:
+        static bool LoadKTX1(const ByteBuffer& file, KTXImage& image);
+        static bool LoadKTX2(const ByteBuffer& file, KTXImage& image);
+    };
+}
@@ -16,6 +16,15 @@
 */
 
 #include "Light.h"
+#include "Camera.h"
+#include "Material.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "RenderTexturePool.h"
+#include "Mesh.h"
+#include "MeshRenderer.h"
+#include "SkinnedMeshRenderer.h"
+#include "math/Mathf.h"
 
 namespace Viry3D
 {
@@ -29,14 +38,26 @@ namespace Viry3D
     Light::Light(LightType type):
         m_type(type),
         m_color(1, 1, 1, 1),
-        m_intensity(1.0f)
+        m_intensity(1.0f),
+        m_range(10),
+        m_spot_angle(30),
+        m_shadow_enable(false),
+        m_shadow_cascade_count(SHADOW_CASCADE_MAX),
+        m_shadow_map_size(1024),
+        m_shadow_distance(50),
+        m_shadow_split_lambda(0.75f),
+        m_shadow_strength(1.0f),
+        m_shadow_z_bias(0.0f),
+        m_shadow_slope_bias(0.0001f),
+        m_shadow_filter_radius(3.0f),
+        m_shadow_resources_dirty(true)
     {
     
     }
 
     Light::~Light()
     {
-        
+        this->ClearShadowResources();
     }
 
     void Light::SetColor(const Color& color)
@@ -48,4 +69,485 @@ namespace Viry3D
     {
         m_intensity = intensity;
     }
+
+    void Light::SetRange(float range)
+    {
+        m_range = range;
+    }
+
+    void Light::SetSpotAngle(float angle)
+    {
+        m_spot_angle = angle;
+    }
+
+    void Light::EnableShadow(bool enable)
+    {
+        if (m_shadow_enable != enable)
+        {
+            m_shadow_enable = enable;
+
+            if (!m_shadow_enable)
+            {
+                this->ClearShadowResources();
+                m_shadow_resources_dirty = true;
+            }
+        }
+    }
+
+    void Light::SetShadowCascadeCount(int count)
+    {
+        count = Mathf::Clamp(count, 1, SHADOW_CASCADE_MAX);
+        if (m_shadow_cascade_count != count)
+        {
+            m_shadow_cascade_count = count;
+            m_shadow_resources_dirty = true;
+        }
+    }
+
+    void Light::SetShadowMapSize(int size)
+    {
+        if (m_shadow_map_size != size)
+        {
+            m_shadow_map_size = size;
+            m_shadow_resources_dirty = true;
+        }
+    }
+
+    void Light::SetShadowDistance(float distance)
+    {
+        m_shadow_distance = distance;
+    }
+
+    void Light::SetShadowSplitLambda(float lambda)
+    {
+        m_shadow_split_lambda = Mathf::Clamp01(lambda);
+    }
+
+    void Light::UpdateShadow(Camera* view_camera)
+    {
+        if (!m_shadow_enable || m_type != LightType::Directional || view_camera == nullptr)
+        {
+            return;
+        }
+
+        if (m_shadow_resources_dirty)
+        {
+            m_shadow_resources_dirty = false;
+            this->ClearShadowResources();
+            this->CreateShadowResources();
+        }
+
+        for (int i = 0; i < m_shadow_cascades.Size(); ++i)
+        {
+            int depth = view_camera->GetDepth() - m_shadow_cascades.Size() + i;
+            if (m_shadow_cascades[i].camera->GetDepth() != depth)
+            {
+                m_shadow_cascades[i].camera->SetDepth(depth);
+            }
+        }
+
+        this->UpdateShadowCasters(view_camera);
+
+        // practical split scheme, blends logarithmic and uniform splits
+        int count = m_shadow_cascades.Size();
+        float near_clip = view_camera->GetNearClip();
+        float far_clip = Mathf::Max(Mathf::Min(view_camera->GetFarClip(), m_shadow_distance), near_clip);
+        Vector<float> splits(count + 1);
+        splits[0] = near_clip;
+        for (int i = 1; i <= count; ++i)
+        {
+            float p = i / (float) count;
+            float uniform_split = near_clip + (far_clip - near_clip) * p;
+            float log_split = uniform_split;
+            if (near_clip > 0)
+            {
+                log_split = near_clip * powf(far_clip / near_clip, p);
+            }
+            splits[i] = Mathf::Lerp(uniform_split, log_split, m_shadow_split_lambda);
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            this->FitShadowCascade(view_camera, i, splits[i], splits[i + 1]);
+        }
+
+        this->UpdateShadowReceivers(view_camera, splits);
+    }
+
+    void Light::CreateShadowResources()
+    {
+        int count = m_shadow_cascade_count;
+        int cols = Mathf::Min(count, 2);
+        int rows = (count + 1) / 2;
+
+        // all cascades share one atlas, the first cascade camera clears it
+        m_shadow_texture = RenderTexturePool::Acquire(
+            m_shadow_map_size * cols,
+            m_shadow_map_size * rows,
+            Texture::ChooseDepthFormatSupported(true),
+            1,
+            true,
+            FilterMode::Nearest,
+            SamplerAddressMode::ClampToEdge);
+
+#if VR_GLES
+        bool mac = false;
+#if VR_MAC
+        mac = true;
+#elif VR_WASM
+        mac = Display::Instance()->GetPlatform() == Display::Platform::Mac;
+#endif
+
+        // MARK:
+        // mac gl / webgl framebuffer need a color attachment
+        if (mac)
+        {
+            m_shadow_color_texture = RenderTexturePool::Acquire(
+                m_shadow_map_size * cols,
+                m_shadow_map_size * rows,
+                TextureFormat::R8G8B8A8,
+                1,
+                false,
+                FilterMode::None,
+                SamplerAddressMode::None);
+        }
+#endif
+
+        RenderState render_state;
+        render_state.cull = RenderState::Cull::Front;
+
+#if VR_VULKAN
+        auto shader = RefMake<Shader>(
+            "#define CAST_SHADOW 1",
+            Vector<String>({ "Diffuse.vs.in" }),
+            "",
+            "#define CAST_SHADOW 1",
+            Vector<String>({ "Diffuse.fs.in" }),
+            "",
+            render_state);
+        auto skin_shader = RefMake<Shader>(
+            "#define CAST_SHADOW 1\n"
+            "#define SKINNED_MESH 1",
+            Vector<String>({ "Skin.in", "Diffuse.vs.in" }),
+            "",
+            "#define CAST_SHADOW 1",
+            Vector<String>({ "Diffuse.fs.in" }),
+            "",
+            render_state);
+#elif VR_GLES
+        auto shader = RefMake<Shader>(
+            "#define CAST_SHADOW 1",
+            Vector<String>({ "Diffuse.100.vs.in" }),
+            "",
+            "#define CAST_SHADOW 1",
+            Vector<String>({ "Diffuse.100.fs.in" }),
+            "",
+            render_state);
+        auto skin_shader = RefMake<Shader>(
+            "#define CAST_SHADOW 1\n"
+            "#define SKINNED_MESH 1",
+            Vector<String>({ "Diffuse.100.vs.in" }),
+            "",
+            "#define CAST_SHADOW 1",
+            Vector<String>({ "Diffuse.100.fs.in" }),
+            "",
+            render_state);
+#endif
+
+        m_shadow_cascades.Resize(count);
+        for (int i = 0; i < count; ++i)
+        {
+            ShadowCascade& cascade = m_shadow_cascades[i];
+            int col = i % cols;
+            int row = i / cols;
+            cascade.rect = Rect(col / (float) cols, row / (float) rows, 1.0f / cols, 1.0f / rows);
+            cascade.material = RefMake<Material>(shader);
+            cascade.skin_material = RefMake<Material>(skin_shader);
+
+            cascade.camera = Display::Instance()->CreateCamera();
+            cascade.camera->SetClearFlags(i == 0 ? CameraClearFlags::Depth : CameraClearFlags::Nothing);
+            cascade.camera->SetRenderTarget(m_shadow_color_texture, m_shadow_texture);
+            cascade.camera->SetViewportRect(cascade.rect);
+        }
+    }
+
+    void Light::ClearShadowResources()
+    {
+        m_shadow_casters.Clear();
+
+        for (int i = 0; i < m_shadow_cascades.Size(); ++i)
+        {
+            Display::Instance()->DestroyCamera(m_shadow_cascades[i].camera);
+        }
+        m_shadow_cascades.Clear();
+
+        RenderTexturePool::Release(m_shadow_texture);
+        RenderTexturePool::Release(m_shadow_color_texture);
+        m_shadow_texture.reset();
+        m_shadow_color_texture.reset();
+    }
+
+    void Light::UpdateShadowCasters(Camera* view_camera)
+    {
+        for (auto& i : m_shadow_casters)
+        {
+            i.second.visited = false;
+        }
+
+        for (const auto& i : view_camera->GetRenderers())
+        {
+            // instances are not mirrored by the proxies
+            Ref<MeshRenderer> renderer = RefCast<MeshRenderer>(i.renderer);
+            if (!renderer || !renderer->IsCastShadow() || !renderer->GetMesh() || renderer->GetInstanceCount() > 1)
+            {
+                continue;
+            }
+
+            ShadowCaster* caster;
+            if (!m_shadow_casters.TryGet(renderer.get(), &caster) || caster->renderer.lock() != renderer)
+            {
+                ShadowCaster new_caster;
+                new_caster.renderer = renderer;
+                new_caster.proxies.Resize(m_shadow_cascades.Size());
+                for (int j = 0; j < m_shadow_cascades.Size(); ++j)
+                {
+                    new_caster.proxies[j] = this->CreateShadowProxy(renderer, j);
+                    m_shadow_cascades[j].camera->AddRenderer(new_caster.proxies[j]);
+                }
+
+                m_shadow_casters.Remove(renderer.get());
+                m_shadow_casters.Add(renderer.get(), new_caster);
+                m_shadow_casters.TryGet(renderer.get(), &caster);
+            }
+            caster->visited = true;
+
+            Vector3 position = renderer->GetPosition();
+            Quaternion rotation = renderer->GetRotation();
+            Vector3 scale = renderer->GetScale();
+
+            for (int j = 0; j < caster->proxies.Size(); ++j)
+            {
+                const Ref<MeshRenderer>& proxy = caster->proxies[j];
+
+                if (proxy->GetMesh() != renderer->GetMesh() || proxy->GetSubmesh() != renderer->GetSubmesh())
+                {
+                    proxy->SetMesh(renderer->GetMesh(), renderer->GetSubmesh());
+                }
+                if (proxy->GetLocalPosition() != position)
+                {
+                    proxy->SetLocalPosition(position);
+                }
+                if (proxy->GetLocalRotation() != rotation)
+                {
+                    proxy->SetLocalRotation(rotation);
+                }
+                if (proxy->GetLocalScale() != scale)
+                {
+                    proxy->SetLocalScale(scale);
+                }
+            }
+        }
+
+        for (auto i = m_shadow_casters.begin(); i != m_shadow_casters.end(); )
+        {
+            if (!i->second.visited)
+            {
+                for (int j = 0; j < i->second.proxies.Size(); ++j)
+                {
+                    m_shadow_cascades[j].camera->RemoveRenderer(i->second.proxies[j]);
+                }
+                i = m_shadow_casters.Remove(i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+    Ref<MeshRenderer> Light::CreateShadowProxy(const Ref<MeshRenderer>& renderer, int cascade)
+    {
+        Ref<MeshRenderer> proxy;
+
+        Ref<SkinnedMeshRenderer> skin = RefCast<SkinnedMeshRenderer>(renderer);
+        if (skin && skin->IsSkinningPrePass())
+        {
+            // draws the vertices already skinned for the view camera
+            Ref<SkinnedMeshRenderer> shadow_skin = RefMake<SkinnedMeshRenderer>();
+            shadow_skin->SetSkinningSource(skin);
+            shadow_skin->SetMaterial(m_shadow_cascades[cascade].material);
+            proxy = shadow_skin;
+        }
+        else if (skin)
+        {
+            Ref<SkinnedMeshRenderer> shadow_skin = RefMake<SkinnedMeshRenderer>();
+            shadow_skin->SetBonePaths(skin->GetBonePaths());
+            shadow_skin->SetBonesRoot(skin->GetBonesRoot());
+            shadow_skin->SetMaterial(m_shadow_cascades[cascade].skin_material);
+            proxy = shadow_skin;
+        }
+        else
+        {
+            proxy = RefMake<MeshRenderer>();
+            proxy->SetMaterial(m_shadow_cascades[cascade].material);
+        }
+
+        proxy->SetMesh(renderer->GetMesh(), renderer->GetSubmesh());
+        proxy->SetLocalPosition(renderer->GetPosition());
+        proxy->SetLocalRotation(renderer->GetRotation());
+        proxy->SetLocalScale(renderer->GetScale());
+
+        return proxy;
+    }
+
+    void Light::FitShadowCascade(Camera* view_camera, int cascade, float near_clip, float far_clip)
+    {
+        ShadowCascade& shadow_cascade = m_shadow_cascades[cascade];
+
+        Vector3 position = view_camera->GetPosition();
+        Vector3 forward = view_camera->GetForward();
+        Vector3 right = view_camera->GetRight();
+        Vector3 up = view_camera->GetUp();
+        const Rect& viewport = view_camera->GetViewportRect();
+        float aspect = (view_camera->GetTargetWidth() * viewport.width) / (view_camera->GetTargetHeight() * viewport.height);
+
+        Vector3 corners[8];
+        for (int i = 0; i < 2; ++i)
+        {
+            float distance = i == 0 ? near_clip : far_clip;
+            float h;
+            if (view_camera->IsOrthographic())
+            {
+                h = view_camera->GetOrthographicSize();
+            }
+            else
+            {
+                h = tanf(view_camera->GetFieldOfView() * Mathf::Deg2Rad / 2) * distance;
+            }
+            float w = h * aspect;
+            Vector3 center = position + forward * distance;
+
+            corners[i * 4 + 0] = center - right * w - up * h;
+            corners[i * 4 + 1] = center + right * w - up * h;
+            corners[i * 4 + 2] = center - right * w + up * h;
+            corners[i * 4 + 3] = center + right * w + up * h;
+        }
+
+        // a bounding sphere keeps the cascade size constant while the view rotates
+        Vector3 center(0, 0, 0);
+        for (int i = 0; i < 8; ++i)
+        {
+            center += corners[i];
+        }
+        center = center * (1.0f / 8);
+
+        float radius = 0;
+        for (int i = 0; i < 8; ++i)
+        {
+            radius = Mathf::Max(radius, (corners[i] - center).Magnitude());
+        }
+        radius = ceilf(radius * 16) / 16;
+
+        // snap the center to whole texels so static shadows do not shimmer while the view moves
+        Matrix4x4 light_view = Matrix4x4::LookTo(Vector3(0, 0, 0), this->GetForward(), this->GetUp());
+        Vector3 light_center = light_view.MultiplyPoint(center);
+        float texel_size = radius * 2 / m_shadow_map_size;
+        light_center.x = floorf(light_center.x / texel_size) * texel_size;
+        light_center.y = floorf(light_center.y / texel_size) * texel_size;
+
+        // light looks down -z, casters between the light and the cascade have greater z
+        float z_min = light_center.z - radius;
+        float z_max = light_center.z + radius;
+
+        for (auto& i : m_shadow_casters)
+        {
+            const Ref<MeshRenderer>& proxy = i.second.proxies[cascade];
+            Ref<MeshRenderer> renderer = i.second.renderer.lock();
+            if (!renderer)
+            {
+                proxy->SetCulled(true);
+                continue;
+            }
+
+            Bounds bounds = renderer->GetBounds();
+            Vector3 min(Mathf::MaxFloatValue, Mathf::MaxFloatValue, Mathf::MaxFloatValue);
+            Vector3 max(Mathf::MinFloatValue, Mathf::MinFloatValue, Mathf::MinFloatValue);
+            for (int j = 0; j < 8; ++j)
+            {
+                Vector3 corner(
+                    (j & 1) ? bounds.Max().x : bounds.Min().x,
+                    (j & 2) ? bounds.Max().y : bounds.Min().y,
+                    (j & 4) ? bounds.Max().z : bounds.Min().z);
+                corner = light_view.MultiplyPoint(corner);
+                min = Vector3::Min(min, corner);
+                max = Vector3::Max(max, corner);
+            }
+
+            bool culled =
+                max.x < light_center.x - radius || min.x > light_center.x + radius ||
+                max.y < light_center.y - radius || min.y > light_center.y + radius ||
+                max.z < z_min;
+            proxy->SetCulled(culled);
+
+            if (!culled)
+            {
+                z_max = Mathf::Max(z_max, max.z);
+            }
+        }
+
+        Vector3 eye(light_center.x, light_center.y, z_max);
+        Matrix4x4 view = Matrix4x4::Translation(-eye) * light_view;
+        Matrix4x4 projection = Matrix4x4::Ortho(-radius, radius, -radius, radius, 0, z_max - z_min);
+
+        shadow_cascade.camera->SetViewMatrixExternal(view);
+        shadow_cascade.camera->SetProjectionMatrixExternal(projection);
+        shadow_cascade.view_projection_matrix = projection * view;
+    }
+
+    void Light::UpdateShadowReceivers(Camera* view_camera, const Vector<float>& splits)
+    {
+        int count = m_shadow_cascades.Size();
+
+        Vector<Vector4> matrices(SHADOW_CASCADE_MAX * 4, Vector4(0, 0, 0, 0));
+        Vector<Vector4> rects(SHADOW_CASCADE_MAX, Vector4(0, 0, 0, 0));
+        Vector4 cascade_splits;
+        for (int i = 0; i < SHADOW_CASCADE_MAX; ++i)
+        {
+            // unused cascades repeat the last split so no depth selects them
+            cascade_splits[i] = splits[Mathf::Min(i + 1, count)];
+
+            if (i < count)
+            {
+                ShadowCascade& cascade = m_shadow_cascades[i];
+                for (int j = 0; j < 4; ++j)
+                {
+                    matrices[i * 4 + j] = cascade.view_projection_matrix.GetRow(j);
+                }
+                rects[i] = Vector4(cascade.rect.x, cascade.rect.y, cascade.rect.width, cascade.rect.height);
+            }
+        }
+
+        for (const auto& i : view_camera->GetRenderers())
+        {
+            const Ref<Material>& material = i.renderer->GetMaterial();
+            if (!i.renderer->IsReceiveShadow() || !material)
+            {
+                continue;
+            }
+
+            // rebinding the same texture would rewrite descriptors still used by the last frame
+            const MaterialProperty* texture_property;
+            if (!material->GetProperties().TryGet(SHADOW_TEXTURE, &texture_property) || texture_property->texture != m_shadow_texture)
+            {
+                material->SetTexture(SHADOW_TEXTURE, m_shadow_texture);
+            }
+            material->SetVectorArray(SHADOW_CASCADE_MATRICES, matrices);
+            material->SetVectorArray(SHADOW_CASCADE_RECTS, rects);
+            material->SetVector(SHADOW_CASCADE_SPLITS, cascade_splits);
+            material->SetFloat(SHADOW_STRENGTH, m_shadow_strength);
+            material->SetFloat(SHADOW_Z_BIAS, m_shadow_z_bias);
+            material->SetFloat(SHADOW_SLOPE_BIAS, m_shadow_slope_bias);
+            material->SetFloat(SHADOW_FILTER_RADIUS, m_shadow_filter_radius / m_shadow_map_size);
+        }
+    }
 }
@@ -19,9 +19,21 @@
 
 #include "Node.h"
 #include "Color.h"
+#include "container/Map.h"
+#include "container/Vector.h"
+#include "math/Matrix4x4.h"
+#include "math/Rect.h"
+
+#define SHADOW_CASCADE_MAX 4
 
 namespace Viry3D
 {
+    class Camera;
+    class Renderer;
+    class MeshRenderer;
+    class Material;
+    class Texture;
+
     enum class LightType
     {
         Directional,
@@ -41,11 +53,80 @@ namespace Viry3D
         void SetColor(const Color& color);
         const float GetIntensity() const { return m_intensity; }
         void SetIntensity(float intensity);
+        float GetRange() const { return m_range; }
+        void SetRange(float range);
+        float GetSpotAngle() const { return m_spot_angle; }
+        void SetSpotAngle(float angle);
+        bool IsShadowEnable() const { return m_shadow_enable; }
+        void EnableShadow(bool enable);
+        int GetShadowCascadeCount() const { return m_shadow_cascade_count; }
+        void SetShadowCascadeCount(int count);
+        // size of one cascade tile in the shadow atlas
+        int GetShadowMapSize() const { return m_shadow_map_size; }
+        void SetShadowMapSize(int size);
+        float GetShadowDistance() const { return m_shadow_distance; }
+        void SetShadowDistance(float distance);
+        // 0 splits the shadow distance uniformly, 1 logarithmically
+        float GetShadowSplitLambda() const { return m_shadow_split_lambda; }
+        void SetShadowSplitLambda(float lambda);
+        float GetShadowStrength() const { return m_shadow_strength; }
+        void SetShadowStrength(float strength) { m_shadow_strength = strength; }
+        float GetShadowZBias() const { return m_shadow_z_bias; }
+        void SetShadowZBias(float bias) { m_shadow_z_bias = bias; }
+        float GetShadowSlopeBias() const { return m_shadow_slope_bias; }
+        void SetShadowSlopeBias(float bias) { m_shadow_slope_bias = bias; }
+        // in texels of a cascade tile
+        float GetShadowFilterRadius() const { return m_shadow_filter_radius; }
+        void SetShadowFilterRadius(float radius) { m_shadow_filter_radius = radius; }
+        const Ref<Texture>& GetShadowTexture() const { return m_shadow_texture; }
+        // directional light only, call once per frame before the display update.
+        // fits the cascades to view_camera, culls its shadow casters per cascade and feeds its shadow receivers
+        void UpdateShadow(Camera* view_camera);
+
+    private:
+        struct ShadowCaster
+        {
+            WeakRef<MeshRenderer> renderer;
+            Vector<Ref<MeshRenderer>> proxies;
+            bool visited;
+        };
+
+        struct ShadowCascade
+        {
+            Camera* camera;
+            Rect rect;
+            Ref<Material> material;
+            Ref<Material> skin_material;
+            Matrix4x4 view_projection_matrix;
+        };
+
+        void CreateShadowResources();
+        void ClearShadowResources();
+        void UpdateShadowCasters(Camera* view_camera);
+        Ref<MeshRenderer> CreateShadowProxy(const Ref<MeshRenderer>& renderer, int cascade);
+        void FitShadowCascade(Camera* view_camera, int cascade, float near_clip, float far_clip);
+        void UpdateShadowReceivers(Camera* view_camera, const Vector<float>& splits);
 
     private:
         static Color m_ambient_color;
         LightType m_type;
         Color m_color;
         float m_intensity;
+        float m_range;
+        float m_spot_angle;
+        bool m_shadow_enable;
+        int m_shadow_cascade_count;
+        int m_shadow_map_size;
+        float m_shadow_distance;
+        float m_shadow_split_lambda;
+        float m_shadow_strength;
+        float m_shadow_z_bias;
+        float m_shadow_slope_bias;
+        float m_shadow_filter_radius;
+        bool m_shadow_resources_dirty;
+        Ref<Texture> m_shadow_texture;
+        Ref<Texture> m_shadow_color_texture;
+        Vector<ShadowCascade> m_shadow_cascades;
+        Map<Renderer*, ShadowCaster> m_shadow_casters;
     };
 }
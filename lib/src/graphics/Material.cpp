@@ -21,6 +21,7 @@
 #include "Light.h"
 #include "BufferObject.h"
 #include "Texture.h"
+#include "Profiler.h"
 
 namespace Viry3D
 {
@@ -135,6 +136,7 @@ namespace Viry3D
         if (m_properties.TryGet(name, &property_ptr))
         {
             property_ptr->texture = texture;
+            property_ptr->texture_version = -1;
             property_ptr->dirty = true;
         }
         else
@@ -143,6 +145,7 @@ namespace Viry3D
             property.name = name;
             property.type = MaterialProperty::Type::Texture;
             property.texture = texture;
+            property.texture_version = -1;
             property.dirty = true;
             m_properties.Add(name, property);
         }
@@ -167,6 +170,27 @@ namespace Viry3D
         }
     }
 
+#if VR_VULKAN
+    void Material::SetStorageBuffer(const String& name, const Ref<BufferObject>& buffer)
+    {
+        MaterialProperty* property_ptr;
+        if (m_properties.TryGet(name, &property_ptr))
+        {
+            property_ptr->buffer = buffer;
+            property_ptr->dirty = true;
+        }
+        else
+        {
+            MaterialProperty property;
+            property.name = name;
+            property.type = MaterialProperty::Type::StorageBuffer;
+            property.buffer = buffer;
+            property.dirty = true;
+            m_properties.Add(name, property);
+        }
+    }
+#endif
+
     void Material::SetLightProperties(const Ref<Light>& light)
     {
         this->SetColor(AMBIENT_COLOR, Light::GetAmbientColor());
@@ -201,25 +225,40 @@ namespace Viry3D
 
     void Material::UpdateUniformSets()
     {
+        PROFILE_ZONE("Material::UpdateUniformSets");
+
         bool instance_cmd_dirty = false;
 
         for (auto& i : m_properties)
         {
+            // a streamed texture got a new image view
+            if (i.second.type == MaterialProperty::Type::Texture &&
+                i.second.texture &&
+                i.second.texture_version != i.second.texture->GetVersion())
+            {
+                i.second.dirty = true;
+            }
+
             if (i.second.dirty)
             {
                 i.second.dirty = false;
 
                 if (i.second.type == MaterialProperty::Type::Texture)
                 {
-                    this->UpdateUniformTexture(i.second.name, i.second.texture, instance_cmd_dirty);
+                    i.second.texture_version = i.second.texture ? i.second.texture->GetVersion() : -1;
+                    this->UpdateUniformTexture(i.second, instance_cmd_dirty);
                 }
                 else if (i.second.type == MaterialProperty::Type::VectorArray)
                 {
-                    this->UpdateUniformMember(i.second.name, i.second.vector_array.Bytes(), i.second.vector_array.SizeInBytes(), instance_cmd_dirty);
+                    this->UpdateUniformMember(i.second, i.second.vector_array.Bytes(), i.second.vector_array.SizeInBytes(), instance_cmd_dirty);
+                }
+                else if (i.second.type == MaterialProperty::Type::StorageBuffer)
+                {
+                    this->UpdateStorageBuffer(i.second, instance_cmd_dirty);
                 }
                 else
                 {
-                    this->UpdateUniformMember(i.second.name, &i.second.data, i.second.size, instance_cmd_dirty);
+                    this->UpdateUniformMember(i.second, &i.second.data, i.second.size, instance_cmd_dirty);
                 }
             }
         }
@@ -260,59 +299,171 @@ namespace Viry3D
                     }
                 }
             }
+
+            for (int j = 0; j < m_uniform_sets[i].storage_buffers.Size(); ++j)
+            {
+                const auto& storage_buffer = m_uniform_sets[i].storage_buffers[j];
+
+                if (storage_buffer.name == name)
+                {
+                    return i;
+                }
+            }
         }
 
         return -1;
     }
 
-    void Material::UpdateUniformMember(const String& name, const void* data, int size, bool& instance_cmd_dirty)
+    void Material::SetPropertySlot(const String& name, const MaterialSlot& slot)
     {
-        for (int i = 0; i < m_uniform_sets.Size(); ++i)
+        MaterialProperty* property_ptr;
+        if (m_properties.TryGet(name, &property_ptr))
         {
-            for (int j = 0; j < m_uniform_sets[i].buffers.Size(); ++j)
-            {
-                auto& buffer = m_uniform_sets[i].buffers[j];
+            property_ptr->slot = slot;
+        }
+    }
 
-                for (int k = 0; k < buffer.members.Size(); ++k)
+    bool Material::FindSlot(const Vector<UniformSet>& uniform_sets, const String& name, MaterialProperty::Type type, MaterialSlot& slot)
+    {
+        for (int i = 0; i < uniform_sets.Size(); ++i)
+        {
+            if (type == MaterialProperty::Type::Texture)
+            {
+                for (int j = 0; j < uniform_sets[i].textures.Size(); ++j)
                 {
-                    const auto& member = buffer.members[k];
+                    if (uniform_sets[i].textures[j].name == name)
+                    {
+                        slot.set = i;
+                        slot.index = j;
+                        slot.member = -1;
+                        return true;
+                    }
+                }
+            }
+            else if (type == MaterialProperty::Type::StorageBuffer)
+            {
+                for (int j = 0; j < uniform_sets[i].storage_buffers.Size(); ++j)
+                {
+                    if (uniform_sets[i].storage_buffers[j].name == name)
+                    {
+                        slot.set = i;
+                        slot.index = j;
+                        slot.member = -1;
+                        return true;
+                    }
+                }
+            }
+            else
+            {
+                for (int j = 0; j < uniform_sets[i].buffers.Size(); ++j)
+                {
+                    const auto& buffer = uniform_sets[i].buffers[j];
 
-                    if (member.name == name && size <= member.size)
+                    for (int k = 0; k < buffer.members.Size(); ++k)
                     {
-                        if (!buffer.buffer)
+                        if (buffer.members[k].name == name)
                         {
-                            Display::Instance()->CreateUniformBuffer(m_descriptor_sets[i], buffer);
-                            instance_cmd_dirty = true;
+                            slot.set = i;
+                            slot.index = j;
+                            slot.member = k;
+                            return true;
                         }
-                        Display::Instance()->UpdateBuffer(buffer.buffer, member.offset, data, size);
-                        return;
                     }
                 }
             }
         }
+
+        slot = MaterialSlot();
+        return false;
     }
 
-    void Material::UpdateUniformTexture(const String& name, const Ref<Texture>& texture, bool& instance_cmd_dirty)
+    bool Material::IsSlotValid(const Vector<UniformSet>& uniform_sets, const String& name, MaterialProperty::Type type, const MaterialSlot& slot)
     {
-        for (int i = 0; i < m_uniform_sets.Size(); ++i)
+        if (slot.set < 0 || slot.set >= uniform_sets.Size() || slot.index < 0)
         {
-            for (int j = 0; j < m_uniform_sets[i].textures.Size(); ++j)
-            {
-                const auto& uniform_texture = m_uniform_sets[i].textures[j];
+            return false;
+        }
 
-                if (uniform_texture.name == name)
-                {
-                    Display::Instance()->UpdateUniformTexture(m_descriptor_sets[i], uniform_texture.binding, texture);
-                    instance_cmd_dirty = true;
-                    return;
-                }
+        const UniformSet& set = uniform_sets[slot.set];
+
+        if (type == MaterialProperty::Type::Texture)
+        {
+            return slot.index < set.textures.Size() && set.textures[slot.index].name == name;
+        }
+        else if (type == MaterialProperty::Type::StorageBuffer)
+        {
+            return slot.index < set.storage_buffers.Size() && set.storage_buffers[slot.index].name == name;
+        }
+        else
+        {
+            return slot.index < set.buffers.Size() && slot.member >= 0 && slot.member < set.buffers[slot.index].members.Size() &&
+                set.buffers[slot.index].members[slot.member].name == name;
+        }
+    }
+
+    bool Material::FindPropertySlot(MaterialProperty& property)
+    {
+        // a cooked slot or the one found last time, the shader may have been built from other sources since
+        if (Material::IsSlotValid(m_uniform_sets, property.name, property.type, property.slot))
+        {
+            return true;
+        }
+
+        return Material::FindSlot(m_uniform_sets, property.name, property.type, property.slot);
+    }
+
+    void Material::UpdateUniformMember(MaterialProperty& property, const void* data, int size, bool& instance_cmd_dirty)
+    {
+        if (!this->FindPropertySlot(property))
+        {
+            return;
+        }
+
+        const MaterialSlot& slot = property.slot;
+        auto& buffer = m_uniform_sets[slot.set].buffers[slot.index];
+        const auto& member = buffer.members[slot.member];
+
+        if (size <= member.size)
+        {
+            if (!buffer.buffer)
+            {
+                Display::Instance()->CreateUniformBuffer(m_descriptor_sets[slot.set], buffer);
+                instance_cmd_dirty = true;
             }
+            Display::Instance()->UpdateBuffer(buffer.buffer, member.offset, data, size);
+        }
+    }
+
+    void Material::UpdateUniformTexture(MaterialProperty& property, bool& instance_cmd_dirty)
+    {
+        if (!this->FindPropertySlot(property))
+        {
+            return;
+        }
+
+        const MaterialSlot& slot = property.slot;
+        const auto& uniform_texture = m_uniform_sets[slot.set].textures[slot.index];
+
+        Display::Instance()->UpdateUniformTexture(m_descriptor_sets[slot.set], uniform_texture.binding, property.texture);
+        instance_cmd_dirty = true;
+    }
+
+    void Material::UpdateStorageBuffer(MaterialProperty& property, bool& instance_cmd_dirty)
+    {
+        if (!this->FindPropertySlot(property))
+        {
+            return;
         }
+
+        const MaterialSlot& slot = property.slot;
+        const auto& storage_buffer = m_uniform_sets[slot.set].storage_buffers[slot.index];
+
+        Display::Instance()->UpdateStorageBuffer(m_descriptor_sets[slot.set], storage_buffer.binding, property.buffer);
+        instance_cmd_dirty = true;
     }
 #elif VR_GLES
-    void Material::ApplyUniforms() const
+    int Material::ApplyUniforms(int texture_unit) const
     {
-        int texture_unit = 0;
         for (const auto& i : m_properties)
         {
             const MaterialProperty& p = i.second;
@@ -345,8 +496,12 @@ namespace Viry3D
             case MaterialProperty::Type::Int:
                 m_shader->SetUniform1i(p.name, p.data.int_value);
                 break;
+            case MaterialProperty::Type::StorageBuffer:
+                break;
             }
         }
+
+        return texture_unit;
     }
 #endif
 }
@@ -36,6 +36,15 @@
 #define LIGHT_COLOR "u_light_color"
 #define LIGHT_ITENSITY "u_light_intensity"
 
+#define SHADOW_TEXTURE "u_shadow_texture"
+#define SHADOW_CASCADE_MATRICES "u_shadow_cascade_matrices"
+#define SHADOW_CASCADE_RECTS "u_shadow_cascade_rects"
+#define SHADOW_CASCADE_SPLITS "u_shadow_cascade_splits"
+#define SHADOW_STRENGTH "u_shadow_strength"
+#define SHADOW_Z_BIAS "u_shadow_z_bias"
+#define SHADOW_SLOPE_BIAS "u_shadow_slope_bias"
+#define SHADOW_FILTER_RADIUS "u_shadow_filter_radius"
+
 #define CAMERA_POSITION "u_camera_pos"
 
 namespace Viry3D
@@ -43,6 +52,17 @@ namespace Viry3D
     class Shader;
     class Renderer;
     class Light;
+    class BufferObject;
+
+    // where a property is in the uniform sets of a vulkan shader: set is the index in the sorted uniform sets,
+    // index the buffer, texture or storage buffer in the set, member the member of a uniform buffer.
+    // the asset cooker resolves it ahead, a material checks it by name and finds it again when it does not match
+    struct MaterialSlot
+    {
+        int set = -1;
+        int index = -1;
+        int member = -1;
+    };
 
     struct MaterialProperty
     {
@@ -56,6 +76,7 @@ namespace Viry3D
             Matrix,
             VectorArray,
             Int,
+            StorageBuffer,
         };
 
         union Data
@@ -71,9 +92,13 @@ namespace Viry3D
         Type type;
         Data data;
         Ref<Texture> texture;
+        // texture version the descriptor was written with
+        int texture_version;
         Vector<Vector4> vector_array;
+        Ref<BufferObject> buffer;
         int size;
         bool dirty;
+        MaterialSlot slot;
     };
 
     class Material : public Object
@@ -95,14 +120,20 @@ namespace Viry3D
         void SetInt(const String& name, int value);
         void SetTexture(const String& name, const Ref<Texture>& texture);
         void SetVectorArray(const String& name, const Vector<Vector4>& array);
+#if VR_VULKAN
+        void SetStorageBuffer(const String& name, const Ref<BufferObject>& buffer);
+#endif
         void SetLightProperties(const Ref<Light>& light);
         const Map<String, MaterialProperty>& GetProperties() const { return m_properties; }
 #if VR_VULKAN
+        void SetPropertySlot(const String& name, const MaterialSlot& slot);
+        static bool FindSlot(const Vector<UniformSet>& uniform_sets, const String& name, MaterialProperty::Type type, MaterialSlot& slot);
+        static bool IsSlotValid(const Vector<UniformSet>& uniform_sets, const String& name, MaterialProperty::Type type, const MaterialSlot& slot);
         void UpdateUniformSets();
         int FindUniformSetIndex(const String& name);
         const Vector<VkDescriptorSet>& GetDescriptorSets() const { return m_descriptor_sets; }
 #elif VR_GLES
-        void ApplyUniforms() const;
+        int ApplyUniforms(int texture_unit = 0) const;
 #endif
 
     private:
@@ -140,8 +171,12 @@ namespace Viry3D
                 m_properties.Add(name, property);
             }
         }
-        void UpdateUniformMember(const String& name, const void* data, int size, bool& instance_cmd_dirty);
-        void UpdateUniformTexture(const String& name, const Ref<Texture>& texture, bool& instance_cmd_dirty);
+#if VR_VULKAN
+        bool FindPropertySlot(MaterialProperty& property);
+        void UpdateUniformMember(MaterialProperty& property, const void* data, int size, bool& instance_cmd_dirty);
+        void UpdateUniformTexture(MaterialProperty& property, bool& instance_cmd_dirty);
+        void UpdateStorageBuffer(MaterialProperty& property, bool& instance_cmd_dirty);
+#endif
         void MarkRendererOrderDirty();
         void Release();
 
@@ -0,0 +1,199 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "MaterialFile.h"
+#include "io/MemoryStream.h"
+#include "memory/Memory.h"
+#include "Debug.h"
+
+#define MATERIAL_FILE_VERSION 1
+
+namespace Viry3D
+{
+    static const byte MATERIAL_FILE_IDENTIFIER[8] = { 0xAB, 'V', 'M', 'A', 'T', 'L', 0x0D, 0x0A };
+
+    static bool ReadString(MemoryStream& ms, String& str)
+    {
+        int size = ms.Read<int>();
+        if (size < 0 || size > ms.GetLength() - ms.GetPosition())
+        {
+            return false;
+        }
+        str = ms.ReadString(size);
+        return true;
+    }
+
+    static void WriteString(MemoryStream& ms, const String& str)
+    {
+        ms.Write<int>(str.Size());
+        ms.Write((void*) str.CString(), str.Size());
+    }
+
+    bool MaterialFile::IsCooked(const ByteBuffer& file)
+    {
+        return file.Size() >= (int) sizeof(MATERIAL_FILE_IDENTIFIER) && Memory::Compare(file.Bytes(), MATERIAL_FILE_IDENTIFIER, sizeof(MATERIAL_FILE_IDENTIFIER)) == 0;
+    }
+
+    bool MaterialFile::Load(const ByteBuffer& file, MaterialFileData& data)
+    {
+        if (MaterialFile::IsCooked(file))
+        {
+            return MaterialFile::LoadCooked(file, data);
+        }
+        else
+        {
+            return MaterialFile::LoadExported(file, data);
+        }
+    }
+
+    bool MaterialFile::LoadExported(const ByteBuffer& file, MaterialFileData& data)
+    {
+        MemoryStream ms(file);
+
+        if (!ReadString(ms, data.name) || !ReadString(ms, data.shader))
+        {
+            return false;
+        }
+
+        int property_count = ms.Read<int>();
+        if (property_count < 0 || property_count > file.Size())
+        {
+            return false;
+        }
+
+        for (int i = 0; i < property_count; ++i)
+        {
+            MaterialFileProperty property;
+            if (!ReadString(ms, property.name))
+            {
+                return false;
+            }
+            property.type = (MaterialProperty::Type) ms.Read<int>();
+
+            switch (property.type)
+            {
+                case MaterialProperty::Type::Color:
+                {
+                    Color value = ms.Read<Color>();
+                    property.value = Vector4(value.r, value.g, value.b, value.a);
+                    break;
+                }
+                case MaterialProperty::Type::Vector:
+                    property.value = ms.Read<Vector4>();
+                    break;
+                case MaterialProperty::Type::Float:
+                case MaterialProperty::Type::Range:
+                    property.value.x = ms.Read<float>();
+                    break;
+                case MaterialProperty::Type::Texture:
+                {
+                    Vector4 uv_scale_offset = ms.Read<Vector4>();
+                    (void) uv_scale_offset;
+                    if (!ReadString(ms, property.texture))
+                    {
+                        return false;
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+
+            data.properties.Add(property);
+        }
+
+        return true;
+    }
+
+    bool MaterialFile::LoadCooked(const ByteBuffer& file, MaterialFileData& data)
+    {
+        MemoryStream ms(file);
+        ms.ReadBuffer(sizeof(MATERIAL_FILE_IDENTIFIER));
+
+        unsigned int version = ms.Read<unsigned int>();
+        if (version != MATERIAL_FILE_VERSION)
+        {
+            Log("material file version not support: %d", version);
+            return false;
+        }
+
+        if (!ReadString(ms, data.name) || !ReadString(ms, data.shader))
+        {
+            return false;
+        }
+
+        int property_count = ms.Read<int>();
+        if (property_count < 0 || property_count > file.Size())
+        {
+            return false;
+        }
+
+        data.properties.Resize(property_count);
+        for (int i = 0; i < property_count; ++i)
+        {
+            MaterialFileProperty& property = data.properties[i];
+            if (!ReadString(ms, property.name))
+            {
+                return false;
+            }
+            property.type = (MaterialProperty::Type) ms.Read<int>();
+            property.value = ms.Read<Vector4>();
+            property.slot.set = ms.Read<int>();
+            property.slot.index = ms.Read<int>();
+            property.slot.member = ms.Read<int>();
+            if (!ReadString(ms, property.texture))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    ByteBuffer MaterialFile::Save(const MaterialFileData& data)
+    {
+        int size = sizeof(MATERIAL_FILE_IDENTIFIER) + 4 * 4 + data.name.Size() + data.shader.Size();
+        for (const auto& i : data.properties)
+        {
+            size += 4 * 6 + sizeof(Vector4) + i.name.Size() + i.texture.Size();
+        }
+
+        ByteBuffer file(size);
+        MemoryStream ms(file);
+
+        ms.Write((void*) MATERIAL_FILE_IDENTIFIER, sizeof(MATERIAL_FILE_IDENTIFIER));
+        ms.Write<unsigned int>(MATERIAL_FILE_VERSION);
+        WriteString(ms, data.name);
+        WriteString(ms, data.shader);
+        ms.Write<int>(data.properties.Size());
+
+        for (const auto& i : data.properties)
+        {
+            WriteString(ms, i.name);
+            ms.Write<int>((int) i.type);
+            ms.Write<Vector4>(i.value);
+            ms.Write<int>(i.slot.set);
+            ms.Write<int>(i.slot.index);
+            ms.Write<int>(i.slot.member);
+            WriteString(ms, i.texture);
+        }
+
+        assert(ms.GetPosition() == file.Size());
+
+        return file;
+    }
+}
@@ -0,0 +1,59 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "Material.h"
+#include "container/Vector.h"
+#include "math/Vector4.h"
+#include "memory/ByteBuffer.h"
+#include "string/String.h"
+
+namespace Viry3D
+{
+    struct MaterialFileProperty
+    {
+        String name;
+        MaterialProperty::Type type;
+        // color, vector, or float in x
+        Vector4 value;
+        String texture;
+        MaterialSlot slot;
+    };
+
+    struct MaterialFileData
+    {
+        String name;
+        String shader;
+        Vector<MaterialFileProperty> properties;
+    };
+
+    // material files exported by the unity tools, and the cooked version with the values stored as
+    // Vector4 and the vulkan slot of each property resolved against the spir-v of the shader
+    class MaterialFile
+    {
+    public:
+        // detects the cooked version from the file identifier
+        static bool Load(const ByteBuffer& file, MaterialFileData& data);
+        static ByteBuffer Save(const MaterialFileData& data);
+        static bool IsCooked(const ByteBuffer& file);
+
+    private:
+        static bool LoadExported(const ByteBuffer& file, MaterialFileData& data);
+        static bool LoadCooked(const ByteBuffer& file, MaterialFileData& data);
+    };
+}
@@ -19,8 +19,9 @@
 #include "Display.h"
 #include "BufferObject.h"
 #include "Debug.h"
-#include "io/File.h"
-#include "io/MemoryStream.h"
+#include "MeshFile.h"
+#include "io/MappedFile.h"
+#include "memory/Memory.h"
 
 namespace Viry3D
 {
@@ -28,94 +29,22 @@ namespace Viry3D
     {
         Ref<Mesh> mesh;
 
-        if (File::Exist(path))
+        // stored blocks of binary files upload straight from the mapping
+        Ref<MappedFile> file = MappedFile::Open(path);
+        if (file)
         {
-            MemoryStream ms(File::ReadAllBytes(path));
-
-            int name_size = ms.Read<int>();
-            String mesh_name = ms.ReadString(name_size);
-
-            Vector<Vertex>* vertices = new Vector<Vertex>();
-            Vector<unsigned short>* indices = new Vector<unsigned short>();
-            Vector<Submesh>* submeshes = new Vector<Submesh>();
-            Vector<Matrix4x4>* bindposes = new Vector<Matrix4x4>();
-
-            int vertex_count = ms.Read<int>();
-            vertices->Resize(vertex_count);
-
-            for (int i = 0; i < vertex_count; ++i)
-            {
-                (*vertices)[i].vertex = ms.Read<Vector3>();
-            }
-
-            int color_count = ms.Read<int>();
-            for (int i = 0; i < color_count; ++i)
+            MeshFileData data;
+            if (MeshFile::Load(file->GetBuffer(), data))
             {
-                float r = ms.Read<byte>() / 255.0f;
-                float g = ms.Read<byte>() / 255.0f;
-                float b = ms.Read<byte>() / 255.0f;
-                float a = ms.Read<byte>() / 255.0f;
-                (*vertices)[i].color = Color(r, g, b, a);
+                mesh = RefMake<Mesh>(data.vertices, data.indices, data.submeshes);
+                mesh->SetName(data.name);
+                mesh->SetBindposes(data.bindposes);
+                mesh->SetSourcePath(path);
             }
-
-            int uv_count = ms.Read<int>();
-            for (int i = 0; i < uv_count; ++i)
-            {
-                (*vertices)[i].uv = ms.Read<Vector2>();
-            }
-
-            int uv2_count = ms.Read<int>();
-            for (int i = 0; i < uv2_count; ++i)
-            {
-                (*vertices)[i].uv2 = ms.Read<Vector2>();
-            }
-
-            int normal_count = ms.Read<int>();
-            for (int i = 0; i < normal_count; ++i)
+            else
             {
-                (*vertices)[i].normal = ms.Read<Vector3>();
+                Log("invalid mesh file: %s", path.CString());
             }
-
-            int tangent_count = ms.Read<int>();
-            for (int i = 0; i < tangent_count; ++i)
-            {
-                (*vertices)[i].tangent = ms.Read<Vector4>();
-            }
-
-            int bone_weight_count = ms.Read<int>();
-            for (int i = 0; i < bone_weight_count; ++i)
-            {
-                (*vertices)[i].bone_weight = ms.Read<Vector4>();
-                float index0 = (float) ms.Read<byte>();
-                float index1 = (float) ms.Read<byte>();
-                float index2 = (float) ms.Read<byte>();
-                float index3 = (float) ms.Read<byte>();
-                (*vertices)[i].bone_indices = Vector4(index0, index1, index2, index3);
-            }
-
-            int index_count = ms.Read<int>();
-            indices->Resize(index_count);
-            ms.Read(&(*indices)[0], indices->SizeInBytes());
-
-            int submesh_count = ms.Read<int>();
-            submeshes->Resize(submesh_count);
-            ms.Read(&(*submeshes)[0], submeshes->SizeInBytes());
-
-            int bindpose_count = ms.Read<int>();
-            if (bindpose_count > 0)
-            {
-                bindposes->Resize(bindpose_count);
-                ms.Read(&(*bindposes)[0], bindposes->SizeInBytes());
-            }
-            
-            mesh = RefMake<Mesh>(*vertices, *indices, *submeshes);
-            mesh->SetName(mesh_name);
-            mesh->SetBindposes(*bindposes);
-
-            delete vertices;
-            delete indices;
-            delete submeshes;
-            delete bindposes;
         }
         else
         {
@@ -126,28 +55,38 @@ namespace Viry3D
     }
 
     Mesh::Mesh(const Vector<Vertex>& vertices, const Vector<unsigned short>& indices, const Vector<Submesh>& submeshes, bool dynamic):
+        Mesh(ByteBuffer((byte*) &vertices[0], vertices.SizeInBytes()), ByteBuffer((byte*) &indices[0], indices.SizeInBytes()), submeshes, dynamic)
+    {
+    }
+
+    Mesh::Mesh(const ByteBuffer& vertices, const ByteBuffer& indices, const Vector<Submesh>& submeshes, bool dynamic):
         m_vertex_count(0),
         m_index_count(0),
         m_buffer_vertex_count(0),
         m_buffer_index_count(0)
     {
+        int vertex_count = vertices.Size() / sizeof(Vertex);
+        int index_count = indices.Size() / sizeof(unsigned short);
+
 #if VR_VULKAN
-        m_vertex_buffer = Display::Instance()->CreateBuffer(&vertices[0], vertices.SizeInBytes(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
-        m_index_buffer = Display::Instance()->CreateBuffer(&indices[0], indices.SizeInBytes(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+        // storage usage lets the skinning pre-pass read source vertices in compute
+        m_vertex_buffer = Display::Instance()->CreateBuffer(vertices.Bytes(), vertices.Size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        m_index_buffer = Display::Instance()->CreateBuffer(indices.Bytes(), indices.Size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
 #elif VR_GLES
-        m_vertex_buffer = Display::Instance()->CreateBuffer(&vertices[0], vertices.SizeInBytes(), GL_ARRAY_BUFFER, dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
-        m_index_buffer = Display::Instance()->CreateBuffer(&indices[0], indices.SizeInBytes(), GL_ELEMENT_ARRAY_BUFFER, dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+        m_vertex_buffer = Display::Instance()->CreateBuffer(vertices.Bytes(), vertices.Size(), GL_ARRAY_BUFFER, dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+        m_index_buffer = Display::Instance()->CreateBuffer(indices.Bytes(), indices.Size(), GL_ELEMENT_ARRAY_BUFFER, dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
 #endif
 
-        m_vertex_count = vertices.Size();
-        m_index_count = indices.Size();
+        m_vertex_count = vertex_count;
+        m_index_count = index_count;
         m_buffer_vertex_count = m_vertex_count;
         m_buffer_index_count = m_index_count;
         m_submeshes = submeshes;
         if (m_submeshes.Empty())
         {
-            m_submeshes.Add(Submesh({ 0, indices.Size() }));
+            m_submeshes.Add(Submesh({ 0, index_count }));
         }
+        this->UpdateBounds((const Vertex*) vertices.Bytes(), vertex_count);
     }
     
     Mesh::~Mesh()
@@ -177,5 +116,49 @@ namespace Viry3D
         {
             m_submeshes.Add(Submesh({ 0, indices.Size() }));
         }
+        this->UpdateBounds(&vertices[0], vertices.Size());
     }
+
+    void Mesh::UpdateBounds(const Vertex* vertices, int vertex_count)
+    {
+        if (vertex_count > 0)
+        {
+            Vector3 min = vertices[0].vertex;
+            Vector3 max = vertices[0].vertex;
+            for (int i = 1; i < vertex_count; ++i)
+            {
+                min = Vector3::Min(min, vertices[i].vertex);
+                max = Vector3::Max(max, vertices[i].vertex);
+            }
+            m_bounds = Bounds(min, max);
+        }
+        else
+        {
+            m_bounds = Bounds();
+        }
+    }
+
+#if VR_GLES
+    const Vector<Vertex>& Mesh::GetVertices()
+    {
+        if (m_vertices.Empty() && m_source_path.Size() > 0)
+        {
+            Ref<MappedFile> file = MappedFile::Open(m_source_path);
+            MeshFileData data;
+            if (file && MeshFile::Load(file->GetBuffer(), data) && data.vertex_count == m_vertex_count)
+            {
+                m_vertices.Resize(data.vertex_count);
+                Memory::Copy(&m_vertices[0], data.vertices.Bytes(), m_vertices.SizeInBytes());
+            }
+            else
+            {
+                Log("mesh source vertices not found: %s", m_source_path.CString());
+                // read once, callers fall back when the vertices stay empty
+                m_source_path = "";
+            }
+        }
+
+        return m_vertices;
+    }
+#endif
 }
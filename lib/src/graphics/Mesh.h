@@ -20,7 +20,9 @@
 #include "Object.h"
 #include "VertexAttribute.h"
 #include "container/Vector.h"
+#include "memory/ByteBuffer.h"
 #include "math/Matrix4x4.h"
+#include "math/Bounds.h"
 
 namespace Viry3D
 {
@@ -38,6 +40,8 @@ namespace Viry3D
     public:
         static Ref<Mesh> LoadFromFile(const String& path);
         Mesh(const Vector<Vertex>& vertices, const Vector<unsigned short>& indices, const Vector<Submesh>& submeshes = Vector<Submesh>(), bool dynamic = false);
+        // Vertex array and 16 bit indices uploaded from any memory, such as a view into a mapped file
+        Mesh(const ByteBuffer& vertices, const ByteBuffer& indices, const Vector<Submesh>& submeshes, bool dynamic = false);
         virtual ~Mesh();
         void Update(const Vector<Vertex>& vertices, const Vector<unsigned short>& indices, const Vector<Submesh>& submeshes = Vector<Submesh>());
         const Ref<BufferObject>& GetVertexBuffer() const { return m_vertex_buffer; }
@@ -47,6 +51,17 @@ namespace Viry3D
         const Submesh& GetSubmesh(int submesh) const { return m_submeshes[submesh]; }
         void SetBindposes(const Vector<Matrix4x4>& bindposes) { m_bindposes = bindposes; }
         const Vector<Matrix4x4>& GetBindposes() const { return m_bindposes; }
+        const Bounds& GetBounds() const { return m_bounds; }
+        // file the mesh was loaded from, empty for meshes built in code
+        void SetSourcePath(const String& path) { m_source_path = path; }
+        const String& GetSourcePath() const { return m_source_path; }
+#if VR_GLES
+        // gles can not read back buffers, the skinning pre-pass gets a cpu copy read from the source file on first use
+        const Vector<Vertex>& GetVertices();
+#endif
+
+    private:
+        void UpdateBounds(const Vertex* vertices, int vertex_count);
 
     private:
         Ref<BufferObject> m_vertex_buffer;
@@ -57,5 +72,10 @@ namespace Viry3D
         int m_buffer_index_count;
         Vector<Submesh> m_submeshes;
         Vector<Matrix4x4> m_bindposes;
+        Bounds m_bounds;
+        String m_source_path;
+#if VR_GLES
+        Vector<Vertex> m_vertices;
+#endif
     };
 }
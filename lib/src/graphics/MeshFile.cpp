@@ -0,0 +1,319 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "MeshFile.h"
+#include "io/MemoryStream.h"
+#include "memory/Memory.h"
+#include "math/Mathf.h"
+#include "Debug.h"
+#include "zlib/zlib.h"
+
+#define MESH_FILE_VERSION 1
+#define MESH_FILE_ALIGNMENT 16
+#define MESH_COMPRESSION_NONE 0
+#define MESH_COMPRESSION_ZLIB 1
+
+namespace Viry3D
+{
+    static const byte MESH_FILE_IDENTIFIER[8] = { 0xAB, 'V', 'M', 'E', 'S', 'H', 0x0D, 0x0A };
+
+    static int AlignOffset(int offset)
+    {
+        return (offset + MESH_FILE_ALIGNMENT - 1) / MESH_FILE_ALIGNMENT * MESH_FILE_ALIGNMENT;
+    }
+
+    bool MeshFile::IsBinary(const ByteBuffer& file)
+    {
+        return file.Size() >= (int) sizeof(MESH_FILE_IDENTIFIER) && Memory::Compare(file.Bytes(), MESH_FILE_IDENTIFIER, sizeof(MESH_FILE_IDENTIFIER)) == 0;
+    }
+
+    bool MeshFile::Load(const ByteBuffer& file, MeshFileData& data)
+    {
+        if (MeshFile::IsBinary(file))
+        {
+            return MeshFile::LoadBinary(file, data);
+        }
+        else
+        {
+            return MeshFile::LoadExported(file, data);
+        }
+    }
+
+    template<class T>
+    static void ReadVertexAttribute(MemoryStream& ms, Vertex* vertices, int vertex_count, T Vertex::* attribute)
+    {
+        int count = ms.Read<int>();
+        ByteBuffer buffer = ms.ReadBuffer(count * sizeof(T));
+        count = Mathf::Min(Mathf::Min(count, buffer.Size() / (int) sizeof(T)), vertex_count);
+        for (int i = 0; i < count; ++i)
+        {
+            Memory::Copy(&(vertices[i].*attribute), &buffer[i * sizeof(T)], sizeof(T));
+        }
+    }
+
+    bool MeshFile::LoadExported(const ByteBuffer& file, MeshFileData& data)
+    {
+        MemoryStream ms(file);
+
+        int name_size = ms.Read<int>();
+        if (name_size < 0 || name_size > file.Size())
+        {
+            return false;
+        }
+        data.name = ms.ReadString(name_size);
+
+        // attributes are stored one after another, interleave them into the gpu layout
+        data.vertex_count = ms.Read<int>();
+        if (data.vertex_count < 0 || data.vertex_count > file.Size())
+        {
+            return false;
+        }
+        ByteBuffer vertex_buffer(data.vertex_count * sizeof(Vertex));
+        Memory::Zero(vertex_buffer.Bytes(), vertex_buffer.Size());
+        Vertex* vertices = (Vertex*) vertex_buffer.Bytes();
+
+        ByteBuffer positions = ms.ReadBuffer(data.vertex_count * sizeof(Vector3));
+        for (int i = 0; i < positions.Size() / (int) sizeof(Vector3); ++i)
+        {
+            Memory::Copy(&vertices[i].vertex, &positions[i * sizeof(Vector3)], sizeof(Vector3));
+        }
+
+        int color_count = ms.Read<int>();
+        ByteBuffer colors = ms.ReadBuffer(color_count * 4);
+        color_count = Mathf::Min(colors.Size() / 4, data.vertex_count);
+        for (int i = 0; i < color_count; ++i)
+        {
+            const byte* c = &colors[i * 4];
+            vertices[i].color = Color(c[0] / 255.0f, c[1] / 255.0f, c[2] / 255.0f, c[3] / 255.0f);
+        }
+
+        ReadVertexAttribute(ms, vertices, data.vertex_count, &Vertex::uv);
+        ReadVertexAttribute(ms, vertices, data.vertex_count, &Vertex::uv2);
+        ReadVertexAttribute(ms, vertices, data.vertex_count, &Vertex::normal);
+        ReadVertexAttribute(ms, vertices, data.vertex_count, &Vertex::tangent);
+
+        int bone_weight_count = ms.Read<int>();
+        int bone_weight_stride = sizeof(Vector4) + 4;
+        ByteBuffer bone_weights = ms.ReadBuffer(bone_weight_count * bone_weight_stride);
+        bone_weight_count = Mathf::Min(bone_weights.Size() / bone_weight_stride, data.vertex_count);
+        for (int i = 0; i < bone_weight_count; ++i)
+        {
+            const byte* p = &bone_weights[i * bone_weight_stride];
+            Memory::Copy(&vertices[i].bone_weight, p, sizeof(Vector4));
+            const byte* index = p + sizeof(Vector4);
+            vertices[i].bone_indices = Vector4((float) index[0], (float) index[1], (float) index[2], (float) index[3]);
+        }
+
+        data.index_count = ms.Read<int>();
+        data.indices = ms.ReadBuffer(data.index_count * sizeof(unsigned short));
+        if (data.indices.Size() != data.index_count * (int) sizeof(unsigned short))
+        {
+            return false;
+        }
+
+        int submesh_count = ms.Read<int>();
+        if (submesh_count < 0 || submesh_count * (int) sizeof(Mesh::Submesh) > file.Size())
+        {
+            return false;
+        }
+        data.submeshes.Resize(submesh_count);
+        if (submesh_count > 0)
+        {
+            ms.Read(&data.submeshes[0], data.submeshes.SizeInBytes());
+        }
+
+        int bindpose_count = ms.Read<int>();
+        if (bindpose_count < 0 || bindpose_count * (int) sizeof(Matrix4x4) > file.Size())
+        {
+            return false;
+        }
+        data.bindposes.Resize(bindpose_count);
+        if (bindpose_count > 0)
+        {
+            ms.Read(&data.bindposes[0], data.bindposes.SizeInBytes());
+        }
+
+        data.vertices = vertex_buffer;
+        data.storage.Add(vertex_buffer);
+
+        return true;
+    }
+
+    static bool ReadBlock(MemoryStream& ms, const ByteBuffer& file, int size, ByteBuffer& block, Vector<ByteBuffer>& storage)
+    {
+        unsigned int compression = ms.Read<unsigned int>();
+        int stored_size = ms.Read<int>();
+        int offset = ms.Read<int>();
+
+        if (offset < 0 || stored_size < 0 || offset % MESH_FILE_ALIGNMENT != 0 || offset > file.Size() - stored_size)
+        {
+            return false;
+        }
+
+        if (compression == MESH_COMPRESSION_NONE)
+        {
+            if (stored_size != size)
+            {
+                return false;
+            }
+            block = ByteBuffer(&file.Bytes()[offset], size);
+        }
+        else if (compression == MESH_COMPRESSION_ZLIB)
+        {
+            ByteBuffer inflated(size);
+            uLongf inflated_size = (uLongf) size;
+            if (uncompress(inflated.Bytes(), &inflated_size, &file.Bytes()[offset], (uLong) stored_size) != Z_OK || inflated_size != (uLongf) size)
+            {
+                return false;
+            }
+            block = inflated;
+            storage.Add(inflated);
+        }
+        else
+        {
+            Log("mesh compression not support: %d", compression);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool MeshFile::LoadBinary(const ByteBuffer& file, MeshFileData& data)
+    {
+        MemoryStream ms(file);
+        ms.ReadBuffer(sizeof(MESH_FILE_IDENTIFIER));
+
+        unsigned int version = ms.Read<unsigned int>();
+        int vertex_stride = ms.Read<int>();
+        if (version != MESH_FILE_VERSION || vertex_stride != (int) sizeof(Vertex))
+        {
+            Log("mesh file version not support: %d", version);
+            return false;
+        }
+
+        data.vertex_count = ms.Read<int>();
+        data.index_count = ms.Read<int>();
+        int submesh_count = ms.Read<int>();
+        int bindpose_count = ms.Read<int>();
+        int name_size = ms.Read<int>();
+        if (data.vertex_count < 0 || data.index_count < 0 || submesh_count < 0 || bindpose_count < 0 || name_size < 0 ||
+            data.vertex_count > 0x7fffffff / (int) sizeof(Vertex) || data.index_count > 0x7fffffff / (int) sizeof(unsigned short) ||
+            submesh_count * (int) sizeof(Mesh::Submesh) > file.Size() || bindpose_count * (int) sizeof(Matrix4x4) > file.Size())
+        {
+            return false;
+        }
+
+        data.name = ms.ReadString(name_size);
+        data.submeshes.Resize(submesh_count);
+        if (submesh_count > 0)
+        {
+            ms.Read(&data.submeshes[0], data.submeshes.SizeInBytes());
+        }
+        data.bindposes.Resize(bindpose_count);
+        if (bindpose_count > 0)
+        {
+            ms.Read(&data.bindposes[0], data.bindposes.SizeInBytes());
+        }
+
+        if (!ReadBlock(ms, file, data.vertex_count * sizeof(Vertex), data.vertices, data.storage) ||
+            !ReadBlock(ms, file, data.index_count * sizeof(unsigned short), data.indices, data.storage))
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    ByteBuffer MeshFile::Save(const MeshFileData& data, bool zlib)
+    {
+        assert(data.vertices.Size() == data.vertex_count * (int) sizeof(Vertex));
+        assert(data.indices.Size() == data.index_count * (int) sizeof(unsigned short));
+
+        ByteBuffer blocks[2] = { data.vertices, data.indices };
+        unsigned int compressions[2] = { MESH_COMPRESSION_NONE, MESH_COMPRESSION_NONE };
+        if (zlib)
+        {
+            for (int i = 0; i < 2; ++i)
+            {
+                uLongf compressed_size = compressBound((uLong) blocks[i].Size());
+                ByteBuffer compressed((int) compressed_size);
+                int result = compress2(compressed.Bytes(), &compressed_size, blocks[i].Bytes(), (uLong) blocks[i].Size(), Z_BEST_COMPRESSION);
+                assert(result == Z_OK);
+                (void) result;
+
+                // keep blocks that do not shrink stored, they upload without a copy
+                if ((int) compressed_size < blocks[i].Size())
+                {
+                    blocks[i] = ByteBuffer((int) compressed_size);
+                    Memory::Copy(blocks[i].Bytes(), compressed.Bytes(), (int) compressed_size);
+                    compressions[i] = MESH_COMPRESSION_ZLIB;
+                }
+            }
+        }
+
+        int header_size = sizeof(MESH_FILE_IDENTIFIER) + 4 * 7 + data.name.Size() +
+            data.submeshes.SizeInBytes() + data.bindposes.SizeInBytes() + 4 * 3 * 2;
+
+        int offsets[2];
+        int size = header_size;
+        for (int i = 0; i < 2; ++i)
+        {
+            size = AlignOffset(size);
+            offsets[i] = size;
+            size += blocks[i].Size();
+        }
+
+        ByteBuffer file(size);
+        Memory::Zero(file.Bytes(), file.Size());
+        MemoryStream ms(file);
+
+        ms.Write((void*) MESH_FILE_IDENTIFIER, sizeof(MESH_FILE_IDENTIFIER));
+        ms.Write<unsigned int>(MESH_FILE_VERSION);
+        ms.Write<int>(sizeof(Vertex));
+        ms.Write<int>(data.vertex_count);
+        ms.Write<int>(data.index_count);
+        ms.Write<int>(data.submeshes.Size());
+        ms.Write<int>(data.bindposes.Size());
+        ms.Write<int>(data.name.Size());
+        ms.Write((void*) data.name.CString(), data.name.Size());
+        if (data.submeshes.Size() > 0)
+        {
+            ms.Write((void*) &data.submeshes[0], data.submeshes.SizeInBytes());
+        }
+        if (data.bindposes.Size() > 0)
+        {
+            ms.Write((void*) &data.bindposes[0], data.bindposes.SizeInBytes());
+        }
+
+        for (int i = 0; i < 2; ++i)
+        {
+            ms.Write<unsigned int>(compressions[i]);
+            ms.Write<int>(blocks[i].Size());
+            ms.Write<int>(offsets[i]);
+        }
+
+        for (int i = 0; i < 2; ++i)
+        {
+            if (blocks[i].Size() > 0)
+            {
+                Memory::Copy(&file[offsets[i]], blocks[i].Bytes(), blocks[i].Size());
+            }
+        }
+
+        return file;
+    }
+}
@@ -0,0 +1,57 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "Mesh.h"
+#include "VertexAttribute.h"
+#include "container/Vector.h"
+#include "memory/ByteBuffer.h"
+#include "string/String.h"
+
+namespace Viry3D
+{
+    struct MeshFileData
+    {
+        String name;
+        int vertex_count = 0;
+        int index_count = 0;
+        // Vertex array and 16 bit indices, views into the loaded file or into storage, keep them alive while using them
+        ByteBuffer vertices;
+        ByteBuffer indices;
+        Vector<Mesh::Submesh> submeshes;
+        Vector<Matrix4x4> bindposes;
+        // converted or inflated blocks
+        Vector<ByteBuffer> storage;
+    };
+
+    // mesh files exported by the unity tools, and the binary version whose vertex and index blocks
+    // are stored in the gpu layout at 16 byte aligned offsets, so stored blocks upload straight from a mapping.
+    class MeshFile
+    {
+    public:
+        // detects the binary version from the file identifier
+        static bool Load(const ByteBuffer& file, MeshFileData& data);
+        // writes the binary version, zlib compresses the vertex and index blocks
+        static ByteBuffer Save(const MeshFileData& data, bool zlib);
+        static bool IsBinary(const ByteBuffer& file);
+
+    private:
+        static bool LoadExported(const ByteBuffer& file, MeshFileData& data);
+        static bool LoadBinary(const ByteBuffer& file, MeshFileData& data);
+    };
+}
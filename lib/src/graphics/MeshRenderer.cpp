@@ -17,7 +17,9 @@
 
 #include "MeshRenderer.h"
 #include "Mesh.h"
+#include "Camera.h"
 #include "BufferObject.h"
+#include "math/Mathf.h"
 
 namespace Viry3D
 {
@@ -70,6 +72,79 @@ namespace Viry3D
         m_mesh = mesh;
         m_submesh = submesh;
         m_draw_buffer_dirty = true;
+
+#if VR_VULKAN
+        this->MarkInstanceCmdDirty();
+#endif
+    }
+
+    Ref<Node> MeshRenderer::Clone() const
+    {
+        Ref<MeshRenderer> renderer = RefMake<MeshRenderer>();
+        this->CopyTo(renderer.get());
+        return renderer;
+    }
+
+    void MeshRenderer::CopyTo(MeshRenderer* renderer) const
+    {
+        renderer->SetMaterial(this->GetMaterial());
+        renderer->SetMesh(m_mesh, m_submesh);
+        renderer->SetCastShadow(this->IsCastShadow());
+        renderer->SetReceiveShadow(this->IsReceiveShadow());
+    }
+
+    Bounds MeshRenderer::GetBounds()
+    {
+        if (!m_mesh)
+        {
+            return Bounds();
+        }
+
+        const Bounds& bounds = m_mesh->GetBounds();
+        const Matrix4x4& local_to_world = this->GetLocalToWorldMatrix();
+        Vector3 min(Mathf::MaxFloatValue, Mathf::MaxFloatValue, Mathf::MaxFloatValue);
+        Vector3 max(Mathf::MinFloatValue, Mathf::MinFloatValue, Mathf::MinFloatValue);
+
+        for (int i = 0; i < 8; ++i)
+        {
+            Vector3 corner(
+                (i & 1) ? bounds.Max().x : bounds.Min().x,
+                (i & 2) ? bounds.Max().y : bounds.Min().y,
+                (i & 4) ? bounds.Max().z : bounds.Min().z);
+            corner = local_to_world.MultiplyPoint(corner);
+            min = Vector3::Min(min, corner);
+            max = Vector3::Max(max, corner);
+        }
+
+        return Bounds(min, max);
+    }
+
+    float MeshRenderer::GetScreenSize(Camera* camera)
+    {
+        if (!m_mesh)
+        {
+            return -1;
+        }
+
+        // projected diameter of the bounding sphere
+        Bounds bounds = this->GetBounds();
+        Vector3 center = (bounds.Min() + bounds.Max()) * 0.5f;
+        float radius = (bounds.Max() - bounds.Min()).Magnitude() * 0.5f;
+        float view_height = camera->GetTargetHeight() * camera->GetViewportRect().height;
+        float scale = camera->GetProjectionMatrix().m11;
+
+        if (camera->IsOrthographic())
+        {
+            return radius * scale * view_height;
+        }
+
+        float depth = fabsf(camera->GetViewMatrix().MultiplyPoint(center).z);
+        if (depth <= radius)
+        {
+            return view_height;
+        }
+
+        return radius * scale / depth * view_height;
     }
 
     void MeshRenderer::UpdateDrawBuffer()
@@ -77,24 +152,27 @@ namespace Viry3D
 #if VR_VULKAN
         VkDrawIndexedIndirectCommand draw;
         draw.indexCount = m_mesh->GetSubmesh(m_submesh).index_count;
-        draw.instanceCount = this->GetInstanceCount();
+        draw.instanceCount = m_culled ? 0 : this->GetInstanceCount();
         draw.firstIndex = m_mesh->GetSubmesh(m_submesh).index_first;
         draw.vertexOffset = 0;
         draw.firstInstance = 0;
 
+        m_draw_index_count = draw.indexCount;
+        m_draw_instance_count = draw.instanceCount;
+
+        // the cmd reads the draw buffer indirectly, only a new buffer needs the cmd rebuilt
         if (!m_draw_buffer)
         {
             m_draw_buffer = Display::Instance()->CreateBuffer(&draw, sizeof(draw), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+            this->MarkInstanceCmdDirty();
         }
         else
         {
             Display::Instance()->UpdateBuffer(m_draw_buffer, 0, &draw, sizeof(draw));
         }
-
-        this->MarkInstanceCmdDirty();
 #elif VR_GLES
         m_draw_buffer.first_index = m_mesh->GetSubmesh(m_submesh).index_first;
-        m_draw_buffer.index_count = m_mesh->GetSubmesh(m_submesh).index_count;
+        m_draw_buffer.index_count = m_culled ? 0 : m_mesh->GetSubmesh(m_submesh).index_count;
 #endif
     }
 }
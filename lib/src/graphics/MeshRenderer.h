@@ -18,6 +18,7 @@
 #pragma once
 
 #include "Renderer.h"
+#include "math/Bounds.h"
 
 namespace Viry3D
 {
@@ -33,9 +34,14 @@ namespace Viry3D
         const Ref<Mesh>& GetMesh() const { return m_mesh; }
         int GetSubmesh() const { return m_submesh; }
         void SetMesh(const Ref<Mesh>& mesh, int submesh = 0);
+        // world space bounds of the mesh, instances are not included
+        Bounds GetBounds();
+        virtual float GetScreenSize(Camera* camera);
 
     protected:
         virtual void UpdateDrawBuffer();
+        virtual Ref<Node> Clone() const;
+        void CopyTo(MeshRenderer* renderer) const;
 
     private:
         Ref<Mesh> m_mesh;
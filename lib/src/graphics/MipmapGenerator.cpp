@@ -0,0 +1,414 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "MipmapGenerator.h"
+#include "math/Mathf.h"
+#include "Debug.h"
+#include <math.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define VR_MIPMAP_SSE 1
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define VR_MIPMAP_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define KAISER_TAP_COUNT 6
+
+namespace Viry3D
+{
+    // one rgba pixel, unused channels stay 0
+#if VR_MIPMAP_SSE
+    typedef __m128 Pixel4;
+    static inline Pixel4 Load4(const float* p) { return _mm_loadu_ps(p); }
+    static inline void Store4(float* p, Pixel4 v) { _mm_storeu_ps(p, v); }
+    static inline Pixel4 Add4(Pixel4 a, Pixel4 b) { return _mm_add_ps(a, b); }
+    static inline Pixel4 Mul4(Pixel4 a, Pixel4 b) { return _mm_mul_ps(a, b); }
+    static inline Pixel4 Splat4(float v) { return _mm_set1_ps(v); }
+#elif VR_MIPMAP_NEON
+    typedef float32x4_t Pixel4;
+    static inline Pixel4 Load4(const float* p) { return vld1q_f32(p); }
+    static inline void Store4(float* p, Pixel4 v) { vst1q_f32(p, v); }
+    static inline Pixel4 Add4(Pixel4 a, Pixel4 b) { return vaddq_f32(a, b); }
+    static inline Pixel4 Mul4(Pixel4 a, Pixel4 b) { return vmulq_f32(a, b); }
+    static inline Pixel4 Splat4(float v) { return vdupq_n_f32(v); }
+#else
+    struct Pixel4
+    {
+        float v[4];
+    };
+    static inline Pixel4 Load4(const float* p) { Pixel4 r = { { p[0], p[1], p[2], p[3] } }; return r; }
+    static inline void Store4(float* p, Pixel4 a) { p[0] = a.v[0]; p[1] = a.v[1]; p[2] = a.v[2]; p[3] = a.v[3]; }
+    static inline Pixel4 Add4(Pixel4 a, Pixel4 b) { Pixel4 r = { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; return r; }
+    static inline Pixel4 Mul4(Pixel4 a, Pixel4 b) { Pixel4 r = { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } }; return r; }
+    static inline Pixel4 Splat4(float v) { Pixel4 r = { { v, v, v, v } }; return r; }
+#endif
+
+    struct FloatImage
+    {
+        int width;
+        int height;
+        Vector<float> pixels;
+    };
+
+    static float SRGBToLinear(float v)
+    {
+        return v <= 0.04045f ? v / 12.92f : powf((v + 0.055f) / 1.055f, 2.4f);
+    }
+
+    static float LinearToSRGB(float v)
+    {
+        return v <= 0.0031308f ? v * 12.92f : 1.055f * powf(v, 1.0f / 2.4f) - 0.055f;
+    }
+
+    static float BesselI0(float x)
+    {
+        float sum = 1;
+        float term = 1;
+        for (int i = 1; i < 20; ++i)
+        {
+            float t = x / (2 * i);
+            term *= t * t;
+            sum += term;
+        }
+        return sum;
+    }
+
+    // kaiser windowed sinc of width 3 and alpha 4 for a 2x reduction,
+    // taps sit at -1.25 to 1.25 destination pixels around the destination center
+    static void GetKaiserWeights(float* weights)
+    {
+        const float width = 3.0f;
+        const float alpha = 4.0f;
+
+        float sum = 0;
+        for (int i = 0; i < KAISER_TAP_COUNT; ++i)
+        {
+            float x = (i - 2.5f) * 0.5f;
+            float sinc = fabsf(x) < 1e-6f ? 1.0f : sinf(Mathf::PI * x) / (Mathf::PI * x);
+            float t = x / (width * 0.5f);
+            float window = BesselI0(alpha * sqrtf(Mathf::Max(0.0f, 1.0f - t * t))) / BesselI0(alpha);
+            weights[i] = sinc * window;
+            sum += weights[i];
+        }
+
+        for (int i = 0; i < KAISER_TAP_COUNT; ++i)
+        {
+            weights[i] /= sum;
+        }
+    }
+
+    static FloatImage ToFloat(const ByteBuffer& pixels, int width, int height, int channel_count, bool srgb)
+    {
+        float to_linear[256];
+        for (int i = 0; i < 256; ++i)
+        {
+            to_linear[i] = srgb ? SRGBToLinear(i / 255.0f) : i / 255.0f;
+        }
+
+        FloatImage image;
+        image.width = width;
+        image.height = height;
+        image.pixels.Resize(width * height * 4, 0.0f);
+
+        bool color = srgb && channel_count >= 3;
+        for (int i = 0; i < width * height; ++i)
+        {
+            for (int c = 0; c < channel_count; ++c)
+            {
+                byte v = pixels[i * channel_count + c];
+                image.pixels[i * 4 + c] = (color && c < 3) ? to_linear[v] : v / 255.0f;
+            }
+        }
+
+        return image;
+    }
+
+    static ByteBuffer ToBytes(const FloatImage& image, int channel_count, bool srgb, float alpha_scale)
+    {
+        ByteBuffer pixels(image.width * image.height * channel_count);
+
+        bool color = srgb && channel_count >= 3;
+        for (int i = 0; i < image.width * image.height; ++i)
+        {
+            for (int c = 0; c < channel_count; ++c)
+            {
+                float v = image.pixels[i * 4 + c];
+                if (c == 3)
+                {
+                    v *= alpha_scale;
+                }
+                v = Mathf::Clamp(v, 0.0f, 1.0f);
+                if (color && c < 3)
+                {
+                    v = LinearToSRGB(v);
+                }
+                pixels[i * channel_count + c] = (byte) (v * 255 + 0.5f);
+            }
+        }
+
+        return pixels;
+    }
+
+    struct BoxTaps
+    {
+        int first;
+        int count;
+        float weights[3];
+    };
+
+    // source pixels of one destination pixel along an axis. an odd axis of 2n + 1 pixels maps each
+    // destination pixel onto a span of 2 + 1 / n source pixels, the 3 taps are weighted by how much
+    // of each the span covers so the last row or column is not dropped
+    static BoxTaps GetBoxTaps(int src_size, int dst_size, int index)
+    {
+        BoxTaps taps;
+
+        if (src_size == 1)
+        {
+            taps.first = 0;
+            taps.count = 1;
+            taps.weights[0] = 1.0f;
+        }
+        else if (src_size % 2 == 0)
+        {
+            taps.first = index * 2;
+            taps.count = 2;
+            taps.weights[0] = 0.5f;
+            taps.weights[1] = 0.5f;
+        }
+        else
+        {
+            float span = (float) (dst_size * 2 + 1);
+            taps.first = index * 2;
+            taps.count = 3;
+            taps.weights[0] = (dst_size - index) / span;
+            taps.weights[1] = dst_size / span;
+            taps.weights[2] = (index + 1) / span;
+        }
+
+        return taps;
+    }
+
+    static FloatImage DownsampleBox(const FloatImage& src)
+    {
+        FloatImage dst;
+        dst.width = Mathf::Max(src.width >> 1, 1);
+        dst.height = Mathf::Max(src.height >> 1, 1);
+        dst.pixels.Resize(dst.width * dst.height * 4);
+
+        const float* s = &src.pixels[0];
+        float* d = &dst.pixels[0];
+
+        Vector<BoxTaps> columns(dst.width);
+        for (int x = 0; x < dst.width; ++x)
+        {
+            columns[x] = GetBoxTaps(src.width, dst.width, x);
+        }
+
+        for (int y = 0; y < dst.height; ++y)
+        {
+            BoxTaps rows = GetBoxTaps(src.height, dst.height, y);
+            for (int x = 0; x < dst.width; ++x)
+            {
+                const BoxTaps& cols = columns[x];
+                Pixel4 sum = Splat4(0);
+                for (int j = 0; j < rows.count; ++j)
+                {
+                    const float* row = &s[(rows.first + j) * src.width * 4];
+                    Pixel4 row_sum = Splat4(0);
+                    for (int i = 0; i < cols.count; ++i)
+                    {
+                        row_sum = Add4(row_sum, Mul4(Load4(&row[(cols.first + i) * 4]), Splat4(cols.weights[i])));
+                    }
+                    sum = Add4(sum, Mul4(row_sum, Splat4(rows.weights[j])));
+                }
+                Store4(&d[(y * dst.width + x) * 4], sum);
+            }
+        }
+
+        return dst;
+    }
+
+    // separable, clamps at the edges, an axis already at 1 pixel is copied
+    static FloatImage DownsampleKaiser(const FloatImage& src, const float* weights)
+    {
+        int dst_width = Mathf::Max(src.width >> 1, 1);
+        int dst_height = Mathf::Max(src.height >> 1, 1);
+
+        Pixel4 w[KAISER_TAP_COUNT];
+        for (int i = 0; i < KAISER_TAP_COUNT; ++i)
+        {
+            w[i] = Splat4(weights[i]);
+        }
+
+        FloatImage temp;
+        temp.width = dst_width;
+        temp.height = src.height;
+        temp.pixels.Resize(temp.width * temp.height * 4);
+
+        for (int y = 0; y < src.height; ++y)
+        {
+            const float* row = &src.pixels[y * src.width * 4];
+            float* out = &temp.pixels[y * temp.width * 4];
+            for (int x = 0; x < dst_width; ++x)
+            {
+                if (src.width == 1)
+                {
+                    Store4(&out[x * 4], Load4(&row[0]));
+                    continue;
+                }
+
+                Pixel4 sum = Splat4(0);
+                for (int i = 0; i < KAISER_TAP_COUNT; ++i)
+                {
+                    int sx = Mathf::Clamp(x * 2 - 2 + i, 0, src.width - 1);
+                    sum = Add4(sum, Mul4(Load4(&row[sx * 4]), w[i]));
+                }
+                Store4(&out[x * 4], sum);
+            }
+        }
+
+        FloatImage dst;
+        dst.width = dst_width;
+        dst.height = dst_height;
+        dst.pixels.Resize(dst.width * dst.height * 4);
+
+        for (int y = 0; y < dst_height; ++y)
+        {
+            float* out = &dst.pixels[y * dst.width * 4];
+            if (temp.height == 1)
+            {
+                for (int x = 0; x < dst_width; ++x)
+                {
+                    Store4(&out[x * 4], Load4(&temp.pixels[x * 4]));
+                }
+                continue;
+            }
+
+            const float* rows[KAISER_TAP_COUNT];
+            for (int i = 0; i < KAISER_TAP_COUNT; ++i)
+            {
+                rows[i] = &temp.pixels[Mathf::Clamp(y * 2 - 2 + i, 0, temp.height - 1) * temp.width * 4];
+            }
+
+            for (int x = 0; x < dst_width; ++x)
+            {
+                Pixel4 sum = Splat4(0);
+                for (int i = 0; i < KAISER_TAP_COUNT; ++i)
+                {
+                    sum = Add4(sum, Mul4(Load4(&rows[i][x * 4]), w[i]));
+                }
+                Store4(&out[x * 4], sum);
+            }
+        }
+
+        return dst;
+    }
+
+    static float GetAlphaCoverage(const FloatImage& image, float cutoff, float scale)
+    {
+        int count = 0;
+        int pixel_count = image.width * image.height;
+        for (int i = 0; i < pixel_count; ++i)
+        {
+            if (image.pixels[i * 4 + 3] * scale >= cutoff)
+            {
+                ++count;
+            }
+        }
+        return count / (float) pixel_count;
+    }
+
+    // scale for the level alpha whose coverage is closest to the source coverage
+    static float FindAlphaScale(const FloatImage& image, float cutoff, float coverage)
+    {
+        float min = 0;
+        float max = 4;
+        float scale = 1;
+        float best_scale = 1;
+        float best_error = 2;
+
+        // coverage is a step function of the scale, keep the closest one tried
+        for (int i = 0; i < 12; ++i)
+        {
+            float c = GetAlphaCoverage(image, cutoff, scale);
+            if (fabsf(c - coverage) < best_error)
+            {
+                best_scale = scale;
+                best_error = fabsf(c - coverage);
+            }
+
+            if (c < coverage)
+            {
+                min = scale;
+            }
+            else if (c > coverage)
+            {
+                max = scale;
+            }
+            else
+            {
+                break;
+            }
+            scale = (min + max) * 0.5f;
+        }
+
+        return best_scale;
+    }
+
+    int MipmapGenerator::GetLevelCount(int width, int height)
+    {
+        return (int) floor(Mathf::Log2((float) Mathf::Max(width, height))) + 1;
+    }
+
+    Vector<ByteBuffer> MipmapGenerator::Generate(const ByteBuffer& pixels, int width, int height, int channel_count, const MipmapOptions& options)
+    {
+        assert(channel_count >= 1 && channel_count <= 4);
+        assert(pixels.Size() == width * height * channel_count);
+
+        Vector<ByteBuffer> levels;
+        levels.Add(pixels);
+
+        float weights[KAISER_TAP_COUNT];
+        GetKaiserWeights(weights);
+
+        bool keep_coverage = channel_count == 4 && options.alpha_cutoff > 0;
+
+        FloatImage image = ToFloat(pixels, width, height, channel_count, options.srgb);
+        float coverage = keep_coverage ? GetAlphaCoverage(image, options.alpha_cutoff, 1.0f) : 0;
+
+        int level_count = GetLevelCount(width, height);
+        for (int i = 1; i < level_count; ++i)
+        {
+            if (options.filter == MipmapFilter::Kaiser)
+            {
+                image = DownsampleKaiser(image, weights);
+            }
+            else
+            {
+                image = DownsampleBox(image);
+            }
+
+            float alpha_scale = keep_coverage ? FindAlphaScale(image, options.alpha_cutoff, coverage) : 1.0f;
+            levels.Add(ToBytes(image, channel_count, options.srgb, alpha_scale));
+        }
+
+        return levels;
+    }
+}
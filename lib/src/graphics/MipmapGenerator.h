@@ -0,0 +1,49 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "container/Vector.h"
+#include "memory/ByteBuffer.h"
+
+namespace Viry3D
+{
+    enum class MipmapFilter
+    {
+        Box,
+        Kaiser,
+    };
+
+    struct MipmapOptions
+    {
+        MipmapFilter filter = MipmapFilter::Box;
+        // filter color channels of 3 and 4 channel images in linear space, alpha stays linear
+        bool srgb = false;
+        // keeps the alpha test coverage of the source on every level, 0 disables it
+        float alpha_cutoff = 0;
+    };
+
+    // cpu mip chain generation, pure and thread safe, so it can run offline and on worker threads.
+    // levels are filtered in float from the previous level with simd, and quantized once per level.
+    class MipmapGenerator
+    {
+    public:
+        static int GetLevelCount(int width, int height);
+        // 8 bit pixels with 1 to 4 channels, returns all levels from the source down to 1x1
+        static Vector<ByteBuffer> Generate(const ByteBuffer& pixels, int width, int height, int channel_count, const MipmapOptions& options);
+    };
+}
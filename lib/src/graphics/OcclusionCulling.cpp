@@ -0,0 +1,491 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "OcclusionCulling.h"
+#include "Application.h"
+#include "Camera.h"
+#include "SkinnedMeshRenderer.h"
+#include "Debug.h"
+#include "math/Mathf.h"
+#include "math/Vector4.h"
+#include "thread/ThreadPool.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define VR_OCCLUSION_SSE 1
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define VR_OCCLUSION_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define OCCLUSION_BAND_HEIGHT 16
+
+namespace Viry3D
+{
+    // edge values of a row start are e = a * x + r, the pixel passes when all 3 are not negative
+#if VR_OCCLUSION_SSE
+    static void RasterizeSpan(float* row, int x_begin, int x_end, const float* a, const float* r, float z_a, float z_r)
+    {
+        __m128 zero = _mm_setzero_ps();
+        __m128 offset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        __m128 a_0 = _mm_set1_ps(a[0]);
+        __m128 a_1 = _mm_set1_ps(a[1]);
+        __m128 a_2 = _mm_set1_ps(a[2]);
+        __m128 r_0 = _mm_set1_ps(r[0]);
+        __m128 r_1 = _mm_set1_ps(r[1]);
+        __m128 r_2 = _mm_set1_ps(r[2]);
+        __m128 za = _mm_set1_ps(z_a);
+        __m128 zr = _mm_set1_ps(z_r);
+
+        for (int x = x_begin; x <= x_end; x += 4)
+        {
+            __m128 px = _mm_add_ps(_mm_set1_ps((float) x), offset);
+            __m128 e_0 = _mm_add_ps(_mm_mul_ps(a_0, px), r_0);
+            __m128 e_1 = _mm_add_ps(_mm_mul_ps(a_1, px), r_1);
+            __m128 e_2 = _mm_add_ps(_mm_mul_ps(a_2, px), r_2);
+            __m128 mask = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e_0, zero), _mm_cmpge_ps(e_1, zero)), _mm_cmpge_ps(e_2, zero));
+            if (_mm_movemask_ps(mask) == 0)
+            {
+                continue;
+            }
+
+            __m128 z = _mm_add_ps(_mm_mul_ps(za, px), zr);
+            __m128 depth = _mm_loadu_ps(&row[x]);
+            __m128 write = _mm_min_ps(depth, z);
+            _mm_storeu_ps(&row[x], _mm_or_ps(_mm_and_ps(mask, write), _mm_andnot_ps(mask, depth)));
+        }
+    }
+
+    static void DownsampleRow(const float* src_0, const float* src_1, float* dst, int dst_width)
+    {
+        for (int x = 0; x < dst_width; x += 4)
+        {
+            __m128 a = _mm_max_ps(_mm_loadu_ps(&src_0[x * 2]), _mm_loadu_ps(&src_1[x * 2]));
+            __m128 b = _mm_max_ps(_mm_loadu_ps(&src_0[x * 2 + 4]), _mm_loadu_ps(&src_1[x * 2 + 4]));
+            __m128 even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 odd = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(&dst[x], _mm_max_ps(even, odd));
+        }
+    }
+#elif VR_OCCLUSION_NEON
+    static void RasterizeSpan(float* row, int x_begin, int x_end, const float* a, const float* r, float z_a, float z_r)
+    {
+        const float offsets[4] = { 0.5f, 1.5f, 2.5f, 3.5f };
+        float32x4_t zero = vdupq_n_f32(0);
+        float32x4_t offset = vld1q_f32(offsets);
+        float32x4_t r_0 = vdupq_n_f32(r[0]);
+        float32x4_t r_1 = vdupq_n_f32(r[1]);
+        float32x4_t r_2 = vdupq_n_f32(r[2]);
+        float32x4_t zr = vdupq_n_f32(z_r);
+
+        for (int x = x_begin; x <= x_end; x += 4)
+        {
+            float32x4_t px = vaddq_f32(vdupq_n_f32((float) x), offset);
+            float32x4_t e_0 = vmlaq_n_f32(r_0, px, a[0]);
+            float32x4_t e_1 = vmlaq_n_f32(r_1, px, a[1]);
+            float32x4_t e_2 = vmlaq_n_f32(r_2, px, a[2]);
+            uint32x4_t mask = vandq_u32(vandq_u32(vcgeq_f32(e_0, zero), vcgeq_f32(e_1, zero)), vcgeq_f32(e_2, zero));
+            uint32x2_t any = vorr_u32(vget_low_u32(mask), vget_high_u32(mask));
+            if (vget_lane_u32(vpmax_u32(any, any), 0) == 0)
+            {
+                continue;
+            }
+
+            float32x4_t z = vmlaq_n_f32(zr, px, z_a);
+            float32x4_t depth = vld1q_f32(&row[x]);
+            vst1q_f32(&row[x], vbslq_f32(mask, vminq_f32(depth, z), depth));
+        }
+    }
+
+    static void DownsampleRow(const float* src_0, const float* src_1, float* dst, int dst_width)
+    {
+        for (int x = 0; x < dst_width; x += 4)
+        {
+            float32x4_t a = vmaxq_f32(vld1q_f32(&src_0[x * 2]), vld1q_f32(&src_1[x * 2]));
+            float32x4_t b = vmaxq_f32(vld1q_f32(&src_0[x * 2 + 4]), vld1q_f32(&src_1[x * 2 + 4]));
+            float32x4x2_t pairs = vuzpq_f32(a, b);
+            vst1q_f32(&dst[x], vmaxq_f32(pairs.val[0], pairs.val[1]));
+        }
+    }
+#else
+    static void RasterizeSpan(float* row, int x_begin, int x_end, const float* a, const float* r, float z_a, float z_r)
+    {
+        for (int x = x_begin; x <= x_end; ++x)
+        {
+            float px = x + 0.5f;
+            if (a[0] * px + r[0] >= 0 && a[1] * px + r[1] >= 0 && a[2] * px + r[2] >= 0)
+            {
+                row[x] = Mathf::Min(row[x], z_a * px + z_r);
+            }
+        }
+    }
+
+    static void DownsampleRow(const float* src_0, const float* src_1, float* dst, int dst_width)
+    {
+        for (int x = 0; x < dst_width; ++x)
+        {
+            dst[x] = Mathf::Max(Mathf::Max(src_0[x * 2], src_0[x * 2 + 1]), Mathf::Max(src_1[x * 2], src_1[x * 2 + 1]));
+        }
+    }
+#endif
+
+    OcclusionCulling::OcclusionCulling(int width, int height):
+        m_width(width),
+        m_height(height),
+        m_culled_count(0)
+    {
+        assert(width >= 4 && (width & (width - 1)) == 0);
+        assert(height >= 4 && (height & (height - 1)) == 0);
+
+        int level_width = width;
+        int level_height = height;
+        while (true)
+        {
+            Level level;
+            level.width = level_width;
+            level.height = level_height;
+            level.depths.Resize(level_width * level_height, Mathf::MaxFloatValue);
+            m_levels.Add(level);
+
+            if (level_width == 1 && level_height == 1)
+            {
+                break;
+            }
+            level_width = Mathf::Max(level_width / 2, 1);
+            level_height = Mathf::Max(level_height / 2, 1);
+        }
+    }
+
+    void OcclusionCulling::AddOccluder(const Ref<Node>& node, const Vector<Vector3>& vertices, const Vector<unsigned short>& indices)
+    {
+        assert(indices.Size() % 3 == 0);
+
+        Occluder occluder;
+        occluder.node = node;
+        occluder.vertices = vertices;
+        occluder.indices = indices;
+        m_occluders.Add(occluder);
+    }
+
+    void OcclusionCulling::RemoveOccluder(const Ref<Node>& node)
+    {
+        for (int i = 0; i < m_occluders.Size(); ++i)
+        {
+            if (m_occluders[i].node == node)
+            {
+                m_occluders.Remove(i);
+                break;
+            }
+        }
+    }
+
+    void OcclusionCulling::Rasterize(const Matrix4x4& view_projection)
+    {
+        m_view_projection = view_projection;
+        m_triangles.Clear();
+
+        Vector<Vector4> clips;
+        for (int i = 0; i < m_occluders.Size(); ++i)
+        {
+            const Occluder& occluder = m_occluders[i];
+            Matrix4x4 mvp = view_projection * occluder.node->GetLocalToWorldMatrix();
+
+            clips.Resize(occluder.vertices.Size());
+            for (int j = 0; j < occluder.vertices.Size(); ++j)
+            {
+                clips[j] = mvp * Vector4(occluder.vertices[j], 1);
+            }
+
+            for (int j = 0; j < occluder.indices.Size(); j += 3)
+            {
+                Vector4 triangle[3] = {
+                    clips[occluder.indices[j]],
+                    clips[occluder.indices[j + 1]],
+                    clips[occluder.indices[j + 2]],
+                };
+                this->SetupTriangle(triangle);
+            }
+        }
+
+        Vector<float>& depths = m_levels[0].depths;
+        for (int i = 0; i < depths.Size(); ++i)
+        {
+            depths[i] = Mathf::MaxFloatValue;
+        }
+
+        // bands own disjoint rows, so they run without locking
+        int band_count = (m_height + OCCLUSION_BAND_HEIGHT - 1) / OCCLUSION_BAND_HEIGHT;
+        ThreadPool::ParallelFor(Application::Instance()->GetThreadPool(), band_count, [this](int band) {
+            int y = band * OCCLUSION_BAND_HEIGHT;
+            this->RasterizeBand(y, Mathf::Min(y + OCCLUSION_BAND_HEIGHT, m_height));
+        });
+
+        for (int i = 1; i < m_levels.Size(); ++i)
+        {
+            this->BuildLevel(i);
+        }
+    }
+
+    void OcclusionCulling::SetupTriangle(const Vector4* clip)
+    {
+        // clip against the near plane z >= -w, the rest is clamped to the screen by the bounding box
+        Vector4 polygon[4];
+        int count = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            const Vector4& a = clip[i];
+            const Vector4& b = clip[(i + 1) % 3];
+            float da = a.z + a.w;
+            float db = b.z + b.w;
+
+            if (da >= 0)
+            {
+                polygon[count++] = a;
+            }
+            if ((da >= 0) != (db >= 0))
+            {
+                float t = da / (da - db);
+                polygon[count++] = a + (b - a) * t;
+            }
+        }
+
+        for (int i = 1; i + 1 < count; ++i)
+        {
+            const Vector4* vertices[3] = { &polygon[0], &polygon[i], &polygon[i + 1] };
+
+            Triangle triangle;
+            for (int j = 0; j < 3; ++j)
+            {
+                float inv_w = 1.0f / vertices[j]->w;
+                triangle.x[j] = (vertices[j]->x * inv_w * 0.5f + 0.5f) * m_width;
+                triangle.y[j] = (vertices[j]->y * inv_w * 0.5f + 0.5f) * m_height;
+                triangle.z[j] = vertices[j]->z * inv_w;
+            }
+
+            float area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) - (triangle.y[1] - triangle.y[0]) * (triangle.x[2] - triangle.x[0]);
+            if (fabs(area) < 1e-6f)
+            {
+                continue;
+            }
+
+            // occluders draw both faces, keep counter clockwise order so inside is positive
+            if (area < 0)
+            {
+                std::swap(triangle.x[1], triangle.x[2]);
+                std::swap(triangle.y[1], triangle.y[2]);
+                std::swap(triangle.z[1], triangle.z[2]);
+            }
+
+            float min_x = Mathf::Min(Mathf::Min(triangle.x[0], triangle.x[1]), triangle.x[2]);
+            float max_x = Mathf::Max(Mathf::Max(triangle.x[0], triangle.x[1]), triangle.x[2]);
+            float min_y = Mathf::Min(Mathf::Min(triangle.y[0], triangle.y[1]), triangle.y[2]);
+            float max_y = Mathf::Max(Mathf::Max(triangle.y[0], triangle.y[1]), triangle.y[2]);
+            if (max_x < 0 || max_y < 0 || min_x >= m_width || min_y >= m_height)
+            {
+                continue;
+            }
+
+            triangle.min_x = Mathf::Clamp((int) floor(min_x), 0, m_width - 1);
+            triangle.max_x = Mathf::Clamp((int) floor(max_x), 0, m_width - 1);
+            triangle.min_y = Mathf::Clamp((int) floor(min_y), 0, m_height - 1);
+            triangle.max_y = Mathf::Clamp((int) floor(max_y), 0, m_height - 1);
+
+            m_triangles.Add(triangle);
+        }
+    }
+
+    void OcclusionCulling::RasterizeBand(int y_begin, int y_end)
+    {
+        Vector<float>& depths = m_levels[0].depths;
+
+        for (int i = 0; i < m_triangles.Size(); ++i)
+        {
+            const Triangle& t = m_triangles[i];
+            int y_min = Mathf::Max(t.min_y, y_begin);
+            int y_max = Mathf::Min(t.max_y, y_end - 1);
+            if (y_min > y_max)
+            {
+                continue;
+            }
+
+            // edge i is opposite to vertex i, its value over the area is the barycentric weight of vertex i
+            float a[3];
+            float b[3];
+            float c[3];
+            for (int j = 0; j < 3; ++j)
+            {
+                int p = (j + 1) % 3;
+                int q = (j + 2) % 3;
+                a[j] = t.y[p] - t.y[q];
+                b[j] = t.x[q] - t.x[p];
+                c[j] = -(a[j] * t.x[p] + b[j] * t.y[p]);
+            }
+
+            float inv_area = 1.0f / (c[0] + c[1] + c[2]);
+            float z_a = (a[0] * t.z[0] + a[1] * t.z[1] + a[2] * t.z[2]) * inv_area;
+            float z_b = (b[0] * t.z[0] + b[1] * t.z[1] + b[2] * t.z[2]) * inv_area;
+            float z_c = (c[0] * t.z[0] + c[1] * t.z[1] + c[2] * t.z[2]) * inv_area;
+
+            // spans start 4 aligned, width is a multiple of 4 so the last group stays in the row
+            int x_begin = t.min_x & ~3;
+
+            for (int y = y_min; y <= y_max; ++y)
+            {
+                float py = y + 0.5f;
+                float r[3] = {
+                    b[0] * py + c[0],
+                    b[1] * py + c[1],
+                    b[2] * py + c[2],
+                };
+                RasterizeSpan(&depths[y * m_width], x_begin, t.max_x, a, r, z_a, z_b * py + z_c);
+            }
+        }
+    }
+
+    void OcclusionCulling::BuildLevel(int level)
+    {
+        const Level& src = m_levels[level - 1];
+        Level& dst = m_levels[level];
+
+        if (src.width == dst.width * 2 && src.height == dst.height * 2 && dst.width % 4 == 0)
+        {
+            for (int y = 0; y < dst.height; ++y)
+            {
+                DownsampleRow(&src.depths[y * 2 * src.width], &src.depths[(y * 2 + 1) * src.width], &dst.depths[y * dst.width], dst.width);
+            }
+            return;
+        }
+
+        for (int y = 0; y < dst.height; ++y)
+        {
+            int y_0 = Mathf::Min(y * 2, src.height - 1);
+            int y_1 = Mathf::Min(y * 2 + 1, src.height - 1);
+
+            for (int x = 0; x < dst.width; ++x)
+            {
+                int x_0 = Mathf::Min(x * 2, src.width - 1);
+                int x_1 = Mathf::Min(x * 2 + 1, src.width - 1);
+
+                dst.depths[y * dst.width + x] = Mathf::Max(
+                    Mathf::Max(src.depths[y_0 * src.width + x_0], src.depths[y_0 * src.width + x_1]),
+                    Mathf::Max(src.depths[y_1 * src.width + x_0], src.depths[y_1 * src.width + x_1]));
+            }
+        }
+    }
+
+    bool OcclusionCulling::IsVisible(const Bounds& bounds) const
+    {
+        float min_x = Mathf::MaxFloatValue;
+        float min_y = Mathf::MaxFloatValue;
+        float max_x = Mathf::MinFloatValue;
+        float max_y = Mathf::MinFloatValue;
+        float min_z = Mathf::MaxFloatValue;
+        int behind_count = 0;
+
+        for (int i = 0; i < 8; ++i)
+        {
+            Vector4 corner(
+                (i & 1) ? bounds.Max().x : bounds.Min().x,
+                (i & 2) ? bounds.Max().y : bounds.Min().y,
+                (i & 4) ? bounds.Max().z : bounds.Min().z,
+                1);
+            Vector4 clip = m_view_projection * corner;
+
+            if (clip.z < -clip.w)
+            {
+                ++behind_count;
+                continue;
+            }
+
+            float inv_w = 1.0f / clip.w;
+            float x = (clip.x * inv_w * 0.5f + 0.5f) * m_width;
+            float y = (clip.y * inv_w * 0.5f + 0.5f) * m_height;
+            min_x = Mathf::Min(min_x, x);
+            min_y = Mathf::Min(min_y, y);
+            max_x = Mathf::Max(max_x, x);
+            max_y = Mathf::Max(max_y, y);
+            min_z = Mathf::Min(min_z, clip.z * inv_w);
+        }
+
+        // fully behind the near plane is never drawn, crossing it leaves the projected rect unbounded
+        if (behind_count == 8)
+        {
+            return false;
+        }
+        if (behind_count > 0)
+        {
+            return true;
+        }
+
+        if (max_x < 0 || max_y < 0 || min_x >= m_width || min_y >= m_height)
+        {
+            return false;
+        }
+
+        int x_0 = Mathf::Clamp((int) floor(min_x), 0, m_width - 1);
+        int x_1 = Mathf::Clamp((int) floor(max_x), 0, m_width - 1);
+        int y_0 = Mathf::Clamp((int) floor(min_y), 0, m_height - 1);
+        int y_1 = Mathf::Clamp((int) floor(max_y), 0, m_height - 1);
+
+        // coarsest level where the rect covers at most 2x2 texels
+        int level = 0;
+        while (level + 1 < m_levels.Size() && ((x_1 >> level) - (x_0 >> level) > 1 || (y_1 >> level) - (y_0 >> level) > 1))
+        {
+            ++level;
+        }
+
+        const Level& hiz = m_levels[level];
+        int tx_0 = Mathf::Min(x_0 >> level, hiz.width - 1);
+        int tx_1 = Mathf::Min(x_1 >> level, hiz.width - 1);
+        int ty_0 = Mathf::Min(y_0 >> level, hiz.height - 1);
+        int ty_1 = Mathf::Min(y_1 >> level, hiz.height - 1);
+
+        float max_depth = Mathf::MinFloatValue;
+        for (int y = ty_0; y <= ty_1; ++y)
+        {
+            for (int x = tx_0; x <= tx_1; ++x)
+            {
+                max_depth = Mathf::Max(max_depth, hiz.depths[y * hiz.width + x]);
+            }
+        }
+
+        return min_z <= max_depth;
+    }
+
+    void OcclusionCulling::Cull(Camera* view_camera)
+    {
+        this->Rasterize(view_camera->GetProjectionMatrix() * view_camera->GetViewMatrix());
+
+        m_culled_count = 0;
+        for (const auto& i : view_camera->GetRenderers())
+        {
+            // skinned bounds come from the bind pose and instances are not in the bounds, both stay drawn
+            Ref<MeshRenderer> renderer = RefCast<MeshRenderer>(i.renderer);
+            if (!renderer || !renderer->GetMesh() || renderer->GetInstanceCount() > 1 || RefCast<SkinnedMeshRenderer>(renderer))
+            {
+                continue;
+            }
+
+            bool culled = !this->IsVisible(renderer->GetBounds());
+            renderer->SetCulled(culled);
+            if (culled)
+            {
+                ++m_culled_count;
+            }
+        }
+    }
+}
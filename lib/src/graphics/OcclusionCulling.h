@@ -0,0 +1,92 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "Node.h"
+#include "container/Vector.h"
+#include "math/Matrix4x4.h"
+#include "math/Bounds.h"
+
+namespace Viry3D
+{
+    class Camera;
+
+    // rasterizes occluder meshes into a low resolution depth buffer on the cpu,
+    // then tests renderer bounds against a max depth mip chain of it.
+    // nothing is read back from the gpu, the result only depends on the inputs.
+    class OcclusionCulling
+    {
+    public:
+        // width and height must be powers of two and at least 4
+        OcclusionCulling(int width = 256, int height = 128);
+        // occluders are simplified meshes placed by node, they should lie inside the geometry they stand for
+        void AddOccluder(const Ref<Node>& node, const Vector<Vector3>& vertices, const Vector<unsigned short>& indices);
+        void RemoveOccluder(const Ref<Node>& node);
+        int GetOccluderCount() const { return m_occluders.Size(); }
+        int GetWidth() const { return m_width; }
+        int GetHeight() const { return m_height; }
+        // ndc depth per pixel, rows from bottom to top
+        const Vector<float>& GetDepthBuffer() const { return m_levels[0].depths; }
+        void Rasterize(const Matrix4x4& view_projection);
+        // call after Rasterize with the same view_projection
+        bool IsVisible(const Bounds& bounds) const;
+        // rasterizes from view_camera and marks its occluded mesh renderers culled,
+        // Camera::Update calls it before recording when the camera has occlusion culling set
+        void Cull(Camera* view_camera);
+        int GetCulledCount() const { return m_culled_count; }
+
+    private:
+        struct Occluder
+        {
+            Ref<Node> node;
+            Vector<Vector3> vertices;
+            Vector<unsigned short> indices;
+        };
+
+        struct Triangle
+        {
+            float x[3];
+            float y[3];
+            float z[3];
+            int min_x;
+            int max_x;
+            int min_y;
+            int max_y;
+        };
+
+        struct Level
+        {
+            int width;
+            int height;
+            Vector<float> depths;
+        };
+
+        void SetupTriangle(const Vector4* clip);
+        void RasterizeBand(int y_begin, int y_end);
+        void BuildLevel(int level);
+
+    private:
+        int m_width;
+        int m_height;
+        Vector<Occluder> m_occluders;
+        Vector<Triangle> m_triangles;
+        Vector<Level> m_levels;
+        Matrix4x4 m_view_projection;
+        int m_culled_count;
+    };
+}
@@ -0,0 +1,504 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "RenderGraph.h"
+#include "Display.h"
+#include "Camera.h"
+#include "Material.h"
+#include "MeshRenderer.h"
+#include "RenderTexturePool.h"
+#include "Debug.h"
+#include "math/Mathf.h"
+
+namespace Viry3D
+{
+    RenderGraph::RenderGraph(int depth):
+        m_depth(depth),
+        m_camera_count(0)
+    {
+        this->Reset();
+    }
+
+    RenderGraph::~RenderGraph()
+    {
+        this->Release();
+    }
+
+    int RenderGraph::CreateTexture(const String& name, const RenderGraphTextureDesc& desc)
+    {
+        Resource resource;
+        resource.name = name;
+        resource.desc = desc;
+        resource.transient = true;
+        resource.physical = -1;
+        resource.first_pass = -1;
+        resource.last_pass = -1;
+        resource.ref_count = 0;
+        resource.written = false;
+        m_resources.Add(resource);
+
+        return m_resources.Size() - 1;
+    }
+
+    int RenderGraph::ImportTexture(const String& name, const Ref<Texture>& texture)
+    {
+        int index = this->CreateTexture(name, RenderGraphTextureDesc());
+        m_resources[index].imported = texture;
+        m_resources[index].transient = false;
+
+        return index;
+    }
+
+    void RenderGraph::AddCameraPass(const String& name, int color, int depth, const Vector<int>& reads, const CameraSetup& setup)
+    {
+        assert(color < m_resources.Size() && depth < m_resources.Size());
+        assert(color != 0 || depth <= 0);
+
+        Pass pass;
+        pass.name = name;
+        pass.type = PassType::Camera;
+        pass.reads = reads;
+        pass.color = color;
+        pass.depth = depth;
+        pass.setup = setup;
+        pass.external_camera = nullptr;
+        pass.ref_count = 0;
+        pass.culled = false;
+        pass.camera = nullptr;
+        m_passes.Add(pass);
+    }
+
+    void RenderGraph::AddCameraPass(const String& name, Camera* camera, int color, int depth, const Vector<int>& reads)
+    {
+        this->AddCameraPass(name, color, depth, reads, CameraSetup());
+        m_passes[m_passes.Size() - 1].external_camera = camera;
+    }
+
+    void RenderGraph::AddBlitPass(const String& name, const Vector<int>& inputs, int output, const Ref<Material>& material, const Vector<String>& input_names)
+    {
+        assert(output >= 0 && output < m_resources.Size());
+        assert(inputs.Size() <= 1 || input_names.Size() == inputs.Size());
+
+        Pass pass;
+        pass.name = name;
+        pass.type = PassType::Blit;
+        pass.reads = inputs;
+        pass.color = output;
+        pass.depth = -1;
+        pass.external_camera = nullptr;
+        pass.material = material;
+        pass.input_names = input_names;
+        pass.ref_count = 0;
+        pass.culled = false;
+        pass.camera = nullptr;
+        m_passes.Add(pass);
+    }
+
+    void RenderGraph::AddBlitPass(const String& name, int input, int output, const Ref<Material>& material)
+    {
+        this->AddBlitPass(name, Vector<int>({ input }), output, material);
+    }
+
+    void RenderGraph::Compile()
+    {
+        this->Release();
+        this->CullPasses();
+        this->ComputeLifetimes();
+
+        Pass* prev_blit = nullptr;
+
+        for (int i = 0; i < m_passes.Size(); ++i)
+        {
+            Pass& pass = m_passes[i];
+            if (pass.culled)
+            {
+                continue;
+            }
+
+            for (int j = 0; j < m_resources.Size(); ++j)
+            {
+                if (m_resources[j].transient && m_resources[j].first_pass == i)
+                {
+                    this->AcquireTexture(j);
+                }
+            }
+
+            this->CreateCamera(pass, prev_blit);
+            prev_blit = pass.type == PassType::Blit ? &pass : nullptr;
+
+            // released textures are handed to later resources, whose first write clears them
+            for (int j = 0; j < m_resources.Size(); ++j)
+            {
+                if (m_resources[j].transient && m_resources[j].last_pass == i)
+                {
+                    m_physical_textures[m_resources[j].physical].used = false;
+                }
+            }
+        }
+    }
+
+    void RenderGraph::Release()
+    {
+        for (auto i : m_cameras)
+        {
+            Display::Instance()->DestroyCamera(i);
+        }
+        m_cameras.Clear();
+        m_camera_count = 0;
+
+        for (int i = 0; i < m_passes.Size(); ++i)
+        {
+            if (m_passes[i].external_camera && m_passes[i].camera)
+            {
+                m_passes[i].external_camera->SetRenderTarget(Ref<Texture>(), Ref<Texture>());
+            }
+            m_passes[i].camera = nullptr;
+        }
+
+        for (int i = 0; i < m_resources.Size(); ++i)
+        {
+            m_resources[i].physical = -1;
+        }
+
+        // the cameras drawing into them are destroyed above, so a recompile gets them back in the same frame
+        for (int i = 0; i < m_physical_textures.Size(); ++i)
+        {
+            RenderTexturePool::Release(m_physical_textures[i].texture, true);
+        }
+        m_physical_textures.Clear();
+    }
+
+    void RenderGraph::Reset()
+    {
+        this->Release();
+        m_passes.Clear();
+        m_resources.Clear();
+
+        int back_buffer = this->CreateTexture("BackBuffer", RenderGraphTextureDesc());
+        m_resources[back_buffer].transient = false;
+    }
+
+    void RenderGraph::CullPasses()
+    {
+        // imported textures and the back buffer are read outside of the graph
+        for (int i = 0; i < m_resources.Size(); ++i)
+        {
+            m_resources[i].ref_count = m_resources[i].transient ? 0 : 1;
+            m_resources[i].written = false;
+        }
+
+        for (int i = 0; i < m_passes.Size(); ++i)
+        {
+            Pass& pass = m_passes[i];
+            pass.culled = false;
+            pass.ref_count = 0;
+
+            for (int j = 0; j < pass.reads.Size(); ++j)
+            {
+                m_resources[pass.reads[j]].ref_count += 1;
+            }
+            if (pass.color >= 0)
+            {
+                pass.ref_count += 1;
+            }
+            if (pass.depth >= 0 && pass.depth != pass.color)
+            {
+                pass.ref_count += 1;
+            }
+            if (pass.external_camera)
+            {
+                pass.ref_count += 1;
+            }
+        }
+
+        Vector<int> unused;
+        for (int i = 0; i < m_resources.Size(); ++i)
+        {
+            if (m_resources[i].ref_count == 0)
+            {
+                unused.Add(i);
+            }
+        }
+
+        while (unused.Size() > 0)
+        {
+            int resource = unused[unused.Size() - 1];
+            unused.Resize(unused.Size() - 1);
+
+            for (int i = 0; i < m_passes.Size(); ++i)
+            {
+                Pass& pass = m_passes[i];
+                if (pass.culled || (pass.color != resource && pass.depth != resource))
+                {
+                    continue;
+                }
+
+                pass.ref_count -= 1;
+                if (pass.ref_count == 0)
+                {
+                    pass.culled = true;
+
+                    for (int j = 0; j < pass.reads.Size(); ++j)
+                    {
+                        Resource& read = m_resources[pass.reads[j]];
+                        read.ref_count -= 1;
+                        if (read.ref_count == 0)
+                        {
+                            unused.Add(pass.reads[j]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void RenderGraph::ComputeLifetimes()
+    {
+        for (int i = 0; i < m_resources.Size(); ++i)
+        {
+            m_resources[i].first_pass = -1;
+            m_resources[i].last_pass = -1;
+        }
+
+        for (int i = 0; i < m_passes.Size(); ++i)
+        {
+            const Pass& pass = m_passes[i];
+            if (pass.culled)
+            {
+                continue;
+            }
+
+            Vector<int> used = pass.reads;
+            used.Add(pass.color);
+            used.Add(pass.depth);
+
+            for (int j = 0; j < used.Size(); ++j)
+            {
+                if (used[j] < 0)
+                {
+                    continue;
+                }
+
+                Resource& resource = m_resources[used[j]];
+                if (resource.first_pass < 0)
+                {
+                    resource.first_pass = i;
+                }
+                resource.last_pass = i;
+            }
+        }
+    }
+
+    void RenderGraph::AcquireTexture(int resource)
+    {
+        Resource& res = m_resources[resource];
+        const RenderGraphTextureDesc& desc = res.desc;
+        int width = desc.width > 0 ? desc.width : Mathf::Max(Display::Instance()->GetWidth() >> desc.downsample, 1);
+        int height = desc.height > 0 ? desc.height : Mathf::Max(Display::Instance()->GetHeight() >> desc.downsample, 1);
+
+        for (int i = 0; i < m_physical_textures.Size(); ++i)
+        {
+            PhysicalTexture& physical = m_physical_textures[i];
+            if (!physical.used &&
+                physical.width == width &&
+                physical.height == height &&
+                physical.desc.format == desc.format &&
+                physical.desc.filter_mode == desc.filter_mode &&
+                physical.desc.wrap_mode == desc.wrap_mode)
+            {
+                physical.used = true;
+                res.physical = i;
+                return;
+            }
+        }
+
+        PhysicalTexture physical;
+        physical.texture = RenderTexturePool::Acquire(
+            width,
+            height,
+            desc.format,
+            1,
+            true,
+            desc.filter_mode,
+            desc.wrap_mode);
+        physical.width = width;
+        physical.height = height;
+        physical.desc = desc;
+        physical.used = true;
+        m_physical_textures.Add(physical);
+
+        res.physical = m_physical_textures.Size() - 1;
+    }
+
+    CameraClearFlags RenderGraph::GetClearFlags(Pass& pass)
+    {
+        bool clear_color = pass.color >= 0 && !m_resources[pass.color].written;
+        bool clear_depth = pass.depth >= 0 && !m_resources[pass.depth].written;
+
+        if (pass.color >= 0)
+        {
+            m_resources[pass.color].written = true;
+        }
+        if (pass.depth >= 0)
+        {
+            m_resources[pass.depth].written = true;
+        }
+
+        if (pass.type == PassType::Blit)
+        {
+            return clear_color ? CameraClearFlags::Invalidate : CameraClearFlags::Nothing;
+        }
+
+        if (pass.color == 0)
+        {
+            return clear_color ? CameraClearFlags::ColorAndDepth : CameraClearFlags::Nothing;
+        }
+        if (clear_color && clear_depth)
+        {
+            return CameraClearFlags::ColorAndDepth;
+        }
+        if (clear_color)
+        {
+            return CameraClearFlags::Color;
+        }
+        if (clear_depth)
+        {
+            return CameraClearFlags::Depth;
+        }
+        return CameraClearFlags::Nothing;
+    }
+
+    void RenderGraph::CreateCamera(Pass& pass, Pass* prev_blit)
+    {
+        CameraClearFlags clear_flags = this->GetClearFlags(pass);
+        Camera* camera = nullptr;
+
+        if (pass.type == PassType::Blit)
+        {
+            String texture_name;
+            if (pass.input_names.Size() > 0)
+            {
+                texture_name = pass.input_names[0];
+            }
+
+            Ref<Texture> input;
+            if (pass.reads.Size() > 0)
+            {
+                input = this->GetTexture(pass.reads[0]);
+            }
+
+            Ref<MeshRenderer> renderer = Display::Instance()->CreateBlitRenderer(input, pass.material, texture_name);
+            for (int i = 1; i < pass.reads.Size(); ++i)
+            {
+                renderer->GetMaterial()->SetTexture(pass.input_names[i], this->GetTexture(pass.reads[i]));
+            }
+
+            bool merge = prev_blit && prev_blit->color == pass.color;
+            for (int i = 0; i < pass.reads.Size(); ++i)
+            {
+                if (pass.reads[i] == pass.color)
+                {
+                    merge = false;
+                }
+            }
+
+            // renderers with the same queue keep their add order, so merged blits draw in declaration order
+            if (merge)
+            {
+                pass.camera = prev_blit->camera;
+                pass.camera->AddRenderer(renderer);
+                pass.camera->SetName(pass.camera->GetName() + "+" + pass.name);
+                return;
+            }
+
+            camera = Display::Instance()->CreateCamera();
+            camera->SetRenderTarget(this->GetTexture(pass.color), Ref<Texture>());
+            camera->AddRenderer(renderer);
+        }
+        else
+        {
+            camera = pass.external_camera;
+            if (!camera)
+            {
+                camera = Display::Instance()->CreateCamera();
+            }
+            if (pass.color != 0)
+            {
+                camera->SetRenderTarget(this->GetTexture(pass.color), this->GetTexture(pass.depth));
+            }
+        }
+
+        camera->SetClearFlags(clear_flags);
+        camera->SetDepth(m_depth + m_camera_count);
+        if (camera != pass.external_camera)
+        {
+            camera->SetName(pass.name);
+            m_cameras.Add(camera);
+        }
+        m_camera_count += 1;
+        pass.camera = camera;
+
+        if (pass.setup)
+        {
+            pass.setup(camera);
+        }
+    }
+
+    Camera* RenderGraph::GetCamera(const String& pass_name) const
+    {
+        for (int i = 0; i < m_passes.Size(); ++i)
+        {
+            if (m_passes[i].name == pass_name)
+            {
+                return m_passes[i].camera;
+            }
+        }
+        return nullptr;
+    }
+
+    Ref<Texture> RenderGraph::GetTexture(int resource) const
+    {
+        if (resource <= 0)
+        {
+            return Ref<Texture>();
+        }
+
+        const Resource& res = m_resources[resource];
+        if (!res.transient)
+        {
+            return res.imported;
+        }
+        if (res.physical >= 0)
+        {
+            return m_physical_textures[res.physical].texture;
+        }
+        return Ref<Texture>();
+    }
+
+    int RenderGraph::GetCulledPassCount() const
+    {
+        int count = 0;
+        for (int i = 0; i < m_passes.Size(); ++i)
+        {
+            if (m_passes[i].culled)
+            {
+                count += 1;
+            }
+        }
+        return count;
+    }
+}
@@ -0,0 +1,135 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "Texture.h"
+#include "CameraClearFlags.h"
+#include "container/Vector.h"
+#include "string/String.h"
+#include <functional>
+
+namespace Viry3D
+{
+    class Camera;
+    class Material;
+
+    struct RenderGraphTextureDesc
+    {
+        // 0 follows the display size shifted right by downsample
+        int width = 0;
+        int height = 0;
+        int downsample = 0;
+        TextureFormat format = TextureFormat::R8G8B8A8;
+        FilterMode filter_mode = FilterMode::Linear;
+        SamplerAddressMode wrap_mode = SamplerAddressMode::ClampToEdge;
+    };
+
+    // declares passes and the textures they read and write, Compile turns them into cameras.
+    // pass order follows declaration and becomes camera depth, the first write of a texture clears it and later writes load it,
+    // passes whose outputs are never read are culled, transient textures with disjoint lifetimes share one render texture,
+    // and consecutive blits into the same target are merged into one camera so they share a render pass.
+    class RenderGraph
+    {
+    public:
+        typedef std::function<void(Camera*)> CameraSetup;
+
+        RenderGraph(int depth = 0);
+        ~RenderGraph();
+        int GetBackBuffer() const { return 0; }
+        int CreateTexture(const String& name, const RenderGraphTextureDesc& desc);
+        int ImportTexture(const String& name, const Ref<Texture>& texture);
+        // color or depth can be -1, the back buffer uses the window color and depth
+        void AddCameraPass(const String& name, int color, int depth, const Vector<int>& reads, const CameraSetup& setup);
+        // renders an existing camera into the graph, it is never culled and its target is reset on Release
+        void AddCameraPass(const String& name, Camera* camera, int color, int depth, const Vector<int>& reads = Vector<int>());
+        // each blit pass owns its material, input_names default to u_texture for the first input
+        void AddBlitPass(const String& name, const Vector<int>& inputs, int output, const Ref<Material>& material = Ref<Material>(), const Vector<String>& input_names = Vector<String>());
+        void AddBlitPass(const String& name, int input, int output, const Ref<Material>& material = Ref<Material>());
+        // creates textures and cameras, call again after resize or after changing declarations
+        void Compile();
+        // destroys cameras and textures, declarations are kept
+        void Release();
+        // releases and forgets all declarations
+        void Reset();
+        Camera* GetCamera(const String& pass_name) const;
+        Ref<Texture> GetTexture(int resource) const;
+        int GetNextDepth() const { return m_depth + m_camera_count; }
+        int GetPassCount() const { return m_passes.Size(); }
+        int GetCulledPassCount() const;
+        int GetPhysicalTextureCount() const { return m_physical_textures.Size(); }
+
+    private:
+        enum class PassType
+        {
+            Camera,
+            Blit,
+        };
+
+        struct Resource
+        {
+            String name;
+            RenderGraphTextureDesc desc;
+            Ref<Texture> imported;
+            bool transient;
+            int physical;
+            int first_pass;
+            int last_pass;
+            int ref_count;
+            bool written;
+        };
+
+        struct Pass
+        {
+            String name;
+            PassType type;
+            Vector<int> reads;
+            int color;
+            int depth;
+            CameraSetup setup;
+            Camera* external_camera;
+            Ref<Material> material;
+            Vector<String> input_names;
+            int ref_count;
+            bool culled;
+            Camera* camera;
+        };
+
+        struct PhysicalTexture
+        {
+            Ref<Texture> texture;
+            int width;
+            int height;
+            RenderGraphTextureDesc desc;
+            bool used;
+        };
+
+        void CullPasses();
+        void ComputeLifetimes();
+        void AcquireTexture(int resource);
+        void CreateCamera(Pass& pass, Pass* prev_blit);
+        CameraClearFlags GetClearFlags(Pass& pass);
+
+    private:
+        int m_depth;
+        Vector<Resource> m_resources;
+        Vector<Pass> m_passes;
+        Vector<PhysicalTexture> m_physical_textures;
+        Vector<Camera*> m_cameras;
+        int m_camera_count;
+    };
+}
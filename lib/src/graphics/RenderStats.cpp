@@ -0,0 +1,147 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "RenderStats.h"
+#include "Display.h"
+#include "Camera.h"
+#include "time/Time.h"
+#include "ui/CanvasRenderer.h"
+#include "ui/Label.h"
+#include "ui/Font.h"
+
+#define OVERLAY_CAMERA_DEPTH 0x7fffff
+#define OVERLAY_UPDATE_INTERVAL 0.5f
+
+namespace Viry3D
+{
+    std::atomic<int> RenderStats::m_counters[(int) RenderStat::Count];
+    int RenderStats::m_last_frame[(int) RenderStat::Count];
+    Camera* RenderStats::m_overlay_camera = nullptr;
+    Label* RenderStats::m_overlay_label = nullptr;
+    float RenderStats::m_overlay_update_time = 0;
+
+    void RenderStats::AddDraw(int instance_count, int index_count)
+    {
+        Add(RenderStat::DrawCalls);
+        Add(RenderStat::Instances, instance_count);
+        Add(RenderStat::Triangles, index_count / 3 * instance_count);
+    }
+
+    const char* RenderStats::GetName(RenderStat stat)
+    {
+        static const char* names[(int) RenderStat::Count] = {
+            "draw calls",
+            "instances",
+            "triangles",
+            "pipeline binds",
+            "descriptor set binds",
+            "buffer updates",
+            "buffer update bytes",
+            "texture uploads",
+            "texture upload bytes",
+            "cmds recorded",
+        };
+
+        return names[(int) stat];
+    }
+
+    String RenderStats::GetSummary()
+    {
+        return String::Format(
+            "draws:%d instances:%d triangles:%d\n"
+            "pipelines:%d descriptor sets:%d\n"
+            "buffer updates:%d %.1fKB\n"
+            "texture uploads:%d %.1fKB\n"
+            "cmds recorded:%d",
+            Get(RenderStat::DrawCalls),
+            Get(RenderStat::Instances),
+            Get(RenderStat::Triangles),
+            Get(RenderStat::PipelineBinds),
+            Get(RenderStat::DescriptorSetBinds),
+            Get(RenderStat::BufferUpdates),
+            Get(RenderStat::BufferUpdateBytes) / 1024.0f,
+            Get(RenderStat::TextureUploads),
+            Get(RenderStat::TextureUploadBytes) / 1024.0f,
+            Get(RenderStat::CmdsRecorded));
+    }
+
+    void RenderStats::SetOverlayVisible(bool visible)
+    {
+        if (visible == IsOverlayVisible())
+        {
+            return;
+        }
+
+        if (visible)
+        {
+            m_overlay_camera = Display::Instance()->CreateCamera();
+            m_overlay_camera->SetName("RenderStats");
+            m_overlay_camera->SetDepth(OVERLAY_CAMERA_DEPTH);
+            m_overlay_camera->SetClearFlags(CameraClearFlags::Nothing);
+
+            auto canvas = RefMake<CanvasRenderer>();
+            m_overlay_camera->AddRenderer(canvas);
+
+            auto label = RefMake<Label>();
+            canvas->AddView(label);
+
+            label->SetAlignment(ViewAlignment::Left | ViewAlignment::Bottom);
+            label->SetPivot(Vector2(0, 1));
+            label->SetSize(Vector2i(600, 150));
+            label->SetOffset(Vector2i(20, -20));
+            label->SetFont(Font::GetFont(FontType::Consola));
+            label->SetFontSize(20);
+            label->SetTextAlignment(ViewAlignment::Left | ViewAlignment::Bottom);
+            label->SetText(GetSummary());
+
+            m_overlay_label = label.get();
+            m_overlay_update_time = Time::GetTime();
+        }
+        else
+        {
+            Display::Instance()->DestroyCamera(m_overlay_camera);
+            m_overlay_camera = nullptr;
+            m_overlay_label = nullptr;
+        }
+    }
+
+    void RenderStats::OnFrameEnd()
+    {
+        for (int i = 0; i < (int) RenderStat::Count; ++i)
+        {
+            m_last_frame[i] = m_counters[i].exchange(0, std::memory_order_relaxed);
+        }
+
+        // the overlay counts itself when its text changes, so keep refreshes rare
+        if (m_overlay_label && Time::GetTime() - m_overlay_update_time >= OVERLAY_UPDATE_INTERVAL)
+        {
+            m_overlay_update_time = Time::GetTime();
+            m_overlay_label->SetText(GetSummary());
+        }
+    }
+
+    void RenderStats::Done()
+    {
+        SetOverlayVisible(false);
+
+        for (int i = 0; i < (int) RenderStat::Count; ++i)
+        {
+            m_counters[i] = 0;
+            m_last_frame[i] = 0;
+        }
+    }
+}
@@ -0,0 +1,68 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "string/String.h"
+#include <atomic>
+
+namespace Viry3D
+{
+    class Camera;
+    class Label;
+
+    enum class RenderStat
+    {
+        DrawCalls,
+        Instances,
+        Triangles,
+        PipelineBinds,
+        DescriptorSetBinds,
+        // vulkan texture uploads go through a staging buffer and count here too
+        BufferUpdates,
+        BufferUpdateBytes,
+        TextureUploads,
+        TextureUploadBytes,
+        // vulkan only, recorded cmds are replayed until something marks them dirty
+        CmdsRecorded,
+
+        Count
+    };
+
+    // per frame counters, safe to add from loading threads. values are moved to the last frame in Display::OnDraw.
+    class RenderStats
+    {
+    public:
+        static void Add(RenderStat stat, int value = 1) { m_counters[(int) stat].fetch_add(value, std::memory_order_relaxed); }
+        static void AddDraw(int instance_count, int index_count);
+        static int Get(RenderStat stat) { return m_last_frame[(int) stat]; }
+        static const char* GetName(RenderStat stat);
+        static String GetSummary();
+        // a label on top of all cameras showing the summary, refreshed twice per second
+        static void SetOverlayVisible(bool visible);
+        static bool IsOverlayVisible() { return m_overlay_camera != nullptr; }
+        static void OnFrameEnd();
+        static void Done();
+
+    private:
+        static std::atomic<int> m_counters[(int) RenderStat::Count];
+        static int m_last_frame[(int) RenderStat::Count];
+        static Camera* m_overlay_camera;
+        static Label* m_overlay_label;
+        static float m_overlay_update_time;
+    };
+}
@@ -0,0 +1,158 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "RenderTexturePool.h"
+#include "time/Time.h"
+
+namespace Viry3D
+{
+    Map<Texture*, RenderTexturePool::Entry> RenderTexturePool::m_used;
+    Vector<RenderTexturePool::Entry> RenderTexturePool::m_idle;
+    float RenderTexturePool::m_idle_timeout = 3.0f;
+    RenderTexturePoolStats RenderTexturePool::m_stats;
+
+    int RenderTexturePool::GetBytes(const Key& key)
+    {
+        int pixel_size = 4;
+        switch (key.format)
+        {
+            case TextureFormat::R8:
+            case TextureFormat::S8:
+                pixel_size = 1;
+                break;
+            case TextureFormat::R8G8:
+            case TextureFormat::D16:
+                pixel_size = 2;
+                break;
+            case TextureFormat::R32G32B32A32F:
+                pixel_size = 16;
+                break;
+            case TextureFormat::D32S8:
+                pixel_size = 8;
+                break;
+            default:
+                break;
+        }
+
+        return key.width * key.height * key.sample_count * pixel_size;
+    }
+
+    Ref<Texture> RenderTexturePool::Acquire(
+        int width,
+        int height,
+        TextureFormat format,
+        int sample_count,
+        bool create_sampler,
+        FilterMode filter_mode,
+        SamplerAddressMode wrap_mode)
+    {
+        Key key;
+        key.width = width;
+        key.height = height;
+        key.format = format;
+        key.sample_count = sample_count;
+        key.create_sampler = create_sampler;
+        key.filter_mode = filter_mode;
+        key.wrap_mode = wrap_mode;
+
+        int frame = Time::GetFrameCount();
+
+        for (int i = 0; i < m_idle.Size(); ++i)
+        {
+            // released in this frame, an earlier camera may still draw into it
+            if (m_idle[i].key == key && m_idle[i].release_frame < frame)
+            {
+                Entry entry = m_idle[i];
+                m_idle.Remove(i);
+                m_used.Add(entry.texture.get(), entry);
+
+                m_stats.reused += 1;
+                m_stats.idle_count -= 1;
+                m_stats.idle_bytes -= entry.bytes;
+                m_stats.used_count += 1;
+                m_stats.used_bytes += entry.bytes;
+
+                return entry.texture;
+            }
+        }
+
+        Entry entry;
+        entry.key = key;
+        entry.texture = Texture::CreateRenderTexture(
+            width,
+            height,
+            format,
+            sample_count,
+            create_sampler,
+            filter_mode,
+            wrap_mode);
+        entry.bytes = GetBytes(key);
+        entry.release_frame = -1;
+        entry.release_time = 0;
+        m_used.Add(entry.texture.get(), entry);
+
+        m_stats.created += 1;
+        m_stats.used_count += 1;
+        m_stats.used_bytes += entry.bytes;
+
+        return entry.texture;
+    }
+
+    void RenderTexturePool::Release(const Ref<Texture>& texture, bool immediate)
+    {
+        Entry* entry;
+        if (!texture || !m_used.TryGet(texture.get(), &entry))
+        {
+            return;
+        }
+
+        entry->release_frame = immediate ? -1 : Time::GetFrameCount();
+        entry->release_time = Time::GetTime();
+        m_idle.Add(*entry);
+
+        m_stats.used_count -= 1;
+        m_stats.used_bytes -= entry->bytes;
+        m_stats.idle_count += 1;
+        m_stats.idle_bytes += entry->bytes;
+
+        m_used.Remove(texture.get());
+    }
+
+    void RenderTexturePool::OnFrameEnd()
+    {
+        float time = Time::GetTime();
+
+        for (int i = m_idle.Size() - 1; i >= 0; --i)
+        {
+            if (time - m_idle[i].release_time > m_idle_timeout)
+            {
+                m_stats.evicted += 1;
+                m_stats.idle_count -= 1;
+                m_stats.idle_bytes -= m_idle[i].bytes;
+
+                m_idle.Remove(i);
+            }
+        }
+    }
+
+    void RenderTexturePool::Done()
+    {
+        m_used.Clear();
+        m_idle.Clear();
+        m_stats = RenderTexturePoolStats();
+    }
+}
@@ -0,0 +1,98 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "Texture.h"
+#include "container/Vector.h"
+#include "container/Map.h"
+
+namespace Viry3D
+{
+    struct RenderTexturePoolStats
+    {
+        int created = 0;
+        int reused = 0;
+        int evicted = 0;
+        int used_count = 0;
+        int idle_count = 0;
+        int used_bytes = 0;
+        int idle_bytes = 0;
+    };
+
+    // keeps released render textures keyed by size, format, samples and sampler state.
+    // a released texture can be acquired again from the next frame on, and is destroyed after staying idle for the timeout.
+    class RenderTexturePool
+    {
+    public:
+        static Ref<Texture> Acquire(
+            int width,
+            int height,
+            TextureFormat format,
+            int sample_count = 1,
+            bool create_sampler = true,
+            FilterMode filter_mode = FilterMode::Linear,
+            SamplerAddressMode wrap_mode = SamplerAddressMode::ClampToEdge);
+        // immediate makes it reusable in this frame, for callers that destroyed the cameras drawing into it
+        static void Release(const Ref<Texture>& texture, bool immediate = false);
+        static void OnFrameEnd();
+        static void Done();
+        static float GetIdleTimeout() { return m_idle_timeout; }
+        static void SetIdleTimeout(float seconds) { m_idle_timeout = seconds; }
+        static const RenderTexturePoolStats& GetStats() { return m_stats; }
+
+    private:
+        struct Key
+        {
+            int width;
+            int height;
+            TextureFormat format;
+            int sample_count;
+            bool create_sampler;
+            FilterMode filter_mode;
+            SamplerAddressMode wrap_mode;
+
+            bool operator ==(const Key& key) const
+            {
+                return width == key.width &&
+                    height == key.height &&
+                    format == key.format &&
+                    sample_count == key.sample_count &&
+                    create_sampler == key.create_sampler &&
+                    filter_mode == key.filter_mode &&
+                    wrap_mode == key.wrap_mode;
+            }
+        };
+
+        struct Entry
+        {
+            Key key;
+            Ref<Texture> texture;
+            int bytes;
+            int release_frame;
+            float release_time;
+        };
+
+        static int GetBytes(const Key& key);
+
+    private:
+        static Map<Texture*, Entry> m_used;
+        static Vector<Entry> m_idle;
+        static float m_idle_timeout;
+        static RenderTexturePoolStats m_stats;
+    };
+}
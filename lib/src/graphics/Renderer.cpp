@@ -20,16 +20,24 @@
 #include "Material.h"
 #include "Shader.h"
 #include "BufferObject.h"
+#include "RenderStats.h"
 #include "Debug.h"
 
 namespace Viry3D
 {
     Renderer::Renderer():
+#if VR_VULKAN
+        m_draw_index_count(0),
+        m_draw_instance_count(0),
+#endif
         m_draw_buffer_dirty(true),
+        m_culled(false),
 		m_camera(nullptr),
         m_model_matrix_dirty(true),
         m_instance_buffer_dirty(false),
-        m_instance_extra_vector_count(0)
+        m_instance_extra_vector_count(0),
+        m_cast_shadow(true),
+        m_receive_shadow(true)
     {
     
     }
@@ -97,6 +105,11 @@ namespace Viry3D
                         case MaterialProperty::Type::Int:
                             m_instance_material->SetInt(i.second.name, *(int*) &i.second.data);
                             break;
+                        case MaterialProperty::Type::StorageBuffer:
+#if VR_VULKAN
+                            m_instance_material->SetStorageBuffer(i.second.name, i.second.buffer);
+#endif
+                            break;
                     }
                 }
             }
@@ -149,6 +162,15 @@ namespace Viry3D
     }
 #endif
 
+    void Renderer::SetCulled(bool culled)
+    {
+        if (m_culled != culled)
+        {
+            m_culled = culled;
+            m_draw_buffer_dirty = true;
+        }
+    }
+
     void Renderer::OnMatrixDirty()
     {
         m_model_matrix_dirty = true;
@@ -213,6 +235,47 @@ namespace Viry3D
         }
     }
 
+    void Renderer::SetInstanceVector(const String& name, const Vector4& vector)
+    {
+        if (m_material)
+        {
+            if (!m_instance_material)
+            {
+                m_instance_material = RefMake<Material>(m_material->GetShader());
+            }
+
+            m_instance_material->SetVector(name, vector);
+        }
+    }
+
+    void Renderer::SetInstanceTexture(const String& name, const Ref<Texture>& texture)
+    {
+        if (m_material)
+        {
+            if (!m_instance_material)
+            {
+                m_instance_material = RefMake<Material>(m_material->GetShader());
+            }
+
+            m_instance_material->SetTexture(name, texture);
+        }
+    }
+
+#if VR_VULKAN
+    void Renderer::SetInstanceStorageBuffer(const String& name, const Ref<BufferObject>& buffer)
+    {
+        if (m_material)
+        {
+            if (!m_instance_material)
+            {
+                m_instance_material = RefMake<Material>(m_material->GetShader());
+            }
+
+            m_instance_material->SetStorageBuffer(name, buffer);
+        }
+    }
+#endif
+
 #if VR_GLES
     void Renderer::OnDraw()
     {
@@ -231,20 +294,24 @@ namespace Viry3D
         {
             return;
         }
+        RenderStats::Add(RenderStat::PipelineBinds);
 
         vertex_buffer->Bind();
         index_buffer->Bind();
         shader->EnableVertexAttribs();
         shader->ApplyRenderState();
-        material->ApplyUniforms();
+        int texture_unit = material->ApplyUniforms();
+        RenderStats::Add(RenderStat::DescriptorSetBinds);
 
         const Ref<Material>& instance_material = this->GetInstanceMaterial();
         if (instance_material)
         {
-            instance_material->ApplyUniforms();
+            instance_material->ApplyUniforms(texture_unit);
+            RenderStats::Add(RenderStat::DescriptorSetBinds);
         }
 
         glDrawElements(GL_TRIANGLES, draw_buffer.index_count, GL_UNSIGNED_SHORT, (const void*) (draw_buffer.first_index * sizeof(unsigned short)));
+        RenderStats::AddDraw(1, draw_buffer.index_count);
 
         shader->DisableVertexAttribs();
         vertex_buffer->Unind();
@@ -29,6 +29,7 @@ namespace Viry3D
     class Material;
     class Camera;
     class BufferObject;
+    class Texture;
 
 #if VR_GLES
     struct DrawBuffer
@@ -55,6 +56,8 @@ namespace Viry3D
         virtual Ref<BufferObject> GetIndexBuffer() const = 0;
 #if VR_VULKAN
         Ref<BufferObject> GetDrawBuffer() const { return m_draw_buffer; }
+        int GetDrawIndexCount() const { return m_draw_index_count; }
+        int GetDrawInstanceCount() const { return m_draw_instance_count; }
 #elif VR_GLES
         const DrawBuffer& GetDrawBuffer() const { return m_draw_buffer; }
 #endif
@@ -79,12 +82,26 @@ namespace Viry3D
         void SetInstanceExtraVector(int instance_index, int vector_index, const Vector4& v);
         int GetInstanceCount() const;
         int GetInstanceStride() const;
+        bool IsCastShadow() const { return m_cast_shadow; }
+        void SetCastShadow(bool enable) { m_cast_shadow = enable; }
+        bool IsReceiveShadow() const { return m_receive_shadow; }
+        void SetReceiveShadow(bool enable) { m_receive_shadow = enable; }
+        bool IsCulled() const { return m_culled; }
+        // a culled renderer keeps its cmd but draws nothing
+        void SetCulled(bool culled);
+        // pixels the renderer spans on the camera target, texture streaming picks mip levels from it, negative when unknown
+        virtual float GetScreenSize(Camera* camera) { return -1; }
 
     protected:
         virtual void OnMatrixDirty();
         virtual void UpdateDrawBuffer() = 0;
         void SetInstanceMatrix(const String& name, const Matrix4x4& mat);
         void SetInstanceVectorArray(const String& name, const Vector<Vector4>& array);
+        void SetInstanceVector(const String& name, const Vector4& vector);
+        void SetInstanceTexture(const String& name, const Ref<Texture>& texture);
+#if VR_VULKAN
+        void SetInstanceStorageBuffer(const String& name, const Ref<BufferObject>& buffer);
+#endif
 
     private:
         void UpdateInstanceBuffer();
@@ -92,10 +109,14 @@ namespace Viry3D
     protected:
 #if VR_VULKAN
         Ref<BufferObject> m_draw_buffer;
+        // cpu copy of the indirect draw for render stats
+        int m_draw_index_count;
+        int m_draw_instance_count;
 #elif VR_GLES
         DrawBuffer m_draw_buffer;
 #endif
         bool m_draw_buffer_dirty;
+        bool m_culled;
 
     private:
         Ref<Material> m_material;
@@ -106,5 +127,7 @@ namespace Viry3D
         Ref<BufferObject> m_instance_buffer;
         bool m_instance_buffer_dirty;
         int m_instance_extra_vector_count;
+        bool m_cast_shadow;
+        bool m_receive_shadow;
     };
 }
@@ -22,6 +22,15 @@
 #include "io/File.h"
 #include "Debug.h"
 
+#if VR_VULKAN
+#include "vulkan/spirv_cross/spirv_glsl.hpp"
+
+extern "C"
+{
+#include "crypto/md5/md5.h"
+}
+#endif
+
 namespace Viry3D
 {
     List<Shader*> Shader::m_shaders;
@@ -207,6 +216,192 @@ namespace Viry3D
             descriptor_sets);
         uniform_sets = m_uniform_sets;
     }
+
+    String Shader::ProcessSource(VkShaderStageFlagBits stage, const String& glsl, const String& predefine, const Vector<String>& includes, const String& include_dir)
+    {
+        static const String s_shader_header =
+            "#version 310 es\n"
+            "#extension GL_ARB_separate_shader_objects : enable\n"
+            "#extension GL_ARB_shading_language_420pack : enable\n"
+            "#define VR_VULKAN 1\n"
+            "#define UniformBuffer(set_index, binding_index) layout(std140, set = set_index, binding = binding_index)\n"
+            "#define UniformTexture(set_index, binding_index) layout(set = set_index, binding = binding_index)\n"
+            "#define StorageBuffer(set_index, binding_index) layout(std430, set = set_index, binding = binding_index)\n"
+            "#define Input(location_index) layout(location = location_index) in\n"
+            "#define Output(location_index) layout(location = location_index) out\n";
+
+        String source = s_shader_header;
+        source += predefine + "\n";
+
+        Vector<String> stage_includes;
+        if (stage == VK_SHADER_STAGE_VERTEX_BIT)
+        {
+            stage_includes.Add("Base.in");
+        }
+        if (includes.Size() > 0)
+        {
+            stage_includes.AddRange(&includes[0], includes.Size());
+        }
+
+        for (const auto& i : stage_includes)
+        {
+            auto include_path = include_dir + "/" + i;
+            auto bytes = File::ReadAllBytes(include_path);
+            auto include_str = String(bytes);
+            source += include_str + "\n";
+        }
+        source += glsl;
+
+        return source;
+    }
+
+    String Shader::GetSpirvName(const String& glsl)
+    {
+        unsigned char hash_bytes[16];
+        MD5_CTX md5_context;
+        MD5_Init(&md5_context);
+        MD5_Update(&md5_context, (void*) glsl.CString(), glsl.Size());
+        MD5_Final(hash_bytes, &md5_context);
+        String md5_str;
+        for (int i = 0; i < sizeof(hash_bytes); ++i)
+        {
+            md5_str += String::Format("%02x", hash_bytes[i]);
+        }
+
+        return md5_str;
+    }
+
+    static UniformSet* GetUniformSet(Vector<UniformSet>& uniform_sets, int set)
+    {
+        for (int i = 0; i < uniform_sets.Size(); ++i)
+        {
+            if (set == uniform_sets[i].set)
+            {
+                return &uniform_sets[i];
+            }
+        }
+
+        uniform_sets.Add(UniformSet());
+        UniformSet* set_ptr = &uniform_sets[uniform_sets.Size() - 1];
+        set_ptr->set = set;
+
+        return set_ptr;
+    }
+
+    void Shader::Reflect(const Vector<unsigned int>& spirv, VkShaderStageFlagBits stage, Vector<VertexAttribute>& attributes, Vector<UniformSet>& uniform_sets)
+    {
+        spirv_cross::CompilerGLSL compiler(&spirv[0], spirv.Size());
+        spirv_cross::ShaderResources resources = compiler.get_shader_resources();
+
+        if (stage == VK_SHADER_STAGE_VERTEX_BIT)
+        {
+            for (const auto& resource : resources.stage_inputs)
+            {
+                uint32_t location = compiler.get_decoration(resource.id, spv::DecorationLocation);
+                const std::string& name = compiler.get_name(resource.id);
+                const auto& type = compiler.get_type(resource.type_id);
+
+                assert(type.basetype == spirv_cross::SPIRType::Float);
+                assert(type.array.size() == 0);
+
+                VertexAttribute attr;
+                attr.location = location;
+                attr.name = name.c_str();
+                attr.vector_size = type.vecsize;
+
+                attributes.Add(attr);
+            }
+        }
+
+        for (const auto& resource : resources.uniform_buffers)
+        {
+            uint32_t set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
+            uint32_t binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
+            const std::string& name = compiler.get_name(resource.id);
+
+            UniformBuffer buffer;
+            buffer.name = name.c_str();
+            buffer.binding = (int) binding;
+            buffer.stage = stage;
+
+            const spirv_cross::SPIRType& type = compiler.get_type(resource.base_type_id);
+
+            int max_offset_member = -1;
+            int max_offset = -1;
+            for (size_t i = 0; i < type.member_types.size(); ++i)
+            {
+                const std::string& member_name = compiler.get_member_name(type.self, (uint32_t) i);
+                int member_offset = (int) compiler.type_struct_member_offset(type, (uint32_t) i);
+                int member_size = (int) compiler.get_declared_struct_member_size(type, (uint32_t) i);
+
+                UniformMember member;
+                member.name = member_name.c_str();
+                member.offset = member_offset;
+                member.size = member_size;
+
+                buffer.members.Add(member);
+
+                if (member.offset > max_offset)
+                {
+                    max_offset = member.offset;
+                    max_offset_member = (int) i;
+                }
+            }
+
+            buffer.size = buffer.members[max_offset_member].offset + buffer.members[max_offset_member].size;
+
+            GetUniformSet(uniform_sets, (int) set)->buffers.Add(buffer);
+        }
+
+        for (const auto& resource : resources.sampled_images)
+        {
+            uint32_t set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
+            uint32_t binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
+            const std::string& name = resource.name;
+
+            UniformTexture texture;
+            texture.name = name.c_str();
+            texture.binding = (int) binding;
+            texture.stage = stage;
+
+            GetUniformSet(uniform_sets, (int) set)->textures.Add(texture);
+        }
+
+        for (const auto& resource : resources.storage_buffers)
+        {
+            uint32_t set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
+            uint32_t binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
+            const spirv_cross::SPIRType& type = compiler.get_type(resource.base_type_id);
+            assert(type.member_types.size() == 1);
+            const std::string& name = compiler.get_member_name(type.self, 0);
+
+            UniformStorageBuffer storage_buffer;
+            storage_buffer.name = name.c_str();
+            storage_buffer.binding = (int) binding;
+            storage_buffer.stage = stage;
+
+            GetUniformSet(uniform_sets, (int) set)->storage_buffers.Add(storage_buffer);
+        }
+    }
+
+    void Shader::SortUniformSets(Vector<UniformSet>& uniform_sets)
+    {
+        List<UniformSet*> sets;
+        for (int i = 0; i < uniform_sets.Size(); ++i)
+        {
+            sets.AddLast(&uniform_sets[i]);
+        }
+        sets.Sort([](const UniformSet* a, const UniformSet* b) {
+            return a->set < b->set;
+        });
+
+        Vector<UniformSet> sets_sorted;
+        for (auto i : sets)
+        {
+            sets_sorted.Add(*i);
+        }
+        uniform_sets = sets_sorted;
+    }
 #elif VR_GLES
     static String ProcessShaderSource(const String& glsl, const String& predefine, const Vector<String>& includes)
     {
@@ -231,6 +426,11 @@ namespace Viry3D
         String source = shader_header;
         source += predefine + "\n";
 
+        if (Display::Instance()->IsGLESv3())
+        {
+            source += "#define VR_GLES3 1\n";
+        }
+
         for (const auto& i : includes)
         {
             auto include_path = Application::Instance()->GetDataPath() + "/shader/Include/" + i;
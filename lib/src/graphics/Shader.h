@@ -54,6 +54,13 @@ namespace Viry3D
         VkPipeline GetPipeline(VkRenderPass render_pass, bool color_attachment, bool depth_attachment, int sample_count, bool instancing, int instance_stride);
         void CreateDescriptorSets(Vector<VkDescriptorSet>& descriptor_sets, Vector<UniformSet>& uniform_sets);
         VkPipelineLayout GetPipelineLayout() const { return m_pipeline_layout; }
+        // the glsl the vulkan backend compiles, vertex sources get Base.in first. the asset cooker builds the same text
+        static String ProcessSource(VkShaderStageFlagBits stage, const String& glsl, const String& predefine, const Vector<String>& includes, const String& include_dir);
+        // md5 of a processed source, names the spir-v in the save path cache and the cooked shader/Cache of the data
+        static String GetSpirvName(const String& glsl);
+        static void Reflect(const Vector<unsigned int>& spirv, VkShaderStageFlagBits stage, Vector<VertexAttribute>& attributes, Vector<UniformSet>& uniform_sets);
+        // by set number, the order of the descriptor set layouts and of the uniform sets a material gets
+        static void SortUniformSets(Vector<UniformSet>& uniform_sets);
 #elif VR_GLES
         bool Use() const;
         void EnableVertexAttribs() const;
@@ -16,19 +16,25 @@
 */
 
 #include "SkinnedMeshRenderer.h"
+#include "BonePalette.h"
+#include "SkinningPrePass.h"
 #include "Mesh.h"
 #include "Debug.h"
 
 namespace Viry3D
 {
-    SkinnedMeshRenderer::SkinnedMeshRenderer()
+    SkinnedMeshRenderer::SkinnedMeshRenderer():
+        m_palette_offset(-1),
+        m_palette_bone_count(0),
+        m_palette_info(-1, 0, 0, 0),
+        m_skinning_pre_pass_enable(false)
     {
 
     }
 
     SkinnedMeshRenderer::~SkinnedMeshRenderer()
     {
-
+        BonePalette::Free(m_palette_offset, m_palette_bone_count);
     }
 
     void SkinnedMeshRenderer::FindBones()
@@ -51,52 +57,283 @@ namespace Viry3D
         }
     }
 
-    void SkinnedMeshRenderer::Update()
+    void SkinnedMeshRenderer::SetBones(const Vector<Ref<Node>>& bones)
     {
-        const auto& material = this->GetMaterial();
-        const auto& mesh = this->GetMesh();
+        m_bones.Resize(bones.Size());
+        for (int i = 0; i < m_bones.Size(); ++i)
+        {
+            m_bones[i] = bones[i];
+
+            if (!bones[i] && i < m_bone_paths.Size())
+            {
+                Log("can not find bone: %s", m_bone_paths[i].CString());
+            }
+        }
+    }
 
-        if (material && mesh && m_bone_paths.Size() > 0)
+    Ref<Node> SkinnedMeshRenderer::Clone() const
+    {
+        Ref<SkinnedMeshRenderer> renderer = RefMake<SkinnedMeshRenderer>();
+        this->CopyTo(renderer.get());
+        renderer->SetBonePaths(m_bone_paths);
+        renderer->SetSkinningPrePass(m_skinning_pre_pass_enable);
+        return renderer;
+    }
+
+    void SkinnedMeshRenderer::OnInstantiate(Node* source, const Map<Node*, Ref<Node>>& copies)
+    {
+        SkinnedMeshRenderer* renderer = (SkinnedMeshRenderer*) source;
+        const Ref<Node>* copy;
+
+        Ref<Node> root = renderer->m_bones_root.lock();
+        if (root && copies.TryGet(root.get(), &copy))
         {
-            const auto& bindposes = mesh->GetBindposes();
-            int bone_count = bindposes.Size();
+            // bones are found by path once on the source, the copies reuse them through the node map
+            if (renderer->m_bones.Empty() && renderer->m_bone_paths.Size() > 0)
+            {
+                renderer->FindBones();
+            }
 
-#if VR_GLES
-            int bone_max;
-            if (Display::Instance()->IsGLESv3())
+            m_bones_root = *copy;
+            m_bones.Resize(renderer->m_bones.Size());
+            for (int i = 0; i < m_bones.Size(); ++i)
             {
-                bone_max = 70;
+                Ref<Node> bone = renderer->m_bones[i].lock();
+                if (bone && copies.TryGet(bone.get(), &copy))
+                {
+                    m_bones[i] = *copy;
+                }
+            }
+        }
+        else
+        {
+            m_bones_root = root;
+        }
+
+        Ref<SkinnedMeshRenderer> skinning_source = renderer->m_skinning_source.lock();
+        if (skinning_source)
+        {
+            if (copies.TryGet(skinning_source.get(), &copy))
+            {
+                this->SetSkinningSource(RefCast<SkinnedMeshRenderer>(*copy));
             }
             else
             {
-                bone_max = 30;
+                this->SetSkinningSource(skinning_source);
+            }
+        }
+    }
+
+    Ref<BufferObject> SkinnedMeshRenderer::GetVertexBuffer() const
+    {
+        if (!m_skinning_source.expired())
+        {
+            return m_skinning_source_buffer;
+        }
+
+        if (m_skinning_pre_pass)
+        {
+            return m_skinning_pre_pass->GetVertexBuffer();
+        }
+
+        return MeshRenderer::GetVertexBuffer();
+    }
+
+    void SkinnedMeshRenderer::Update()
+    {
+        const auto& material = this->GetMaterial();
+        const auto& mesh = this->GetMesh();
+        auto source = m_skinning_source.lock();
+
+        if (source)
+        {
+            Ref<BufferObject> vertex_buffer = source->GetVertexBuffer();
+            if (m_skinning_source_buffer != vertex_buffer)
+            {
+                m_skinning_source_buffer = vertex_buffer;
+#if VR_VULKAN
+                this->MarkInstanceCmdDirty();
+#endif
             }
-#else
-            const int bone_max = 70;
-#endif  
+        }
+        else if (material && mesh && m_bone_paths.Size() > 0)
+        {
+            const auto& bindposes = mesh->GetBindposes();
+            int bone_count = bindposes.Size();
 
             assert(m_bone_paths.Size() == bone_count);
-            assert(m_bone_paths.Size() <= bone_max);
 
             if (m_bones.Empty())
             {
                 this->FindBones();
             }
 
-            Vector<Vector4> bone_vectors(bone_count * 3);
+            Vector<Vector4> bone_vectors(bone_count * BONE_VECTOR_COUNT);
+
+            bool pre_pass = m_skinning_pre_pass_enable && SkinningPrePass::IsSupported(mesh);
+            if (!pre_pass && m_skinning_pre_pass)
+            {
+                m_skinning_pre_pass.reset();
+#if VR_VULKAN
+                this->MarkInstanceCmdDirty();
+#endif
+            }
+
+            // pre-pass vertices stay in renderer space so the static shader applies the model matrix
+            Matrix4x4 world_to_local = Matrix4x4::Identity();
+            if (pre_pass)
+            {
+                world_to_local = this->GetLocalToWorldMatrix().Inverse();
+            }
 
             for (int i = 0; i < bone_count; ++i)
             {
-                Matrix4x4 mat = m_bones[i].lock()->GetLocalToWorldMatrix() * bindposes[i];
+                Matrix4x4 mat = world_to_local * m_bones[i].lock()->GetLocalToWorldMatrix() * bindposes[i];
 
                 bone_vectors[i * 3 + 0] = mat.GetRow(0);
                 bone_vectors[i * 3 + 1] = mat.GetRow(1);
                 bone_vectors[i * 3 + 2] = mat.GetRow(2);
             }
 
-            this->SetInstanceVectorArray("u_bones", bone_vectors);
+            if (pre_pass)
+            {
+                this->UpdateSkinningPrePass(bone_vectors);
+            }
+#if VR_GLES
+            else if (!Display::Instance()->IsGLESv3())
+            {
+                assert(bone_count <= BONE_MAX_GLESV2);
+
+                this->SetInstanceVectorArray("u_bones", bone_vectors);
+            }
+            else
+#endif
+            {
+                this->UpdateBonePalette(bone_vectors);
+            }
         }
 
         MeshRenderer::Update();
     }
+
+    void SkinnedMeshRenderer::UpdateBonePalette(const Vector<Vector4>& bone_vectors)
+    {
+        int bone_count = bone_vectors.Size() / BONE_VECTOR_COUNT;
+
+        if (m_palette_bone_count != bone_count)
+        {
+            BonePalette::Free(m_palette_offset, m_palette_bone_count);
+            m_palette_offset = BonePalette::Alloc(bone_count);
+            m_palette_bone_count = bone_count;
+
+            for (int i = 0; i < m_instance_palettes.Size(); ++i)
+            {
+                if (m_instance_palettes[i] >= 0)
+                {
+                    this->SetInstanceBonePalette(i, m_instance_palettes[i]);
+                }
+            }
+        }
+
+        if (this->GetInstanceCount() > 1 && m_instance_palettes.Empty())
+        {
+            // instanced skinning reads a palette delta from extra vector 0
+            m_instance_palettes.Resize(1, -1);
+            this->SetInstanceExtraVector(0, 0, Vector4(0, 0, 0, 0));
+        }
+
+        BonePalette::SetBones(m_palette_offset, bone_vectors);
+
+        Vector4 palette_info((float) m_palette_offset, (float) BonePalette::GetTextureWidth(), (float) BonePalette::GetTextureHeight(), 0);
+        if (m_palette_info != palette_info)
+        {
+            m_palette_info = palette_info;
+            this->SetInstanceVector(BONE_PALETTE_INFO, m_palette_info);
+        }
+
+#if VR_VULKAN
+        if (m_palette_buffer != BonePalette::GetBuffer())
+        {
+            m_palette_buffer = BonePalette::GetBuffer();
+            this->SetInstanceStorageBuffer(BONE_PALETTE, m_palette_buffer);
+        }
+#elif VR_GLES
+        if (m_palette_texture != BonePalette::GetTexture())
+        {
+            m_palette_texture = BonePalette::GetTexture();
+            this->SetInstanceTexture(BONE_PALETTE, m_palette_texture);
+        }
+#endif
+    }
+
+    void SkinnedMeshRenderer::UpdateSkinningPrePass(const Vector<Vector4>& bone_vectors)
+    {
+        const auto& mesh = this->GetMesh();
+
+        if (!m_skinning_pre_pass || m_skinning_pre_pass->GetMesh() != mesh)
+        {
+            m_skinning_pre_pass = RefMake<SkinningPrePass>(mesh);
+#if VR_VULKAN
+            this->MarkInstanceCmdDirty();
+#endif
+        }
+
+#if VR_VULKAN
+        int bone_count = bone_vectors.Size() / BONE_VECTOR_COUNT;
+
+        if (m_palette_bone_count != bone_count)
+        {
+            BonePalette::Free(m_palette_offset, m_palette_bone_count);
+            m_palette_offset = BonePalette::Alloc(bone_count);
+            m_palette_bone_count = bone_count;
+        }
+
+        BonePalette::SetBones(m_palette_offset, bone_vectors);
+#endif
+
+        m_skinning_pre_pass->Skin(m_palette_offset, bone_vectors);
+    }
+
+    void SkinnedMeshRenderer::SetSkinningPrePass(bool enable)
+    {
+        if (m_skinning_pre_pass_enable == enable)
+        {
+            return;
+        }
+
+        m_skinning_pre_pass_enable = enable;
+
+        if (!m_skinning_pre_pass_enable)
+        {
+            m_skinning_pre_pass.reset();
+#if VR_VULKAN
+            this->MarkInstanceCmdDirty();
+#endif
+        }
+    }
+
+    void SkinnedMeshRenderer::SetSkinningSource(const Ref<SkinnedMeshRenderer>& source)
+    {
+        assert(!source || source->IsSkinningPrePass());
+
+        m_skinning_source = source;
+        m_skinning_source_buffer.reset();
+#if VR_VULKAN
+        this->MarkInstanceCmdDirty();
+#endif
+    }
+
+    void SkinnedMeshRenderer::SetInstanceBonePalette(int instance_index, int palette_offset)
+    {
+        if (m_instance_palettes.Size() < instance_index + 1)
+        {
+            m_instance_palettes.Resize(instance_index + 1, -1);
+        }
+        m_instance_palettes[instance_index] = palette_offset;
+
+        if (m_palette_offset >= 0)
+        {
+            this->SetInstanceExtraVector(instance_index, 0, Vector4((float) (palette_offset - m_palette_offset)));
+        }
+    }
 }
@@ -21,23 +21,55 @@
 
 namespace Viry3D
 {
+    class SkinningPrePass;
+
     class SkinnedMeshRenderer : public MeshRenderer
     {
     public:
         SkinnedMeshRenderer();
         virtual ~SkinnedMeshRenderer();
         virtual void Update();
+        virtual Ref<BufferObject> GetVertexBuffer() const;
         const Vector<String>& GetBonePaths() const { return m_bone_paths; }
         void SetBonePaths(const Vector<String>& bones) { m_bone_paths = bones; }
         Ref<Node> GetBonesRoot() const { return m_bones_root.lock(); }
         void SetBonesRoot(const Ref<Node>& node) { m_bones_root = node; }
+        // bones found ahead, e.g. from a cooked prefab, instead of by path on the first update
+        void SetBones(const Vector<Ref<Node>>& bones);
+        int GetBonePaletteOffset() const { return m_palette_offset; }
+        void SetInstanceBonePalette(int instance_index, int palette_offset);
+        // skin once per frame into a vertex buffer drawn with a non skinned shader, instance palettes are ignored.
+        // on gles the vertices are read back from the mesh file, a mesh not loaded from one keeps palette skinning
+        void SetSkinningPrePass(bool enable);
+        bool IsSkinningPrePass() const { return m_skinning_pre_pass_enable; }
+        // draw from the pre-pass buffer of another renderer instead of skinning again, e.g. for a shadow camera
+        void SetSkinningSource(const Ref<SkinnedMeshRenderer>& source);
+
+    protected:
+        virtual Ref<Node> Clone() const;
+        virtual void OnInstantiate(Node* source, const Map<Node*, Ref<Node>>& copies);
 
     private:
         void FindBones();
+        void UpdateBonePalette(const Vector<Vector4>& bone_vectors);
+        void UpdateSkinningPrePass(const Vector<Vector4>& bone_vectors);
 
     private:
         Vector<String> m_bone_paths;
         WeakRef<Node> m_bones_root;
         Vector<WeakRef<Node>> m_bones;
+        Vector<int> m_instance_palettes;
+        int m_palette_offset;
+        int m_palette_bone_count;
+        Vector4 m_palette_info;
+        bool m_skinning_pre_pass_enable;
+        Ref<SkinningPrePass> m_skinning_pre_pass;
+        WeakRef<SkinnedMeshRenderer> m_skinning_source;
+        Ref<BufferObject> m_skinning_source_buffer;
+#if VR_VULKAN
+        Ref<BufferObject> m_palette_buffer;
+#elif VR_GLES
+        Ref<Texture> m_palette_texture;
+#endif
     };
 }
@@ -0,0 +1,440 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SkinningPrePass.h"
+#include "BonePalette.h"
+#include "BufferObject.h"
+#include "Mesh.h"
+#include "Debug.h"
+#include "memory/Memory.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define VR_SKINNING_SSE 1
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define VR_SKINNING_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define SKINNING_GROUP_SIZE 64
+
+namespace Viry3D
+{
+#if VR_VULKAN
+    VkShaderModule SkinningPrePass::m_shader_module = VK_NULL_HANDLE;
+    Vector<UniformSet> SkinningPrePass::m_shader_uniform_sets;
+    Vector<VkDescriptorSetLayout> SkinningPrePass::m_descriptor_layouts;
+    VkPipelineLayout SkinningPrePass::m_pipeline_layout = VK_NULL_HANDLE;
+    VkPipeline SkinningPrePass::m_pipeline = VK_NULL_HANDLE;
+    VkDescriptorPool SkinningPrePass::m_descriptor_pool = VK_NULL_HANDLE;
+    List<SkinningPrePass*> SkinningPrePass::m_passes;
+
+    static const char* SKINNING_CS = R"(
+layout(local_size_x = SKINNING_GROUP_SIZE) in;
+
+StorageBuffer(0, 0) readonly buffer StorageBuffer00
+{
+    float u_source_vertices[];
+} buf_0_0;
+
+StorageBuffer(0, 1) buffer StorageBuffer01
+{
+    float u_skinned_vertices[];
+} buf_0_1;
+
+StorageBuffer(0, 2) readonly buffer StorageBuffer02
+{
+    vec4 u_bone_palette[];
+} buf_0_2;
+
+UniformBuffer(0, 3) uniform UniformBuffer03
+{
+    vec4 u_skinning_info;
+} buf_0_3;
+
+vec4 source_vec4(int offset)
+{
+    return vec4(
+        buf_0_0.u_source_vertices[offset + 0],
+        buf_0_0.u_source_vertices[offset + 1],
+        buf_0_0.u_source_vertices[offset + 2],
+        buf_0_0.u_source_vertices[offset + 3]);
+}
+
+void skinned_vec3(int offset, vec3 v)
+{
+    buf_0_1.u_skinned_vertices[offset + 0] = v.x;
+    buf_0_1.u_skinned_vertices[offset + 1] = v.y;
+    buf_0_1.u_skinned_vertices[offset + 2] = v.z;
+}
+
+void main()
+{
+    int index = int(gl_GlobalInvocationID.x);
+    if (index >= int(buf_0_3.u_skinning_info.y))
+    {
+        return;
+    }
+
+    int base = index * VERTEX_STRIDE;
+    for (int i = 0; i < VERTEX_STRIDE; ++i)
+    {
+        buf_0_1.u_skinned_vertices[base + i] = buf_0_0.u_source_vertices[base + i];
+    }
+
+    vec4 weights = source_vec4(base + BONE_WEIGHT_OFFSET);
+    vec4 indices = source_vec4(base + BONE_INDICES_OFFSET) + vec4(buf_0_3.u_skinning_info.x);
+
+    vec4 row_0 = vec4(0.0);
+    vec4 row_1 = vec4(0.0);
+    vec4 row_2 = vec4(0.0);
+    for (int i = 0; i < 4; ++i)
+    {
+        int bone = int(indices[i]) * 3;
+        row_0 += buf_0_2.u_bone_palette[bone + 0] * weights[i];
+        row_1 += buf_0_2.u_bone_palette[bone + 1] * weights[i];
+        row_2 += buf_0_2.u_bone_palette[bone + 2] * weights[i];
+    }
+
+    vec4 pos = vec4(source_vec4(base + VERTEX_OFFSET).xyz, 1.0);
+    vec3 normal = source_vec4(base + NORMAL_OFFSET).xyz;
+    vec3 tangent = source_vec4(base + TANGENT_OFFSET).xyz;
+
+    skinned_vec3(base + VERTEX_OFFSET, vec3(dot(row_0, pos), dot(row_1, pos), dot(row_2, pos)));
+    skinned_vec3(base + NORMAL_OFFSET, normalize(vec3(dot(row_0.xyz, normal), dot(row_1.xyz, normal), dot(row_2.xyz, normal))));
+    skinned_vec3(base + TANGENT_OFFSET, normalize(vec3(dot(row_0.xyz, tangent), dot(row_1.xyz, tangent), dot(row_2.xyz, tangent))));
+}
+)";
+#endif
+
+#if VR_SKINNING_SSE
+    static inline void SkinVertex(const Vertex& src, Vertex& dst, const Vector4* bone_vectors)
+    {
+        __m128 row_0 = _mm_setzero_ps();
+        __m128 row_1 = _mm_setzero_ps();
+        __m128 row_2 = _mm_setzero_ps();
+        __m128 row_3 = _mm_setzero_ps();
+
+        for (int i = 0; i < 4; ++i)
+        {
+            float weight = src.bone_weight[i];
+            if (weight > 0)
+            {
+                const Vector4* bone = &bone_vectors[(int) src.bone_indices[i] * BONE_VECTOR_COUNT];
+                __m128 w = _mm_set1_ps(weight);
+                row_0 = _mm_add_ps(row_0, _mm_mul_ps(_mm_loadu_ps(&bone[0].x), w));
+                row_1 = _mm_add_ps(row_1, _mm_mul_ps(_mm_loadu_ps(&bone[1].x), w));
+                row_2 = _mm_add_ps(row_2, _mm_mul_ps(_mm_loadu_ps(&bone[2].x), w));
+            }
+        }
+
+        // rows to columns, then each transform is 3 multiply-adds
+        _MM_TRANSPOSE4_PS(row_0, row_1, row_2, row_3);
+
+        float out[4];
+
+        __m128 pos = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(row_0, _mm_set1_ps(src.vertex.x)), _mm_mul_ps(row_1, _mm_set1_ps(src.vertex.y))),
+            _mm_add_ps(_mm_mul_ps(row_2, _mm_set1_ps(src.vertex.z)), row_3));
+        _mm_storeu_ps(out, pos);
+        dst.vertex = Vector3(out[0], out[1], out[2]);
+
+        __m128 normal = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(row_0, _mm_set1_ps(src.normal.x)), _mm_mul_ps(row_1, _mm_set1_ps(src.normal.y))),
+            _mm_mul_ps(row_2, _mm_set1_ps(src.normal.z)));
+        _mm_storeu_ps(out, normal);
+        dst.normal = Vector3::Normalize(Vector3(out[0], out[1], out[2]));
+
+        __m128 tangent = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(row_0, _mm_set1_ps(src.tangent.x)), _mm_mul_ps(row_1, _mm_set1_ps(src.tangent.y))),
+            _mm_mul_ps(row_2, _mm_set1_ps(src.tangent.z)));
+        _mm_storeu_ps(out, tangent);
+        dst.tangent = Vector4(Vector3::Normalize(Vector3(out[0], out[1], out[2])), src.tangent.w);
+    }
+#elif VR_SKINNING_NEON
+    static inline float Dot(float32x4_t a, float32x4_t b)
+    {
+        float32x4_t m = vmulq_f32(a, b);
+        float32x2_t s = vadd_f32(vget_low_f32(m), vget_high_f32(m));
+        return vget_lane_f32(vpadd_f32(s, s), 0);
+    }
+
+    static inline void SkinVertex(const Vertex& src, Vertex& dst, const Vector4* bone_vectors)
+    {
+        float32x4_t row_0 = vdupq_n_f32(0);
+        float32x4_t row_1 = vdupq_n_f32(0);
+        float32x4_t row_2 = vdupq_n_f32(0);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            float weight = src.bone_weight[i];
+            if (weight > 0)
+            {
+                const Vector4* bone = &bone_vectors[(int) src.bone_indices[i] * BONE_VECTOR_COUNT];
+                row_0 = vmlaq_n_f32(row_0, vld1q_f32(&bone[0].x), weight);
+                row_1 = vmlaq_n_f32(row_1, vld1q_f32(&bone[1].x), weight);
+                row_2 = vmlaq_n_f32(row_2, vld1q_f32(&bone[2].x), weight);
+            }
+        }
+
+        float in[4] = { src.vertex.x, src.vertex.y, src.vertex.z, 1 };
+        float32x4_t pos = vld1q_f32(in);
+        dst.vertex = Vector3(Dot(row_0, pos), Dot(row_1, pos), Dot(row_2, pos));
+
+        in[0] = src.normal.x; in[1] = src.normal.y; in[2] = src.normal.z; in[3] = 0;
+        float32x4_t normal = vld1q_f32(in);
+        dst.normal = Vector3::Normalize(Vector3(Dot(row_0, normal), Dot(row_1, normal), Dot(row_2, normal)));
+
+        in[0] = src.tangent.x; in[1] = src.tangent.y; in[2] = src.tangent.z; in[3] = 0;
+        float32x4_t tangent = vld1q_f32(in);
+        dst.tangent = Vector4(Vector3::Normalize(Vector3(Dot(row_0, tangent), Dot(row_1, tangent), Dot(row_2, tangent))), src.tangent.w);
+    }
+#else
+    static inline void SkinVertex(const Vertex& src, Vertex& dst, const Vector4* bone_vectors)
+    {
+        Vector4 row_0;
+        Vector4 row_1;
+        Vector4 row_2;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            float weight = src.bone_weight[i];
+            if (weight > 0)
+            {
+                const Vector4* bone = &bone_vectors[(int) src.bone_indices[i] * BONE_VECTOR_COUNT];
+                row_0 = row_0 + bone[0] * weight;
+                row_1 = row_1 + bone[1] * weight;
+                row_2 = row_2 + bone[2] * weight;
+            }
+        }
+
+        Vector4 pos(src.vertex, 1);
+        dst.vertex = Vector3(Vector4::Dot(row_0, pos), Vector4::Dot(row_1, pos), Vector4::Dot(row_2, pos));
+
+        Vector4 normal(src.normal, 0);
+        dst.normal = Vector3::Normalize(Vector3(Vector4::Dot(row_0, normal), Vector4::Dot(row_1, normal), Vector4::Dot(row_2, normal)));
+
+        Vector4 tangent(src.tangent.x, src.tangent.y, src.tangent.z, 0);
+        dst.tangent = Vector4(Vector3::Normalize(Vector3(Vector4::Dot(row_0, tangent), Vector4::Dot(row_1, tangent), Vector4::Dot(row_2, tangent))), src.tangent.w);
+    }
+#endif
+
+    void SkinningPrePass::SkinVertices(const Vertex* src, Vertex* dst, int count, const Vector4* bone_vectors)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            SkinVertex(src[i], dst[i], bone_vectors);
+        }
+    }
+
+    void SkinningPrePass::Done()
+    {
+#if VR_VULKAN
+        assert(m_passes.Empty());
+
+        if (m_pipeline != VK_NULL_HANDLE)
+        {
+            VkDevice device = Display::Instance()->GetDevice();
+
+            vkDestroyPipeline(device, m_pipeline, nullptr);
+            vkDestroyDescriptorPool(device, m_descriptor_pool, nullptr);
+            vkDestroyPipelineLayout(device, m_pipeline_layout, nullptr);
+            for (int i = 0; i < m_descriptor_layouts.Size(); ++i)
+            {
+                vkDestroyDescriptorSetLayout(device, m_descriptor_layouts[i], nullptr);
+            }
+            vkDestroyShaderModule(device, m_shader_module, nullptr);
+
+            m_pipeline = VK_NULL_HANDLE;
+            m_descriptor_pool = VK_NULL_HANDLE;
+            m_pipeline_layout = VK_NULL_HANDLE;
+            m_descriptor_layouts.Clear();
+            m_shader_module = VK_NULL_HANDLE;
+            m_shader_uniform_sets.Clear();
+        }
+#endif
+    }
+
+#if VR_VULKAN
+    void SkinningPrePass::CreatePipeline()
+    {
+        String predefine = String::Format(
+            "#define SKINNING_GROUP_SIZE %d\n"
+            "#define VERTEX_STRIDE %d\n"
+            "#define VERTEX_OFFSET %d\n"
+            "#define NORMAL_OFFSET %d\n"
+            "#define TANGENT_OFFSET %d\n"
+            "#define BONE_WEIGHT_OFFSET %d\n"
+            "#define BONE_INDICES_OFFSET %d",
+            SKINNING_GROUP_SIZE,
+            (int) (sizeof(Vertex) / sizeof(float)),
+            VERTEX_ATTR_OFFSETS[(int) VertexAttributeType::Vertex] / (int) sizeof(float),
+            VERTEX_ATTR_OFFSETS[(int) VertexAttributeType::Normal] / (int) sizeof(float),
+            VERTEX_ATTR_OFFSETS[(int) VertexAttributeType::Tangent] / (int) sizeof(float),
+            VERTEX_ATTR_OFFSETS[(int) VertexAttributeType::BlendWeight] / (int) sizeof(float),
+            VERTEX_ATTR_OFFSETS[(int) VertexAttributeType::BlendIndices] / (int) sizeof(float));
+
+        Display::Instance()->CreateComputeShaderModule(
+            predefine,
+            Vector<String>(),
+            SKINNING_CS,
+            &m_shader_module,
+            m_shader_uniform_sets);
+        Display::Instance()->CreatePipelineLayout(m_shader_uniform_sets, m_descriptor_layouts, &m_pipeline_layout);
+        Display::Instance()->CreateComputePipeline(m_shader_module, m_pipeline_layout, VK_NULL_HANDLE, &m_pipeline);
+        Display::Instance()->CreateDescriptorSetPool(m_shader_uniform_sets, &m_descriptor_pool);
+    }
+
+    void SkinningPrePass::BuildCmd(VkCommandBuffer cmd)
+    {
+        bool dispatched = false;
+
+        for (auto i : m_passes)
+        {
+            // not skinned yet, the palette is bound on first skin
+            if (!i->m_palette_buffer)
+            {
+                continue;
+            }
+
+            int vertex_count = i->m_mesh->GetVertexCount();
+
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout, 0, (uint32_t) i->m_descriptor_sets.Size(), &i->m_descriptor_sets[0], 0, nullptr);
+            vkCmdDispatch(cmd, (uint32_t) ((vertex_count + SKINNING_GROUP_SIZE - 1) / SKINNING_GROUP_SIZE), 1, 1);
+
+            dispatched = true;
+        }
+
+        if (dispatched)
+        {
+            VkMemoryBarrier barrier;
+            Memory::Zero(&barrier, sizeof(barrier));
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.pNext = nullptr;
+            barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+
+            vkCmdPipelineBarrier(cmd,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                0,
+                1, &barrier,
+                0, nullptr,
+                0, nullptr);
+        }
+    }
+
+    int SkinningPrePass::FindStorageBufferBinding(const String& name) const
+    {
+        for (int i = 0; i < m_uniform_sets[0].storage_buffers.Size(); ++i)
+        {
+            if (m_uniform_sets[0].storage_buffers[i].name == name)
+            {
+                return m_uniform_sets[0].storage_buffers[i].binding;
+            }
+        }
+
+        assert(!"skinning storage buffer not found");
+        return -1;
+    }
+#endif
+
+    bool SkinningPrePass::IsSupported(const Ref<Mesh>& mesh)
+    {
+#if VR_GLES
+        return mesh->GetVertices().Size() > 0;
+#else
+        return true;
+#endif
+    }
+
+    SkinningPrePass::SkinningPrePass(const Ref<Mesh>& mesh):
+        m_mesh(mesh)
+    {
+#if VR_VULKAN
+        if (m_pipeline == VK_NULL_HANDLE)
+        {
+            SkinningPrePass::CreatePipeline();
+        }
+
+        const auto& source_buffer = m_mesh->GetVertexBuffer();
+        m_vertex_buffer = Display::Instance()->CreateBuffer(nullptr, source_buffer->GetSize(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+        m_uniform_sets = m_shader_uniform_sets;
+        Display::Instance()->CreateDescriptorSets(m_uniform_sets, m_descriptor_pool, m_descriptor_layouts, m_descriptor_sets);
+        Display::Instance()->CreateUniformBuffer(m_descriptor_sets[0], m_uniform_sets[0].buffers[0]);
+        Display::Instance()->UpdateStorageBuffer(m_descriptor_sets[0], this->FindStorageBufferBinding("u_source_vertices"), source_buffer);
+        Display::Instance()->UpdateStorageBuffer(m_descriptor_sets[0], this->FindStorageBufferBinding("u_skinned_vertices"), m_vertex_buffer);
+
+        m_skinning_info = Vector4(-1, 0, 0, 0);
+
+        m_passes.AddLast(this);
+#elif VR_GLES
+        m_vertices = m_mesh->GetVertices();
+        if (m_vertices.Size() > 0)
+        {
+            m_vertex_buffer = Display::Instance()->CreateBuffer(m_vertices.Bytes(), m_vertices.SizeInBytes(), GL_ARRAY_BUFFER, GL_DYNAMIC_DRAW);
+        }
+#endif
+    }
+
+    SkinningPrePass::~SkinningPrePass()
+    {
+#if VR_VULKAN
+        m_passes.Remove(this);
+        Display::Instance()->MarkPrimaryCmdDirty();
+
+        VkDevice device = Display::Instance()->GetDevice();
+        m_uniform_sets[0].buffers[0].buffer->Destroy(device);
+        m_vertex_buffer->Destroy(device);
+#endif
+
+        m_vertex_buffer.reset();
+    }
+
+    void SkinningPrePass::Skin(int palette_offset, const Vector<Vector4>& bone_vectors)
+    {
+#if VR_VULKAN
+        if (m_palette_buffer != BonePalette::GetBuffer())
+        {
+            m_palette_buffer = BonePalette::GetBuffer();
+            Display::Instance()->UpdateStorageBuffer(m_descriptor_sets[0], this->FindStorageBufferBinding(BONE_PALETTE), m_palette_buffer);
+            Display::Instance()->MarkPrimaryCmdDirty();
+        }
+
+        Vector4 skinning_info((float) palette_offset, (float) m_mesh->GetVertexCount(), 0, 0);
+        if (m_skinning_info != skinning_info)
+        {
+            m_skinning_info = skinning_info;
+
+            const auto& buffer = m_uniform_sets[0].buffers[0];
+            Display::Instance()->UpdateBuffer(buffer.buffer, buffer.members[0].offset, &m_skinning_info, sizeof(Vector4));
+        }
+#elif VR_GLES
+        const auto& source = m_mesh->GetVertices();
+        if (source.Size() != m_vertices.Size() || m_vertices.Empty())
+        {
+            return;
+        }
+
+        SkinningPrePass::SkinVertices(&source[0], &m_vertices[0], m_vertices.Size(), &bone_vectors[0]);
+
+        Display::Instance()->UpdateBuffer(m_vertex_buffer, 0, m_vertices.Bytes(), m_vertices.SizeInBytes());
+#endif
+    }
+}
@@ -0,0 +1,76 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "Display.h"
+#include "VertexAttribute.h"
+#include "container/List.h"
+#include "container/Vector.h"
+#include "math/Vector4.h"
+
+namespace Viry3D
+{
+    class Mesh;
+    class BufferObject;
+
+    // skins a mesh once per frame into its own vertex buffer, every camera then draws it as a static mesh.
+    // vulkan dispatches a compute shader at the start of the primary cmd, gles skins on the cpu.
+    class SkinningPrePass
+    {
+    public:
+        static void SkinVertices(const Vertex* src, Vertex* dst, int count, const Vector4* bone_vectors);
+        static void Done();
+        // gles skins from the mesh vertices, a mesh without them stays on palette skinning
+        static bool IsSupported(const Ref<Mesh>& mesh);
+#if VR_VULKAN
+        static void BuildCmd(VkCommandBuffer cmd);
+#endif
+        SkinningPrePass(const Ref<Mesh>& mesh);
+        ~SkinningPrePass();
+        const Ref<Mesh>& GetMesh() const { return m_mesh; }
+        const Ref<BufferObject>& GetVertexBuffer() const { return m_vertex_buffer; }
+        void Skin(int palette_offset, const Vector<Vector4>& bone_vectors);
+
+    private:
+#if VR_VULKAN
+        static void CreatePipeline();
+        int FindStorageBufferBinding(const String& name) const;
+#endif
+
+    private:
+#if VR_VULKAN
+        static VkShaderModule m_shader_module;
+        static Vector<UniformSet> m_shader_uniform_sets;
+        static Vector<VkDescriptorSetLayout> m_descriptor_layouts;
+        static VkPipelineLayout m_pipeline_layout;
+        static VkPipeline m_pipeline;
+        static VkDescriptorPool m_descriptor_pool;
+        static List<SkinningPrePass*> m_passes;
+#endif
+        Ref<Mesh> m_mesh;
+        Ref<BufferObject> m_vertex_buffer;
+#if VR_VULKAN
+        Vector<UniformSet> m_uniform_sets;
+        Vector<VkDescriptorSet> m_descriptor_sets;
+        Ref<BufferObject> m_palette_buffer;
+        Vector4 m_skinning_info;
+#elif VR_GLES
+        Vector<Vertex> m_vertices;
+#endif
+    };
+}
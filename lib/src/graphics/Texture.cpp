@@ -17,10 +17,14 @@
 
 #include "Texture.h"
 #include "Image.h"
+#include "KTX.h"
+#include "MipmapGenerator.h"
 #include "BufferObject.h"
 #include "memory/Memory.h"
 #include "io/File.h"
+#include "io/MappedFile.h"
 #include "math/Mathf.h"
+#include "RenderStats.h"
 #include "Debug.h"
 
 namespace Viry3D
@@ -41,6 +45,8 @@ namespace Viry3D
                 return VK_FORMAT_R8G8_UNORM;
             case TextureFormat::R8G8B8A8:
                 return VK_FORMAT_R8G8B8A8_UNORM;
+            case TextureFormat::R32G32B32A32F:
+                return VK_FORMAT_R32G32B32A32_SFLOAT;
             case TextureFormat::D16:
                 return VK_FORMAT_D16_UNORM;
             case TextureFormat::D24X8:
@@ -55,6 +61,26 @@ namespace Viry3D
                 return VK_FORMAT_D32_SFLOAT_S8_UINT;
             case TextureFormat::S8:
                 return VK_FORMAT_S8_UINT;
+            case TextureFormat::BC1:
+                return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+            case TextureFormat::BC3:
+                return VK_FORMAT_BC3_UNORM_BLOCK;
+            case TextureFormat::BC4:
+                return VK_FORMAT_BC4_UNORM_BLOCK;
+            case TextureFormat::BC5:
+                return VK_FORMAT_BC5_UNORM_BLOCK;
+            case TextureFormat::BC7:
+                return VK_FORMAT_BC7_UNORM_BLOCK;
+            case TextureFormat::ETC2_R8G8B8:
+                return VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
+            case TextureFormat::ETC2_R8G8B8A8:
+                return VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK;
+            case TextureFormat::ASTC_4x4:
+                return VK_FORMAT_ASTC_4x4_UNORM_BLOCK;
+            case TextureFormat::ASTC_6x6:
+                return VK_FORMAT_ASTC_6x6_UNORM_BLOCK;
+            case TextureFormat::ASTC_8x8:
+                return VK_FORMAT_ASTC_8x8_UNORM_BLOCK;
             default:
                 return VK_FORMAT_UNDEFINED;
         }
@@ -70,6 +96,8 @@ namespace Viry3D
                 return TextureFormat::R8G8;
             case VK_FORMAT_R8G8B8A8_UNORM:
                 return TextureFormat::R8G8B8A8;
+            case VK_FORMAT_R32G32B32A32_SFLOAT:
+                return TextureFormat::R32G32B32A32F;
             case VK_FORMAT_D16_UNORM:
                 return TextureFormat::D16;
             case VK_FORMAT_X8_D24_UNORM_PACK32:
@@ -84,6 +112,26 @@ namespace Viry3D
                 return TextureFormat::D32S8;
             case VK_FORMAT_S8_UINT:
                 return TextureFormat::S8; 
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+                return TextureFormat::BC1;
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+                return TextureFormat::BC3;
+            case VK_FORMAT_BC4_UNORM_BLOCK:
+                return TextureFormat::BC4;
+            case VK_FORMAT_BC5_UNORM_BLOCK:
+                return TextureFormat::BC5;
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+                return TextureFormat::BC7;
+            case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+                return TextureFormat::ETC2_R8G8B8;
+            case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+                return TextureFormat::ETC2_R8G8B8A8;
+            case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+                return TextureFormat::ASTC_4x4;
+            case VK_FORMAT_ASTC_6x6_UNORM_BLOCK:
+                return TextureFormat::ASTC_6x6;
+            case VK_FORMAT_ASTC_8x8_UNORM_BLOCK:
+                return TextureFormat::ASTC_8x8;
             default:
                 return TextureFormat::None;
         }
@@ -132,42 +180,112 @@ namespace Viry3D
 #endif
     }
 
-    ByteBuffer Texture::LoadImageFromFile(const String& path, int& width, int& height, int& bpp)
+#if VR_GLES
+    static bool HasGLExtension(const char* name)
     {
-        ByteBuffer pixels;
-
-        if (File::Exist(path))
+        if (Display::Instance()->IsGLESv3())
         {
-            if (path.EndsWith(".png"))
+            GLint count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+            for (int i = 0; i < count; ++i)
             {
-                ByteBuffer png = File::ReadAllBytes(path);
-                pixels = Image::LoadPNG(png, width, height, bpp);
-            }
-            else if (path.EndsWith(".jpg"))
-            {
-                ByteBuffer jpg = File::ReadAllBytes(path);
-                pixels = Image::LoadJPEG(jpg, width, height, bpp);
+                const char* extension = (const char*) glGetStringi(GL_EXTENSIONS, i);
+                if (extension && strstr(extension, name))
+                {
+                    return true;
+                }
             }
-            else
+            return false;
+        }
+        else
+        {
+            const char* extensions = (const char*) glGetString(GL_EXTENSIONS);
+            return extensions && strstr(extensions, name);
+        }
+    }
+#endif
+
+    bool Texture::IsFormatSupported(TextureFormat format)
+    {
+#if VR_VULKAN
+        VkFormat vk_format = TextureFormatToVkFormat(format);
+        if (vk_format == VK_FORMAT_UNDEFINED)
+        {
+            return false;
+        }
+        return Display::Instance()->ChooseFormatSupported({ vk_format }, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) == vk_format;
+#elif VR_GLES
+        switch (format)
+        {
+            case TextureFormat::BC1:
+            case TextureFormat::BC3:
+                return HasGLExtension("texture_compression_s3tc") || HasGLExtension("texture_compression_dxt");
+            case TextureFormat::BC4:
+            case TextureFormat::BC5:
+                return HasGLExtension("texture_compression_rgtc");
+            case TextureFormat::BC7:
+                return HasGLExtension("texture_compression_bptc");
+            case TextureFormat::ETC2_R8G8B8:
+            case TextureFormat::ETC2_R8G8B8A8:
+#if VR_WINDOWS || VR_MAC
+                return HasGLExtension("ES3_compatibility");
+#else
+                return Display::Instance()->IsGLESv3() || HasGLExtension("compressed_texture_etc");
+#endif
+            case TextureFormat::ASTC_4x4:
+            case TextureFormat::ASTC_6x6:
+            case TextureFormat::ASTC_8x8:
+                return HasGLExtension("texture_compression_astc");
+            case TextureFormat::R32G32B32A32F:
+                return Display::Instance()->IsGLESv3() || HasGLExtension("OES_texture_float");
+            case TextureFormat::None:
+                return false;
+            default:
+                return true;
+        }
+#endif
+    }
+
+    TextureFormat Texture::ChooseFormatSupported(const Vector<TextureFormat>& formats)
+    {
+        for (int i = 0; i < formats.Size(); ++i)
+        {
+            if (Texture::IsFormatSupported(formats[i]))
             {
-                assert(!"image file format not support");
+                return formats[i];
             }
+        }
+
+        return TextureFormat::None;
+    }
+
+    ByteBuffer Texture::LoadImageFromFile(const String& path, int& width, int& height, int& bpp, int max_size)
+    {
+        ByteBuffer pixels;
+
+        if (File::Exist(path))
+        {
+            ByteBuffer file = File::ReadAllBytes(path);
 
-            // vulkan not support R8G8B8, convert to R8G8B8A8 always
-            if (bpp == 24)
+            // vulkan not support R8G8B8, decode to R8G8B8A8 always
+            ImageInfo info;
+            if (Image::ReadInfo(file, info, true, max_size))
             {
-                int pixel_count = pixels.Size() / 3;
-                ByteBuffer rgba(pixel_count * 4);
-                for (int i = 0; i < pixel_count; ++i)
+                pixels = ByteBuffer(Image::GetPixelsSize(info));
+                if (!Image::Decode(file, pixels.Bytes(), true, max_size))
                 {
-                    rgba[i * 4 + 0] = pixels[i * 3 + 0];
-                    rgba[i * 4 + 1] = pixels[i * 3 + 1];
-                    rgba[i * 4 + 2] = pixels[i * 3 + 2];
-                    rgba[i * 4 + 3] = 255;
+                    pixels = ByteBuffer();
                 }
-                pixels = rgba;
-                bpp = 32;
             }
+
+            if (pixels.Size() == 0)
+            {
+                Log("image decode failed: %s", path.CString());
+            }
+
+            width = info.width;
+            height = info.height;
+            bpp = info.bpp;
         }
         else
         {
@@ -181,14 +299,20 @@ namespace Viry3D
         const String& path,
         FilterMode filter_mode,
         SamplerAddressMode wrap_mode,
-        bool gen_mipmap)
+        bool gen_mipmap,
+        int max_size)
     {
+        if (path.EndsWith(".ktx") || path.EndsWith(".ktx2"))
+        {
+            return Texture::LoadTextureFromKTX(path, filter_mode, wrap_mode, max_size);
+        }
+
         Ref<Texture> texture;
 
         int width;
         int height;
         int bpp;
-        ByteBuffer pixels = Texture::LoadImageFromFile(path, width, height, bpp);
+        ByteBuffer pixels = Texture::LoadImageFromFile(path, width, height, bpp, max_size);
         if (pixels.Size() > 0)
         {
             TextureFormat format;
@@ -212,6 +336,65 @@ namespace Viry3D
         return texture;
     }
 
+    Ref<Texture> Texture::LoadTextureFromKTX(
+        const String& path,
+        FilterMode filter_mode,
+        SamplerAddressMode wrap_mode,
+        int max_size)
+    {
+        Ref<Texture> texture;
+
+        // levels are copied from the mapping straight into the staging buffer
+        Ref<MappedFile> file = MappedFile::Open(path);
+        if (!file)
+        {
+            Log("texture file not exist: %s", path.CString());
+            return texture;
+        }
+
+        KTXImage image;
+        if (!KTX::Load(file->GetBuffer(), image))
+        {
+            Log("invalid ktx file: %s", path.CString());
+            return texture;
+        }
+
+        String* value;
+        if (image.key_values.TryGet(KTX_KEY_FILTER_MODE, &value))
+        {
+            filter_mode = (FilterMode) atoi(value->CString());
+        }
+        if (image.key_values.TryGet(KTX_KEY_WRAP_MODE, &value))
+        {
+            wrap_mode = (SamplerAddressMode) atoi(value->CString());
+        }
+
+        if (max_size > 0)
+        {
+            int skip = 0;
+            while (skip < image.level_count - 1 && Mathf::Max(image.width >> skip, image.height >> skip) > max_size)
+            {
+                skip += 1;
+            }
+
+            if (skip > 0)
+            {
+                image.images.RemoveRange(0, skip * image.layer_count * image.face_count);
+                image.width = Mathf::Max(image.width >> skip, 1);
+                image.height = Mathf::Max(image.height >> skip, 1);
+                image.level_count -= skip;
+            }
+        }
+
+        texture = Texture::CreateTextureFromKTX(image, filter_mode, wrap_mode);
+        if (!texture)
+        {
+            Log("create texture failed: %s", path.CString());
+        }
+
+        return texture;
+    }
+
     Ref<Texture> Texture::CreateTexture2DFromMemory(
         const ByteBuffer& pixels,
         int width,
@@ -224,10 +407,11 @@ namespace Viry3D
     {
         Ref<Texture> texture;
 
+        // mips are blitted on the gpu, loaders build them on workers and call CreateTexture2DFromLevels
         int mipmap_level_count = 1;
         if (gen_mipmap)
         {
-            mipmap_level_count = (int) floor(Mathf::Log2((float) Mathf::Max(width, height))) + 1;
+            mipmap_level_count = MipmapGenerator::GetLevelCount(width, height);
         }
 
 #if VR_VULKAN
@@ -272,6 +456,98 @@ namespace Viry3D
         return texture;
     }
 
+    Ref<Texture> Texture::CreateTexture2DFromLevels(
+        const Vector<ByteBuffer>& levels,
+        int width,
+        int height,
+        TextureFormat format,
+        FilterMode filter_mode,
+        SamplerAddressMode wrap_mode)
+    {
+        KTXImage image;
+        image.format = format;
+        image.width = width;
+        image.height = height;
+        image.level_count = levels.Size();
+        image.images = levels;
+
+        return Texture::CreateTextureFromKTX(image, filter_mode, wrap_mode);
+    }
+
+    Ref<Texture> Texture::CreateTextureFromKTX(
+        const KTXImage& image,
+        FilterMode filter_mode,
+        SamplerAddressMode wrap_mode)
+    {
+        Ref<Texture> texture;
+
+        if (!Texture::IsFormatSupported(image.format))
+        {
+            Log("texture format not support: %s", TextureFormatInfo::GetName(image.format));
+            return texture;
+        }
+
+        bool cubemap = image.face_count == 6;
+        if (cubemap && image.layer_count > 1)
+        {
+            Log("cubemap array not support");
+            return texture;
+        }
+
+        assert(image.level_count > 0);
+        assert(image.images.Size() == image.level_count * image.layer_count * image.face_count);
+
+#if VR_VULKAN
+        VkImageViewType view_type = VK_IMAGE_VIEW_TYPE_2D;
+        if (cubemap)
+        {
+            view_type = VK_IMAGE_VIEW_TYPE_CUBE;
+        }
+        else if (image.layer_count > 1)
+        {
+            view_type = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+        }
+
+        texture = Display::Instance()->CreateTexture(
+            VK_IMAGE_TYPE_2D,
+            view_type,
+            image.width,
+            image.height,
+            TextureFormatToVkFormat(image.format),
+            VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            {
+                VK_COMPONENT_SWIZZLE_R,
+                VK_COMPONENT_SWIZZLE_G,
+                VK_COMPONENT_SWIZZLE_B,
+                VK_COMPONENT_SWIZZLE_A
+            },
+            image.level_count,
+            cubemap,
+            image.layer_count,
+            1);
+        Display::Instance()->CreateSampler(texture, FilterModeToVkFilter(filter_mode), SamplerAddressModeToVkMode(wrap_mode));
+#elif VR_GLES
+        if (image.layer_count > 1)
+        {
+            Log("texture array not support");
+            return texture;
+        }
+
+        texture = CreateTexture(
+            cubemap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D,
+            image.width,
+            image.height,
+            image.format,
+            image.level_count);
+        texture->CreateSampler(filter_mode, wrap_mode);
+#endif
+
+        texture->UpdateLevels(image.images, image.layer_count * image.face_count);
+
+        return texture;
+    }
+
     Ref<Texture> Texture::CreateCubemap(
         int size,
         TextureFormat format,
@@ -603,6 +879,9 @@ namespace Viry3D
 
     void Texture::UpdateTexture2D(const ByteBuffer& pixels, int x, int y, int w, int h)
     {
+        RenderStats::Add(RenderStat::TextureUploads);
+        RenderStats::Add(RenderStat::TextureUploadBytes, pixels.Size());
+
 #if VR_VULKAN
         VkDevice device = Display::Instance()->GetDevice();
 
@@ -651,6 +930,9 @@ namespace Viry3D
 
     void Texture::UpdateCubemap(const ByteBuffer& pixels, CubemapFace face, int level)
     {
+        RenderStats::Add(RenderStat::TextureUploads);
+        RenderStats::Add(RenderStat::TextureUploadBytes, pixels.Size());
+
 #if VR_VULKAN
         VkDevice device = Display::Instance()->GetDevice();
 
@@ -683,6 +965,9 @@ namespace Viry3D
 
     void Texture::UpdateTexture2DArray(const ByteBuffer& pixels, int layer, int level)
     {
+        RenderStats::Add(RenderStat::TextureUploads);
+        RenderStats::Add(RenderStat::TextureUploadBytes, pixels.Size());
+
 #if VR_VULKAN
         VkDevice device = Display::Instance()->GetDevice();
 
@@ -707,6 +992,75 @@ namespace Viry3D
 #endif
     }
 
+    void Texture::UpdateLevels(const Vector<ByteBuffer>& images, int layer_count)
+    {
+        for (int i = 0; i < images.Size(); ++i)
+        {
+            RenderStats::Add(RenderStat::TextureUploads);
+            RenderStats::Add(RenderStat::TextureUploadBytes, images[i].Size());
+        }
+
+        int level_count = images.Size() / layer_count;
+
+#if VR_VULKAN
+        VkDevice device = Display::Instance()->GetDevice();
+
+        // all images share one staging buffer and one copy command
+        Vector<int> offsets(images.Size());
+        int buffer_size = 0;
+        for (int i = 0; i < images.Size(); ++i)
+        {
+            offsets[i] = buffer_size;
+            buffer_size += (images[i].Size() + 15) & ~15;
+        }
+
+        Ref<BufferObject> image_buffer = Display::Instance()->CreateBuffer(nullptr, buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+        for (int i = 0; i < images.Size(); ++i)
+        {
+            Display::Instance()->UpdateBuffer(image_buffer, offsets[i], images[i].Bytes(), images[i].Size());
+        }
+
+        this->CopyBufferToImageBegin();
+        for (int i = 0; i < level_count; ++i)
+        {
+            int w = Mathf::Max(m_width >> i, 1);
+            int h = Mathf::Max(m_height >> i, 1);
+            for (int j = 0; j < layer_count; ++j)
+            {
+                this->CopyBufferToImage(image_buffer, 0, 0, w, h, j, i, offsets[i * layer_count + j]);
+            }
+        }
+        this->CopyBufferToImageEnd();
+
+        image_buffer->Destroy(device);
+#elif VR_GLES
+        this->Bind();
+
+        for (int i = 0; i < level_count; ++i)
+        {
+            int w = Mathf::Max(m_width >> i, 1);
+            int h = Mathf::Max(m_height >> i, 1);
+            for (int j = 0; j < layer_count; ++j)
+            {
+                GLenum target = m_cubemap ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + j : m_target;
+                const ByteBuffer& image = images[i * layer_count + j];
+
+                if (m_compressed)
+                {
+                    glCompressedTexImage2D(target, i, m_internal_format, w, h, 0, image.Size(), image.Bytes());
+                }
+                else
+                {
+                    glTexImage2D(target, i, m_internal_format, w, h, 0, m_format, m_pixel_type, image.Bytes());
+                }
+            }
+        }
+        m_have_storage = true;
+
+        this->Unbind();
+#endif
+    }
+
 #if VR_VULKAN
     void Texture::CopyTexture(
         const Ref<Texture>& src_texture,
@@ -837,11 +1191,11 @@ namespace Viry3D
             (VkAccessFlagBits) 0);
     }
     
-    void Texture::CopyBufferToImage(const Ref<BufferObject>& image_buffer, int x, int y, int w, int h, int layer, int level)
+    void Texture::CopyBufferToImage(const Ref<BufferObject>& image_buffer, int x, int y, int w, int h, int layer, int level, int buffer_offset)
     {
         VkBufferImageCopy copy;
         Memory::Zero(&copy, sizeof(copy));
-        copy.bufferOffset = 0;
+        copy.bufferOffset = (VkDeviceSize) buffer_offset;
         copy.bufferRowLength = 0;
         copy.bufferImageHeight = 0;
         copy.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, (uint32_t) level, (uint32_t) layer, 1 };
@@ -957,6 +1311,44 @@ namespace Viry3D
         return layer_count;
     }
 
+    void Texture::SwapImage(const Ref<Texture>& texture)
+    {
+#if VR_VULKAN
+        std::swap(m_format, texture->m_format);
+        std::swap(m_image, texture->m_image);
+        std::swap(m_image_view, texture->m_image_view);
+        std::swap(m_memory, texture->m_memory);
+        std::swap(m_memory_info, texture->m_memory_info);
+        std::swap(m_image_multi_sample, texture->m_image_multi_sample);
+        std::swap(m_image_view_multi_sample, texture->m_image_view_multi_sample);
+        std::swap(m_memory_multi_sample, texture->m_memory_multi_sample);
+        std::swap(m_memory_info_multi_sample, texture->m_memory_info_multi_sample);
+        std::swap(m_sampler, texture->m_sampler);
+        std::swap(m_image_buffer, texture->m_image_buffer);
+#elif VR_GLES
+        std::swap(m_texture, texture->m_texture);
+        std::swap(m_target, texture->m_target);
+        std::swap(m_internal_format, texture->m_internal_format);
+        std::swap(m_format, texture->m_format);
+        std::swap(m_pixel_type, texture->m_pixel_type);
+        std::swap(m_have_storage, texture->m_have_storage);
+        std::swap(m_copy_framebuffer, texture->m_copy_framebuffer);
+        std::swap(m_render_texture, texture->m_render_texture);
+        std::swap(m_depth_texture, texture->m_depth_texture);
+        std::swap(m_compressed, texture->m_compressed);
+        std::swap(m_renderbuffer_multi_sample, texture->m_renderbuffer_multi_sample);
+#endif
+        std::swap(m_width, texture->m_width);
+        std::swap(m_height, texture->m_height);
+        std::swap(m_mipmap_level_count, texture->m_mipmap_level_count);
+        std::swap(m_dynamic, texture->m_dynamic);
+        std::swap(m_cubemap, texture->m_cubemap);
+        std::swap(m_array_size, texture->m_array_size);
+        std::swap(m_sample_count, texture->m_sample_count);
+
+        m_version += 1;
+    }
+
     void Texture::GenMipmaps()
     {
         assert(m_mipmap_level_count > 1);
@@ -1047,6 +1439,7 @@ namespace Viry3D
         m_image_view_multi_sample(VK_NULL_HANDLE),
         m_memory_multi_sample(VK_NULL_HANDLE),
         m_sampler(VK_NULL_HANDLE),
+        m_retired(false),
 #elif VR_GLES
         m_texture(0),
         m_target(0),
@@ -1057,6 +1450,7 @@ namespace Viry3D
         m_copy_framebuffer(0),
         m_render_texture(false),
         m_depth_texture(false),
+        m_compressed(false),
         m_renderbuffer_multi_sample(0),
 #endif
         m_width(0),
@@ -1065,7 +1459,8 @@ namespace Viry3D
         m_dynamic(false),
         m_cubemap(false),
         m_array_size(1),
-        m_sample_count(1)
+        m_sample_count(1),
+        m_version(0)
     {
 #if VR_VULKAN
         Memory::Zero(&m_memory_info, sizeof(m_memory_info));
@@ -1079,7 +1474,10 @@ namespace Viry3D
         VkDevice device = Display::Instance()->GetDevice();
 
         // All submitted commands that refer to image, either directly or via a VkImageView, must have completed execution
-        Display::Instance()->WaitDevice();
+        if (!m_retired)
+        {
+            Display::Instance()->WaitDevice();
+        }
 
         if (m_image_buffer)
         {
@@ -1167,6 +1565,18 @@ namespace Viry3D
             texture->m_format = GL_RGBA;
             texture->m_pixel_type = GL_UNSIGNED_BYTE;
             break;
+        case TextureFormat::R32G32B32A32F:
+            if (Display::Instance()->IsGLESv3())
+            {
+                texture->m_internal_format = GL_RGBA32F;
+            }
+            else
+            {
+                texture->m_internal_format = GL_RGBA;
+            }
+            texture->m_format = GL_RGBA;
+            texture->m_pixel_type = GL_FLOAT;
+            break;
         case TextureFormat::D16:
             if (Display::Instance()->IsGLESv3())
             {
@@ -1236,6 +1646,19 @@ namespace Viry3D
             }
             texture->m_depth_texture = true;
             break;
+        case TextureFormat::BC1:
+        case TextureFormat::BC3:
+        case TextureFormat::BC4:
+        case TextureFormat::BC5:
+        case TextureFormat::BC7:
+        case TextureFormat::ETC2_R8G8B8:
+        case TextureFormat::ETC2_R8G8B8A8:
+        case TextureFormat::ASTC_4x4:
+        case TextureFormat::ASTC_6x6:
+        case TextureFormat::ASTC_8x8:
+            texture->m_internal_format = KTX::FormatToGLInternalFormat(format);
+            texture->m_compressed = true;
+            break;
         default:
             Log("texture format not support: %d", format);
             break;
@@ -19,10 +19,13 @@
 
 #include "Object.h"
 #include "Display.h"
+#include "TextureFormat.h"
 #include "thread/ThreadPool.h"
 
 namespace Viry3D
 {
+    struct KTXImage;
+
     enum class CubemapFace
     {
         Unknown = -1,
@@ -37,21 +40,6 @@ namespace Viry3D
         Count
     };
 
-    enum class TextureFormat
-    {
-        None,
-        R8,
-        R8G8,
-        R8G8B8A8,
-        D16,
-        D24X8,
-        D32,
-        D16S8,
-        D24S8,
-        D32S8,
-        S8,
-    };
-
     enum class FilterMode
     {
         None = -1,
@@ -73,14 +61,24 @@ namespace Viry3D
     {
     private:
         friend class DisplayPrivate;
+        friend class TextureStreamer;
 
     public:
-        static ByteBuffer LoadImageFromFile(const String& path, int& width, int& height, int& bpp);
+        // a max_size above 0 limits the larger side, see Image::ReadInfo
+        static ByteBuffer LoadImageFromFile(const String& path, int& width, int& height, int& bpp, int max_size = 0);
         static Ref<Texture> LoadTexture2DFromFile(
             const String& path,
             FilterMode filter_mode,
             SamplerAddressMode wrap_mode,
-            bool gen_mipmap);
+            bool gen_mipmap,
+            int max_size = 0);
+        // ktx 1.1 or 2.0 2d, array or cubemap texture, sampler keys in the file override the given modes.
+        // a max_size above 0 skips the levels larger than it
+        static Ref<Texture> LoadTextureFromKTX(
+            const String& path,
+            FilterMode filter_mode,
+            SamplerAddressMode wrap_mode,
+            int max_size = 0);
         static Ref<Texture> CreateTexture2DFromMemory(
             const ByteBuffer& pixels,
             int width,
@@ -90,6 +88,18 @@ namespace Viry3D
             SamplerAddressMode wrap_mode,
             bool gen_mipmap,
             bool dynamic);
+        // one image per mip level, also for block compressed formats
+        static Ref<Texture> CreateTexture2DFromLevels(
+            const Vector<ByteBuffer>& levels,
+            int width,
+            int height,
+            TextureFormat format,
+            FilterMode filter_mode,
+            SamplerAddressMode wrap_mode);
+        static Ref<Texture> CreateTextureFromKTX(
+            const KTXImage& image,
+            FilterMode filter_mode,
+            SamplerAddressMode wrap_mode);
         static Ref<Texture> CreateCubemap(
             int size,
             TextureFormat format,
@@ -115,6 +125,9 @@ namespace Viry3D
             bool gen_mipmap,
             bool dynamic);
         static TextureFormat ChooseDepthFormatSupported(bool sample);
+        static bool IsFormatSupported(TextureFormat format);
+        // first format the device can sample, or None
+        static TextureFormat ChooseFormatSupported(const Vector<TextureFormat>& formats);
 		static Ref<Texture> GetSharedWhiteTexture();
 		static Ref<Texture> GetSharedBlackTexture();
 		static Ref<Texture> GetSharedNormalTexture();
@@ -125,6 +138,8 @@ namespace Viry3D
         int GetHeight() const { return m_height; }
         int GetMipmapLevelCount() const { return m_mipmap_level_count; }
         int GetSampleCount() const { return m_sample_count; }
+        // changes when texture streaming replaces the gpu image
+        int GetVersion() const { return m_version; }
         void UpdateTexture2D(const ByteBuffer& pixels, int x, int y, int w, int h);
         void UpdateCubemap(const ByteBuffer& pixels, CubemapFace face, int level);
         void UpdateTexture2DArray(const ByteBuffer& pixels, int layer, int level);
@@ -156,7 +171,7 @@ namespace Viry3D
     private:
 #if VR_VULKAN
         void CopyBufferToImageBegin();
-        void CopyBufferToImage(const Ref<BufferObject>& image_buffer, int x, int y, int w, int h, int face, int level);
+        void CopyBufferToImage(const Ref<BufferObject>& image_buffer, int x, int y, int w, int h, int face, int level, int buffer_offset = 0);
         void CopyBufferToImageEnd();
 #elif VR_GLES
         static Ref<Texture> CreateTexture(
@@ -170,6 +185,10 @@ namespace Viry3D
 #endif
         Texture();
         int GetLayerCount();
+        // images ordered by level and layer, cubemap faces count as layers
+        void UpdateLevels(const Vector<ByteBuffer>& images, int layer_count);
+        // exchanges gpu images and sizes with texture, which then releases the old image
+        void SwapImage(const Ref<Texture>& texture);
 
     private:
 		static Ref<Texture> m_shared_white_texture;
@@ -188,6 +207,8 @@ namespace Viry3D
         VkMemoryAllocateInfo m_memory_info_multi_sample;
         VkSampler m_sampler;
         Ref<BufferObject> m_image_buffer;
+        // kept by its owner until no submitted frame uses it, destroyed without waiting for the device
+        bool m_retired;
 #elif VR_GLES
         GLuint m_texture;
         GLuint m_target;
@@ -198,6 +219,7 @@ namespace Viry3D
         GLuint m_copy_framebuffer;
         bool m_render_texture;
         bool m_depth_texture;
+        bool m_compressed;
         GLuint m_renderbuffer_multi_sample;
 #endif
         int m_width;
@@ -207,5 +229,6 @@ namespace Viry3D
         bool m_cubemap;
         int m_array_size;
         int m_sample_count;
+        int m_version;
     };
 }
@@ -0,0 +1,893 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "TextureCompressor.h"
+#include "memory/Memory.h"
+#include "math/Mathf.h"
+#include "Debug.h"
+#include <math.h>
+
+namespace Viry3D
+{
+    static const int ETC1_MODIFIERS[8][2] = {
+        { 2, 8 },
+        { 5, 17 },
+        { 9, 29 },
+        { 13, 42 },
+        { 18, 60 },
+        { 24, 80 },
+        { 33, 106 },
+        { 47, 183 },
+    };
+
+    static const int EAC_MODIFIERS[16][8] = {
+        { -3, -6, -9, -15, 2, 5, 8, 14 },
+        { -3, -7, -10, -13, 2, 6, 9, 12 },
+        { -2, -5, -8, -13, 1, 4, 7, 12 },
+        { -2, -4, -6, -13, 1, 3, 5, 12 },
+        { -3, -6, -8, -12, 2, 5, 7, 11 },
+        { -3, -7, -9, -11, 2, 6, 8, 10 },
+        { -4, -7, -8, -11, 3, 6, 7, 10 },
+        { -3, -5, -8, -11, 2, 4, 7, 10 },
+        { -2, -6, -8, -10, 1, 5, 7, 9 },
+        { -2, -5, -8, -10, 1, 4, 7, 9 },
+        { -2, -4, -8, -10, 1, 3, 7, 9 },
+        { -2, -5, -7, -10, 1, 4, 6, 9 },
+        { -3, -4, -7, -10, 2, 3, 6, 9 },
+        { -1, -2, -3, -10, 0, 1, 2, 9 },
+        { -4, -6, -8, -9, 3, 5, 7, 8 },
+        { -3, -5, -7, -9, 2, 4, 6, 8 },
+    };
+
+    static const int BC7_WEIGHTS_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    static int Clamp255(int v)
+    {
+        return Mathf::Clamp(v, 0, 255);
+    }
+
+    static int Square(int v)
+    {
+        return v * v;
+    }
+
+    // principal axis of the block colors through their mean, channel_count is 3 or 4
+    static void FitLine(const byte* block, int channel_count, float* mean, float* axis)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            mean[c] = 0;
+            axis[c] = 0;
+        }
+
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int c = 0; c < channel_count; ++c)
+            {
+                mean[c] += block[i * 4 + c];
+            }
+        }
+        for (int c = 0; c < channel_count; ++c)
+        {
+            mean[c] /= 16.0f;
+        }
+
+        float cov[4][4] = { { 0 } };
+        for (int i = 0; i < 16; ++i)
+        {
+            float d[4];
+            for (int c = 0; c < channel_count; ++c)
+            {
+                d[c] = block[i * 4 + c] - mean[c];
+            }
+            for (int a = 0; a < channel_count; ++a)
+            {
+                for (int b = 0; b < channel_count; ++b)
+                {
+                    cov[a][b] += d[a] * d[b];
+                }
+            }
+        }
+
+        float v[4] = { 1, 1, 1, 1 };
+        for (int iter = 0; iter < 8; ++iter)
+        {
+            float next[4] = { 0 };
+            float max = 0;
+            for (int a = 0; a < channel_count; ++a)
+            {
+                for (int b = 0; b < channel_count; ++b)
+                {
+                    next[a] += cov[a][b] * v[b];
+                }
+                max = Mathf::Max(max, fabsf(next[a]));
+            }
+
+            if (max < 1e-6f)
+            {
+                break;
+            }
+
+            for (int a = 0; a < channel_count; ++a)
+            {
+                v[a] = next[a] / max;
+            }
+        }
+
+        float length = 0;
+        for (int c = 0; c < channel_count; ++c)
+        {
+            length += v[c] * v[c];
+        }
+        length = sqrtf(length);
+
+        for (int c = 0; c < channel_count; ++c)
+        {
+            axis[c] = v[c] / length;
+        }
+    }
+
+    static void FitEndpoints(const byte* block, int channel_count, float* e0, float* e1)
+    {
+        float mean[4];
+        float axis[4];
+        FitLine(block, channel_count, mean, axis);
+
+        float min = 1e9f;
+        float max = -1e9f;
+        for (int i = 0; i < 16; ++i)
+        {
+            float t = 0;
+            for (int c = 0; c < channel_count; ++c)
+            {
+                t += (block[i * 4 + c] - mean[c]) * axis[c];
+            }
+            min = Mathf::Min(min, t);
+            max = Mathf::Max(max, t);
+        }
+
+        for (int c = 0; c < channel_count; ++c)
+        {
+            e0[c] = Mathf::Clamp(mean[c] + axis[c] * max, 0.0f, 255.0f);
+            e1[c] = Mathf::Clamp(mean[c] + axis[c] * min, 0.0f, 255.0f);
+        }
+    }
+
+    static unsigned short PackRGB565(const float* c)
+    {
+        int r = Mathf::Clamp((int) (c[0] * 31 / 255.0f + 0.5f), 0, 31);
+        int g = Mathf::Clamp((int) (c[1] * 63 / 255.0f + 0.5f), 0, 63);
+        int b = Mathf::Clamp((int) (c[2] * 31 / 255.0f + 0.5f), 0, 31);
+        return (unsigned short) ((r << 11) | (g << 5) | b);
+    }
+
+    static void UnpackRGB565(unsigned short v, int* c)
+    {
+        int r = (v >> 11) & 31;
+        int g = (v >> 5) & 63;
+        int b = v & 31;
+        c[0] = (r << 3) | (r >> 2);
+        c[1] = (g << 2) | (g >> 4);
+        c[2] = (b << 3) | (b >> 2);
+    }
+
+    // 4 color mode needs color0 > color1, returns the error
+    static int EncodeBC1Indices(const byte* block, unsigned short& c0, unsigned short& c1, unsigned int& indices)
+    {
+        if (c0 < c1)
+        {
+            unsigned short t = c0;
+            c0 = c1;
+            c1 = t;
+        }
+
+        indices = 0;
+
+        int palette[4][3];
+        UnpackRGB565(c0, palette[0]);
+        UnpackRGB565(c1, palette[1]);
+
+        int error = 0;
+
+        if (c0 == c1)
+        {
+            for (int i = 0; i < 16; ++i)
+            {
+                for (int c = 0; c < 3; ++c)
+                {
+                    error += Square(block[i * 4 + c] - palette[0][c]);
+                }
+            }
+            return error;
+        }
+
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0;
+            int best_error = 0x7fffffff;
+            for (int j = 0; j < 4; ++j)
+            {
+                int e = 0;
+                for (int c = 0; c < 3; ++c)
+                {
+                    e += Square(block[i * 4 + c] - palette[j][c]);
+                }
+                if (e < best_error)
+                {
+                    best_error = e;
+                    best = j;
+                }
+            }
+
+            indices |= best << (i * 2);
+            error += best_error;
+        }
+
+        return error;
+    }
+
+    // least squares endpoints for fixed indices
+    static bool RefineBC1(const byte* block, unsigned int indices, float* e0, float* e1)
+    {
+        static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3, 1.0f / 3 };
+
+        float aa = 0, bb = 0, ab = 0;
+        float ax[3] = { 0 }, bx[3] = { 0 };
+        for (int i = 0; i < 16; ++i)
+        {
+            float a = weights[(indices >> (i * 2)) & 3];
+            float b = 1.0f - a;
+            aa += a * a;
+            bb += b * b;
+            ab += a * b;
+            for (int c = 0; c < 3; ++c)
+            {
+                ax[c] += a * block[i * 4 + c];
+                bx[c] += b * block[i * 4 + c];
+            }
+        }
+
+        float det = aa * bb - ab * ab;
+        if (fabsf(det) < 1e-6f)
+        {
+            return false;
+        }
+
+        for (int c = 0; c < 3; ++c)
+        {
+            e0[c] = Mathf::Clamp((ax[c] * bb - bx[c] * ab) / det, 0.0f, 255.0f);
+            e1[c] = Mathf::Clamp((bx[c] * aa - ax[c] * ab) / det, 0.0f, 255.0f);
+        }
+
+        return true;
+    }
+
+    static void EncodeBC1(const byte* block, byte* out)
+    {
+        float e0[4];
+        float e1[4];
+        FitEndpoints(block, 3, e0, e1);
+
+        unsigned short c0 = PackRGB565(e0);
+        unsigned short c1 = PackRGB565(e1);
+        unsigned int indices;
+        int error = EncodeBC1Indices(block, c0, c1, indices);
+
+        if (error > 0 && c0 != c1 && RefineBC1(block, indices, e0, e1))
+        {
+            unsigned short r0 = PackRGB565(e0);
+            unsigned short r1 = PackRGB565(e1);
+            unsigned int refine_indices;
+            int refine_error = EncodeBC1Indices(block, r0, r1, refine_indices);
+            if (refine_error < error)
+            {
+                c0 = r0;
+                c1 = r1;
+                indices = refine_indices;
+            }
+        }
+
+        out[0] = c0 & 0xff;
+        out[1] = c0 >> 8;
+        out[2] = c1 & 0xff;
+        out[3] = c1 >> 8;
+        for (int i = 0; i < 4; ++i)
+        {
+            out[4 + i] = (indices >> (i * 8)) & 0xff;
+        }
+    }
+
+    // one channel of the block with stride 4
+    static void EncodeBC4(const byte* values, byte* out)
+    {
+        int min = 255;
+        int max = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            min = Mathf::Min(min, (int) values[i * 4]);
+            max = Mathf::Max(max, (int) values[i * 4]);
+        }
+
+        out[0] = (byte) max;
+        out[1] = (byte) min;
+
+        unsigned long long indices = 0;
+
+        if (max > min)
+        {
+            int palette[8];
+            palette[0] = max;
+            palette[1] = min;
+            for (int i = 2; i < 8; ++i)
+            {
+                palette[i] = ((8 - i) * max + (i - 1) * min) / 7;
+            }
+
+            for (int i = 0; i < 16; ++i)
+            {
+                int best = 0;
+                int best_error = 0x7fffffff;
+                for (int j = 0; j < 8; ++j)
+                {
+                    int e = Square(values[i * 4] - palette[j]);
+                    if (e < best_error)
+                    {
+                        best_error = e;
+                        best = j;
+                    }
+                }
+
+                indices |= (unsigned long long) best << (i * 3);
+            }
+        }
+
+        for (int i = 0; i < 6; ++i)
+        {
+            out[2 + i] = (indices >> (i * 8)) & 0xff;
+        }
+    }
+
+    class BitWriter
+    {
+    public:
+        BitWriter(byte* out, int size):
+            m_out(out),
+            m_pos(0)
+        {
+            Memory::Zero(out, size);
+        }
+
+        void Write(unsigned int value, int bits)
+        {
+            for (int i = 0; i < bits; ++i)
+            {
+                if (value & (1 << i))
+                {
+                    m_out[m_pos >> 3] |= 1 << (m_pos & 7);
+                }
+                ++m_pos;
+            }
+        }
+
+    private:
+        byte* m_out;
+        int m_pos;
+    };
+
+    // 7 bit endpoint with a shared p bit, picks the p bit with less error
+    static void QuantizeBC7Endpoint(const float* e, int* q, int& p)
+    {
+        float best_error = 1e30f;
+        for (int pb = 0; pb < 2; ++pb)
+        {
+            int candidate[4];
+            float error = 0;
+            for (int c = 0; c < 4; ++c)
+            {
+                candidate[c] = Mathf::Clamp((int) ((e[c] - pb) / 2 + 0.5f), 0, 127);
+                float d = (candidate[c] * 2 + pb) - e[c];
+                error += d * d;
+            }
+
+            if (error < best_error)
+            {
+                best_error = error;
+                p = pb;
+                for (int c = 0; c < 4; ++c)
+                {
+                    q[c] = candidate[c];
+                }
+            }
+        }
+    }
+
+    // mode 6, one subset of rgba 7.7.7.7 endpoints with p bits and 4 bit indices
+    static void EncodeBC7(const byte* block, byte* out)
+    {
+        float e0[4];
+        float e1[4];
+        FitEndpoints(block, 4, e0, e1);
+
+        int q[2][4];
+        int p[2];
+        QuantizeBC7Endpoint(e0, q[0], p[0]);
+        QuantizeBC7Endpoint(e1, q[1], p[1]);
+
+        int palette[16][4];
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                int a = q[0][c] * 2 + p[0];
+                int b = q[1][c] * 2 + p[1];
+                palette[i][c] = ((64 - BC7_WEIGHTS_4[i]) * a + BC7_WEIGHTS_4[i] * b + 32) >> 6;
+            }
+        }
+
+        int indices[16];
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0;
+            int best_error = 0x7fffffff;
+            for (int j = 0; j < 16; ++j)
+            {
+                int e = 0;
+                for (int c = 0; c < 4; ++c)
+                {
+                    e += Square(block[i * 4 + c] - palette[j][c]);
+                }
+                if (e < best_error)
+                {
+                    best_error = e;
+                    best = j;
+                }
+            }
+            indices[i] = best;
+        }
+
+        // the anchor index drops its high bit
+        if (indices[0] >= 8)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                int t = q[0][c];
+                q[0][c] = q[1][c];
+                q[1][c] = t;
+            }
+            int t = p[0];
+            p[0] = p[1];
+            p[1] = t;
+
+            for (int i = 0; i < 16; ++i)
+            {
+                indices[i] = 15 - indices[i];
+            }
+        }
+
+        BitWriter writer(out, 16);
+        writer.Write(1 << 6, 7);
+        for (int c = 0; c < 4; ++c)
+        {
+            writer.Write(q[0][c], 7);
+            writer.Write(q[1][c], 7);
+        }
+        writer.Write(p[0], 1);
+        writer.Write(p[1], 1);
+        writer.Write(indices[0], 3);
+        for (int i = 1; i < 16; ++i)
+        {
+            writer.Write(indices[i], 4);
+        }
+    }
+
+    static void WriteBigEndian64(unsigned long long bits, byte* out)
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            out[i] = (bits >> (56 - i * 8)) & 0xff;
+        }
+    }
+
+    // best table and indices for one etc subblock with a fixed base color, returns the error
+    static int EncodeETCSubblock(const byte* block, const int* pixels, const int* base, int& table, int* indices)
+    {
+        int best_error = 0x7fffffff;
+
+        for (int t = 0; t < 8; ++t)
+        {
+            int modifiers[4] = { ETC1_MODIFIERS[t][0], ETC1_MODIFIERS[t][1], -ETC1_MODIFIERS[t][0], -ETC1_MODIFIERS[t][1] };
+            int error = 0;
+            int table_indices[8];
+
+            for (int i = 0; i < 8; ++i)
+            {
+                const byte* color = &block[pixels[i] * 4];
+                int best = 0;
+                int best_pixel_error = 0x7fffffff;
+                for (int j = 0; j < 4; ++j)
+                {
+                    int e = 0;
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        e += Square(color[c] - Clamp255(base[c] + modifiers[j]));
+                    }
+                    if (e < best_pixel_error)
+                    {
+                        best_pixel_error = e;
+                        best = j;
+                    }
+                }
+                table_indices[i] = best;
+                error += best_pixel_error;
+            }
+
+            if (error < best_error)
+            {
+                best_error = error;
+                table = t;
+                for (int i = 0; i < 8; ++i)
+                {
+                    indices[i] = table_indices[i];
+                }
+            }
+        }
+
+        return best_error;
+    }
+
+    struct ETCSubblockFit
+    {
+        int quantized[3];
+        int table;
+        int indices[8];
+        int error;
+    };
+
+    // tries the rounded average and its neighbors, bits is 4 or 5
+    static void FitETCSubblock(const byte* block, const int* pixels, int bits, ETCSubblockFit& fit)
+    {
+        int max = (1 << bits) - 1;
+        float average[3] = { 0, 0, 0 };
+        for (int i = 0; i < 8; ++i)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                average[c] += block[pixels[i] * 4 + c];
+            }
+        }
+
+        int center[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            center[c] = Mathf::Clamp((int) (average[c] / 8 * max / 255.0f + 0.5f), 0, max);
+        }
+
+        fit.error = 0x7fffffff;
+
+        for (int dr = -1; dr <= 1; ++dr)
+        {
+            for (int dg = -1; dg <= 1; ++dg)
+            {
+                for (int db = -1; db <= 1; ++db)
+                {
+                    int q[3] = { center[0] + dr, center[1] + dg, center[2] + db };
+                    if (q[0] < 0 || q[0] > max || q[1] < 0 || q[1] > max || q[2] < 0 || q[2] > max)
+                    {
+                        continue;
+                    }
+
+                    int base[3];
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        base[c] = bits == 4 ? (q[c] << 4) | q[c] : (q[c] << 3) | (q[c] >> 2);
+                    }
+
+                    int table;
+                    int indices[8];
+                    int error = EncodeETCSubblock(block, pixels, base, table, indices);
+                    if (error < fit.error)
+                    {
+                        fit.error = error;
+                        fit.table = table;
+                        for (int c = 0; c < 3; ++c)
+                        {
+                            fit.quantized[c] = q[c];
+                        }
+                        for (int i = 0; i < 8; ++i)
+                        {
+                            fit.indices[i] = indices[i];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // etc1 individual and differential modes, which decode the same in etc2
+    static void EncodeETC2RGB(const byte* block, byte* out)
+    {
+        unsigned long long best_bits = 0;
+        int best_error = 0x7fffffff;
+
+        for (int flip = 0; flip < 2; ++flip)
+        {
+            int pixels[2][8];
+            int count[2] = { 0, 0 };
+            for (int y = 0; y < 4; ++y)
+            {
+                for (int x = 0; x < 4; ++x)
+                {
+                    int sub = flip ? (y >= 2) : (x >= 2);
+                    pixels[sub][count[sub]++] = y * 4 + x;
+                }
+            }
+
+            for (int diff = 0; diff < 2; ++diff)
+            {
+                ETCSubblockFit fits[2];
+                FitETCSubblock(block, pixels[0], diff ? 5 : 4, fits[0]);
+                FitETCSubblock(block, pixels[1], diff ? 5 : 4, fits[1]);
+
+                int delta[3];
+                if (diff)
+                {
+                    bool valid = true;
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        delta[c] = fits[1].quantized[c] - fits[0].quantized[c];
+                        if (delta[c] < -4 || delta[c] > 3)
+                        {
+                            valid = false;
+                        }
+                    }
+                    if (!valid)
+                    {
+                        continue;
+                    }
+                }
+
+                int error = fits[0].error + fits[1].error;
+                if (error >= best_error)
+                {
+                    continue;
+                }
+                best_error = error;
+
+                unsigned long long bits = 0;
+                if (diff)
+                {
+                    bits |= (unsigned long long) fits[0].quantized[0] << 59;
+                    bits |= (unsigned long long) (delta[0] & 7) << 56;
+                    bits |= (unsigned long long) fits[0].quantized[1] << 51;
+                    bits |= (unsigned long long) (delta[1] & 7) << 48;
+                    bits |= (unsigned long long) fits[0].quantized[2] << 43;
+                    bits |= (unsigned long long) (delta[2] & 7) << 40;
+                }
+                else
+                {
+                    bits |= (unsigned long long) fits[0].quantized[0] << 60;
+                    bits |= (unsigned long long) fits[1].quantized[0] << 56;
+                    bits |= (unsigned long long) fits[0].quantized[1] << 52;
+                    bits |= (unsigned long long) fits[1].quantized[1] << 48;
+                    bits |= (unsigned long long) fits[0].quantized[2] << 44;
+                    bits |= (unsigned long long) fits[1].quantized[2] << 40;
+                }
+                bits |= (unsigned long long) fits[0].table << 37;
+                bits |= (unsigned long long) fits[1].table << 34;
+                bits |= (unsigned long long) diff << 33;
+                bits |= (unsigned long long) flip << 32;
+
+                // pixel indices are stored column major, high bits in the upper half
+                for (int sub = 0; sub < 2; ++sub)
+                {
+                    for (int i = 0; i < 8; ++i)
+                    {
+                        int x = pixels[sub][i] % 4;
+                        int y = pixels[sub][i] / 4;
+                        int bit = x * 4 + y;
+                        int index = fits[sub].indices[i];
+                        bits |= (unsigned long long) (index >> 1) << (16 + bit);
+                        bits |= (unsigned long long) (index & 1) << bit;
+                    }
+                }
+
+                best_bits = bits;
+            }
+        }
+
+        WriteBigEndian64(best_bits, out);
+    }
+
+    static int FitEAC(const byte* block, int base, int multiplier, int table, int* indices)
+    {
+        int error = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0;
+            int best_error = 0x7fffffff;
+            for (int j = 0; j < 8; ++j)
+            {
+                int e = Square(block[i * 4 + 3] - Clamp255(base + EAC_MODIFIERS[table][j] * multiplier));
+                if (e < best_error)
+                {
+                    best_error = e;
+                    best = j;
+                }
+            }
+            indices[i] = best;
+            error += best_error;
+        }
+        return error;
+    }
+
+    static void EncodeEACAlpha(const byte* block, byte* out)
+    {
+        int min = 255;
+        int max = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            min = Mathf::Min(min, (int) block[i * 4 + 3]);
+            max = Mathf::Max(max, (int) block[i * 4 + 3]);
+        }
+
+        int best_base = max;
+        int best_multiplier = 1;
+        int best_table = 13;
+        int best_indices[16];
+        int best_error = FitEAC(block, best_base, best_multiplier, best_table, best_indices);
+
+        for (int t = 0; t < 16 && best_error > 0; ++t)
+        {
+            int table_min = EAC_MODIFIERS[t][3];
+            int table_max = EAC_MODIFIERS[t][7];
+            int center_multiplier = Mathf::Max(1, (int) ((max - min) / (float) (table_max - table_min) + 0.5f));
+
+            for (int m = center_multiplier - 1; m <= center_multiplier + 1; ++m)
+            {
+                if (m < 1 || m > 15)
+                {
+                    continue;
+                }
+
+                int center_base = Clamp255((int) ((min + max) / 2.0f - (table_min + table_max) * m / 2.0f + 0.5f));
+                for (int b = center_base - 1; b <= center_base + 1; ++b)
+                {
+                    if (b < 0 || b > 255)
+                    {
+                        continue;
+                    }
+
+                    int indices[16];
+                    int error = FitEAC(block, b, m, t, indices);
+                    if (error < best_error)
+                    {
+                        best_error = error;
+                        best_base = b;
+                        best_multiplier = m;
+                        best_table = t;
+                        Memory::Copy(best_indices, indices, sizeof(indices));
+                    }
+                }
+            }
+        }
+
+        unsigned long long bits = 0;
+        bits |= (unsigned long long) best_base << 56;
+        bits |= (unsigned long long) best_multiplier << 52;
+        bits |= (unsigned long long) best_table << 48;
+        for (int y = 0; y < 4; ++y)
+        {
+            for (int x = 0; x < 4; ++x)
+            {
+                int i = x * 4 + y;
+                bits |= (unsigned long long) best_indices[y * 4 + x] << (45 - i * 3);
+            }
+        }
+
+        WriteBigEndian64(bits, out);
+    }
+
+    bool TextureCompressor::IsFormatSupported(TextureFormat format)
+    {
+        switch (format)
+        {
+            case TextureFormat::BC1:
+            case TextureFormat::BC3:
+            case TextureFormat::BC4:
+            case TextureFormat::BC5:
+            case TextureFormat::BC7:
+            case TextureFormat::ETC2_R8G8B8:
+            case TextureFormat::ETC2_R8G8B8A8:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    ByteBuffer TextureCompressor::Compress(const ByteBuffer& rgba, int width, int height, TextureFormat format)
+    {
+        assert(IsFormatSupported(format));
+        assert(rgba.Size() == width * height * 4);
+
+        int block_width;
+        int block_height;
+        int block_bytes;
+        TextureFormatInfo::GetBlockSize(format, block_width, block_height, block_bytes);
+
+        int block_x = (width + 3) / 4;
+        int block_y = (height + 3) / 4;
+        ByteBuffer blocks(block_x * block_y * block_bytes);
+
+        byte block[64];
+
+        for (int by = 0; by < block_y; ++by)
+        {
+            for (int bx = 0; bx < block_x; ++bx)
+            {
+                for (int y = 0; y < 4; ++y)
+                {
+                    for (int x = 0; x < 4; ++x)
+                    {
+                        int px = Mathf::Min(bx * 4 + x, width - 1);
+                        int py = Mathf::Min(by * 4 + y, height - 1);
+                        Memory::Copy(&block[(y * 4 + x) * 4], &rgba[(py * width + px) * 4], 4);
+                    }
+                }
+
+                byte* out = &blocks[(by * block_x + bx) * block_bytes];
+
+                switch (format)
+                {
+                    case TextureFormat::BC1:
+                        EncodeBC1(block, out);
+                        break;
+                    case TextureFormat::BC3:
+                        EncodeBC4(&block[3], out);
+                        EncodeBC1(block, out + 8);
+                        break;
+                    case TextureFormat::BC4:
+                        EncodeBC4(&block[0], out);
+                        break;
+                    case TextureFormat::BC5:
+                        EncodeBC4(&block[0], out);
+                        EncodeBC4(&block[1], out + 8);
+                        break;
+                    case TextureFormat::BC7:
+                        EncodeBC7(block, out);
+                        break;
+                    case TextureFormat::ETC2_R8G8B8:
+                        EncodeETC2RGB(block, out);
+                        break;
+                    case TextureFormat::ETC2_R8G8B8A8:
+                        EncodeEACAlpha(block, out);
+                        EncodeETC2RGB(block, out + 8);
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+
+        return blocks;
+    }
+}
@@ -0,0 +1,34 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "TextureFormat.h"
+#include "memory/ByteBuffer.h"
+
+namespace Viry3D
+{
+    // cpu block encoder for offline use, favors simple fits over exhaustive searches.
+    // bc1 is always opaque, bc7 uses mode 6 only, etc2 uses the etc1 compatible modes only, astc is not encoded.
+    class TextureCompressor
+    {
+    public:
+        static bool IsFormatSupported(TextureFormat format);
+        // rgba8 pixels in, edge blocks repeat the last row and column
+        static ByteBuffer Compress(const ByteBuffer& rgba, int width, int height, TextureFormat format);
+    };
+}
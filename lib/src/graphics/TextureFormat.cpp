@@ -0,0 +1,143 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "TextureFormat.h"
+#include <string.h>
+
+namespace Viry3D
+{
+    static const char* g_texture_format_names[] = {
+        "None",
+        "R8",
+        "R8G8",
+        "R8G8B8A8",
+        "R32G32B32A32F",
+        "D16",
+        "D24X8",
+        "D32",
+        "D16S8",
+        "D24S8",
+        "D32S8",
+        "S8",
+        "BC1",
+        "BC3",
+        "BC4",
+        "BC5",
+        "BC7",
+        "ETC2_R8G8B8",
+        "ETC2_R8G8B8A8",
+        "ASTC_4x4",
+        "ASTC_6x6",
+        "ASTC_8x8",
+    };
+
+    bool TextureFormatInfo::IsCompressed(TextureFormat format)
+    {
+        return format >= TextureFormat::BC1 && format <= TextureFormat::ASTC_8x8;
+    }
+
+    void TextureFormatInfo::GetBlockSize(TextureFormat format, int& block_width, int& block_height, int& block_bytes)
+    {
+        block_width = 1;
+        block_height = 1;
+
+        switch (format)
+        {
+            case TextureFormat::R8:
+            case TextureFormat::S8:
+                block_bytes = 1;
+                break;
+            case TextureFormat::R8G8:
+            case TextureFormat::D16:
+                block_bytes = 2;
+                break;
+            case TextureFormat::D16S8:
+            case TextureFormat::D24S8:
+            case TextureFormat::D24X8:
+            case TextureFormat::D32:
+            case TextureFormat::R8G8B8A8:
+                block_bytes = 4;
+                break;
+            case TextureFormat::D32S8:
+                block_bytes = 8;
+                break;
+            case TextureFormat::R32G32B32A32F:
+                block_bytes = 16;
+                break;
+            case TextureFormat::BC1:
+            case TextureFormat::BC4:
+            case TextureFormat::ETC2_R8G8B8:
+                block_width = 4;
+                block_height = 4;
+                block_bytes = 8;
+                break;
+            case TextureFormat::BC3:
+            case TextureFormat::BC5:
+            case TextureFormat::BC7:
+            case TextureFormat::ETC2_R8G8B8A8:
+            case TextureFormat::ASTC_4x4:
+                block_width = 4;
+                block_height = 4;
+                block_bytes = 16;
+                break;
+            case TextureFormat::ASTC_6x6:
+                block_width = 6;
+                block_height = 6;
+                block_bytes = 16;
+                break;
+            case TextureFormat::ASTC_8x8:
+                block_width = 8;
+                block_height = 8;
+                block_bytes = 16;
+                break;
+            default:
+                block_bytes = 0;
+                break;
+        }
+    }
+
+    int TextureFormatInfo::GetImageSize(TextureFormat format, int width, int height)
+    {
+        int block_width;
+        int block_height;
+        int block_bytes;
+        GetBlockSize(format, block_width, block_height, block_bytes);
+
+        int block_x = (width + block_width - 1) / block_width;
+        int block_y = (height + block_height - 1) / block_height;
+
+        return block_x * block_y * block_bytes;
+    }
+
+    const char* TextureFormatInfo::GetName(TextureFormat format)
+    {
+        return g_texture_format_names[(int) format];
+    }
+
+    TextureFormat TextureFormatInfo::FromName(const char* name)
+    {
+        for (int i = 0; i < (int) (sizeof(g_texture_format_names) / sizeof(g_texture_format_names[0])); ++i)
+        {
+            if (strcmp(g_texture_format_names[i], name) == 0)
+            {
+                return (TextureFormat) i;
+            }
+        }
+
+        return TextureFormat::None;
+    }
+}
@@ -0,0 +1,58 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+namespace Viry3D
+{
+    enum class TextureFormat
+    {
+        None,
+        R8,
+        R8G8,
+        R8G8B8A8,
+        R32G32B32A32F,
+        D16,
+        D24X8,
+        D32,
+        D16S8,
+        D24S8,
+        D32S8,
+        S8,
+        BC1,
+        BC3,
+        BC4,
+        BC5,
+        BC7,
+        ETC2_R8G8B8,
+        ETC2_R8G8B8A8,
+        ASTC_4x4,
+        ASTC_6x6,
+        ASTC_8x8,
+    };
+
+    class TextureFormatInfo
+    {
+    public:
+        static bool IsCompressed(TextureFormat format);
+        // uncompressed formats are 1x1 blocks of one pixel
+        static void GetBlockSize(TextureFormat format, int& block_width, int& block_height, int& block_bytes);
+        static int GetImageSize(TextureFormat format, int width, int height);
+        static const char* GetName(TextureFormat format);
+        static TextureFormat FromName(const char* name);
+    };
+}
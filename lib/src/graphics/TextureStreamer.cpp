@@ -0,0 +1,524 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "TextureStreamer.h"
+#include "KTX.h"
+#include "Camera.h"
+#include "Renderer.h"
+#include "Material.h"
+#include "Application.h"
+#include "Debug.h"
+#include "io/MappedFile.h"
+#include "math/Mathf.h"
+#include "memory/Memory.h"
+#include "time/Time.h"
+
+namespace Viry3D
+{
+    // levels read by a worker, owned so the file can be closed
+    class TextureStreamerLevels : public Object
+    {
+    public:
+        KTXImage image;
+    };
+
+    Map<Texture*, TextureStreamer::Entry> TextureStreamer::m_entries;
+    int TextureStreamer::m_budget = 128 * 1024 * 1024;
+    int TextureStreamer::m_min_resident_size = 64;
+    int TextureStreamer::m_mip_bias = 0;
+    int TextureStreamer::m_keep_frames = 30;
+    int TextureStreamer::m_max_pending_loads = 2;
+    TextureStreamerStats TextureStreamer::m_stats;
+    Vector<Ref<Texture>> TextureStreamer::m_retired_textures;
+    Vector<Ref<Texture>> TextureStreamer::m_retired_textures_prev;
+    static Mutex g_entries_mutex;
+
+    static void SliceLevels(const KTXImage& image, int level, KTXImage& slice)
+    {
+        slice.format = image.format;
+        slice.width = Mathf::Max(image.width >> level, 1);
+        slice.height = Mathf::Max(image.height >> level, 1);
+        slice.layer_count = image.layer_count;
+        slice.face_count = image.face_count;
+        slice.level_count = image.level_count - level;
+        slice.images.Clear();
+        for (int i = level; i < image.level_count; ++i)
+        {
+            slice.images.Add(image.images[i]);
+        }
+    }
+
+    static bool IsStreamable(const KTXImage& image)
+    {
+        return image.level_count > 1 && image.layer_count == 1 && image.face_count == 1;
+    }
+
+    Ref<Texture> TextureStreamer::LoadTexture(
+        const String& path,
+        FilterMode filter_mode,
+        SamplerAddressMode wrap_mode)
+    {
+        Ref<Texture> texture;
+
+        Ref<MappedFile> file = MappedFile::Open(path);
+        if (!file)
+        {
+            Log("texture file not exist: %s", path.CString());
+            return texture;
+        }
+
+        KTXImage image;
+        if (!KTX::Load(file->GetBuffer(), image))
+        {
+            Log("invalid ktx file: %s", path.CString());
+            return texture;
+        }
+
+        String* value;
+        if (image.key_values.TryGet(KTX_KEY_FILTER_MODE, &value))
+        {
+            filter_mode = (FilterMode) atoi(value->CString());
+        }
+        if (image.key_values.TryGet(KTX_KEY_WRAP_MODE, &value))
+        {
+            wrap_mode = (SamplerAddressMode) atoi(value->CString());
+        }
+
+        if (!IsStreamable(image))
+        {
+            texture = Texture::CreateTextureFromKTX(image, filter_mode, wrap_mode);
+            if (!texture)
+            {
+                Log("create texture failed: %s", path.CString());
+            }
+            return texture;
+        }
+
+        Entry entry;
+        entry.path = path;
+        entry.filter_mode = filter_mode;
+        entry.wrap_mode = wrap_mode;
+        entry.width = image.width;
+        entry.height = image.height;
+        entry.level_count = image.level_count;
+        entry.min_level = image.level_count - 1;
+        entry.level_bytes.Resize(image.level_count);
+        for (int i = 0; i < image.level_count; ++i)
+        {
+            int w = Mathf::Max(image.width >> i, 1);
+            int h = Mathf::Max(image.height >> i, 1);
+            entry.level_bytes[i] = TextureFormatInfo::GetImageSize(image.format, w, h);
+
+            if (i < entry.min_level && Mathf::Max(w, h) <= m_min_resident_size)
+            {
+                entry.min_level = i;
+            }
+        }
+        entry.resident_level = entry.min_level;
+        entry.wanted_level = entry.min_level;
+        entry.target_level = entry.min_level;
+        entry.pending_level = -1;
+        entry.last_seen_frame = -1;
+        entry.screen_size = 0;
+        entry.failed = false;
+
+        // small levels first, the rest streams in once a camera sees the texture
+        KTXImage slice;
+        SliceLevels(image, entry.min_level, slice);
+        texture = Texture::CreateTextureFromKTX(slice, filter_mode, wrap_mode);
+        if (!texture)
+        {
+            Log("create texture failed: %s", path.CString());
+            return texture;
+        }
+        entry.texture = texture;
+
+        std::lock_guard<Mutex> lock(g_entries_mutex);
+        // the address of a released texture can come back
+        m_entries.Remove(texture.get());
+        m_entries.Add(texture.get(), entry);
+
+        return texture;
+    }
+
+    bool TextureStreamer::IsStreamed(const Ref<Texture>& texture)
+    {
+        return GetResidentLevel(texture) >= 0;
+    }
+
+    int TextureStreamer::GetResidentLevel(const Ref<Texture>& texture)
+    {
+        std::lock_guard<Mutex> lock(g_entries_mutex);
+
+        Entry* entry;
+        if (texture && m_entries.TryGet(texture.get(), &entry) && entry->texture.lock() == texture)
+        {
+            return entry->resident_level;
+        }
+
+        return -1;
+    }
+
+    int TextureStreamer::GetResidentBytes(const Ref<Texture>& texture)
+    {
+        std::lock_guard<Mutex> lock(g_entries_mutex);
+
+        Entry* entry;
+        if (texture && m_entries.TryGet(texture.get(), &entry) && entry->texture.lock() == texture)
+        {
+            return GetBytes(*entry, entry->resident_level);
+        }
+
+        return 0;
+    }
+
+    void TextureStreamer::OnCameraUpdate(Camera* camera)
+    {
+        std::lock_guard<Mutex> lock(g_entries_mutex);
+
+        if (m_entries.Empty())
+        {
+            return;
+        }
+
+        int frame = Time::GetFrameCount();
+
+        for (const auto& i : camera->GetRenderers())
+        {
+            const Ref<Renderer>& renderer = i.renderer;
+            if (renderer->IsCulled())
+            {
+                continue;
+            }
+
+            bool size_done = false;
+            float screen_size = 0;
+
+            const Ref<Material>* materials[2] = { &renderer->GetMaterial(), &renderer->GetInstanceMaterial() };
+            for (int j = 0; j < 2; ++j)
+            {
+                if (!*materials[j])
+                {
+                    continue;
+                }
+
+                for (const auto& k : (*materials[j])->GetProperties())
+                {
+                    const MaterialProperty& property = k.second;
+                    Entry* entry;
+                    if (property.type != MaterialProperty::Type::Texture ||
+                        !property.texture ||
+                        !m_entries.TryGet(property.texture.get(), &entry) ||
+                        entry->texture.lock() != property.texture)
+                    {
+                        continue;
+                    }
+
+                    if (!size_done)
+                    {
+                        size_done = true;
+                        screen_size = renderer->GetScreenSize(camera);
+                    }
+
+                    // unknown size wants the full texture
+                    float size = screen_size;
+                    if (size < 0)
+                    {
+                        size = (float) Mathf::Max(entry->width, entry->height);
+                    }
+
+                    if (entry->last_seen_frame != frame)
+                    {
+                        entry->last_seen_frame = frame;
+                        entry->screen_size = size;
+                    }
+                    else
+                    {
+                        entry->screen_size = Mathf::Max(entry->screen_size, size);
+                    }
+                }
+            }
+        }
+    }
+
+    int TextureStreamer::GetBytes(const Entry& entry, int level)
+    {
+        int bytes = 0;
+        for (int i = level; i < entry.level_count; ++i)
+        {
+            bytes += entry.level_bytes[i];
+        }
+        return bytes;
+    }
+
+    void TextureStreamer::ApplyBudget()
+    {
+        int total = 0;
+        for (auto& i : m_entries)
+        {
+            i.second.target_level = i.second.wanted_level;
+            total += GetBytes(i.second, i.second.target_level);
+        }
+        m_stats.wanted_bytes = total;
+
+        // drop one level at a time from the least recently seen, then the largest level
+        while (total > m_budget)
+        {
+            Entry* drop = nullptr;
+            int drop_bytes = 0;
+            for (auto& i : m_entries)
+            {
+                Entry& entry = i.second;
+                if (entry.target_level >= entry.min_level)
+                {
+                    continue;
+                }
+
+                int bytes = entry.level_bytes[entry.target_level];
+                if (drop == nullptr ||
+                    entry.last_seen_frame < drop->last_seen_frame ||
+                    (entry.last_seen_frame == drop->last_seen_frame && bytes > drop_bytes))
+                {
+                    drop = &entry;
+                    drop_bytes = bytes;
+                }
+            }
+
+            if (drop == nullptr)
+            {
+                break;
+            }
+
+            drop->target_level += 1;
+            total -= drop_bytes;
+        }
+    }
+
+    void TextureStreamer::Update()
+    {
+        std::lock_guard<Mutex> lock(g_entries_mutex);
+
+        // images swapped out before the last frame are no longer used by any submitted command
+        m_retired_textures_prev = m_retired_textures;
+        m_retired_textures.Clear();
+
+        int frame = Time::GetFrameCount();
+
+        for (auto i = m_entries.begin(); i != m_entries.end(); )
+        {
+            if (i->second.texture.expired())
+            {
+                i = m_entries.Remove(i);
+                continue;
+            }
+
+            Entry& entry = i->second;
+            if (entry.failed)
+            {
+                entry.wanted_level = entry.resident_level;
+            }
+            else if (entry.last_seen_frame >= 0 && frame - entry.last_seen_frame <= m_keep_frames)
+            {
+                int size = Mathf::Max(entry.width, entry.height);
+                int level = entry.min_level;
+                if (entry.screen_size > 0)
+                {
+                    level = (int) floor(Mathf::Log2(size / entry.screen_size)) + m_mip_bias;
+                }
+                entry.wanted_level = Mathf::Clamp(level, 0, entry.min_level);
+            }
+            else
+            {
+                entry.wanted_level = entry.min_level;
+            }
+
+            ++i;
+        }
+
+        ApplyBudget();
+
+        int pending_count = 0;
+        for (const auto& i : m_entries)
+        {
+            if (i.second.pending_level >= 0)
+            {
+                ++pending_count;
+            }
+        }
+
+        // drops free memory first, then the levels wanted most
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            while (pending_count < m_max_pending_loads)
+            {
+                Texture* load_key = nullptr;
+                Entry* load = nullptr;
+                for (auto& i : m_entries)
+                {
+                    Entry& entry = i.second;
+                    if (entry.pending_level >= 0 || entry.target_level == entry.resident_level)
+                    {
+                        continue;
+                    }
+                    if ((pass == 0) != (entry.target_level > entry.resident_level))
+                    {
+                        continue;
+                    }
+
+                    if (load == nullptr || entry.screen_size > load->screen_size)
+                    {
+                        load_key = i.first;
+                        load = &entry;
+                    }
+                }
+
+                if (load == nullptr)
+                {
+                    break;
+                }
+
+                StartLoad(load_key, *load);
+                ++pending_count;
+            }
+        }
+
+        m_stats.texture_count = m_entries.Size();
+        m_stats.pending_count = pending_count;
+        m_stats.resident_bytes = 0;
+        for (const auto& i : m_entries)
+        {
+            m_stats.resident_bytes += GetBytes(i.second, i.second.resident_level);
+        }
+    }
+
+    void TextureStreamer::StartLoad(Texture* key, Entry& entry)
+    {
+        int level = entry.target_level;
+        String path = entry.path;
+        FilterMode filter_mode = entry.filter_mode;
+        SamplerAddressMode wrap_mode = entry.wrap_mode;
+        entry.pending_level = level;
+
+        Thread::Task task;
+        task.job = [=]() -> Ref<Object> {
+            Ref<MappedFile> file = MappedFile::Open(path);
+            KTXImage image;
+            if (!file || !KTX::Load(file->GetBuffer(), image) || level >= image.level_count)
+            {
+                return Ref<Object>();
+            }
+
+            Ref<TextureStreamerLevels> levels = RefMake<TextureStreamerLevels>();
+            SliceLevels(image, level, levels->image);
+
+            // the images point into the mapping
+            for (int i = 0; i < levels->image.images.Size(); ++i)
+            {
+                const ByteBuffer& src = levels->image.images[i];
+                ByteBuffer dst(src.Size());
+                Memory::Copy(dst.Bytes(), src.Bytes(), src.Size());
+                levels->image.images[i] = dst;
+            }
+
+            return levels;
+        };
+        task.complete = [=](const Ref<Object>& res) {
+            Ref<TextureStreamerLevels> levels = RefCast<TextureStreamerLevels>(res);
+            Ref<Texture> texture;
+            if (levels)
+            {
+                texture = Texture::CreateTextureFromKTX(levels->image, filter_mode, wrap_mode);
+            }
+            OnLoaded(key, level, texture);
+        };
+
+        ThreadPool* pool = Application::Instance()->GetThreadPool();
+        if (pool)
+        {
+            pool->AddTask(task);
+        }
+        else
+        {
+            // Update holds the entries lock, so the completion is posted like a pool task's
+            Ref<Object> res = task.job();
+            Application::Instance()->PostAction([=]() {
+                task.complete(res);
+            });
+        }
+    }
+
+    void TextureStreamer::OnLoaded(Texture* key, int level, const Ref<Texture>& texture)
+    {
+        std::lock_guard<Mutex> lock(g_entries_mutex);
+
+        Entry* entry;
+        if (!m_entries.TryGet(key, &entry) || entry->pending_level != level)
+        {
+            return;
+        }
+        entry->pending_level = -1;
+
+        Ref<Texture> target = entry->texture.lock();
+        if (!target)
+        {
+            return;
+        }
+
+        if (!texture)
+        {
+            // keep what is resident and do not retry this file
+            Log("texture stream failed: %s", entry->path.CString());
+            entry->failed = true;
+            return;
+        }
+
+        if (level < entry->resident_level)
+        {
+            m_stats.streamed_in += 1;
+        }
+        else
+        {
+            m_stats.streamed_out += 1;
+        }
+        entry->resident_level = level;
+
+        // the old image goes with texture, which is kept until the frames using it are done
+        target->SwapImage(texture);
+#if VR_VULKAN
+        texture->m_retired = true;
+#endif
+        m_retired_textures.Add(texture);
+    }
+
+    void TextureStreamer::Done()
+    {
+        std::lock_guard<Mutex> lock(g_entries_mutex);
+
+        m_entries.Clear();
+        m_stats = TextureStreamerStats();
+
+        // no later frame releases them, so wait for the device once
+#if VR_VULKAN
+        if (m_retired_textures.Size() > 0 || m_retired_textures_prev.Size() > 0)
+        {
+            Display::Instance()->WaitDevice();
+        }
+#endif
+        m_retired_textures.Clear();
+        m_retired_textures_prev.Clear();
+    }
+}
@@ -0,0 +1,114 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "Texture.h"
+#include "container/Vector.h"
+#include "container/Map.h"
+
+namespace Viry3D
+{
+    class Camera;
+
+    struct TextureStreamerStats
+    {
+        int texture_count = 0;
+        int pending_count = 0;
+        // bytes of the streamed textures on the gpu
+        int resident_bytes = 0;
+        // bytes the visible textures want before the budget is applied
+        int wanted_bytes = 0;
+        int streamed_in = 0;
+        int streamed_out = 0;
+    };
+
+    // streams the large mip levels of 2d ktx textures in and out under a memory budget.
+    // a texture loads with its small levels only, cameras report how many pixels the renderers using it span,
+    // and the wanted levels are read from the file on a worker thread, then swapped into the same texture object.
+    class TextureStreamer
+    {
+    public:
+        // arrays, cubemaps and files without mipmaps load fully and are not streamed
+        static Ref<Texture> LoadTexture(
+            const String& path,
+            FilterMode filter_mode,
+            SamplerAddressMode wrap_mode);
+        // Camera::Update calls it after culling
+        static void OnCameraUpdate(Camera* camera);
+        // once per frame after drawing, applies the budget and starts the loads
+        static void Update();
+        static void Done();
+        static bool IsStreamed(const Ref<Texture>& texture);
+        // first file level on the gpu, -1 for textures not streamed
+        static int GetResidentLevel(const Ref<Texture>& texture);
+        // bytes of the resident levels, 0 for textures not streamed
+        static int GetResidentBytes(const Ref<Texture>& texture);
+        static int GetBudget() { return m_budget; }
+        static void SetBudget(int bytes) { m_budget = bytes; }
+        // levels no larger than this always stay resident
+        static int GetMinResidentSize() { return m_min_resident_size; }
+        static void SetMinResidentSize(int size) { m_min_resident_size = size; }
+        // added to the level picked from screen size, negative for tiled textures
+        static int GetMipBias() { return m_mip_bias; }
+        static void SetMipBias(int bias) { m_mip_bias = bias; }
+        // frames a texture keeps its levels after it was last seen
+        static int GetKeepFrames() { return m_keep_frames; }
+        static void SetKeepFrames(int frames) { m_keep_frames = frames; }
+        static int GetMaxPendingLoads() { return m_max_pending_loads; }
+        static void SetMaxPendingLoads(int count) { m_max_pending_loads = count; }
+        static const TextureStreamerStats& GetStats() { return m_stats; }
+
+    private:
+        struct Entry
+        {
+            WeakRef<Texture> texture;
+            String path;
+            FilterMode filter_mode;
+            SamplerAddressMode wrap_mode;
+            int width;
+            int height;
+            int level_count;
+            // lowest level always resident
+            int min_level;
+            int resident_level;
+            int wanted_level;
+            int target_level;
+            int pending_level;
+            int last_seen_frame;
+            float screen_size;
+            bool failed;
+            Vector<int> level_bytes;
+        };
+
+        static int GetBytes(const Entry& entry, int level);
+        static void ApplyBudget();
+        static void StartLoad(Texture* key, Entry& entry);
+        static void OnLoaded(Texture* key, int level, const Ref<Texture>& texture);
+
+    private:
+        static Map<Texture*, Entry> m_entries;
+        static int m_budget;
+        static int m_min_resident_size;
+        static int m_mip_bias;
+        static int m_keep_frames;
+        static int m_max_pending_loads;
+        static TextureStreamerStats m_stats;
+        static Vector<Ref<Texture>> m_retired_textures;
+        static Vector<Ref<Texture>> m_retired_textures_prev;
+    };
+}
@@ -208,16 +208,20 @@ namespace Viry3D
 	void Directory::Create(const String& path)
 	{
 		auto splits = path.Split("/", true);
-		String folder = splits[0];
+		String folder;
 
 		if (path.StartsWith("/"))
 		{
-			folder = "/" + folder;
+			folder = "/";
 		}
 
-		for (int i = 1; i < splits.Size(); ++i)
+		for (int i = 0; i < splits.Size(); ++i)
 		{
-			folder += "/" + splits[i];
+			if (i > 0)
+			{
+				folder += "/";
+			}
+			folder += splits[i];
 
 #if VR_WINDOWS || VR_UWP
 			CreateDirectoryA(folder.CString(), nullptr);
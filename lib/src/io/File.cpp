@@ -17,12 +17,16 @@
 
 #include "File.h"
 #include "Directory.h"
+#include "FileSystem.h"
+#include "memory/Memory.h"
 #include "Debug.h"
 #include "zlib/unzip.h"
 #include <fstream>
 
 #if VR_WINDOWS
 #include <Windows.h>
+#else
+#include <stdio.h>
 #endif
 
 namespace Viry3D
@@ -32,12 +36,12 @@ namespace Viry3D
     extern ByteBuffer FileReadAllBytes(const String& path);
     extern bool FileWriteAllBytes(const String& path, const ByteBuffer& buffer);
 
-    bool File::Exist(const String& path)
+    bool File::ExistNative(const String& path)
     {
         return FileExist(path);
     }
 
-    ByteBuffer File::ReadAllBytes(const String& path)
+    ByteBuffer File::ReadAllBytesNative(const String& path)
     {
         return FileReadAllBytes(path);
     }
@@ -47,7 +51,7 @@ namespace Viry3D
         return FileWriteAllBytes(path, buffer);
     }
 #else
-    bool File::Exist(const String& path)
+    bool File::ExistNative(const String& path)
     {
         std::ifstream is(path.CString(), std::ios::binary);
 
@@ -61,7 +65,7 @@ namespace Viry3D
         return exist;
     }
 
-    ByteBuffer File::ReadAllBytes(const String& path)
+    ByteBuffer File::ReadAllBytesNative(const String& path)
     {
         ByteBuffer buffer;
 
@@ -98,6 +102,38 @@ namespace Viry3D
     }
 #endif
 
+    bool File::Exist(const String& path)
+    {
+        bool exist;
+        if (FileSystem::Exist(path, &exist))
+        {
+            return exist;
+        }
+
+        return File::ExistNative(path);
+    }
+
+    ByteBuffer File::ReadAllBytes(const String& path)
+    {
+        Ref<MappedFile> file;
+        if (FileSystem::Open(path, &file))
+        {
+            if (!file)
+            {
+                return ByteBuffer();
+            }
+            if (file->IsMapped())
+            {
+                ByteBuffer buffer(file->GetSize());
+                Memory::Copy(buffer.Bytes(), file->GetBuffer().Bytes(), file->GetSize());
+                return buffer;
+            }
+            return file->GetBuffer();
+        }
+
+        return File::ReadAllBytesNative(path);
+    }
+
 	String File::ReadAllText(const String& path)
 	{
 		return String(File::ReadAllBytes(path));
@@ -113,6 +149,8 @@ namespace Viry3D
     {
 #if VR_WINDOWS
         ::DeleteFile(path.CString());
+#else
+        ::remove(path.CString());
 #endif
     }
 
@@ -27,6 +27,9 @@ namespace Viry3D
 	public:
 		static bool Exist(const String& path);
 		static ByteBuffer ReadAllBytes(const String& path);
+        // skip the FileSystem mounts
+        static bool ExistNative(const String& path);
+        static ByteBuffer ReadAllBytesNative(const String& path);
 		static bool WriteAllBytes(const String& path, const ByteBuffer& buffer);
 		static String ReadAllText(const String& path);
 		static bool WriteAllText(const String& path, const String& text);
@@ -0,0 +1,427 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#include "FileSystem.h"
+#include "File.h"
+#include "Directory.h"
+#include "Pak.h"
+#include "container/List.h"
+#include "memory/Memory.h"
+#include "thread/ThreadPool.h"
+
+namespace Viry3D
+{
+    class FileMount
+    {
+    public:
+        virtual ~FileMount() { }
+        // paths relative to the mount point
+        virtual bool Exist(const String& path) const = 0;
+        virtual Ref<MappedFile> Open(const String& path) const = 0;
+
+        String name;
+        String mount_point;
+        // a path under the mount point missing here does not exist on the disk either
+        bool complete = false;
+    };
+
+    class DirectoryMount : public FileMount
+    {
+    public:
+        virtual bool Exist(const String& path) const
+        {
+            return files.Contains(path);
+        }
+
+        virtual Ref<MappedFile> Open(const String& path) const
+        {
+            if (files.Contains(path))
+            {
+                return MappedFile::OpenNative(name + "/" + path);
+            }
+            return Ref<MappedFile>();
+        }
+
+        Map<String, bool> files;
+    };
+
+    class PakMount : public FileMount
+    {
+    public:
+        virtual bool Exist(const String& path) const
+        {
+            return pak->Exist(path.CString(), path.Size());
+        }
+
+        virtual Ref<MappedFile> Open(const String& path) const
+        {
+            return pak->Open(path.CString(), path.Size());
+        }
+
+        Ref<Pak> pak;
+    };
+
+    class MemoryMount : public FileMount
+    {
+    public:
+        virtual bool Exist(const String& path) const
+        {
+            return files.Contains(path);
+        }
+
+        virtual Ref<MappedFile> Open(const String& path) const
+        {
+            const Ref<MappedFile>* file;
+            if (files.TryGet(path, &file))
+            {
+                // a view so readers copy instead of sharing the mounted data
+                return MappedFile::Wrap(ByteBuffer((*file)->GetBuffer().Bytes(), (*file)->GetSize()), *file);
+            }
+            return Ref<MappedFile>();
+        }
+
+        Map<String, Ref<MappedFile>> files;
+    };
+
+    struct PrefetchBatch
+    {
+        int pending = 0;
+        std::function<void()> complete;
+    };
+
+    struct PrefetchItem
+    {
+        String path;
+        Ref<PrefetchBatch> batch;
+    };
+
+    static Mutex g_mutex;
+    static Vector<Ref<FileMount>> g_mounts;
+    static Map<String, ByteBuffer> g_prefetched;
+    static Map<String, bool> g_prefetching;
+    // the io layer does not use the thread pool, whose callbacks need the application
+    static Ref<std::thread> g_prefetch_thread;
+    static std::condition_variable g_prefetch_condition;
+    static List<PrefetchItem> g_prefetch_queue;
+    static List<Ref<PrefetchBatch>> g_prefetch_batches;
+    static bool g_prefetch_close = false;
+
+    static String TrimMountPoint(const String& mount_point)
+    {
+        if (mount_point.EndsWith("/"))
+        {
+            return mount_point.Substring(0, mount_point.Size() - 1);
+        }
+        return mount_point;
+    }
+
+    static void AddMount(const Ref<FileMount>& mount, const String& name, const String& mount_point)
+    {
+        mount->name = name;
+        mount->mount_point = TrimMountPoint(mount_point);
+
+        std::lock_guard<Mutex> lock(g_mutex);
+        g_mounts.Add(mount);
+    }
+
+    static Ref<FileMount> FindMount(const String& path, String& relative, bool* complete)
+    {
+        std::lock_guard<Mutex> lock(g_mutex);
+
+        *complete = false;
+
+        for (int i = g_mounts.Size() - 1; i >= 0; --i)
+        {
+            const Ref<FileMount>& mount = g_mounts[i];
+            const String& mount_point = mount->mount_point;
+
+            if (mount_point.Size() > 0)
+            {
+                if (path.Size() <= mount_point.Size() || path[mount_point.Size()] != '/' || !path.StartsWith(mount_point))
+                {
+                    continue;
+                }
+                relative = path.Substring(mount_point.Size() + 1);
+            }
+            else
+            {
+                relative = path;
+            }
+
+            if (mount->Exist(relative))
+            {
+                return mount;
+            }
+            // an empty mount point covers every path, it only decides the files it has
+            if (mount->complete && mount_point.Size() > 0)
+            {
+                *complete = true;
+            }
+        }
+
+        return Ref<FileMount>();
+    }
+
+    bool FileSystem::MountDirectory(const String& directory, const String& mount_point)
+    {
+        String path = TrimMountPoint(directory);
+        if (!Directory::Exist(path))
+        {
+            return false;
+        }
+
+        Ref<DirectoryMount> mount = RefMake<DirectoryMount>();
+        mount->complete = true;
+        Vector<String> files = Directory::GetFiles(path, true);
+        for (const auto& i : files)
+        {
+            mount->files.Add(i.Substring(path.Size() + 1), true);
+        }
+
+        AddMount(mount, path, mount_point);
+
+        return true;
+    }
+
+    bool FileSystem::MountPak(const String& path, const String& mount_point)
+    {
+        Ref<Pak> pak = Pak::Load(path);
+        if (!pak)
+        {
+            return false;
+        }
+
+        Ref<PakMount> mount = RefMake<PakMount>();
+        mount->pak = pak;
+
+        AddMount(mount, path, mount_point);
+
+        return true;
+    }
+
+    void FileSystem::MountMemory(const String& name, const String& mount_point, const Map<String, ByteBuffer>& files)
+    {
+        Ref<MemoryMount> mount = RefMake<MemoryMount>();
+        for (const auto& i : files)
+        {
+            mount->files.Add(i.first, MappedFile::Wrap(i.second, Ref<MappedFile>()));
+        }
+
+        AddMount(mount, name, mount_point);
+    }
+
+    void FileSystem::Unmount(const String& name)
+    {
+        std::lock_guard<Mutex> lock(g_mutex);
+        for (int i = g_mounts.Size() - 1; i >= 0; --i)
+        {
+            if (g_mounts[i]->name == name)
+            {
+                g_mounts.Remove(i);
+            }
+        }
+    }
+
+    void FileSystem::UnmountAll()
+    {
+        std::lock_guard<Mutex> lock(g_mutex);
+        g_mounts.Clear();
+    }
+
+    bool FileSystem::Exist(const String& path, bool* exist)
+    {
+        {
+            std::lock_guard<Mutex> lock(g_mutex);
+            if (g_prefetched.Contains(path))
+            {
+                *exist = true;
+                return true;
+            }
+        }
+
+        String relative;
+        bool complete;
+        if (FindMount(path, relative, &complete))
+        {
+            *exist = true;
+            return true;
+        }
+        if (complete)
+        {
+            *exist = false;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool FileSystem::Open(const String& path, Ref<MappedFile>* file)
+    {
+        {
+            std::lock_guard<Mutex> lock(g_mutex);
+            ByteBuffer* buffer;
+            if (g_prefetched.TryGet(path, &buffer))
+            {
+                *file = MappedFile::Wrap(*buffer, Ref<MappedFile>());
+                g_prefetched.Remove(path);
+                return true;
+            }
+        }
+
+        String relative;
+        bool complete;
+        Ref<FileMount> mount = FindMount(path, relative, &complete);
+        if (mount)
+        {
+            *file = mount->Open(relative);
+            return true;
+        }
+        if (complete)
+        {
+            *file = Ref<MappedFile>();
+            return true;
+        }
+
+        return false;
+    }
+
+    static void PrefetchRun()
+    {
+        while (true)
+        {
+            PrefetchItem item;
+            {
+                std::unique_lock<Mutex> lock(g_mutex);
+                g_prefetch_condition.wait(lock, []() {
+                    return !g_prefetch_queue.Empty() || g_prefetch_close;
+                });
+
+                if (g_prefetch_close)
+                {
+                    break;
+                }
+
+                item = g_prefetch_queue.First();
+                g_prefetch_queue.RemoveFirst();
+            }
+
+            // copied so the data is in memory, not only mapped
+            Ref<MappedFile> file = MappedFile::Open(item.path);
+            ByteBuffer buffer;
+            if (file)
+            {
+                buffer = ByteBuffer(file->GetSize());
+                Memory::Copy(buffer.Bytes(), file->GetBuffer().Bytes(), file->GetSize());
+            }
+
+            std::lock_guard<Mutex> lock(g_mutex);
+            g_prefetching.Remove(item.path);
+            if (file)
+            {
+                g_prefetched.Remove(item.path);
+                g_prefetched.Add(item.path, buffer);
+            }
+            item.batch->pending -= 1;
+        }
+    }
+
+    void FileSystem::Prefetch(const Vector<String>& paths, std::function<void()> complete)
+    {
+        Ref<PrefetchBatch> batch = RefMake<PrefetchBatch>();
+        batch->complete = complete;
+
+        std::lock_guard<Mutex> lock(g_mutex);
+
+        for (const auto& i : paths)
+        {
+            if (!g_prefetched.Contains(i) && !g_prefetching.Contains(i))
+            {
+                g_prefetching.Add(i, true);
+                g_prefetch_queue.AddLast({ i, batch });
+                batch->pending += 1;
+            }
+        }
+
+        // files already read or being read complete with the next update
+        g_prefetch_batches.AddLast(batch);
+
+        if (batch->pending > 0)
+        {
+            if (!g_prefetch_thread)
+            {
+                g_prefetch_close = false;
+                g_prefetch_thread = RefMake<std::thread>(PrefetchRun);
+            }
+            g_prefetch_condition.notify_one();
+        }
+    }
+
+    void FileSystem::DropPrefetched()
+    {
+        std::lock_guard<Mutex> lock(g_mutex);
+        g_prefetched.Clear();
+    }
+
+    void FileSystem::Update()
+    {
+        List<Ref<PrefetchBatch>> complete_batches;
+        {
+            std::lock_guard<Mutex> lock(g_mutex);
+            for (auto i = g_prefetch_batches.begin(); i != g_prefetch_batches.end(); )
+            {
+                if ((*i)->pending == 0)
+                {
+                    complete_batches.AddLast(*i);
+                    i = g_prefetch_batches.Remove(i);
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+        }
+
+        for (const auto& i : complete_batches)
+        {
+            if (i->complete)
+            {
+                i->complete();
+            }
+        }
+    }
+
+    void FileSystem::Done()
+    {
+        if (g_prefetch_thread)
+        {
+            {
+                std::lock_guard<Mutex> lock(g_mutex);
+                g_prefetch_close = true;
+                g_prefetch_condition.notify_one();
+            }
+            g_prefetch_thread->join();
+            g_prefetch_thread.reset();
+        }
+
+        g_prefetch_queue.Clear();
+        g_prefetch_batches.Clear();
+        g_prefetching.Clear();
+        FileSystem::UnmountAll();
+        FileSystem::DropPrefetched();
+    }
+}
@@ -0,0 +1,56 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#pragma once
+
+#include "MappedFile.h"
+#include "container/Vector.h"
+#include "container/Map.h"
+#include <functional>
+
+namespace Viry3D
+{
+    // mount points File and MappedFile read through. a path under a mount point is looked up in the mounts
+    // from the last mounted to the first, paths no mount covers go to the disk as before
+    class FileSystem
+    {
+    public:
+        // the file list is scanned once, so lookups under the mount point need no disk access.
+        // it is the whole truth for them, remount to see files added later.
+        // with an empty mount point a missing file falls through to the other mounts and the disk
+        static bool MountDirectory(const String& directory, const String& mount_point);
+        static bool MountPak(const String& path, const String& mount_point);
+        // files by path relative to the mount point, name is used to unmount
+        static void MountMemory(const String& name, const String& mount_point, const Map<String, ByteBuffer>& files);
+        // name is the directory, pak path or memory mount name
+        static void Unmount(const String& name);
+        static void UnmountAll();
+        // false when the disk decides
+        static bool Exist(const String& path, bool* exist);
+        // false when the disk decides
+        static bool Open(const String& path, Ref<MappedFile>* file);
+        // reads the files into memory on a background thread, the next open of each takes its data from there.
+        // complete runs in Update after all of them are read
+        static void Prefetch(const Vector<String>& paths, std::function<void()> complete = nullptr);
+        // frees the prefetched files nothing opened yet
+        static void DropPrefetched();
+        // once per frame on the main thread
+        static void Update();
+        static void Done();
+    };
+}
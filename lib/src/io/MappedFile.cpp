@@ -0,0 +1,159 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "MappedFile.h"
+#include "File.h"
+#include "FileSystem.h"
+#include "Debug.h"
+
+#if VR_WINDOWS
+#include <Windows.h>
+#elif !VR_UWP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Viry3D
+{
+    Ref<MappedFile> MappedFile::Open(const String& path)
+    {
+        Ref<MappedFile> file;
+        if (FileSystem::Open(path, &file))
+        {
+            return file;
+        }
+
+        return MappedFile::OpenNative(path);
+    }
+
+    Ref<MappedFile> MappedFile::OpenNative(const String& path)
+    {
+        Ref<MappedFile> file;
+
+#if VR_WINDOWS
+        HANDLE handle = CreateFileA(path.CString(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE)
+        {
+            return file;
+        }
+
+        file = Ref<MappedFile>(new MappedFile());
+        file->m_file = handle;
+        file->m_size = (int) GetFileSize(handle, nullptr);
+
+        if (file->m_size > 0)
+        {
+            file->m_mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (file->m_mapping)
+            {
+                file->m_data = MapViewOfFile(file->m_mapping, FILE_MAP_READ, 0, 0, 0);
+            }
+        }
+#elif VR_UWP
+        if (!File::ExistNative(path))
+        {
+            return file;
+        }
+
+        file = Ref<MappedFile>(new MappedFile());
+        file->m_buffer = File::ReadAllBytesNative(path);
+        file->m_size = file->m_buffer.Size();
+        return file;
+#else
+        int fd = open(path.CString(), O_RDONLY);
+        if (fd < 0)
+        {
+            return file;
+        }
+
+        file = Ref<MappedFile>(new MappedFile());
+
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            file->m_size = (int) st.st_size;
+
+            void* data = mmap(nullptr, (size_t) file->m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED)
+            {
+                file->m_data = data;
+            }
+        }
+
+        // the mapping keeps the file referenced
+        close(fd);
+#endif
+
+        if (file->m_data)
+        {
+            file->m_buffer = ByteBuffer((byte*) file->m_data, file->m_size);
+        }
+        else if (file->m_size > 0)
+        {
+            Log("map file failed, read it instead: %s", path.CString());
+            file->m_buffer = File::ReadAllBytesNative(path);
+        }
+
+        return file;
+    }
+
+    Ref<MappedFile> MappedFile::Wrap(const ByteBuffer& buffer, const Ref<MappedFile>& owner)
+    {
+        Ref<MappedFile> file = Ref<MappedFile>(new MappedFile());
+        file->m_buffer = buffer;
+        file->m_owner = owner;
+        file->m_size = buffer.Size();
+        return file;
+    }
+
+    MappedFile::MappedFile():
+#if VR_WINDOWS
+        m_file(nullptr),
+        m_mapping(nullptr),
+#endif
+        m_data(nullptr),
+        m_size(0)
+    {
+    }
+
+    MappedFile::~MappedFile()
+    {
+        m_buffer = ByteBuffer();
+
+#if VR_WINDOWS
+        if (m_data)
+        {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mapping)
+        {
+            CloseHandle((HANDLE) m_mapping);
+        }
+        if (m_file)
+        {
+            CloseHandle((HANDLE) m_file);
+        }
+#elif !VR_UWP
+        if (m_data)
+        {
+            munmap(m_data, (size_t) m_size);
+        }
+#endif
+    }
+}
@@ -0,0 +1,56 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "memory/Ref.h"
+#include "memory/ByteBuffer.h"
+#include "string/String.h"
+
+namespace Viry3D
+{
+    // read only mapping of a whole file, platforms without file mapping read it into memory instead
+    class MappedFile
+    {
+    public:
+        // files under FileSystem mount points are opened from their mount
+        static Ref<MappedFile> Open(const String& path);
+        // skips the mounts
+        static Ref<MappedFile> OpenNative(const String& path);
+        // a buffer owned by the returned object, or a view into the owner kept alive with it
+        static Ref<MappedFile> Wrap(const ByteBuffer& buffer, const Ref<MappedFile>& owner);
+        ~MappedFile();
+        // weak view of the file data, valid while this object lives
+        const ByteBuffer& GetBuffer() const { return m_buffer; }
+        int GetSize() const { return m_buffer.Size(); }
+        // the buffer is a view, copy it to keep the data past this object
+        bool IsMapped() const { return m_data != nullptr || m_owner; }
+
+    private:
+        MappedFile();
+
+    private:
+        ByteBuffer m_buffer;
+        Ref<MappedFile> m_owner;
+#if VR_WINDOWS
+        void* m_file;
+        void* m_mapping;
+#endif
+        void* m_data;
+        int m_size;
+    };
+}
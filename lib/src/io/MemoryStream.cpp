@@ -25,6 +25,13 @@ namespace Viry3D
 		m_length = m_buffer.Size();
 	}
 
+	MemoryStream::MemoryStream(const Ref<MappedFile>& file):
+		m_buffer(file->GetBuffer()),
+		m_file(file)
+	{
+		m_length = m_buffer.Size();
+	}
+
 	int MemoryStream::Read(void* buffer, int size)
 	{
 		int pos = m_position;
@@ -40,6 +47,8 @@ namespace Viry3D
 
 	int MemoryStream::Write(void* buffer, int size)
 	{
+		assert(!m_file);
+
 		int pos = m_position;
 		int write = Stream::Write(buffer, size);
 
@@ -53,8 +62,19 @@ namespace Viry3D
 
 	String MemoryStream::ReadString(int size)
 	{
-		ByteBuffer buffer(size);
-		Read(buffer.Bytes(), size);
-		return String(buffer);
+		return String(ReadBuffer(size));
+	}
+
+	ByteBuffer MemoryStream::ReadBuffer(int size)
+	{
+		int pos = m_position;
+		int read = Stream::Read(nullptr, size);
+
+		if (read > 0)
+		{
+			return ByteBuffer(&m_buffer[pos], read);
+		}
+
+		return ByteBuffer();
 	}
 }
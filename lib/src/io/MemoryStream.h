@@ -18,6 +18,7 @@
 #pragma once
 
 #include "Stream.h"
+#include "MappedFile.h"
 #include "memory/ByteBuffer.h"
 #include "memory/Memory.h"
 #include "string/String.h"
@@ -29,6 +30,8 @@ namespace Viry3D
 	{
 	public:
 		MemoryStream(const ByteBuffer& buffer);
+		// reads the mapped file data in place and keeps the mapping alive, writing is not allowed
+		MemoryStream(const Ref<MappedFile>& file);
 		virtual int Read(void* buffer, int size);
 		virtual int Write(void* buffer, int size);
 		template<class T>
@@ -36,9 +39,15 @@ namespace Viry3D
 		template<class T>
 		void Write(const T& t);
 		String ReadString(int size);
+		// weak view of the next size bytes without copying, valid while the stream data lives.
+		// the view is not aligned, copy elements out of it instead of casting
+		ByteBuffer ReadBuffer(int size);
+		int GetPosition() const { return m_position; }
+		int GetLength() const { return m_length; }
 
 	private:
 		ByteBuffer m_buffer;
+		Ref<MappedFile> m_file;
 	};
 
 	template<class T>
@@ -0,0 +1,256 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#include "Pak.h"
+#include "File.h"
+#include "MemoryStream.h"
+#include "memory/Memory.h"
+#include "Debug.h"
+#include "zlib/zlib.h"
+
+#define PAK_FILE_VERSION 1
+#define PAK_FILE_ALIGNMENT 16
+#define PAK_HEADER_SIZE 24
+#define PAK_COMPRESSION_NONE 0
+#define PAK_COMPRESSION_ZLIB 1
+
+namespace Viry3D
+{
+    static const byte PAK_FILE_IDENTIFIER[8] = { 0xAB, 'V', 'R', 'P', 'A', 'K', 0x0D, 0x0A };
+
+    static int AlignOffset(int offset)
+    {
+        return (offset + PAK_FILE_ALIGNMENT - 1) / PAK_FILE_ALIGNMENT * PAK_FILE_ALIGNMENT;
+    }
+
+    // fnv-1a
+    unsigned int Pak::HashPath(const char* path, int size)
+    {
+        unsigned int hash = 2166136261u;
+        for (int i = 0; i < size; ++i)
+        {
+            hash ^= (unsigned char) path[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    Ref<Pak> Pak::Load(const String& path)
+    {
+        Ref<Pak> pak;
+
+        Ref<MappedFile> file = MappedFile::Open(path);
+        if (!file || file->GetSize() < PAK_HEADER_SIZE ||
+            Memory::Compare(file->GetBuffer().Bytes(), PAK_FILE_IDENTIFIER, sizeof(PAK_FILE_IDENTIFIER)) != 0)
+        {
+            Log("pak open failed: %s", path.CString());
+            return pak;
+        }
+
+        MemoryStream ms(file->GetBuffer());
+        ms.ReadBuffer(sizeof(PAK_FILE_IDENTIFIER));
+
+        unsigned int version = ms.Read<unsigned int>();
+        int entry_count = ms.Read<int>();
+        int names_size = ms.Read<int>();
+        if (version != PAK_FILE_VERSION)
+        {
+            Log("pak version not support: %d", version);
+            return pak;
+        }
+        if (entry_count < 0 || names_size < 0 ||
+            entry_count > (file->GetSize() - PAK_HEADER_SIZE) / (int) sizeof(Entry) ||
+            names_size > file->GetSize() - PAK_HEADER_SIZE - entry_count * (int) sizeof(Entry))
+        {
+            Log("pak index invalid: %s", path.CString());
+            return pak;
+        }
+
+        pak = RefMake<Pak>();
+        pak->m_path = path;
+        pak->m_file = file;
+        pak->m_entries = (const Entry*) &file->GetBuffer()[PAK_HEADER_SIZE];
+        pak->m_entry_count = entry_count;
+        pak->m_names = (const char*) &file->GetBuffer()[PAK_HEADER_SIZE + entry_count * sizeof(Entry)];
+
+        int bucket_count = 1;
+        while (bucket_count < entry_count)
+        {
+            bucket_count <<= 1;
+        }
+        pak->m_buckets.Resize(bucket_count, -1);
+        pak->m_next.Resize(entry_count, -1);
+
+        for (int i = 0; i < entry_count; ++i)
+        {
+            const Entry& entry = pak->m_entries[i];
+            if (entry.name_offset > (unsigned int) names_size || entry.name_size > (unsigned int) names_size - entry.name_offset ||
+                entry.offset > (unsigned int) file->GetSize() || entry.stored_size > (unsigned int) file->GetSize() - entry.offset ||
+                (entry.compression == PAK_COMPRESSION_NONE && entry.stored_size != entry.size))
+            {
+                Log("pak entry invalid: %s %d", path.CString(), i);
+                return Ref<Pak>();
+            }
+
+            int bucket = (int) (entry.hash & (bucket_count - 1));
+            pak->m_next[i] = pak->m_buckets[bucket];
+            pak->m_buckets[bucket] = i;
+        }
+
+        return pak;
+    }
+
+    const Pak::Entry* Pak::FindEntry(const char* path, int size) const
+    {
+        if (m_entry_count == 0)
+        {
+            return nullptr;
+        }
+
+        unsigned int hash = HashPath(path, size);
+        int index = m_buckets[hash & (m_buckets.Size() - 1)];
+        while (index >= 0)
+        {
+            const Entry& entry = m_entries[index];
+            if (entry.hash == hash && entry.name_size == (unsigned int) size && Memory::Compare(&m_names[entry.name_offset], path, size) == 0)
+            {
+                return &entry;
+            }
+            index = m_next[index];
+        }
+
+        return nullptr;
+    }
+
+    Ref<MappedFile> Pak::Open(const char* path, int size) const
+    {
+        const Entry* entry = this->FindEntry(path, size);
+        if (entry == nullptr)
+        {
+            return Ref<MappedFile>();
+        }
+
+        const ByteBuffer& file = m_file->GetBuffer();
+
+        if (entry->compression == PAK_COMPRESSION_NONE)
+        {
+            return MappedFile::Wrap(ByteBuffer(&file.Bytes()[entry->offset], entry->size), m_file);
+        }
+        else if (entry->compression == PAK_COMPRESSION_ZLIB)
+        {
+            ByteBuffer buffer(entry->size);
+
+            z_stream stream;
+            Memory::Zero(&stream, sizeof(stream));
+            stream.next_in = &file.Bytes()[entry->offset];
+            stream.avail_in = entry->stored_size;
+            stream.next_out = buffer.Bytes();
+            stream.avail_out = entry->size;
+
+            // a single inflate call straight from the mapping into the buffer
+            int result = inflateInit(&stream);
+            if (result == Z_OK)
+            {
+                result = inflate(&stream, Z_FINISH);
+                inflateEnd(&stream);
+            }
+
+            if (result != Z_STREAM_END || stream.total_out != entry->size)
+            {
+                Log("pak inflate failed: %s", m_path.CString());
+                return Ref<MappedFile>();
+            }
+
+            return MappedFile::Wrap(buffer, Ref<MappedFile>());
+        }
+        else
+        {
+            Log("pak compression not support: %d", entry->compression);
+            return Ref<MappedFile>();
+        }
+    }
+
+    bool Pak::Save(const String& path, const Vector<PakFile>& files)
+    {
+        Vector<Entry> entries(files.Size());
+        Vector<ByteBuffer> blocks(files.Size());
+        int names_size = 0;
+
+        for (int i = 0; i < files.Size(); ++i)
+        {
+            const PakFile& file = files[i];
+            Entry& entry = entries[i];
+            entry.hash = HashPath(file.path.CString(), file.path.Size());
+            entry.name_offset = names_size;
+            entry.name_size = file.path.Size();
+            entry.compression = PAK_COMPRESSION_NONE;
+            entry.size = file.data.Size();
+            blocks[i] = file.data;
+            names_size += file.path.Size();
+
+            if (file.compress && file.data.Size() > 0)
+            {
+                uLongf compressed_size = compressBound((uLong) file.data.Size());
+                ByteBuffer compressed((int) compressed_size);
+                int result = compress2(compressed.Bytes(), &compressed_size, file.data.Bytes(), (uLong) file.data.Size(), Z_BEST_COMPRESSION);
+                if (result == Z_OK && (int) compressed_size < file.data.Size())
+                {
+                    blocks[i] = ByteBuffer((int) compressed_size);
+                    Memory::Copy(blocks[i].Bytes(), compressed.Bytes(), (int) compressed_size);
+                    entry.compression = PAK_COMPRESSION_ZLIB;
+                }
+            }
+            entry.stored_size = blocks[i].Size();
+        }
+
+        int size = PAK_HEADER_SIZE + entries.Size() * sizeof(Entry) + names_size;
+        for (int i = 0; i < entries.Size(); ++i)
+        {
+            size = AlignOffset(size);
+            entries[i].offset = size;
+            size += blocks[i].Size();
+        }
+
+        ByteBuffer buffer(size);
+        Memory::Zero(buffer.Bytes(), buffer.Size());
+        MemoryStream ms(buffer);
+
+        ms.Write((void*) PAK_FILE_IDENTIFIER, sizeof(PAK_FILE_IDENTIFIER));
+        ms.Write<unsigned int>(PAK_FILE_VERSION);
+        ms.Write<int>(entries.Size());
+        ms.Write<int>(names_size);
+        ms.Write<int>(0);
+        if (entries.Size() > 0)
+        {
+            ms.Write((void*) &entries[0], entries.SizeInBytes());
+        }
+        for (const auto& i : files)
+        {
+            ms.Write((void*) i.path.CString(), i.path.Size());
+        }
+        for (int i = 0; i < entries.Size(); ++i)
+        {
+            if (blocks[i].Size() > 0)
+            {
+                Memory::Copy(&buffer[entries[i].offset], blocks[i].Bytes(), blocks[i].Size());
+            }
+        }
+
+        return File::WriteAllBytes(path, buffer);
+    }
+}
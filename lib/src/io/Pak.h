@@ -0,0 +1,74 @@
+/*
+* Viry3D
+* Copyright 2014-2018 by Stack - stackos@qq.com
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#pragma once
+
+#include "MappedFile.h"
+#include "container/Vector.h"
+
+namespace Viry3D
+{
+    struct PakFile
+    {
+        // relative to the mount point, separated by '/'
+        String path;
+        ByteBuffer data;
+        bool compress = true;
+    };
+
+    // read only archive of asset files, mounted through FileSystem::MountPak.
+    // the archive is mapped once and indexed by path hash, stored files are views into the mapping,
+    // zlib files are inflated from the mapping into their buffer when opened
+    class Pak
+    {
+    public:
+        static Ref<Pak> Load(const String& path);
+        // files are zlib compressed when asked and it makes them smaller
+        static bool Save(const String& path, const Vector<PakFile>& files);
+        static unsigned int HashPath(const char* path, int size);
+        const String& GetPath() const { return m_path; }
+        int GetFileCount() const { return m_entry_count; }
+        bool Exist(const char* path, int size) const { return this->FindEntry(path, size) != nullptr; }
+        // null for files not in the archive
+        Ref<MappedFile> Open(const char* path, int size) const;
+
+    private:
+        struct Entry
+        {
+            unsigned int hash;
+            unsigned int name_offset;
+            unsigned int name_size;
+            unsigned int compression;
+            unsigned int offset;
+            unsigned int stored_size;
+            unsigned int size;
+        };
+
+        const Entry* FindEntry(const char* path, int size) const;
+
+    private:
+        String m_path;
+        Ref<MappedFile> m_file;
+        const Entry* m_entries;
+        int m_entry_count;
+        const char* m_names;
+        // heads of the hash chains, linked through m_next
+        Vector<int> m_buckets;
+        Vector<int> m_next;
+    };
+}
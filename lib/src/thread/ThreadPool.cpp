@@ -19,17 +19,52 @@
 #include "Object.h"
 #include "Application.h"
 #include "graphics/Display.h"
+#include "Profiler.h"
+#include "math/Mathf.h"
+#include <atomic>
 
 namespace Viry3D
 {
+    struct ParallelBatch
+    {
+        std::function<void(int)> job;
+        int count;
+        std::atomic<int> next;
+        int done;
+        Mutex mutex;
+        std::condition_variable condition;
+    };
+
+    static void RunParallelItems(ParallelBatch* batch)
+    {
+        while (true)
+        {
+            int index = batch->next++;
+            if (index >= batch->count)
+            {
+                break;
+            }
+
+            batch->job(index);
+
+            std::lock_guard<Mutex> lock(batch->mutex);
+            batch->done += 1;
+            if (batch->done == batch->count)
+            {
+                batch->condition.notify_all();
+            }
+        }
+    }
+
 	void Thread::Sleep(int ms)
 	{
 		std::this_thread::sleep_for(std::chrono::milliseconds(ms));
 	}
 
-	Thread::Thread(Action init, Action done):
+	Thread::Thread(Action init, Action done, const String& name):
         m_init_action(init),
-        m_done_action(done)
+        m_done_action(done),
+        m_name(name)
 	{
 		m_close = false;
         m_thread = RefMake<std::thread>(&Thread::Run, this);
@@ -75,7 +110,12 @@ namespace Viry3D
     void Thread::Run()
     {
         bool gl_thread = m_init_action && m_done_action;
-        
+
+        if (!m_name.Empty())
+        {
+            Profiler::SetThreadName(m_name);
+        }
+
         if (m_init_action)
         {
             m_init_action();
@@ -103,7 +143,11 @@ namespace Viry3D
 
             if (task.job)
             {
-                Ref<Object> res = task.job();
+                Ref<Object> res;
+                {
+                    PROFILE_ZONE("Thread::Task");
+                    res = task.job();
+                }
 
 #if VR_GLES
                 if (gl_thread)
@@ -133,12 +177,12 @@ namespace Viry3D
         }
     }
 
-	ThreadPool::ThreadPool(int thread_count, Action init, Action done)
+	ThreadPool::ThreadPool(int thread_count, Action init, Action done, const String& name)
 	{
 		m_threads.Resize(thread_count);
 		for (int i = 0; i < m_threads.Size(); ++i)
 		{
-			m_threads[i] = RefMake<Thread>(init, done);
+			m_threads[i] = RefMake<Thread>(init, done, String::Format("%s %d", name.CString(), i));
 		}
 	}
 
@@ -179,4 +223,46 @@ namespace Viry3D
             m_threads[min_index]->AddTask(task);
         }
     }
+
+    void ThreadPool::ParallelFor(ThreadPool* pool, int count, const std::function<void(int)>& job)
+    {
+        if (count <= 0)
+        {
+            return;
+        }
+
+        if (pool == nullptr || count == 1)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                job(i);
+            }
+            return;
+        }
+
+        Ref<ParallelBatch> batch = RefMake<ParallelBatch>();
+        batch->job = job;
+        batch->count = count;
+        batch->next = 0;
+        batch->done = 0;
+
+        // helpers queued behind other tasks find no items left and return, they never see the caller's stack
+        int helper_count = Mathf::Min(pool->GetThreadCount(), count - 1);
+        for (int i = 0; i < helper_count; ++i)
+        {
+            Thread::Task task;
+            task.job = [=]() {
+                RunParallelItems(batch.get());
+                return Ref<Object>();
+            };
+            pool->AddTask(task);
+        }
+
+        RunParallelItems(batch.get());
+
+        std::unique_lock<Mutex> lock(batch->mutex);
+        batch->condition.wait(lock, [&]() {
+            return batch->done == batch->count;
+        });
+    }
 }
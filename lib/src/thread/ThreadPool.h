@@ -19,6 +19,7 @@
 
 #include "container/Vector.h"
 #include "container/List.h"
+#include "string/String.h"
 #include "memory/Ref.h"
 #include "Action.h"
 #include <thread>
@@ -44,7 +45,7 @@ namespace Viry3D
 		};
 
 		static void Sleep(int ms);
-        Thread(Action init, Action done);
+        Thread(Action init, Action done, const String& name = "");
 		~Thread();
         void Wait();
         int GetQueueLength();
@@ -60,15 +61,19 @@ namespace Viry3D
 		bool m_close;
         Action m_init_action;
         Action m_done_action;
+        String m_name;
 	};
 
 	class ThreadPool
 	{
 	public:
-		ThreadPool(int thread_count, Action init = nullptr, Action done = nullptr);
+		ThreadPool(int thread_count, Action init = nullptr, Action done = nullptr, const String& name = "Worker");
 		void WaitAll();
 		int GetThreadCount() const { return m_threads.Size(); }
         void AddTask(const Thread::Task& task, int thread_index = -1);
+        // runs job(0) to job(count - 1) and returns when they are done, the caller runs items too
+        // and only waits for this batch, not for other tasks in the queues. null pool runs inline
+        static void ParallelFor(ThreadPool* pool, int count, const std::function<void(int)>& job);
 
 	private:
 		Vector<Ref<Thread>> m_threads;
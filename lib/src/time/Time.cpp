@@ -21,7 +21,7 @@
 
 #if VR_WINDOWS || VR_UWP
 #include <windows.h>
-#elif VR_IOS || VR_ANDROID || VR_MAC || VR_WASM
+#elif VR_IOS || VR_ANDROID || VR_MAC || VR_WASM || VR_LINUX
 #include <sys/time.h>
 #endif
 
@@ -34,6 +34,7 @@ namespace Viry3D
 	int Time::m_frame_record;
 	float Time::m_time = 0;
 	int Time::m_fps;
+	float Time::m_fixed_delta_time = 0;
 
 	Date Time::GetDate()
 	{
@@ -74,7 +75,7 @@ namespace Viry3D
 		tm.tm_isdst = -1;
 
 		t = mktime(&tm) * (long long) 1000 + sys_time.wMilliseconds;
-#elif VR_IOS || VR_ANDROID || VR_MAC || VR_WASM
+#elif VR_IOS || VR_ANDROID || VR_MAC || VR_WASM || VR_LINUX
 		struct timeval tv;
 		gettimeofday(&tv, nullptr);
 		t = tv.tv_sec;
@@ -115,7 +116,15 @@ namespace Viry3D
 
 	void Time::Update()
 	{
-		float time = Time::GetRealTimeSinceStartup();
+		float time;
+		if (m_fixed_delta_time > 0)
+		{
+			time = m_frame_count < 0 ? 0 : Time::m_time + m_fixed_delta_time;
+		}
+		else
+		{
+			time = Time::GetRealTimeSinceStartup();
+		}
 		Time::m_time_delta = time - Time::m_time;
 		Time::m_time = time;
 
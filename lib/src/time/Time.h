@@ -51,6 +51,8 @@ namespace Viry3D
 		static Date GetDate();
 		static int GetFPS() { return m_fps; }
 		static void Update();
+		//	greater than 0 advances time by a fixed step each frame, for deterministic runs
+		static void SetFixedDeltaTime(float delta) { m_fixed_delta_time = delta; }
 
 	private:
 		static long long m_time_startup;
@@ -60,5 +62,6 @@ namespace Viry3D
 		static int m_frame_count;
 		static int m_frame_record;
 		static int m_fps;
+		static float m_fixed_delta_time;
 	};
 }
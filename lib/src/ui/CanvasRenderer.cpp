@@ -502,6 +502,9 @@ void main()
         draw.vertexOffset = 0;
         draw.firstInstance = 0;
 
+        m_draw_index_count = draw.indexCount;
+        m_draw_instance_count = draw.instanceCount;
+
         if (!m_draw_buffer)
         {
             m_draw_buffer = Display::Instance()->CreateBuffer(&draw, sizeof(draw), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
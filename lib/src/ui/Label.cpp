@@ -19,6 +19,7 @@
 #include "CanvasRenderer.h"
 #include "Font.h"
 #include "graphics/Texture.h"
+#include <limits.h>
 
 namespace Viry3D
 {
@@ -27,4 +27,6 @@
 #elif VR_MAC
 #include "vulkan/vulkan.h"
 #include "vulkan/vulkan_macos.h"
+#elif VR_LINUX
+#include "vulkan/vulkan.h"
 #endif